@@ -0,0 +1,211 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "glnn_c.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include "../nn/NeuralNetwork.h"
+#include "../utils/SetupUtil.h"
+
+struct glnn_network {
+    GLFWwindow *context = nullptr;
+    std::unique_ptr<NeuralNetwork> network;
+};
+
+namespace {
+    bool initialized = false;
+    thread_local std::string lastError;
+
+    glnn_status fail(const glnn_status status, const char *message) {
+        lastError = message;
+        return status;
+    }
+
+    // Makes a context current for one call and gives the thread its previous one back, also on errors.
+    // A context can only be current on one thread, so a handle must not stay bound to its last caller.
+    class ContextScope {
+    public:
+        explicit ContextScope(GLFWwindow *context)
+            : previous(glfwGetCurrentContext()), switched(previous != context) {
+            if (switched) glfwMakeContextCurrent(context);
+        }
+
+        ~ContextScope() {
+            if (switched) glfwMakeContextCurrent(previous);
+        }
+
+        ContextScope(const ContextScope &) = delete;
+
+        ContextScope &operator=(const ContextScope &) = delete;
+
+    private:
+        GLFWwindow *previous;
+        bool switched;
+    };
+
+    // Turns whatever `body` throws into a status code, nothing may unwind into the foreign caller
+    template<typename Body>
+    glnn_status translateExceptions(Body &&body) {
+        try {
+            body();
+            lastError.clear();
+            return GLNN_OK;
+        } catch (const std::invalid_argument &e) {
+            return fail(GLNN_ERROR_INVALID_ARGUMENT, e.what());
+        } catch (const std::exception &e) {
+            return fail(GLNN_ERROR_RUNTIME, e.what());
+        } catch (...) {
+            return fail(GLNN_ERROR_RUNTIME, "Unknown error.");
+        }
+    }
+
+    // Runs `body` with the network's context current
+    template<typename Body>
+    glnn_status guarded(const glnn_network *handle, Body &&body) {
+        if (!initialized) return fail(GLNN_ERROR_NOT_INITIALIZED, "glnn_init() has not been called.");
+        if (!handle) return fail(GLNN_ERROR_INVALID_ARGUMENT, "Network handle is null.");
+        return translateExceptions([&] {
+            ContextScope scope(handle->context);
+            body(*handle->network);
+        });
+    }
+
+    void destroyHandle(glnn_network *handle) {
+        {
+            ContextScope scope(handle->context);
+            handle->network.reset();
+        }
+        destroyOffscreenContext(handle->context);
+        delete handle;
+    }
+
+    // Builds a network inside a new context of its own
+    template<typename Factory>
+    glnn_status createHandle(glnn_network **out, Factory &&factory) {
+        if (!initialized) return fail(GLNN_ERROR_NOT_INITIALIZED, "glnn_init() has not been called.");
+        if (!out) return fail(GLNN_ERROR_INVALID_ARGUMENT, "Output handle pointer is null.");
+        *out = nullptr;
+
+        glnn_network *handle = nullptr;
+        const glnn_status status = translateExceptions([&] {
+            handle = new glnn_network();
+            handle->context = createOffscreenContext();
+            ContextScope scope(handle->context);
+            handle->network = factory();
+        });
+        if (status != GLNN_OK) {
+            if (handle) destroyHandle(handle);
+            return status;
+        }
+        *out = handle;
+        return GLNN_OK;
+    }
+
+    size_t outputSize(const NeuralNetwork &network) {
+        return static_cast<size_t>(network.getLayerSizes().back());
+    }
+}
+
+int glnn_api_version(void) {
+    return GLNN_C_API_VERSION;
+}
+
+glnn_status glnn_init(void) {
+    if (initialized) return GLNN_OK;
+    return translateExceptions([] {
+        if (setupOpenGLWindow() != 0) throw std::runtime_error("Failed to set up the OpenGL context.");
+        initialized = true;
+    });
+}
+
+void glnn_shutdown(void) {
+    if (!initialized) return;
+    cleanupOpenGLWindow();
+    initialized = false;
+}
+
+const char *glnn_last_error(void) {
+    return lastError.c_str();
+}
+
+glnn_status glnn_create(const int *layer_sizes, const size_t layer_count, const float learning_rate,
+                        glnn_network **out) {
+    if (!layer_sizes || layer_count < 2) {
+        return fail(GLNN_ERROR_INVALID_ARGUMENT, "A network needs an input size and at least one layer.");
+    }
+    for (size_t i = 0; i < layer_count; ++i) {
+        if (layer_sizes[i] < 1) return fail(GLNN_ERROR_INVALID_ARGUMENT, "Layer sizes must be positive.");
+    }
+    return createHandle(out, [&] {
+        auto network = std::make_unique<NeuralNetwork>();
+        network->learningRate = learning_rate;
+        network->addLayer(layer_sizes[0], layer_sizes[1]);
+        for (size_t i = 2; i < layer_count; ++i) {
+            network->addLayer(layer_sizes[i]);
+        }
+        return network;
+    });
+}
+
+glnn_status glnn_load(const char *path, glnn_network **out) {
+    if (!path) return fail(GLNN_ERROR_INVALID_ARGUMENT, "Path is null.");
+    return createHandle(out, [path] { return NeuralNetwork::loadFromFile(path); });
+}
+
+glnn_status glnn_save(const glnn_network *network, const char *path) {
+    if (!path) return fail(GLNN_ERROR_INVALID_ARGUMENT, "Path is null.");
+    return guarded(network, [path](const NeuralNetwork &nn) { nn.saveToFile(path); });
+}
+
+void glnn_destroy(glnn_network *network) {
+    if (network) destroyHandle(network);
+}
+
+size_t glnn_input_size(const glnn_network *network) {
+    return network ? static_cast<size_t>(network->network->getInputSize()) : 0;
+}
+
+size_t glnn_output_size(const glnn_network *network) {
+    return network ? outputSize(*network->network) : 0;
+}
+
+glnn_status glnn_set_learning_rate(glnn_network *network, const float learning_rate) {
+    return guarded(network, [learning_rate](NeuralNetwork &nn) { nn.learningRate = learning_rate; });
+}
+
+glnn_status glnn_predict_batch(glnn_network *network, const float *inputs, const size_t batch_size,
+                               float *outputs) {
+    if (batch_size > 0 && (!inputs || !outputs)) {
+        return fail(GLNN_ERROR_INVALID_ARGUMENT, "Input or output buffer is null.");
+    }
+    return guarded(network, [&](NeuralNetwork &nn) {
+        // One pass over the whole batch, straight from and into the caller's memory
+        nn.predictBatch(std::span(inputs, batch_size * static_cast<size_t>(nn.getInputSize())), batch_size,
+                        std::span(outputs, batch_size * outputSize(nn)));
+    });
+}
+
+glnn_status glnn_train_batch(glnn_network *network, const float *inputs, const float *targets,
+                             const size_t batch_size, const int accumulation_steps) {
+    if (batch_size > 0 && (!inputs || !targets)) {
+        return fail(GLNN_ERROR_INVALID_ARGUMENT, "Input or target buffer is null.");
+    }
+    return guarded(network, [&](NeuralNetwork &nn) {
+        if (nn.getGradientAccumulationSteps() != accumulation_steps) {
+            nn.setGradientAccumulationSteps(accumulation_steps);
+        }
+        const size_t in = nn.getInputSize();
+        const size_t out = outputSize(nn);
+        for (size_t b = 0; b < batch_size; ++b) {
+            nn.train(std::span(inputs + b * in, in), std::span(targets + b * out, out));
+        }
+    });
+}
@@ -0,0 +1,110 @@
+/*
+ * Created by CorruptionHades on 19/10/2025.
+ */
+
+#ifndef GLNN_C_H
+#define GLNN_C_H
+
+/*
+ * Stable C interface of the GlNeuralNetC shared library, for callers that cannot link C++ (Dart FFI,
+ * Python ctypes, ...). Only plain C types cross the boundary, and no C++ exception ever leaves it.
+ *
+ * Tensors are caller-owned, densely packed float arrays: a batch of N samples is N * size floats,
+ * one sample after the other. Inputs are read straight from that memory into the GPU buffers, and
+ * outputs are written straight into the memory the caller provides. Nothing is retained after a call
+ * returns, so the caller may reuse or free its buffers right away.
+ *
+ * Threading: glnn_init(), glnn_create(), glnn_load(), glnn_destroy() and glnn_shutdown() must be
+ * called from the same thread (GLFW requirement). Each network has its own hidden GL context, so the
+ * other functions may be called from any thread, as long as a network is only used by one thread at
+ * a time: every call makes the network's context current and restores the thread's previous context
+ * before returning. Shaders are loaded from "shaders/" relative to the working directory, as for the
+ * executable.
+ *
+ * Functions returning glnn_status report failures through it; glnn_last_error() then describes the
+ * last failure of the calling thread.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+#if defined(GLNN_BUILD_SHARED)
+#define GLNN_API __declspec(dllexport)
+#else
+#define GLNN_API __declspec(dllimport)
+#endif
+#else
+#define GLNN_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct glnn_network glnn_network;
+
+typedef enum glnn_status {
+    GLNN_OK = 0,
+    GLNN_ERROR_INVALID_ARGUMENT = 1, /* wrong sizes, null pointers, unusable layer sizes */
+    GLNN_ERROR_RUNTIME = 2, /* GL errors, unreadable files, missing shaders */
+    GLNN_ERROR_NOT_INITIALIZED = 3 /* glnn_init() has not succeeded */
+} glnn_status;
+
+/* Version of this interface, bumped whenever a declaration in this file changes incompatibly. */
+#define GLNN_C_API_VERSION 1
+
+GLNN_API int glnn_api_version(void);
+
+/* Creates the hidden window and GL context the library needs. Call once, before anything else. */
+GLNN_API glnn_status glnn_init(void);
+
+/* Releases what glnn_init() created. Every network must have been destroyed. */
+GLNN_API void glnn_shutdown(void);
+
+/* Message of the last failed call on this thread, or "" if there was none. Valid until the next call. */
+GLNN_API const char *glnn_last_error(void);
+
+/*
+ * Creates a dense sigmoid network.
+ * layer_sizes: [input, hidden1, ..., output], at least two entries.
+ */
+GLNN_API glnn_status glnn_create(const int *layer_sizes, size_t layer_count, float learning_rate,
+                                 glnn_network **out);
+
+/* Loads a network saved by glnn_save() or NeuralNetwork::saveToFile(). */
+GLNN_API glnn_status glnn_load(const char *path, glnn_network **out);
+
+GLNN_API glnn_status glnn_save(const glnn_network *network, const char *path);
+
+/* Accepts null. */
+GLNN_API void glnn_destroy(glnn_network *network);
+
+GLNN_API size_t glnn_input_size(const glnn_network *network);
+
+GLNN_API size_t glnn_output_size(const glnn_network *network);
+
+GLNN_API glnn_status glnn_set_learning_rate(glnn_network *network, float learning_rate);
+
+/*
+ * Runs batch_size samples through the network, in one pass over the whole batch where the network allows
+ * it (see NeuralNetwork::predictBatch()).
+ * inputs: batch_size * glnn_input_size() floats, outputs: batch_size * glnn_output_size() floats.
+ */
+GLNN_API glnn_status glnn_predict_batch(glnn_network *network, const float *inputs, size_t batch_size,
+                                        float *outputs);
+
+/*
+ * Trains on batch_size samples, in order. Gradients of accumulation_steps consecutive samples are
+ * averaged into one update (see NeuralNetwork::setGradientAccumulationSteps()), 1 updates after every
+ * sample. A batch that is not a multiple of it leaves its gradients to the next call; calling with a
+ * different accumulation_steps applies those leftover gradients first.
+ * inputs: batch_size * glnn_input_size() floats, targets: batch_size * glnn_output_size() floats.
+ */
+GLNN_API glnn_status glnn_train_batch(glnn_network *network, const float *inputs, const float *targets,
+                                      size_t batch_size, int accumulation_steps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GLNN_C_H */
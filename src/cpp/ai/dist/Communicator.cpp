@@ -0,0 +1,146 @@
+//
+// Created by CorruptionHades on 02/10/2025.
+//
+
+#include "Communicator.h"
+#include "Transports.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    std::string getEnv(const char *name, const std::string &fallback) {
+        const char *value = std::getenv(name);
+        return value ? std::string(value) : fallback;
+    }
+
+    bool isLocalHost(const std::string &host) {
+        return host == "127.0.0.1" || host == "localhost" || host == "::1";
+    }
+}
+
+DistributedConfig DistributedConfig::fromEnvironment() {
+    DistributedConfig config;
+    config.rank = std::stoi(getEnv("GLNN_RANK", "0"));
+    config.worldSize = std::stoi(getEnv("GLNN_WORLD_SIZE", "1"));
+    config.basePort = std::stoi(getEnv("GLNN_PORT", std::to_string(config.basePort)));
+    config.jobId = getEnv("GLNN_JOB_ID", config.jobId);
+    config.exchangeTimeoutMs = std::stoi(getEnv("GLNN_EXCHANGE_TIMEOUT_MS",
+                                                std::to_string(config.exchangeTimeoutMs)));
+
+    const std::string hosts = getEnv("GLNN_HOSTS", "");
+    if (!hosts.empty()) {
+        config.hosts.clear();
+        std::stringstream ss(hosts);
+        std::string host;
+        while (std::getline(ss, host, ',')) {
+            config.hosts.push_back(host);
+        }
+    }
+
+    const std::string transport = getEnv("GLNN_TRANSPORT", "auto");
+    if (transport == "tcp") config.transport = TransportType::TCP;
+    else if (transport == "unix") config.transport = TransportType::UNIX_SOCKET;
+    else if (transport == "shm") config.transport = TransportType::SHARED_MEMORY;
+    else if (transport == "auto") config.transport = TransportType::AUTO;
+    else throw std::invalid_argument("Unknown GLNN_TRANSPORT: " + transport);
+
+    return config;
+}
+
+void Communicator::allReduceAverage(float *data, const size_t count) {
+    allReduceSum(data, count);
+    const float scale = 1.0f / static_cast<float>(worldSize());
+    for (size_t i = 0; i < count; ++i) {
+        data[i] *= scale;
+    }
+}
+
+void Communicator::broadcast(float *data, const size_t count, const int root) {
+    // A sum where every rank but the root contributes zeros leaves the root's values everywhere.
+    if (rank() != root) {
+        std::fill_n(data, count, 0.0f);
+    }
+    allReduceSum(data, count);
+}
+
+void Communicator::barrier() {
+    float token = 0.0f;
+    allReduceSum(&token, 1);
+}
+
+RingCommunicator::RingCommunicator(const int rank, const int worldSize, std::unique_ptr<RingTransport> transport)
+    : rank_(rank), worldSize_(worldSize), transport(std::move(transport)) {
+    if (worldSize_ < 1 || rank_ < 0 || rank_ >= worldSize_) {
+        throw std::invalid_argument("Invalid rank/world size for ring communicator.");
+    }
+}
+
+void RingCommunicator::allReduceSum(float *data, const size_t count) {
+    const int n = worldSize_;
+    if (n == 1 || count == 0) return;
+
+    // Split the buffer into n chunks; chunk c covers [begin(c), begin(c + 1)).
+    auto begin = [&](const int c) { return count * static_cast<size_t>(c) / n; };
+    auto chunkSize = [&](const int c) { return begin(c + 1) - begin(c); };
+    auto wrap = [&](const int c) { return ((c % n) + n) % n; };
+
+    recvScratch.resize(chunkSize(0) + 1);
+
+    // 1. Reduce-scatter: after n - 1 steps, rank r holds the complete sum of chunk r + 1.
+    for (int step = 0; step < n - 1; ++step) {
+        const int sendChunk = wrap(rank_ - step);
+        const int recvChunk = wrap(rank_ - step - 1);
+        transport->exchange(data + begin(sendChunk), chunkSize(sendChunk) * sizeof(float),
+                            recvScratch.data(), chunkSize(recvChunk) * sizeof(float));
+
+        float *dst = data + begin(recvChunk);
+        for (size_t i = 0; i < chunkSize(recvChunk); ++i) {
+            dst[i] += recvScratch[i];
+        }
+    }
+
+    // 2. All-gather: pass the completed chunks around the ring.
+    for (int step = 0; step < n - 1; ++step) {
+        const int sendChunk = wrap(rank_ - step + 1);
+        const int recvChunk = wrap(rank_ - step);
+        transport->exchange(data + begin(sendChunk), chunkSize(sendChunk) * sizeof(float),
+                            data + begin(recvChunk), chunkSize(recvChunk) * sizeof(float));
+    }
+}
+
+std::unique_ptr<Communicator> createCommunicator(const DistributedConfig &config) {
+    if (config.worldSize < 1 || config.rank < 0 || config.rank >= config.worldSize) {
+        throw std::invalid_argument("Invalid rank " + std::to_string(config.rank) +
+                                    " for world size " + std::to_string(config.worldSize));
+    }
+    if (config.hosts.empty()) {
+        throw std::invalid_argument("DistributedConfig needs at least one host.");
+    }
+
+    if (config.worldSize == 1) {
+        return std::make_unique<RingCommunicator>(0, 1, nullptr);
+    }
+
+    TransportType transport = config.transport;
+    if (transport == TransportType::AUTO) {
+        const bool allLocal = std::ranges::all_of(config.hosts, isLocalHost);
+        transport = allLocal ? TransportType::SHARED_MEMORY : TransportType::TCP;
+    }
+
+    std::unique_ptr<RingTransport> ring;
+    switch (transport) {
+        case TransportType::SHARED_MEMORY:
+            ring = std::make_unique<SharedMemoryTransport>(config);
+            break;
+        case TransportType::UNIX_SOCKET:
+        case TransportType::TCP:
+        default:
+            ring = std::make_unique<SocketTransport>(config, transport == TransportType::UNIX_SOCKET);
+            break;
+    }
+
+    return std::make_unique<RingCommunicator>(config.rank, config.worldSize, std::move(ring));
+}
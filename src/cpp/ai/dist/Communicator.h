@@ -0,0 +1,114 @@
+//
+// Created by CorruptionHades on 02/10/2025.
+//
+
+#ifndef COMMUNICATOR_H
+#define COMMUNICATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// How the ranks of a ring talk to their neighbours.
+enum class TransportType {
+    AUTO = 0, // SHARED_MEMORY if every rank is on this host, TCP otherwise
+    TCP = 1,
+    UNIX_SOCKET = 2,
+    SHARED_MEMORY = 3
+};
+
+struct DistributedConfig {
+    int rank = 0;
+    int worldSize = 1;
+    TransportType transport = TransportType::AUTO;
+
+    // One host per rank. If only one entry is given, every rank is assumed to live on it.
+    std::vector<std::string> hosts = {"127.0.0.1"};
+    // Rank r listens on basePort + r.
+    int basePort = 29500;
+    // Distinguishes concurrent jobs on one host (socket paths and shared memory names).
+    std::string jobId = "glnn";
+    // How long to keep retrying while the other ranks are starting up.
+    int connectTimeoutMs = 30000;
+    // How long an exchange may go without moving a byte before the neighbours are considered dead.
+    int exchangeTimeoutMs = 60000;
+
+    /**
+     * @brief Reads the config from GLNN_RANK, GLNN_WORLD_SIZE, GLNN_HOSTS (comma separated),
+     * GLNN_PORT, GLNN_JOB_ID, GLNN_TRANSPORT (auto|tcp|unix|shm) and GLNN_EXCHANGE_TIMEOUT_MS.
+     */
+    static DistributedConfig fromEnvironment();
+};
+
+/**
+ * @brief Moves bytes around a ring: every rank sends to rank + 1 and receives from rank - 1.
+ */
+class RingTransport {
+public:
+    virtual ~RingTransport() = default;
+
+    /**
+     * @brief Sends sendBytes to the next rank while receiving recvBytes from the previous one.
+     * Both directions progress together, so every rank may call this at the same time without deadlocking.
+     * Throws if neither direction moves for DistributedConfig::exchangeTimeoutMs (a rank died or hangs).
+     */
+    virtual void exchange(const void *sendData, size_t sendBytes, void *recvData, size_t recvBytes) = 0;
+};
+
+/**
+ * @brief Collective operations used by data-parallel training.
+ */
+class Communicator {
+public:
+    virtual ~Communicator() = default;
+
+    [[nodiscard]] virtual int rank() const = 0;
+
+    [[nodiscard]] virtual int worldSize() const = 0;
+
+    /**
+     * @brief In-place element-wise sum of data across all ranks.
+     */
+    virtual void allReduceSum(float *data, size_t count) = 0;
+
+    /**
+     * @brief In-place element-wise mean of data across all ranks.
+     */
+    void allReduceAverage(float *data, size_t count);
+
+    /**
+     * @brief Overwrites data on every rank with the values of the root rank.
+     */
+    void broadcast(float *data, size_t count, int root = 0);
+
+    void barrier();
+};
+
+/**
+ * @brief Bandwidth-optimal ring all-reduce (reduce-scatter followed by all-gather) on top of any RingTransport.
+ */
+class RingCommunicator : public Communicator {
+public:
+    RingCommunicator(int rank, int worldSize, std::unique_ptr<RingTransport> transport);
+
+    [[nodiscard]] int rank() const override { return rank_; }
+
+    [[nodiscard]] int worldSize() const override { return worldSize_; }
+
+    void allReduceSum(float *data, size_t count) override;
+
+private:
+    int rank_;
+    int worldSize_;
+    std::unique_ptr<RingTransport> transport;
+    std::vector<float> recvScratch;
+};
+
+/**
+ * @brief Creates a communicator for the given config, connecting to the neighbouring ranks.
+ * Blocks until the ring is complete or config.connectTimeoutMs expires.
+ */
+std::unique_ptr<Communicator> createCommunicator(const DistributedConfig &config);
+
+#endif //COMMUNICATOR_H
@@ -0,0 +1,175 @@
+//
+// Created by CorruptionHades on 03/10/2025.
+//
+
+#include "GradientBucketer.h"
+#include "../nn/Layer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+GradientBucketer::GradientBucketer(Communicator &communicator)
+    : communicator(communicator), worker(&GradientBucketer::run, this) {
+}
+
+GradientBucketer::~GradientBucketer() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    worker.join();
+
+    for (auto &[layer, bucket]: buckets) {
+        if (bucket.fence) glDeleteSync(bucket.fence);
+        if (bucket.staging) glDeleteBuffers(1, &bucket.staging);
+    }
+}
+
+void GradientBucketer::submit(Layer &layer) {
+    Bucket &bucket = buckets[&layer];
+    bucket.layer = &layer;
+    bucket.buffers = layer.gradientBuffers();
+    submitted.push_back(&bucket);
+
+    if (bucket.buffers.empty()) {
+        // A streamed layer's ∇W is already on the host, the earlier buckets have to go first to keep the order.
+        collect(true);
+        const size_t weightCount = static_cast<size_t>(layer.neuronCount) * layer.inputSize;
+        bucket.data.resize(weightCount + layer.neuronCount);
+        layer.downloadWeightGradients(bucket.data.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer.gradBiasesBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, layer.neuronCount * sizeof(float),
+                           bucket.data.data() + weightCount);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        enqueue(bucket);
+        return;
+    }
+
+    size_t total = 0;
+    for (const auto &[buffer, floats]: bucket.buffers) total += floats;
+    bucket.data.resize(total);
+    if (bucket.stagingFloats < total) {
+        if (!bucket.staging) glGenBuffers(1, &bucket.staging);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bucket.staging);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(total * sizeof(float)), nullptr, GL_STREAM_READ);
+        bucket.stagingFloats = total;
+    }
+
+    // The copies are queued behind the backward pass and the fence tells when they are done, nothing waits here
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bucket.staging);
+    size_t offset = 0;
+    for (const auto &[buffer, floats]: bucket.buffers) {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0,
+                            static_cast<GLintptr>(offset * sizeof(float)),
+                            static_cast<GLsizeiptr>(floats * sizeof(float)));
+        offset += floats;
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    bucket.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    pending.push_back(&bucket);
+    collect(false);
+}
+
+void GradientBucketer::collect(const bool wait) {
+    while (!pending.empty()) {
+        Bucket &bucket = *pending.front();
+        // Polling must not flush either, submit() already did
+        GLenum result = glClientWaitSync(bucket.fence, 0, 0);
+        while (wait && result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(bucket.fence, GL_SYNC_FLUSH_COMMANDS_BIT, UINT64_C(1000000000));
+        }
+        if (result == GL_TIMEOUT_EXPIRED) return;
+        if (result == GL_WAIT_FAILED) throw std::runtime_error("Waiting for a gradient copy failed.");
+        glDeleteSync(bucket.fence);
+        bucket.fence = nullptr;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, bucket.staging);
+        const auto bytes = static_cast<GLsizeiptr>(bucket.data.size() * sizeof(float));
+        const void *mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if (!mapped) throw std::runtime_error("Failed to map a gradient staging buffer.");
+        std::memcpy(bucket.data.data(), mapped, bytes);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        pending.pop_front();
+        enqueue(bucket);
+    }
+}
+
+void GradientBucketer::enqueue(Bucket &bucket) {
+    {
+        std::lock_guard lock(mutex);
+        queue.push_back(&bucket);
+        ++inFlight;
+    }
+    workAvailable.notify_one();
+}
+
+void GradientBucketer::finish() {
+    collect(true);
+    {
+        std::unique_lock lock(mutex);
+        workDone.wait(lock, [this] { return inFlight == 0; });
+        if (error) {
+            auto e = error;
+            error = nullptr;
+            submitted.clear();
+            std::rethrow_exception(e);
+        }
+    }
+
+    for (const Bucket *bucket: submitted) {
+        Layer &layer = *bucket->layer;
+        if (bucket->buffers.empty()) {
+            const size_t weightCount = static_cast<size_t>(layer.neuronCount) * layer.inputSize;
+            layer.uploadWeightGradients(bucket->data.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer.gradBiasesBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, layer.neuronCount * sizeof(float),
+                            bucket->data.data() + weightCount);
+            continue;
+        }
+        size_t offset = 0;
+        for (const auto &[buffer, floats]: bucket->buffers) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(floats * sizeof(float)),
+                            bucket->data.data() + offset);
+            offset += floats;
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    submitted.clear();
+}
+
+void GradientBucketer::run() {
+    while (true) {
+        Bucket *bucket;
+        {
+            std::unique_lock lock(mutex);
+            workAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            bucket = queue.front();
+            queue.pop_front();
+        }
+
+        // Every rank submits the layers in the same order, so the collectives line up.
+        try {
+            communicator.allReduceAverage(bucket->data.data(), bucket->data.size());
+        } catch (...) {
+            std::lock_guard lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(mutex);
+            --inFlight;
+        }
+        workDone.notify_all();
+    }
+}
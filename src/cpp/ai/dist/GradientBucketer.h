@@ -0,0 +1,86 @@
+//
+// Created by CorruptionHades on 03/10/2025.
+//
+
+#ifndef GRADIENTBUCKETER_H
+#define GRADIENTBUCKETER_H
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Communicator.h"
+
+class Layer;
+
+/**
+ * @brief Averages layer gradients across ranks while the backward pass keeps running.
+ *
+ * Each Layer::backward produces one bucket. submit() queues a GPU copy of its gradients into a staging
+ * buffer behind a fence and returns without waiting; buckets whose fence has signalled are read back and
+ * handed to a background thread that all-reduces them, so the communication of layer l overlaps with the
+ * backward pass of layer l - 1. finish() waits for every bucket and writes the averaged gradients back to
+ * the GPU. All GL calls stay on the calling (context) thread.
+ */
+class GradientBucketer {
+public:
+    explicit GradientBucketer(Communicator &communicator);
+
+    ~GradientBucketer();
+
+    GradientBucketer(const GradientBucketer &) = delete;
+
+    GradientBucketer &operator=(const GradientBucketer &) = delete;
+
+    /**
+     * @brief Starts copying the gradients of the layer off the GPU, and reduces them in the background once there.
+     */
+    void submit(Layer &layer);
+
+    /**
+     * @brief Blocks until every submitted bucket is reduced, then uploads the averaged gradients.
+     */
+    void finish();
+
+private:
+    struct Bucket {
+        Layer *layer = nullptr;
+        std::vector<float> data; // [gradWeights..., gradBiases...], in the layout of the layer's buffers
+        std::vector<std::pair<GLuint, size_t> > buffers; // Layer::gradientBuffers(), empty for a streamed layer
+        GLuint staging = 0; // GL_STREAM_READ copy target, grown as needed
+        size_t stagingFloats = 0;
+        GLsync fence = nullptr; // Signals once the copy into staging has landed
+    };
+
+    Communicator &communicator;
+
+    // Host and staging storage is reused across steps, one bucket per layer.
+    std::unordered_map<Layer *, Bucket> buckets;
+    std::vector<Bucket *> submitted;
+    // Copied but not yet read back, in submission order, which is the order the ranks reduce in
+    std::deque<Bucket *> pending;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::deque<Bucket *> queue;
+    size_t inFlight = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread worker;
+
+    void run();
+
+    // Hands the buckets at the front of `pending` whose copies have landed to the worker. With `wait`, all of them.
+    void collect(bool wait);
+
+    void enqueue(Bucket &bucket);
+};
+
+#endif //GRADIENTBUCKETER_H
@@ -0,0 +1,488 @@
+//
+// Created by CorruptionHades on 02/10/2025.
+//
+
+#include "Transports.h"
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+#ifdef _WIN32
+    using NativeSocket = SOCKET;
+    constexpr intptr_t INVALID = static_cast<intptr_t>(INVALID_SOCKET);
+
+    void closeSocket(const intptr_t s) { closesocket(static_cast<SOCKET>(s)); }
+
+    int lastSocketError() { return WSAGetLastError(); }
+
+    bool wouldBlock(const int err) { return err == WSAEWOULDBLOCK; }
+
+    int pollSockets(WSAPOLLFD *fds, const ULONG n, const int timeoutMs) { return WSAPoll(fds, n, timeoutMs); }
+
+    using PollFd = WSAPOLLFD;
+
+    struct WinsockInit {
+        WinsockInit() {
+            WSADATA wsa;
+            if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+                throw std::runtime_error("WSAStartup failed.");
+            }
+        }
+
+        ~WinsockInit() { WSACleanup(); }
+    };
+#else
+    using NativeSocket = int;
+    constexpr intptr_t INVALID = -1;
+
+    void closeSocket(const intptr_t s) { ::close(static_cast<int>(s)); }
+
+    int lastSocketError() { return errno; }
+
+    bool wouldBlock(const int err) { return err == EAGAIN || err == EWOULDBLOCK; }
+
+    int pollSockets(pollfd *fds, const nfds_t n, const int timeoutMs) { return ::poll(fds, n, timeoutMs); }
+
+    using PollFd = pollfd;
+#endif
+
+    void ensureSocketsInitialized() {
+#ifdef _WIN32
+        static WinsockInit init;
+#endif
+    }
+
+    void setNonBlocking(const intptr_t s) {
+#ifdef _WIN32
+        u_long mode = 1;
+        ioctlsocket(static_cast<SOCKET>(s), FIONBIO, &mode);
+#else
+        const int flags = fcntl(static_cast<int>(s), F_GETFL, 0);
+        fcntl(static_cast<int>(s), F_SETFL, flags | O_NONBLOCK);
+#endif
+    }
+
+    void setNoDelay(const intptr_t s) {
+        int flag = 1;
+        setsockopt(static_cast<NativeSocket>(s), IPPROTO_TCP, TCP_NODELAY,
+                   reinterpret_cast<const char *>(&flag), sizeof(flag));
+    }
+
+    std::string hostOf(const DistributedConfig &config, const int rank) {
+        return config.hosts.size() == 1 ? config.hosts[0] : config.hosts.at(rank);
+    }
+
+    std::string unixSocketPath(const DistributedConfig &config, const int rank) {
+        return "/tmp/" + config.jobId + "_" + std::to_string(rank) + ".sock";
+    }
+
+    intptr_t listenTcp(const int port) {
+        const intptr_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID) throw std::runtime_error("Could not create listen socket.");
+
+        int reuse = 1;
+        setsockopt(static_cast<NativeSocket>(s), SOL_SOCKET, SO_REUSEADDR,
+                   reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        if (bind(static_cast<NativeSocket>(s), reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+            listen(static_cast<NativeSocket>(s), 1) != 0) {
+            closeSocket(s);
+            throw std::runtime_error("Could not listen on port " + std::to_string(port));
+        }
+        return s;
+    }
+
+    intptr_t connectTcp(const std::string &host, const int port, const int timeoutMs) {
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result = nullptr;
+        if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+            throw std::runtime_error("Could not resolve host: " + host);
+        }
+
+        // The next rank may not be listening yet, so keep retrying until the timeout.
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            const intptr_t s = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+            if (s != INVALID && connect(static_cast<NativeSocket>(s), result->ai_addr,
+                                        static_cast<int>(result->ai_addrlen)) == 0) {
+                freeaddrinfo(result);
+                return s;
+            }
+            if (s != INVALID) closeSocket(s);
+            if (Clock::now() > deadline) {
+                freeaddrinfo(result);
+                throw std::runtime_error("Timed out connecting to " + host + ":" + std::to_string(port));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+
+#ifndef _WIN32
+    intptr_t listenUnix(const std::string &path) {
+        const int s = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s < 0) throw std::runtime_error("Could not create unix socket.");
+
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        ::unlink(path.c_str()); // stale socket from a crashed run
+        if (bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(s, 1) != 0) {
+            ::close(s);
+            throw std::runtime_error("Could not listen on unix socket: " + path);
+        }
+        return s;
+    }
+
+    intptr_t connectUnix(const std::string &path, const int timeoutMs) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (true) {
+            const int s = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (s >= 0 && connect(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+                return s;
+            }
+            if (s >= 0) ::close(s);
+            if (Clock::now() > deadline) {
+                throw std::runtime_error("Timed out connecting to unix socket: " + path);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+#endif
+
+    // Header at the start of every shared memory ring. head/tail are running byte counts.
+    struct RingHeader {
+        alignas(64) std::atomic<uint64_t> head; // written by the producer (previous rank)
+        alignas(64) std::atomic<uint64_t> tail; // written by the consumer (owner)
+        alignas(64) std::atomic<uint32_t> ready;
+    };
+
+    constexpr uint32_t RING_MAGIC = 0x474C4E4E; // "GLNN"
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                  "Shared memory rings need address-free atomics.");
+
+    unsigned char *ringData(void *base) {
+        return static_cast<unsigned char *>(base) + sizeof(RingHeader);
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// SocketTransport
+// ---------------------------------------------------------------------------------------------------------------------
+
+SocketTransport::Socket::~Socket() {
+    if (handle != INVALID) closeSocket(handle);
+}
+
+SocketTransport::Socket &SocketTransport::Socket::operator=(Socket &&other) noexcept {
+    if (this != &other) {
+        if (handle != INVALID) closeSocket(handle);
+        handle = std::exchange(other.handle, INVALID);
+    }
+    return *this;
+}
+
+SocketTransport::SocketFile::~SocketFile() {
+#ifndef _WIN32
+    if (!path.empty()) ::unlink(path.c_str());
+#endif
+}
+
+SocketTransport::SocketTransport(const DistributedConfig &config, const bool unixDomain)
+    : exchangeTimeoutMs(config.exchangeTimeoutMs) {
+    ensureSocketsInitialized();
+
+    const int nextRank = (config.rank + 1) % config.worldSize;
+
+    // Listen first so the previous rank can connect while we connect to the next one.
+    if (unixDomain) {
+#ifdef _WIN32
+        throw std::runtime_error("Unix domain sockets are not supported on this platform, use TCP.");
+#else
+        unixFile.path = unixSocketPath(config, config.rank);
+        listenSocket = Socket(listenUnix(unixFile.path));
+        nextSocket = Socket(connectUnix(unixSocketPath(config, nextRank), config.connectTimeoutMs));
+#endif
+    } else {
+        listenSocket = Socket(listenTcp(config.basePort + config.rank));
+        nextSocket = Socket(connectTcp(hostOf(config, nextRank), config.basePort + nextRank,
+                                       config.connectTimeoutMs));
+        setNoDelay(nextSocket.get());
+    }
+
+    prevSocket = Socket(static_cast<intptr_t>(accept(static_cast<NativeSocket>(listenSocket.get()), nullptr,
+                                                     nullptr)));
+    if (prevSocket.get() == INVALID) {
+        throw std::runtime_error("Failed to accept connection from the previous rank.");
+    }
+    if (!unixDomain) setNoDelay(prevSocket.get());
+
+    setNonBlocking(nextSocket.get());
+    setNonBlocking(prevSocket.get());
+}
+
+SocketTransport::~SocketTransport() = default;
+
+void SocketTransport::exchange(const void *sendData, const size_t sendBytes, void *recvData, const size_t recvBytes) {
+    auto sendPtr = static_cast<const char *>(sendData);
+    auto recvPtr = static_cast<char *>(recvData);
+    size_t sent = 0, received = 0;
+    auto lastProgress = Clock::now();
+
+    // Drive both directions from one poll loop; a blocking send would deadlock once the
+    // kernel buffers of every rank in the ring are full.
+    while (sent < sendBytes || received < recvBytes) {
+        const size_t before = sent + received;
+        PollFd fds[2];
+        int n = 0;
+        int sendIdx = -1, recvIdx = -1;
+        if (sent < sendBytes) {
+            fds[n].fd = static_cast<NativeSocket>(nextSocket.get());
+            fds[n].events = POLLOUT;
+            fds[n].revents = 0;
+            sendIdx = n++;
+        }
+        if (received < recvBytes) {
+            fds[n].fd = static_cast<NativeSocket>(prevSocket.get());
+            fds[n].events = POLLIN;
+            fds[n].revents = 0;
+            recvIdx = n++;
+        }
+
+        if (pollSockets(fds, n, 1000) < 0) {
+            throw std::runtime_error("poll() failed during ring exchange.");
+        }
+
+        if (sendIdx >= 0 && (fds[sendIdx].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            const int chunk = static_cast<int>(std::min<size_t>(sendBytes - sent, 1 << 20));
+            const auto r = send(static_cast<NativeSocket>(nextSocket.get()), sendPtr + sent, chunk, 0);
+            if (r > 0) sent += r;
+            else if (!wouldBlock(lastSocketError())) throw std::runtime_error("Ring send failed.");
+        }
+        if (recvIdx >= 0 && (fds[recvIdx].revents & (POLLIN | POLLERR | POLLHUP))) {
+            const int chunk = static_cast<int>(std::min<size_t>(recvBytes - received, 1 << 20));
+            const auto r = recv(static_cast<NativeSocket>(prevSocket.get()), recvPtr + received, chunk, 0);
+            if (r > 0) received += r;
+            else if (r == 0) throw std::runtime_error("Previous rank closed the connection.");
+            else if (!wouldBlock(lastSocketError())) throw std::runtime_error("Ring receive failed.");
+        }
+
+        if (sent + received != before) {
+            lastProgress = Clock::now();
+        } else if (Clock::now() - lastProgress > std::chrono::milliseconds(exchangeTimeoutMs)) {
+            throw std::runtime_error("Ring exchange made no progress for " + std::to_string(exchangeTimeoutMs) +
+                                     " ms, a neighbouring rank is not responding.");
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------------------------------------------------
+// SharedMemoryTransport
+// ---------------------------------------------------------------------------------------------------------------------
+
+SharedMemoryTransport::SharedMemoryTransport(const DistributedConfig &config)
+    : exchangeTimeoutMs(config.exchangeTimeoutMs) {
+    const int nextRank = (config.rank + 1) % config.worldSize;
+    const size_t size = sizeof(RingHeader) + RING_CAPACITY;
+
+    own = create(config.jobId + "_" + std::to_string(config.rank), size);
+    try {
+        next = open(config.jobId + "_" + std::to_string(nextRank), size, config.connectTimeoutMs);
+    } catch (...) {
+        close(own, true);
+        throw;
+    }
+}
+
+SharedMemoryTransport::~SharedMemoryTransport() {
+    close(next, false);
+    close(own, true);
+}
+
+void SharedMemoryTransport::exchange(const void *sendData, const size_t sendBytes,
+                                     void *recvData, const size_t recvBytes) {
+    auto *out = static_cast<RingHeader *>(next.base);
+    auto *in = static_cast<RingHeader *>(own.base);
+    unsigned char *outData = ringData(next.base);
+    const unsigned char *inData = ringData(own.base);
+
+    auto sendPtr = static_cast<const unsigned char *>(sendData);
+    auto recvPtr = static_cast<unsigned char *>(recvData);
+    size_t sent = 0, received = 0;
+    // A crashed peer never moves its end of the ring again; there is no connection that would break
+    auto lastProgress = Clock::now();
+    uint32_t idleSpins = 0;
+
+    while (sent < sendBytes || received < recvBytes) {
+        bool progressed = false;
+
+        if (sent < sendBytes) {
+            const uint64_t head = out->head.load(std::memory_order_relaxed);
+            const uint64_t tail = out->tail.load(std::memory_order_acquire);
+            const size_t space = RING_CAPACITY - static_cast<size_t>(head - tail);
+            size_t n = std::min(space, sendBytes - sent);
+            if (n > 0) {
+                const size_t offset = head % RING_CAPACITY;
+                const size_t first = std::min(n, RING_CAPACITY - offset);
+                std::memcpy(outData + offset, sendPtr + sent, first);
+                std::memcpy(outData, sendPtr + sent + first, n - first);
+                out->head.store(head + n, std::memory_order_release);
+                sent += n;
+                progressed = true;
+            }
+        }
+
+        if (received < recvBytes) {
+            const uint64_t tail = in->tail.load(std::memory_order_relaxed);
+            const uint64_t head = in->head.load(std::memory_order_acquire);
+            size_t n = std::min(static_cast<size_t>(head - tail), recvBytes - received);
+            if (n > 0) {
+                const size_t offset = tail % RING_CAPACITY;
+                const size_t first = std::min(n, RING_CAPACITY - offset);
+                std::memcpy(recvPtr + received, inData + offset, first);
+                std::memcpy(recvPtr + received + first, inData, n - first);
+                in->tail.store(tail + n, std::memory_order_release);
+                received += n;
+                progressed = true;
+            }
+        }
+
+        if (progressed) {
+            // Every progressing round moves a whole chunk, a clock read is cheap next to that
+            lastProgress = Clock::now();
+            idleSpins = 0;
+            continue;
+        }
+        if (++idleSpins % 1024 == 0 && Clock::now() - lastProgress > std::chrono::milliseconds(exchangeTimeoutMs)) {
+            throw std::runtime_error("Shared memory exchange made no progress for " + std::to_string(exchangeTimeoutMs) +
+                                     " ms, a neighbouring rank is not responding.");
+        }
+        std::this_thread::yield();
+    }
+}
+
+SharedMemoryTransport::Segment SharedMemoryTransport::create(const std::string &name, const size_t size) {
+    Segment segment;
+    segment.name = name;
+    segment.size = size;
+
+#ifdef _WIN32
+    const std::string winName = "Local\\" + name;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size), winName.c_str());
+    if (!mapping) throw std::runtime_error("CreateFileMapping failed for " + winName);
+    segment.handle = reinterpret_cast<intptr_t>(mapping);
+    segment.base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    const std::string posixName = "/" + name;
+    shm_unlink(posixName.c_str()); // stale segment from a crashed run
+    const int fd = shm_open(posixName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw std::runtime_error("shm_open failed for " + posixName);
+    }
+    segment.base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (segment.base == MAP_FAILED) segment.base = nullptr;
+#endif
+    if (!segment.base) throw std::runtime_error("Could not map shared memory segment " + name);
+
+    auto *header = new(segment.base) RingHeader();
+    header->head.store(0);
+    header->tail.store(0);
+    header->ready.store(RING_MAGIC, std::memory_order_release);
+    return segment;
+}
+
+SharedMemoryTransport::Segment SharedMemoryTransport::open(const std::string &name, const size_t size,
+                                                           const int timeoutMs) {
+    Segment segment;
+    segment.name = name;
+    segment.size = size;
+
+    const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!segment.base) {
+#ifdef _WIN32
+        const std::string winName = "Local\\" + name;
+        HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, winName.c_str());
+        if (mapping) {
+            segment.handle = reinterpret_cast<intptr_t>(mapping);
+            segment.base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        }
+#else
+        const std::string posixName = "/" + name;
+        const int fd = shm_open(posixName.c_str(), O_RDWR, 0600);
+        struct stat st{};
+        if (fd >= 0 && fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= size) {
+            void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (base != MAP_FAILED) segment.base = base;
+        }
+        if (fd >= 0) ::close(fd);
+#endif
+        // The owner creates the segment first and marks it ready once the header is initialized.
+        if (segment.base &&
+            static_cast<RingHeader *>(segment.base)->ready.load(std::memory_order_acquire) != RING_MAGIC) {
+            close(segment, false);
+            segment.name = name;
+        }
+        if (segment.base) break;
+
+        if (Clock::now() > deadline) {
+            throw std::runtime_error("Timed out waiting for shared memory segment " + name);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return segment;
+}
+
+void SharedMemoryTransport::close(Segment &segment, const bool unlink) {
+    if (!segment.base) return;
+#ifdef _WIN32
+    UnmapViewOfFile(segment.base);
+    CloseHandle(reinterpret_cast<HANDLE>(segment.handle));
+    (void) unlink; // the mapping disappears with its last handle
+#else
+    munmap(segment.base, segment.size);
+    if (unlink) shm_unlink(("/" + segment.name).c_str());
+#endif
+    segment.base = nullptr;
+    segment.handle = -1;
+}
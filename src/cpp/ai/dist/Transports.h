@@ -0,0 +1,106 @@
+//
+// Created by CorruptionHades on 02/10/2025.
+//
+
+#ifndef TRANSPORTS_H
+#define TRANSPORTS_H
+
+#include "Communicator.h"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Ring transport over TCP (any host) or Unix domain sockets (same host, POSIX only).
+ * Rank r listens on config.basePort + r (or a socket file under /tmp), connects to rank r + 1
+ * and accepts rank r - 1.
+ */
+class SocketTransport : public RingTransport {
+public:
+    SocketTransport(const DistributedConfig &config, bool unixDomain);
+
+    ~SocketTransport() override;
+
+    SocketTransport(const SocketTransport &) = delete;
+
+    SocketTransport &operator=(const SocketTransport &) = delete;
+
+    void exchange(const void *sendData, size_t sendBytes, void *recvData, size_t recvBytes) override;
+
+private:
+    // Owns a native handle, stored as intptr_t so SOCKET (Windows) and int (POSIX) both fit. Closing in the
+    // destructor means a constructor that throws halfway leaks nothing.
+    class Socket {
+    public:
+        Socket() = default;
+
+        explicit Socket(intptr_t handle) : handle(handle) {
+        }
+
+        ~Socket();
+
+        Socket(const Socket &) = delete;
+
+        Socket &operator=(const Socket &) = delete;
+
+        Socket &operator=(Socket &&other) noexcept;
+
+        [[nodiscard]] intptr_t get() const { return handle; }
+
+    private:
+        intptr_t handle = -1;
+    };
+
+    // Removes the socket file of a Unix domain listener, after the listener itself is closed
+    struct SocketFile {
+        std::string path;
+
+        ~SocketFile();
+    };
+
+    SocketFile unixFile;
+    Socket listenSocket;
+    Socket nextSocket; // we send on this one
+    Socket prevSocket; // we receive on this one
+    int exchangeTimeoutMs;
+};
+
+/**
+ * @brief Ring transport for ranks on the same host. Each rank owns a single-producer/single-consumer
+ * byte ring in a named shared memory segment that its previous rank writes into.
+ */
+class SharedMemoryTransport : public RingTransport {
+public:
+    explicit SharedMemoryTransport(const DistributedConfig &config);
+
+    ~SharedMemoryTransport() override;
+
+    SharedMemoryTransport(const SharedMemoryTransport &) = delete;
+
+    SharedMemoryTransport &operator=(const SharedMemoryTransport &) = delete;
+
+    void exchange(const void *sendData, size_t sendBytes, void *recvData, size_t recvBytes) override;
+
+    // Bytes of payload each ring can hold.
+    static constexpr size_t RING_CAPACITY = 4 << 20;
+
+private:
+    struct Segment {
+        std::string name;
+        void *base = nullptr;
+        size_t size = 0;
+        intptr_t handle = -1;
+    };
+
+    Segment own;  // we read from this ring
+    Segment next; // we write into the ring of the next rank
+    int exchangeTimeoutMs;
+
+    static Segment create(const std::string &name, size_t size);
+
+    static Segment open(const std::string &name, size_t size, int timeoutMs);
+
+    static void close(Segment &segment, bool unlink);
+};
+
+#endif //TRANSPORTS_H
@@ -7,22 +7,65 @@
 #include <sstream>
 #include <iostream>
 
-void Shader::loadComputeShader(const std::string &shaderPath) {
-    std::string shaderCode;
-    std::ifstream shaderFile;
+namespace {
+    std::string readFile(const std::string &path) {
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            return stream.str();
+        } catch (std::ifstream::failure &e) {
+            std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+            return {};
+        }
+    }
+
+    // Replaces every line of the form `#include "file"` with the contents of that file,
+    // resolved relative to the including shader. Lets kernels share helpers like the RNG.
+    std::string resolveIncludes(const std::string &source, const std::string &directory, int depth = 0) {
+        if (depth > 8) {
+            std::cerr << "ERROR::SHADER::INCLUDE_TOO_DEEP" << std::endl;
+            return source;
+        }
 
-    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        shaderFile.open(shaderPath);
-        std::stringstream shaderStream;
-        shaderStream << shaderFile.rdbuf();
-        shaderFile.close();
-        shaderCode = shaderStream.str();
-    } catch (std::ifstream::failure &e) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << shaderPath << std::endl;
+        std::stringstream in(source);
+        std::string result, line;
+        while (std::getline(in, line)) {
+            const size_t directive = line.find("#include");
+            const size_t open = line.find('"');
+            const size_t close = line.rfind('"');
+            const bool isDirective = directive != std::string::npos && directive == line.find_first_not_of(" \t");
+            if (isDirective && open != std::string::npos && close > open) {
+                const std::string includePath = directory + line.substr(open + 1, close - open - 1);
+                const size_t slash = includePath.find_last_of("/\\");
+                const std::string includeDir = slash == std::string::npos ? "" : includePath.substr(0, slash + 1);
+                result += resolveIncludes(readFile(includePath), includeDir, depth + 1);
+            } else {
+                result += line;
+            }
+            result += '\n';
+        }
+        return result;
     }
+}
 
-    const char *cShaderCode = shaderCode.c_str();
+void Shader::loadComputeShader(const std::string &shaderPath, const std::string &defines) {
+    const size_t slash = shaderPath.find_last_of("/\\");
+    const std::string directory = slash == std::string::npos ? "" : shaderPath.substr(0, slash + 1);
+    std::string source = resolveIncludes(readFile(shaderPath), directory);
+    if (!defines.empty()) {
+        // #version has to stay the first statement
+        const size_t version = source.find("#version");
+        const size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+        source.insert(lineEnd == std::string::npos ? 0 : lineEnd + 1, defines);
+    }
+    loadComputeShaderSource(source);
+}
+
+void Shader::loadComputeShaderSource(const std::string &source) {
+    const char *cShaderCode = source.c_str();
     const GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
     glShaderSource(computeShader, 1, &cShaderCode, nullptr);
     glCompileShader(computeShader);
@@ -44,6 +87,14 @@ void Shader::setInt(const std::string &name, int value) const {
     glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
 }
 
+void Shader::setUInt(const std::string &name, GLuint value) const {
+    glUniform1ui(glGetUniformLocation(ID, name.c_str()), value);
+}
+
+void Shader::setFloat(const std::string &name, float value) const {
+    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+}
+
 void Shader::dispatch(const GLuint group_x, const GLuint group_y, const GLuint group_z) const {
     glDispatchCompute(group_x, group_y, group_z);
     // Block until all writes from this shader call are complete
@@ -14,12 +14,27 @@ public:
 
     Shader() = default;
 
-    void loadComputeShader(const std::string &shaderPath);
+    /**
+     * Loads and compiles a compute shader. Lines of the form #include "file" are replaced
+     * with that file, resolved relative to the shader.
+     * @param defines Inserted right after the #version line, e.g. "#define MAX_PAGES 5\n" for
+     * constants the host code owns.
+     */
+    void loadComputeShader(const std::string &shaderPath, const std::string &defines = {});
+
+    /**
+     * Compiles a compute shader from source held in memory, e.g. one generated at runtime.
+     */
+    void loadComputeShaderSource(const std::string &source);
 
     void use() const;
 
     void setInt(const std::string &name, int value) const;
 
+    void setUInt(const std::string &name, GLuint value) const;
+
+    void setFloat(const std::string &name, float value) const;
+
     /**
      * Dispatches a compute shader.
      * The global work group counts are the total number of invocations you want.
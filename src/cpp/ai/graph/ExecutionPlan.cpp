@@ -0,0 +1,45 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#include "ExecutionPlan.h"
+
+#include <algorithm>
+
+ExecutionPlan::ExecutionPlan(const std::span<const std::unique_ptr<Layer> > layers, const GraphBindings &bindings,
+                             GraphKernels kernels, const std::span<const int> checkpoints) {
+    kernels.generated = &generatedKernels;
+    // Everything in front of the last checkpoint
+    for (const int l: checkpoints) {
+        if (l < static_cast<int>(layers.size())) recomputedLayers = std::max(recomputedLayers, l);
+    }
+
+    CompileStats accumulateStats, updateStats;
+    inference = GraphCompiler::compile(Graph::build(layers, bindings, Graph::Mode::INFERENCE), kernels, pool,
+                                       inferenceStats);
+    training = GraphCompiler::compile(Graph::build(layers, bindings, Graph::Mode::TRAINING, checkpoints), kernels,
+                                      pool, trainingStats);
+    trainingAccumulate = GraphCompiler::compile(Graph::build(layers, bindings, Graph::Mode::TRAINING_ACCUMULATE,
+                                                             checkpoints), kernels, pool, accumulateStats);
+    update = GraphCompiler::compile(Graph::build(layers, bindings, Graph::Mode::UPDATE), kernels, pool, updateStats);
+
+    stats += inferenceStats;
+    stats += trainingStats;
+    stats += accumulateStats;
+    stats += updateStats;
+}
+
+void ExecutionPlan::printSummary(std::ostream &out) const {
+    out << "Execution plan: predict " << inferenceStats.commandsBefore << " -> " << inference.dispatchCount()
+            << " dispatches, train step " << trainingStats.commandsBefore << " -> " << training.dispatchCount()
+            << " (+" << update.dispatchCount() << " for the update)" << std::endl;
+    out << "  " << stats.copiesEliminated << " copies eliminated, " << stats.copiesFolded << " folded, "
+            << stats.opsFused << " elementwise ops fused, " << stats.storesEliminated
+            << " intermediates kept in registers, " << generatedKernels.size() << " kernels generated" << std::endl;
+    out << "  " << stats.transientValues << " transient values planned into " << pool.slotCount()
+            << " buffers (" << pool.totalBytes() / 1024.0 << " KB)" << std::endl;
+    if (recomputedLayers > 0) {
+        out << "  " << recomputedLayers << " layers recomputed from activation checkpoints per train step"
+                << std::endl;
+    }
+}
@@ -0,0 +1,56 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#ifndef EXECUTIONPLAN_H
+#define EXECUTIONPLAN_H
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "GraphCompiler.h"
+#include "Schedule.h"
+
+/**
+ * @brief The compiled schedules of one network, built once and replayed every step.
+ * Must be rebuilt whenever layers are added.
+ */
+class ExecutionPlan {
+public:
+    /**
+     * @param kernels Shaders owned by the network; kernels for fused ops are generated by the plan.
+     * @param checkpoints Activation checkpoints of the training schedules, see Graph::build().
+     */
+    ExecutionPlan(std::span<const std::unique_ptr<Layer> > layers, const GraphBindings &bindings,
+                  GraphKernels kernels, std::span<const int> checkpoints = {});
+
+    ExecutionPlan(const ExecutionPlan &) = delete;
+
+    ExecutionPlan &operator=(const ExecutionPlan &) = delete;
+
+    Schedule inference;
+    Schedule training;
+    Schedule trainingAccumulate;
+    Schedule update;
+
+    [[nodiscard]] const CompileStats &getStats() const { return stats; }
+
+    // Device memory of the transient values (activations, errors, intermediates) of all schedules
+    [[nodiscard]] size_t activationBytes() const { return pool.totalBytes(); }
+
+    // Layers run forward a second time by every training step
+    [[nodiscard]] int getRecomputedLayers() const { return recomputedLayers; }
+
+    void printSummary(std::ostream &out) const;
+
+private:
+    KernelCache generatedKernels;
+    BufferPool pool;
+    CompileStats stats;
+    CompileStats inferenceStats;
+    CompileStats trainingStats;
+    int recomputedLayers = 0;
+};
+
+#endif //EXECUTIONPLAN_H
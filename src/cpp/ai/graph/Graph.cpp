@@ -0,0 +1,237 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#include "Graph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../nn/Layer.h"
+
+int Graph::addValue(const std::string &name, const int size, const GLuint buffer) {
+    values.push_back({name, size, buffer});
+    return static_cast<int>(values.size()) - 1;
+}
+
+void Graph::addElementwise(const ElementOp op, const int out, const int a, const int b) {
+    Op node{OpType::ELEMENTWISE};
+    node.program.push_back({op, out, a, b});
+    updateOperands(node);
+    ops.push_back(std::move(node));
+}
+
+void Graph::addCopy(const int source, const int destination) {
+    Op node{OpType::COPY};
+    node.inputs = {source};
+    node.outputs = {destination};
+    ops.push_back(std::move(node));
+}
+
+void Graph::updateOperands(Op &op) {
+    op.inputs.clear();
+    op.outputs.clear();
+    auto read = [&op](const int value) {
+        if (value < 0) return;
+        const bool local = std::ranges::find(op.outputs, value) != op.outputs.end();
+        if (!local && std::ranges::find(op.inputs, value) == op.inputs.end()) {
+            op.inputs.push_back(value);
+        }
+    };
+
+    for (const auto &instr: op.program) {
+        read(instr.a);
+        read(instr.b);
+        if (instr.op == ElementOp::ACCUMULATE) {
+            read(instr.out); // read-modify-write
+        }
+        if (std::ranges::find(op.outputs, instr.out) == op.outputs.end()) {
+            op.outputs.push_back(instr.out);
+        }
+    }
+}
+
+Graph Graph::build(const std::span<const std::unique_ptr<Layer> > layers, const GraphBindings &bindings,
+                   const Mode mode, const std::span<const int> checkpoints) {
+    if (layers.empty()) {
+        throw std::invalid_argument("Cannot build a graph for an empty network.");
+    }
+
+    Graph g;
+    const int layerCount = static_cast<int>(layers.size());
+
+    // W and ∇W values per layer, one per shard
+    auto shardValues = [&g, &layers](const int l, GLuint WeightShard::*buffer, const std::string &name) {
+        const Layer &layer = *layers[l];
+        std::vector<int> values;
+        for (size_t s = 0; s < layer.shards.size(); ++s) {
+            const WeightShard &shard = layer.shards[s];
+            std::string id = name + std::to_string(l);
+            if (layer.isSharded()) id += "." + std::to_string(s);
+            values.push_back(g.addValue(id, layer.neuronCount * shard.columns, shard.*buffer));
+        }
+        return values;
+    };
+
+    if (mode == Mode::UPDATE) {
+        for (int l = 0; l < layerCount; ++l) {
+            const Layer &layer = *layers[l];
+            const std::string id = std::to_string(l);
+            const std::vector<int> w = shardValues(l, &WeightShard::weights, "W");
+            const std::vector<int> gw = shardValues(l, &WeightShard::gradWeights, "dW");
+            for (size_t s = 0; s < w.size(); ++s) {
+                const int weightCount = layer.neuronCount * layer.shards[s].columns;
+                g.ops.push_back({OpType::SGD_UPDATE, {gw[s]}, {w[s]}, weightCount, 1, false, l});
+            }
+            const int b = g.addValue("b" + id, layer.neuronCount, layer.biasesBuffer);
+            const int gb = g.addValue("db" + id, layer.neuronCount, layer.gradBiasesBuffer);
+            g.ops.push_back({OpType::SGD_UPDATE, {gb}, {b}, layer.neuronCount, 1, false, l});
+        }
+        return g;
+    }
+
+    // transpose(W) * δ into `out`, every shard fills its block of columns
+    auto propagate = [&g, &layers](const int l, const std::vector<int> &w, const int delta, const int out) {
+        const Layer &layer = *layers[l];
+        for (size_t s = 0; s < w.size(); ++s) {
+            const WeightShard &shard = layer.shards[s];
+            g.ops.push_back({
+                OpType::MATMUL_TRANSPOSED, {w[s], delta}, {out}, layer.neuronCount, shard.columns, false, l,
+                shard.firstColumn
+            });
+        }
+    };
+
+    std::vector<std::vector<int> > weights(layerCount);
+    std::vector<int> biases(layerCount);
+    for (int l = 0; l < layerCount; ++l) {
+        weights[l] = shardValues(l, &WeightShard::weights, "W");
+        biases[l] = g.addValue("b" + std::to_string(l), layers[l]->neuronCount, layers[l]->biasesBuffer);
+    }
+
+    // --- Forward: copy input, z = W * x, z = z + b, a = sigmoid(z) ---
+    // Without an activation value (a < 0) only z is produced; `suffix` names recomputed values apart
+    std::vector<int> savedInputs(layerCount);
+    std::vector<int> weightedSums(layerCount);
+    auto forwardLayer = [&](const int l, const int x, const int a, const std::string &suffix) {
+        const Layer &layer = *layers[l];
+        const std::string id = std::to_string(l) + suffix;
+
+        savedInputs[l] = g.addValue("x" + id, layer.inputSize);
+        g.addCopy(x, savedInputs[l]);
+
+        const int z = g.addValue("Wx" + id, layer.neuronCount);
+        weightedSums[l] = g.addValue("z" + id, layer.neuronCount);
+        for (size_t s = 0; s < layer.shards.size(); ++s) {
+            // The shards after the first add their partial sums to z
+            const WeightShard &shard = layer.shards[s];
+            const bool partial = s > 0;
+            Op matmul{OpType::MATMUL, {weights[l][s], x}, {z}, layer.neuronCount, shard.columns, partial, l};
+            matmul.offset = shard.firstColumn;
+            if (partial) matmul.inputs.push_back(z);
+            g.ops.push_back(std::move(matmul));
+        }
+        g.addElementwise(ElementOp::ADD, weightedSums[l], z, biases[l]);
+        if (a >= 0) g.addElementwise(ElementOp::SIGMOID, a, weightedSums[l]);
+    };
+
+    const int input = g.addValue("input", layers.front()->inputSize, bindings.input);
+    std::vector<int> activations(layerCount);
+    for (int l = 0; l < layerCount; ++l) {
+        activations[l] = l == layerCount - 1
+                             ? g.addValue("output", layers[l]->neuronCount, bindings.output)
+                             : g.addValue("a" + std::to_string(l), layers[l]->neuronCount);
+        forwardLayer(l, l == 0 ? input : activations[l - 1], activations[l], "");
+    }
+    int x = activations.back();
+
+    if (mode == Mode::INFERENCE) {
+        return g;
+    }
+
+    // Layers that start a segment: their input is kept, the segment in front of the next one is recomputed.
+    // With no checkpoints every activation is kept; the last segment always is, its backward pass comes next.
+    std::vector<bool> checkpointed(layerCount, false);
+    if (!checkpoints.empty()) {
+        checkpointed[0] = true;
+        for (const int l: checkpoints) {
+            if (l < 0) throw std::invalid_argument("Activation checkpoints must be layer indices.");
+            if (l < layerCount) checkpointed[l] = true;
+        }
+    }
+
+    // --- Backward: δ_L = prediction - target, then δ_l = (W_{l+1}^T δ_{l+1}) .* g'(z_l) ---
+    const bool accumulate = mode == Mode::TRAINING_ACCUMULATE;
+    const int outputSize = layers.back()->neuronCount;
+    int delta = g.addValue("delta" + std::to_string(layerCount - 1), outputSize);
+    if (bindings.outputError) {
+        // The host continues the forward pass and hands back dL/d(output); δ = that .* g'(z)
+        const int error = g.addValue("outputError", outputSize, bindings.outputError);
+        g.ops.push_back({OpType::OUTPUT_READY, {x}, {error}, 0, 0, false, layerCount - 1});
+
+        const int derivative = g.addValue("g'" + std::to_string(layerCount - 1), outputSize);
+        g.addElementwise(ElementOp::SIGMOID_DERIVATIVE, derivative, weightedSums.back());
+        g.addElementwise(ElementOp::MUL, delta, error, derivative);
+    } else {
+        const int target = g.addValue("target", outputSize, bindings.target);
+        const int error = g.addValue("error", outputSize);
+        g.addElementwise(ElementOp::SUB, error, x, target);
+        g.addCopy(error, delta);
+    }
+
+    for (int l = layerCount - 1; l >= 0; --l) {
+        const Layer &layer = *layers[l];
+        const std::string id = std::to_string(l);
+
+        // ∇b = δ (or += δ), ∇W = δ * transpose(x)
+        const int gb = g.addValue("db" + id, layer.neuronCount, layer.gradBiasesBuffer);
+        if (accumulate) g.addElementwise(ElementOp::ACCUMULATE, gb, delta);
+        else g.addCopy(delta, gb);
+
+        std::vector<int> gw = shardValues(l, &WeightShard::gradWeights, "dW");
+        for (size_t s = 0; s < gw.size(); ++s) {
+            const WeightShard &shard = layer.shards[s];
+            g.ops.push_back({
+                OpType::OUTER_PRODUCT, {delta, savedInputs[l]}, {gw[s]}, layer.neuronCount, shard.columns, accumulate,
+                l, shard.firstColumn
+            });
+        }
+        gw.push_back(gb);
+        g.ops.push_back({OpType::GRADIENTS_READY, gw, {}, 0, 0, false, l});
+
+        if (l == 0) {
+            if (bindings.inputGradient) {
+                const int inputError = g.addValue("inputError", layer.inputSize, bindings.inputGradient);
+                propagate(0, weights[0], delta, inputError);
+            }
+            break;
+        }
+
+        const Layer &previous = *layers[l - 1];
+        const std::string prevId = std::to_string(l - 1);
+        const int propagated = g.addValue("e" + prevId, previous.neuronCount);
+        propagate(l, weights[l], delta, propagated);
+
+        if (checkpointed[l]) {
+            // Layer l - 1 ends a segment whose activations were dropped after the forward pass: run it again
+            // from its checkpointed input. Its last output is the input of layer l, which was kept.
+            int start = l - 1;
+            while (!checkpointed[start]) --start;
+            int recomputed = start == 0 ? input : activations[start - 1];
+            for (int r = start; r < l; ++r) {
+                const int a = r < l - 1 ? g.addValue("a" + std::to_string(r) + "'", layers[r]->neuronCount) : -1;
+                forwardLayer(r, recomputed, a, "'");
+                recomputed = a;
+            }
+        }
+
+        const int derivative = g.addValue("g'" + prevId, previous.neuronCount);
+        g.addElementwise(ElementOp::SIGMOID_DERIVATIVE, derivative, weightedSums[l - 1]);
+
+        const int nextDelta = g.addValue("delta" + prevId, previous.neuronCount);
+        g.addElementwise(ElementOp::MUL, nextDelta, propagated, derivative);
+        delta = nextDelta;
+    }
+
+    return g;
+}
@@ -0,0 +1,118 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include <GL/glew.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class Layer;
+
+enum class OpType {
+    MATMUL, // out = W * x (out += for the shards after the first)
+    MATMUL_TRANSPOSED, // out = transpose(W) * x, into its block of columns for a shard
+    OUTER_PRODUCT, // out (+)= a * transpose(b)
+    SGD_UPDATE, // out -= lr * in
+    COPY,
+    ELEMENTWISE, // a straight-line program of ElementInstr, one invocation per element
+    GRADIENTS_READY, // no dispatch, tells the host that a layer's gradients are complete
+    OUTPUT_READY // no dispatch, the host reads the output and writes dL/d(output) before the backward pass
+};
+
+enum class ElementOp {
+    ADD,
+    SUB,
+    MUL,
+    SIGMOID,
+    SIGMOID_DERIVATIVE,
+    MOVE, // out = a
+    ACCUMULATE // out += a
+};
+
+struct ElementInstr {
+    ElementOp op;
+    int out;
+    int a;
+    int b = -1;
+};
+
+struct Value {
+    std::string name;
+    int size; // in floats
+    GLuint buffer = 0; // bound to an existing buffer (parameters, gradients, I/O); 0 = transient
+};
+
+struct Op {
+    OpType type;
+    std::vector<int> inputs{}; // value ids
+    std::vector<int> outputs{};
+    int rows = 0; // matrix ops: rows/cols of W (or of the result for the outer product)
+    int cols = 0;
+    bool accumulate = false;
+    int layer = -1;
+    int offset = 0; // weight shards: first column of the shard in x (MATMUL, OUTER_PRODUCT) or out (transposed)
+    std::vector<ElementInstr> program{}; // ELEMENTWISE only
+};
+
+// Buffers owned by the network that the graph reads from and writes to
+struct GraphBindings {
+    GLuint input = 0;
+    GLuint output = 0;
+    GLuint target = 0;
+    // If set, training also writes dL/d(input) here, for the feature layers in front of the dense stack
+    GLuint inputGradient = 0;
+    // If set, the layers end in a hidden layer whose successors run on the host: training stops at
+    // OUTPUT_READY and backpropagates the dL/d(output) found here instead of prediction - target
+    GLuint outputError = 0;
+};
+
+/**
+ * @brief Dataflow graph of one network step.
+ *
+ * Every value is written exactly once per step (except parameters and accumulated gradients,
+ * which are bound to the layers' buffers, and the products of a sharded layer, which its shards
+ * build up in place one after another), so passes can rewrite and reorder uses freely.
+ * build() reproduces the dispatch sequence of Layer::forward/backward/update one op per shader
+ * call, including its copies; GraphCompiler then optimizes it.
+ */
+class Graph {
+public:
+    enum class Mode {
+        INFERENCE, // forward pass only
+        TRAINING, // forward + backward, gradients overwritten
+        TRAINING_ACCUMULATE, // forward + backward, gradients added to the existing ones
+        UPDATE // SGD step on all parameters
+    };
+
+    std::vector<Value> values;
+    std::vector<Op> ops;
+
+    /**
+     * @param checkpoints Activation checkpoints for the training modes: layers whose input is kept from the
+     * forward pass. The activations of the other layers die with the forward pass, and every segment but
+     * the last is run forward again from its checkpoint during the backward pass, so fewer values are live
+     * at once for a few more dispatches. Empty keeps every activation.
+     */
+    static Graph build(std::span<const std::unique_ptr<Layer> > layers, const GraphBindings &bindings, Mode mode,
+                       std::span<const int> checkpoints = {});
+
+    int addValue(const std::string &name, int size, GLuint buffer = 0);
+
+    void addElementwise(ElementOp op, int out, int a, int b = -1);
+
+    void addCopy(int source, int destination);
+
+    /**
+     * @brief Recomputes inputs/outputs of an ELEMENTWISE op from its program.
+     */
+    static void updateOperands(Op &op);
+
+    [[nodiscard]] bool isTransient(const int value) const { return values[value].buffer == 0; }
+};
+
+#endif //GRAPH_H
@@ -0,0 +1,362 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#include "GraphCompiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    // Longest chain merged into one op
+    constexpr size_t MAX_FUSED_INSTRUCTIONS = 12;
+
+    GLuint groupsFor(const int count, const int localSize) {
+        return static_cast<GLuint>((count + localSize - 1) / localSize);
+    }
+
+    void replaceUses(Graph &graph, const size_t from, const int oldValue, const int newValue) {
+        for (size_t i = from; i < graph.ops.size(); ++i) {
+            Op &op = graph.ops[i];
+            std::ranges::replace(op.inputs, oldValue, newValue);
+            for (auto &instr: op.program) {
+                if (instr.a == oldValue) instr.a = newValue;
+                if (instr.b == oldValue) instr.b = newValue;
+            }
+        }
+    }
+
+    bool writtenAfter(const Graph &graph, const size_t from, const int value) {
+        for (size_t i = from; i < graph.ops.size(); ++i) {
+            if (std::ranges::find(graph.ops[i].outputs, value) != graph.ops[i].outputs.end()) return true;
+        }
+        return false;
+    }
+
+    size_t distinctValues(const std::vector<ElementInstr> &program) {
+        std::vector<int> seen;
+        for (const auto &instr: program) {
+            for (const int v: {instr.out, instr.a, instr.b}) {
+                if (v >= 0 && std::ranges::find(seen, v) == seen.end()) seen.push_back(v);
+            }
+        }
+        return seen.size();
+    }
+
+    std::string expression(const ElementOp op, const std::string &a, const std::string &b) {
+        switch (op) {
+            case ElementOp::ADD: return a + " + " + b;
+            case ElementOp::SUB: return a + " - " + b;
+            case ElementOp::MUL: return a + " * " + b;
+            case ElementOp::SIGMOID: return "sigmoid(" + a + ")";
+            case ElementOp::SIGMOID_DERIVATIVE: return "sigmoidDerivative(" + a + ")";
+            default: throw std::logic_error("Element op has no expression.");
+        }
+    }
+
+    GLint uniform(const Shader &shader, const char *name) {
+        return glGetUniformLocation(shader.ID, name);
+    }
+}
+
+KernelCache::~KernelCache() {
+    for (const auto &[source, shader]: shaders) {
+        glDeleteProgram(shader.ID);
+    }
+}
+
+const Shader &KernelCache::get(const std::string &source) {
+    auto it = shaders.find(source);
+    if (it == shaders.end()) {
+        it = shaders.emplace(source, Shader()).first;
+        it->second.loadComputeShaderSource(source);
+    }
+    return it->second;
+}
+
+CompileStats &CompileStats::operator+=(const CompileStats &other) {
+    commandsBefore += other.commandsBefore;
+    copiesEliminated += other.copiesEliminated;
+    copiesFolded += other.copiesFolded;
+    opsFused += other.opsFused;
+    storesEliminated += other.storesEliminated;
+    transientValues += other.transientValues;
+    dispatches += other.dispatches;
+    return *this;
+}
+
+void GraphCompiler::eliminateCopies(Graph &graph, CompileStats &stats) {
+    for (size_t i = 0; i < graph.ops.size();) {
+        Op &op = graph.ops[i];
+        if (op.type != OpType::COPY) {
+            ++i;
+            continue;
+        }
+
+        const int source = op.inputs.front();
+        const int destination = op.outputs.front();
+        if (graph.isTransient(destination) && !writtenAfter(graph, i + 1, source)) {
+            // Both hold the same data for the rest of the step: read the source directly
+            graph.ops.erase(graph.ops.begin() + static_cast<std::ptrdiff_t>(i));
+            replaceUses(graph, i, destination, source);
+            ++stats.copiesEliminated;
+        } else {
+            op.type = OpType::ELEMENTWISE;
+            op.program = {{ElementOp::MOVE, destination, source}};
+            Graph::updateOperands(op);
+            ++stats.copiesFolded;
+            ++i;
+        }
+    }
+}
+
+void GraphCompiler::fuseElementwise(Graph &graph, CompileStats &stats) {
+    std::vector<Op> fused;
+    fused.reserve(graph.ops.size());
+
+    for (auto &op: graph.ops) {
+        if (op.type == OpType::ELEMENTWISE && !fused.empty() && fused.back().type == OpType::ELEMENTWISE) {
+            Op &previous = fused.back();
+            const int count = graph.values[previous.outputs.front()].size;
+            if (graph.values[op.outputs.front()].size == count) {
+                std::vector<ElementInstr> program = previous.program;
+                program.insert(program.end(), op.program.begin(), op.program.end());
+                // Every element only touches its own index, so running the chain per element is exact
+                if (program.size() <= MAX_FUSED_INSTRUCTIONS && distinctValues(program) <= MAX_SLOTS) {
+                    previous.program = std::move(program);
+                    Graph::updateOperands(previous);
+                    ++stats.opsFused;
+                    continue;
+                }
+            }
+        }
+        fused.push_back(std::move(op));
+    }
+    graph.ops = std::move(fused);
+}
+
+std::vector<GLuint> GraphCompiler::planBuffers(const Graph &graph, BufferPool &pool, CompileStats &stats) {
+    const size_t valueCount = graph.values.size();
+    std::vector<int> definition(valueCount, -1);
+    std::vector<int> lastUse(valueCount, -1);
+    std::vector<bool> usedElsewhere(valueCount, false);
+
+    for (int i = 0; i < static_cast<int>(graph.ops.size()); ++i) {
+        for (const int v: graph.ops[i].outputs) {
+            if (definition[v] < 0) definition[v] = i;
+        }
+        for (const int v: graph.ops[i].inputs) {
+            lastUse[v] = std::max(lastUse[v], i);
+            if (definition[v] != i) usedElsewhere[v] = true;
+        }
+    }
+
+    struct Interval {
+        int value;
+        int start;
+        int end;
+        size_t bytes;
+    };
+    std::vector<Interval> intervals;
+    std::vector<GLuint> buffers(valueCount, 0);
+
+    for (int v = 0; v < static_cast<int>(valueCount); ++v) {
+        if (!graph.isTransient(v)) {
+            buffers[v] = graph.values[v].buffer;
+            continue;
+        }
+        if (definition[v] < 0) continue; // removed by a pass
+
+        const bool inRegisters = graph.ops[definition[v]].type == OpType::ELEMENTWISE && !usedElsewhere[v];
+        if (inRegisters) {
+            ++stats.storesEliminated;
+            continue;
+        }
+        intervals.push_back({v, definition[v], std::max(lastUse[v], definition[v]),
+                             static_cast<size_t>(graph.values[v].size) * sizeof(float)});
+    }
+    stats.transientValues += intervals.size();
+
+    // Greedy by start: take a free slot that is big enough (smallest first), else grow the largest free one
+    std::ranges::sort(intervals, [](const Interval &a, const Interval &b) { return a.start < b.start; });
+    std::vector<int> slotBusyUntil;
+    for (const auto &interval: intervals) {
+        int best = -1;
+        for (int s = 0; s < static_cast<int>(slotBusyUntil.size()); ++s) {
+            // Strictly before: an op never reads and writes the same slot
+            if (slotBusyUntil[s] >= interval.start) continue;
+            if (best < 0) {
+                best = s;
+                continue;
+            }
+            const size_t have = pool.slotBytes(s);
+            const size_t bestHave = pool.slotBytes(best);
+            const bool fits = have >= interval.bytes;
+            const bool bestFits = bestHave >= interval.bytes;
+            if ((fits && (!bestFits || have < bestHave)) || (!fits && !bestFits && have > bestHave)) {
+                best = s;
+            }
+        }
+        if (best < 0) {
+            best = static_cast<int>(slotBusyUntil.size());
+            slotBusyUntil.push_back(-1);
+        }
+        slotBusyUntil[best] = interval.end;
+        buffers[interval.value] = pool.reserve(best, interval.bytes);
+    }
+
+    return buffers;
+}
+
+Dispatch GraphCompiler::emitElementwise(const Graph &graph, const Op &op, const std::vector<GLuint> &buffers,
+                                        const std::vector<bool> &stored, KernelCache &cache) {
+    std::vector<GLuint> slots;
+    auto slotOf = [&](const int value) {
+        const GLuint buffer = buffers[value];
+        const auto it = std::ranges::find(slots, buffer);
+        if (it != slots.end()) return "S" + std::to_string(it - slots.begin()) + "[i]";
+        if (slots.size() >= MAX_SLOTS) {
+            throw std::runtime_error("Fused elementwise op uses too many buffers.");
+        }
+        slots.push_back(buffer);
+        return "S" + std::to_string(slots.size() - 1) + "[i]";
+    };
+
+    // One local per value; loads happen on first use
+    std::ostringstream body;
+    std::vector<std::string> local(graph.values.size());
+    int nextLocal = 0;
+    auto localOf = [&](const int value) {
+        if (local[value].empty()) {
+            local[value] = "r" + std::to_string(nextLocal++);
+            body << "    float " << local[value] << " = " << slotOf(value) << "; // " << graph.values[value].name << "\n";
+        }
+        return local[value];
+    };
+
+    for (const auto &instr: op.program) {
+        const std::string &name = graph.values[instr.out].name;
+        switch (instr.op) {
+            case ElementOp::MOVE:
+                local[instr.out] = localOf(instr.a);
+                break;
+            case ElementOp::ACCUMULATE:
+                body << "    " << slotOf(instr.out) << " += " << localOf(instr.a) << "; // " << name << "\n";
+                continue;
+            default: {
+                const std::string a = localOf(instr.a);
+                const std::string b = instr.b >= 0 ? localOf(instr.b) : "";
+                local[instr.out] = "r" + std::to_string(nextLocal++);
+                body << "    float " << local[instr.out] << " = " << expression(instr.op, a, b) << "; // " << name << "\n";
+                break;
+            }
+        }
+        if (stored[instr.out]) {
+            body << "    " << slotOf(instr.out) << " = " << local[instr.out] << ";\n";
+        }
+    }
+
+    std::ostringstream source;
+    source << "#version 430 core\n"
+            << "layout (local_size_x = 256, local_size_y = 1, local_size_z = 1) in;\n\n";
+    for (size_t s = 0; s < slots.size(); ++s) {
+        source << "layout(std430, binding = " << s << ") buffer Slot" << s << " { float S" << s << "[]; };\n";
+    }
+    source << "\nuniform int u_element_count;\n\n"
+            << "float sigmoid(float x) {\n    return 1.0 / (1.0 + exp(-x));\n}\n\n"
+            << "float sigmoidDerivative(float x) {\n    float s = sigmoid(x);\n    return s * (1.0 - s);\n}\n\n"
+            << "void main() {\n"
+            << "    uint i = gl_GlobalInvocationID.x;\n\n"
+            << "    if (i >= u_element_count) {\n        return;\n    }\n\n"
+            << body.str() << "}\n";
+
+    const Shader &shader = cache.get(source.str());
+    const int count = graph.values[op.outputs.front()].size;
+
+    Dispatch d;
+    d.program = shader.ID;
+    d.intUniforms = {{uniform(shader, "u_element_count"), count}};
+    for (GLuint s = 0; s < slots.size(); ++s) {
+        d.bindings.emplace_back(s, slots[s]);
+    }
+    d.groups[0] = groupsFor(count, 256);
+    return d;
+}
+
+Schedule GraphCompiler::compile(Graph graph, const GraphKernels &kernels, BufferPool &pool, CompileStats &stats) {
+    stats.commandsBefore += std::ranges::count_if(graph.ops, [](const Op &op) {
+        return op.type != OpType::GRADIENTS_READY && op.type != OpType::OUTPUT_READY;
+    });
+
+    eliminateCopies(graph, stats);
+    fuseElementwise(graph, stats);
+    const std::vector<GLuint> buffers = planBuffers(graph, pool, stats);
+    std::vector<bool> stored(buffers.size());
+    for (size_t v = 0; v < buffers.size(); ++v) stored[v] = buffers[v] != 0;
+
+    Schedule schedule;
+    for (const auto &op: graph.ops) {
+        Dispatch d;
+        switch (op.type) {
+            case OpType::MATMUL: {
+                const Shader &s = *kernels.matmul;
+                d.program = s.ID;
+                d.intUniforms = {
+                    {uniform(s, "u_A_rows"), op.rows}, {uniform(s, "u_A_cols"), op.cols}, {uniform(s, "u_B_cols"), 1},
+                    {uniform(s, "u_B_offset"), op.offset}, {uniform(s, "u_accumulate"), op.accumulate ? 1 : 0}
+                };
+                d.bindings = {{0, buffers[op.inputs[0]]}, {1, buffers[op.inputs[1]]}, {2, buffers[op.outputs[0]]}};
+                d.groups[1] = groupsFor(op.rows, 16);
+                break;
+            }
+            case OpType::MATMUL_TRANSPOSED: {
+                const Shader &s = *kernels.matmulTransposed;
+                d.program = s.ID;
+                d.intUniforms = {
+                    {uniform(s, "u_A_rows"), op.rows}, {uniform(s, "u_A_cols"), op.cols}, {uniform(s, "u_B_cols"), 1},
+                    {uniform(s, "u_C_offset"), op.offset}
+                };
+                d.bindings = {{0, buffers[op.inputs[0]]}, {1, buffers[op.inputs[1]]}, {2, buffers[op.outputs[0]]}};
+                d.groups[1] = groupsFor(op.cols, 16);
+                break;
+            }
+            case OpType::OUTER_PRODUCT: {
+                const Shader &s = *kernels.outerProduct;
+                d.program = s.ID;
+                d.intUniforms = {
+                    {uniform(s, "u_A_rows"), op.rows}, {uniform(s, "u_B_cols"), op.cols},
+                    {uniform(s, "u_B_offset"), op.offset}, {uniform(s, "u_accumulate"), op.accumulate ? 1 : 0}
+                };
+                d.bindings = {{0, buffers[op.inputs[0]]}, {1, buffers[op.inputs[1]]}, {2, buffers[op.outputs[0]]}};
+                d.groups[0] = groupsFor(op.cols, 16);
+                d.groups[1] = groupsFor(op.rows, 16);
+                break;
+            }
+            case OpType::SGD_UPDATE: {
+                const Shader &s = *kernels.sgdUpdate;
+                d.program = s.ID;
+                d.intUniforms = {{uniform(s, "u_element_count"), op.rows}};
+                d.learningRateLocation = uniform(s, "u_learning_rate");
+                d.bindings = {{0, buffers[op.outputs[0]]}, {1, buffers[op.inputs[0]]}};
+                d.groups[0] = groupsFor(op.rows, 256);
+                break;
+            }
+            case OpType::ELEMENTWISE:
+                d = emitElementwise(graph, op, buffers, stored, *kernels.generated);
+                break;
+            case OpType::GRADIENTS_READY:
+                d.gradientsReadyLayer = op.layer;
+                break;
+            case OpType::OUTPUT_READY:
+                d.outputReady = true;
+                break;
+            case OpType::COPY:
+                throw std::logic_error("Copies must be removed before emission.");
+        }
+        schedule.steps.push_back(std::move(d));
+    }
+
+    stats.dispatches += schedule.dispatchCount();
+    return schedule;
+}
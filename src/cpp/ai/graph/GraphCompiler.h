@@ -0,0 +1,91 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#ifndef GRAPHCOMPILER_H
+#define GRAPHCOMPILER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Graph.h"
+#include "Schedule.h"
+#include "../gl/Shader.h"
+
+/**
+ * @brief Programs generated for fused elementwise ops, compiled once per distinct source.
+ */
+class KernelCache {
+public:
+    KernelCache() = default;
+
+    ~KernelCache();
+
+    KernelCache(const KernelCache &) = delete;
+
+    KernelCache &operator=(const KernelCache &) = delete;
+
+    const Shader &get(const std::string &source);
+
+    [[nodiscard]] size_t size() const { return shaders.size(); }
+
+private:
+    std::unordered_map<std::string, Shader> shaders;
+};
+
+struct GraphKernels {
+    const Shader *matmul = nullptr;
+    const Shader *matmulTransposed = nullptr;
+    const Shader *outerProduct = nullptr;
+    const Shader *sgdUpdate = nullptr;
+    KernelCache *generated = nullptr; // fused elementwise chains
+};
+
+struct CompileStats {
+    size_t commandsBefore = 0; // dispatches and copies of the unoptimized graph
+    size_t copiesEliminated = 0; // destination aliased to the source
+    size_t copiesFolded = 0; // turned into a register move of an elementwise chain
+    size_t opsFused = 0; // elementwise ops merged into the previous one
+    size_t storesEliminated = 0; // intermediates that never leave registers
+    size_t transientValues = 0; // values that needed memory
+    size_t dispatches = 0;
+
+    CompileStats &operator+=(const CompileStats &other);
+};
+
+/**
+ * @brief Turns a Graph into a Schedule.
+ *
+ * Passes, in order:
+ *  1. eliminateCopies: a copy into a transient value is removed and its uses read the source
+ *     (values are written once, so both hold the same data). Copies into bound buffers (e.g. the
+ *     bias gradient) become register moves so the next pass can fold them into their producer.
+ *  2. fuseElementwise: adjacent elementwise ops over the same number of elements are merged into
+ *     one op, for which a dedicated kernel is generated: intermediates stay in registers.
+ *  3. Buffer planning: transient values that are read outside their own fused op get a pool slot
+ *     by liveness (greedy interval assignment); the others are never stored.
+ *  4. Emission: every op becomes a Dispatch with uniform locations and bindings resolved.
+ */
+class GraphCompiler {
+public:
+    static constexpr int MAX_SLOTS = 8; // GL guarantees 8 storage blocks per compute shader
+
+    static void eliminateCopies(Graph &graph, CompileStats &stats);
+
+    static void fuseElementwise(Graph &graph, CompileStats &stats);
+
+    /**
+     * @brief Runs all passes and emits the schedule. Transient buffers come from `pool`.
+     */
+    static Schedule compile(Graph graph, const GraphKernels &kernels, BufferPool &pool, CompileStats &stats);
+
+private:
+    // Per value: the buffer it lives in, 0 if it only exists in registers
+    static std::vector<GLuint> planBuffers(const Graph &graph, BufferPool &pool, CompileStats &stats);
+
+    static Dispatch emitElementwise(const Graph &graph, const Op &op, const std::vector<GLuint> &buffers,
+                                    const std::vector<bool> &stored, KernelCache &cache);
+};
+
+#endif //GRAPHCOMPILER_H
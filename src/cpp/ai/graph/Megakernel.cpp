@@ -0,0 +1,250 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "Megakernel.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "../nn/DeviceDataset.h"
+#include "../nn/Layer.h"
+
+namespace {
+    size_t parameterCountOf(const std::span<const std::unique_ptr<Layer> > layers) {
+        size_t count = 0;
+        for (const auto &layer: layers) {
+            count += static_cast<size_t>(layer->neuronCount) * (layer->inputSize + 1);
+        }
+        return count;
+    }
+
+    // One invocation per neuron (or input value) of the widest layer, in whole subgroups
+    int localSizeFor(const std::span<const std::unique_ptr<Layer> > layers) {
+        int widest = layers.front()->inputSize;
+        for (const auto &layer: layers) widest = std::max(widest, layer->neuronCount);
+        return std::clamp((widest + 31) / 32 * 32, 32, Megakernel::MAX_LOCAL_SIZE);
+    }
+}
+
+size_t Megakernel::sharedFloats(const std::span<const std::unique_ptr<Layer> > layers) {
+    // Parameters and gradients, every activation (with the input), every δ and the target
+    size_t activations = layers.front()->inputSize;
+    size_t deltas = 0;
+    for (const auto &layer: layers) {
+        activations += layer->neuronCount;
+        deltas += layer->neuronCount;
+    }
+    return 2 * parameterCountOf(layers) + activations + deltas + layers.back()->neuronCount;
+}
+
+bool Megakernel::supports(const std::span<const std::unique_ptr<Layer> > layers) {
+    if (layers.empty()) return false;
+    for (const auto &layer: layers) {
+        if (layer->isStreamed() || layer->isSharded() || layer->isSparse()) return false;
+    }
+    GLint sharedBytes = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_SHARED_MEMORY_SIZE, &sharedBytes);
+    return sharedFloats(layers) * sizeof(float) <= static_cast<size_t>(sharedBytes);
+}
+
+Megakernel::Megakernel(const std::span<const std::unique_ptr<Layer> > layers)
+    : parameterCount(parameterCountOf(layers)) {
+    if (!supports(layers)) {
+        throw std::invalid_argument("These layers do not fit a megakernel, see Megakernel::supports().");
+    }
+    source = generate(layers, localSizeFor(layers));
+    shader.loadComputeShaderSource(source);
+
+    glGenBuffers(1, &parameterBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, parameterBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, parameterCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+Megakernel::~Megakernel() {
+    glDeleteBuffers(1, &parameterBuffer);
+    glDeleteProgram(shader.ID);
+}
+
+std::string Megakernel::generate(const std::span<const std::unique_ptr<Layer> > layers, const int localSize) {
+    const size_t layerCount = layers.size();
+    const int inputSize = layers.front()->inputSize;
+    const int outputSize = layers.back()->neuronCount;
+
+    // Offsets into the parameter, activation and delta arrays; activation 0 is the input
+    std::vector<size_t> weightOffset(layerCount), biasOffset(layerCount), activationOffset(layerCount + 1),
+            deltaOffset(layerCount);
+    size_t parameters = 0, activations = inputSize, deltas = 0;
+    activationOffset[0] = 0;
+    for (size_t l = 0; l < layerCount; ++l) {
+        weightOffset[l] = parameters;
+        biasOffset[l] = parameters + static_cast<size_t>(layers[l]->neuronCount) * layers[l]->inputSize;
+        parameters = biasOffset[l] + layers[l]->neuronCount;
+        activationOffset[l + 1] = activations;
+        activations += layers[l]->neuronCount;
+        deltaOffset[l] = deltas;
+        deltas += layers[l]->neuronCount;
+    }
+
+    std::ostringstream s;
+    s << "#version 430 core\n"
+            << "layout (local_size_x = " << localSize << ", local_size_y = 1, local_size_z = 1) in;\n\n"
+            << "// Generated by Megakernel for a " << inputSize;
+    for (const auto &layer: layers) s << " -> " << layer->neuronCount;
+    s << " network. One workgroup trains u_steps mini-batches of u_batch_size samples.\n"
+            << "layout(std430, binding = 0) buffer Parameters { float parameters[]; };\n"
+            << "layout(std430, binding = 1) buffer Indices { uint indices[]; };\n"
+            << "layout(std430, binding = 2) buffer Pages { float rows[]; } pages[" << DeviceDataset::MAX_PAGES
+            << "];\n\n"
+            << "uniform uint u_position;\n"
+            << "uniform int u_steps;\n"
+            << "uniform int u_batch_size;\n"
+            << "uniform float u_learning_rate; // already divided by the batch size\n"
+            << "uniform uint u_rows_per_page;\n\n"
+            << "const uint LOCAL_SIZE = " << localSize << "u;\n"
+            << "const uint PARAMETER_COUNT = " << parameters << "u;\n"
+            << "const uint ROW_SIZE = " << inputSize + outputSize << "u;\n\n"
+            << "shared float params[" << parameters << "];\n"
+            << "shared float grads[" << parameters << "];\n"
+            << "shared float act[" << activations << "];\n"
+            << "shared float delta[" << deltas << "];\n"
+            << "shared float target[" << outputSize << "];\n\n"
+            << "float sigmoid(float x) {\n    return 1.0 / (1.0 + exp(-x));\n}\n\n"
+            << "float sampleValue(uint sampleIndex, uint column) {\n"
+            << "    uint page = sampleIndex / u_rows_per_page;\n"
+            << "    uint offset = (sampleIndex % u_rows_per_page) * ROW_SIZE + column;\n"
+            << "    switch (page) {\n";
+    // Buffer block arrays only take constant indices here, so every page gets its own case
+    for (int p = 0; p + 1 < DeviceDataset::MAX_PAGES; ++p) {
+        s << "        case " << p << "u: return pages[" << p << "].rows[offset];\n";
+    }
+    s << "        default: return pages[" << DeviceDataset::MAX_PAGES - 1 << "].rows[offset];\n"
+            << "    }\n"
+            << "}\n\n"
+            << "void main() {\n"
+            << "    uint t = gl_LocalInvocationID.x;\n\n"
+            << "    for (uint i = t; i < PARAMETER_COUNT; i += LOCAL_SIZE) {\n"
+            << "        params[i] = parameters[i];\n"
+            << "        grads[i] = 0.0;\n"
+            << "    }\n"
+            << "    barrier();\n\n"
+            << "    for (int step = 0; step < u_steps; ++step) {\n"
+            << "        for (int b = 0; b < u_batch_size; ++b) {\n"
+            << "            uint sampleIndex = indices[u_position + uint(step * u_batch_size + b)];\n"
+            << "            for (uint i = t; i < ROW_SIZE; i += LOCAL_SIZE) {\n"
+            << "                float value = sampleValue(sampleIndex, i);\n"
+            << "                if (i < " << inputSize << "u) act[i] = value;\n"
+            << "                else target[i - " << inputSize << "u] = value;\n"
+            << "            }\n"
+            << "            barrier();\n\n";
+
+    for (size_t l = 0; l < layerCount; ++l) {
+        const int in = layers[l]->inputSize;
+        const int n = layers[l]->neuronCount;
+        s << "            // Layer " << l << " forward: a = sigmoid(W * x + b)\n"
+                << "            for (uint r = t; r < " << n << "u; r += LOCAL_SIZE) {\n"
+                << "                float z = params[" << biasOffset[l] << "u + r];\n"
+                << "                for (uint c = 0u; c < " << in << "u; ++c) {\n"
+                << "                    z += params[" << weightOffset[l] << "u + r * " << in << "u + c] * act["
+                << activationOffset[l] << "u + c];\n"
+                << "                }\n"
+                << "                act[" << activationOffset[l + 1] << "u + r] = sigmoid(z);\n"
+                << "            }\n"
+                << "            barrier();\n\n";
+    }
+
+    const size_t last = layerCount - 1;
+    s << "            // Output error: prediction - target\n"
+            << "            for (uint r = t; r < " << outputSize << "u; r += LOCAL_SIZE) {\n"
+            << "                delta[" << deltaOffset[last] << "u + r] = act[" << activationOffset[last + 1]
+            << "u + r] - target[r];\n"
+            << "            }\n"
+            << "            barrier();\n\n";
+
+    for (int l = static_cast<int>(layerCount) - 2; l >= 0; --l) {
+        const int n = layers[l]->neuronCount;
+        const int next = layers[l + 1]->neuronCount;
+        s << "            // Layer " << l << " backward: delta = (transpose(W_next) * delta_next) .* a (1 - a)\n"
+                << "            for (uint r = t; r < " << n << "u; r += LOCAL_SIZE) {\n"
+                << "                float e = 0.0;\n"
+                << "                for (uint k = 0u; k < " << next << "u; ++k) {\n"
+                << "                    e += params[" << weightOffset[l + 1] << "u + k * " << n << "u + r] * delta["
+                << deltaOffset[l + 1] << "u + k];\n"
+                << "                }\n"
+                << "                float a = act[" << activationOffset[l + 1] << "u + r];\n"
+                << "                delta[" << deltaOffset[l] << "u + r] = e * a * (1.0 - a);\n"
+                << "            }\n"
+                << "            barrier();\n\n";
+    }
+
+    s << "            // Gradients, summed over the mini-batch: dW += delta * transpose(x), db += delta\n";
+    for (size_t l = 0; l < layerCount; ++l) {
+        const int in = layers[l]->inputSize;
+        const int n = layers[l]->neuronCount;
+        s << "            for (uint i = t; i < " << static_cast<size_t>(n) * in << "u; i += LOCAL_SIZE) {\n"
+                << "                grads[" << weightOffset[l] << "u + i] += delta[" << deltaOffset[l] << "u + i / "
+                << in << "u] * act[" << activationOffset[l] << "u + i % " << in << "u];\n"
+                << "            }\n"
+                << "            for (uint r = t; r < " << n << "u; r += LOCAL_SIZE) {\n"
+                << "                grads[" << biasOffset[l] << "u + r] += delta[" << deltaOffset[l] << "u + r];\n"
+                << "            }\n";
+    }
+    s << "            barrier();\n"
+            << "        }\n\n"
+            << "        for (uint i = t; i < PARAMETER_COUNT; i += LOCAL_SIZE) {\n"
+            << "            params[i] -= u_learning_rate * grads[i];\n"
+            << "            grads[i] = 0.0;\n"
+            << "        }\n"
+            << "        barrier();\n"
+            << "    }\n\n"
+            << "    for (uint i = t; i < PARAMETER_COUNT; i += LOCAL_SIZE) {\n"
+            << "        parameters[i] = params[i];\n"
+            << "    }\n"
+            << "}\n";
+    return s.str();
+}
+
+void Megakernel::copyParameters(const std::span<const std::unique_ptr<Layer> > layers, const bool toLayers) const {
+    GLintptr offset = 0;
+    for (const auto &layer: layers) {
+        const GLsizeiptr weightBytes = static_cast<GLsizeiptr>(layer->neuronCount) * layer->inputSize * sizeof(float);
+        const GLsizeiptr biasBytes = layer->neuronCount * sizeof(float);
+        for (const auto &[buffer, bytes]: {std::pair{layer->weightsBuffer, weightBytes},
+                                           std::pair{layer->biasesBuffer, biasBytes}}) {
+            glBindBuffer(GL_COPY_READ_BUFFER, toLayers ? parameterBuffer : buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, toLayers ? buffer : parameterBuffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, toLayers ? offset : 0,
+                                toLayers ? 0 : offset, bytes);
+            offset += bytes;
+        }
+    }
+}
+
+void Megakernel::train(const std::span<const std::unique_ptr<Layer> > layers, DeviceDataset &dataset,
+                       const size_t position, const int steps, const int batchSize, const float learningRate) {
+    if (steps < 1 || batchSize < 1) {
+        throw std::invalid_argument("Steps and batch size must be at least 1.");
+    }
+    if (position + static_cast<size_t>(steps) * batchSize > dataset.size()) {
+        throw std::out_of_range("The steps run past the end of the dataset.");
+    }
+
+    // The last update of the layers' buffers came from a shader
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    copyParameters(layers, false);
+
+    shader.use();
+    shader.setUInt("u_position", static_cast<GLuint>(position));
+    shader.setInt("u_steps", steps);
+    shader.setInt("u_batch_size", batchSize);
+    shader.setFloat("u_learning_rate", learningRate / static_cast<float>(batchSize));
+    shader.setUInt("u_rows_per_page", static_cast<GLuint>(dataset.getRowsPerPage()));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, parameterBuffer);
+    dataset.bindForReading(1);
+    shader.dispatch(1, 1, 1);
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    copyParameters(layers, true);
+}
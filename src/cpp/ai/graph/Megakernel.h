@@ -0,0 +1,74 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef MEGAKERNEL_H
+#define MEGAKERNEL_H
+
+#include <GL/glew.h>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../gl/Shader.h"
+
+class Layer;
+class DeviceDataset;
+
+/**
+ * @brief A compute kernel generated for one small dense network that runs many training steps in a
+ * single dispatch.
+ *
+ * A normal step issues a few dispatches per layer, each followed by a full memory barrier, which is all
+ * a 4 -> 8 -> 2 network costs. Here one workgroup loads every weight and bias into shared memory, then
+ * loops over the steps: for each sample of the mini-batch it reads the sample from the DeviceDataset,
+ * runs forward, output error, backward and gradient accumulation with workgroup barriers between the
+ * layers, and applies the SGD update after the last sample. The parameters go back to the layers'
+ * buffers once, at the end.
+ *
+ * Layer sizes are compiled into the kernel, so it must be regenerated when the architecture changes.
+ */
+class Megakernel {
+public:
+    static constexpr int MAX_LOCAL_SIZE = 256;
+
+    /**
+     * @brief Whether the layers can be trained by a megakernel: plain dense layers (not streamed, sharded
+     * or pruned) whose parameters, gradients and activations fit in shared memory together.
+     */
+    static bool supports(std::span<const std::unique_ptr<Layer> > layers);
+
+    explicit Megakernel(std::span<const std::unique_ptr<Layer> > layers);
+
+    ~Megakernel();
+
+    Megakernel(const Megakernel &) = delete;
+
+    Megakernel &operator=(const Megakernel &) = delete;
+
+    /**
+     * @brief Trains `steps` mini-batches of `batchSize` samples, taken from the dataset's current shuffle
+     * starting at `position`. Each update uses the mean gradient of its mini-batch.
+     */
+    void train(std::span<const std::unique_ptr<Layer> > layers, DeviceDataset &dataset, size_t position,
+               int steps, int batchSize, float learningRate);
+
+    [[nodiscard]] const std::string &getSource() const { return source; }
+
+private:
+    std::string source;
+    Shader shader;
+    GLuint parameterBuffer = 0; // W and b of every layer, back to back
+    size_t parameterCount = 0;
+
+    // Floats of shared memory the kernel needs for these layers
+    static size_t sharedFloats(std::span<const std::unique_ptr<Layer> > layers);
+
+    static std::string generate(std::span<const std::unique_ptr<Layer> > layers, int localSize);
+
+    // Moves W and b between the layers and parameterBuffer
+    void copyParameters(std::span<const std::unique_ptr<Layer> > layers, bool toLayers) const;
+};
+
+#endif //MEGAKERNEL_H
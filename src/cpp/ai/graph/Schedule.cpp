@@ -0,0 +1,81 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#include "Schedule.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+BufferPool::~BufferPool() {
+    glDeleteBuffers(buffers.size(), buffers.data());
+}
+
+GLuint BufferPool::reserve(const size_t slot, const size_t bytes) {
+    while (buffers.size() <= slot) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        buffers.push_back(buffer);
+        sizes.push_back(0);
+    }
+    if (sizes[slot] < bytes) {
+        // Reallocating keeps the name, so schedules compiled earlier stay valid
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[slot]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        sizes[slot] = bytes;
+    }
+    return buffers[slot];
+}
+
+size_t BufferPool::totalBytes() const {
+    return std::accumulate(sizes.begin(), sizes.end(), size_t{0});
+}
+
+void Schedule::run(const float learningRate, const std::function<void(int)> &onGradientsReady,
+                   const std::function<void()> &onOutputReady) const {
+    GLuint current = 0;
+    for (const auto &step: steps) {
+        if (step.outputReady) {
+            if (!onOutputReady) {
+                throw std::logic_error("This schedule needs the host to provide the output error.");
+            }
+            // The host reads the output back, then uploads the error
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            onOutputReady();
+            current = 0;
+            continue;
+        }
+        if (step.gradientsReadyLayer >= 0) {
+            if (onGradientsReady) {
+                // The callback usually reads the gradients back
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                onGradientsReady(step.gradientsReadyLayer);
+                current = 0; // the callback may have changed the bound program
+            }
+            continue;
+        }
+
+        if (step.program != current) {
+            glUseProgram(step.program);
+            current = step.program;
+        }
+        for (const auto &[location, value]: step.intUniforms) {
+            glUniform1i(location, value);
+        }
+        if (step.learningRateLocation >= 0) {
+            glUniform1f(step.learningRateLocation, learningRate);
+        }
+        for (const auto &[binding, buffer]: step.bindings) {
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+        }
+
+        glDispatchCompute(step.groups[0], step.groups[1], step.groups[2]);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
+
+size_t Schedule::dispatchCount() const {
+    return std::ranges::count_if(steps, [](const Dispatch &d) { return d.isDispatch(); });
+}
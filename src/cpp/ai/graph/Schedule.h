@@ -0,0 +1,75 @@
+//
+// Created by CorruptionHades on 13/10/2025.
+//
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <GL/glew.h>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Transient buffers shared by all schedules of a network.
+ * Schedules never run at the same time, so each slot is sized for the largest value planned into it.
+ */
+class BufferPool {
+public:
+    BufferPool() = default;
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /**
+     * @brief Returns the buffer of the given slot, growing it to at least `bytes`.
+     */
+    GLuint reserve(size_t slot, size_t bytes);
+
+    [[nodiscard]] size_t slotCount() const { return buffers.size(); }
+
+    [[nodiscard]] size_t slotBytes(const size_t slot) const { return sizes[slot]; }
+
+    [[nodiscard]] size_t totalBytes() const;
+
+private:
+    std::vector<GLuint> buffers;
+    std::vector<size_t> sizes;
+};
+
+// One entry of a schedule; everything is resolved at compile time
+struct Dispatch {
+    GLuint program = 0;
+    std::vector<std::pair<GLint, GLint> > intUniforms; // location, value
+    GLint learningRateLocation = -1; // SGD updates take the rate of the current run()
+    std::vector<std::pair<GLuint, GLuint> > bindings; // binding point, buffer
+    GLuint groups[3] = {1, 1, 1};
+    int gradientsReadyLayer = -1; // >= 0: host notification instead of a dispatch
+    bool outputReady = false; // host hand-off in the middle of a training step instead of a dispatch
+
+    [[nodiscard]] bool isDispatch() const { return gradientsReadyLayer < 0 && !outputReady; }
+};
+
+/**
+ * @brief A fixed list of dispatches that is replayed as-is every step.
+ */
+class Schedule {
+public:
+    std::vector<Dispatch> steps;
+
+    /**
+     * @param learningRate Used by SGD updates.
+     * @param onGradientsReady Called (on this thread) as soon as a layer's gradients have been written.
+     * @param onOutputReady Called between the forward and the backward pass of a schedule built with an
+     * outputError binding. Must write dL/d(output) into that buffer.
+     */
+    void run(float learningRate = 0.0f, const std::function<void(int)> &onGradientsReady = {},
+             const std::function<void()> &onOutputReady = {}) const;
+
+    [[nodiscard]] size_t dispatchCount() const;
+};
+
+#endif //SCHEDULE_H
@@ -0,0 +1,64 @@
+//
+// Created by CorruptionHades on 07/10/2025.
+//
+
+#include <iostream>
+#include <random>
+
+#include "serve/InferenceServer.h"
+#include "serve/LoadGenerator.h"
+#include "utils/SetupUtil.h"
+
+// Serves the min/max model (written by min_max_function_ai.cpp) and measures latency vs throughput.
+int mainServe() {
+    const std::string modelPath = "min_max_model.json";
+    constexpr bool useGl = true;
+    constexpr int engineCount = 2;
+    // One copy of the parameters for all engines, each engine only holds its activations
+    constexpr bool shareWeights = true;
+
+    if (useGl && setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    std::shared_ptr<const SharedGlModel> glModel;
+    std::shared_ptr<const CpuModel> cpuModel;
+    if (shareWeights) {
+        if (useGl) glModel = std::make_shared<const SharedGlModel>(modelPath);
+        else cpuModel = CpuModel::load(modelPath);
+    }
+
+    std::vector<std::unique_ptr<InferenceEngine> > engines;
+    for (int i = 0; i < engineCount; ++i) {
+        if (useGl && shareWeights) engines.push_back(std::make_unique<GlInferenceEngine>(glModel));
+        else if (useGl) engines.push_back(std::make_unique<GlInferenceEngine>(modelPath));
+        else if (shareWeights) engines.push_back(std::make_unique<CpuInferenceEngine>(cpuModel));
+        else engines.push_back(std::make_unique<CpuInferenceEngine>(modelPath));
+    }
+
+    InferenceServerConfig config;
+    config.maxBatchSize = 64;
+    config.maxBatchDelay = std::chrono::microseconds(1000);
+
+    {
+        InferenceServer server(std::move(engines), config);
+
+        auto makeInput = [](const size_t i) {
+            std::mt19937 gen(static_cast<unsigned>(i));
+            std::uniform_real_distribution dis(0.0f, 100.0f);
+            return std::vector{dis(gen), dis(gen)};
+        };
+
+        std::cout << "--- Load sweep (" << engineCount << (useGl ? " GL" : " CPU") << " engines) ---" << std::endl;
+        LoadGenerator::sweep(server, makeInput, {1000, 5000, 10000, 20000, 50000},
+                             std::chrono::milliseconds(2000), std::cout);
+
+        server.queueLatency().print(std::cout, "queue");
+        server.endToEndLatency().print(std::cout, "end2end");
+    }
+
+    glModel.reset(); // the engines are gone, its context goes before GLFW shuts down
+    if (useGl) cleanupOpenGLWindow();
+    return 0;
+}
@@ -0,0 +1,83 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "nn/DeviceDataset.h"
+#include "nn/NeuralNetwork.h"
+#include "utils/SetupUtil.h"
+
+// Trains the 4 -> 8 -> 2 network of main_rand_training one step at a time and with the megakernel,
+// and compares the time per step.
+int mainMegakernelBenchmark() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int SAMPLES = 4096;
+    constexpr int STEPS_PER_DISPATCH = 1024;
+    constexpr int EPOCHS = 4;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution dis(0.0f, 1.0f);
+    TrainingData data;
+    for (int i = 0; i < SAMPLES; ++i) {
+        std::vector<float> input(4);
+        for (auto &x: input) x = dis(gen);
+        // Which half holds more
+        const bool left = input[0] + input[1] > input[2] + input[3];
+        data.inputs.push_back(input);
+        data.targets.push_back({left ? 1.0f : 0.0f, left ? 0.0f : 1.0f});
+    }
+    DeviceDataset dataset(data);
+
+    NeuralNetwork stepwise;
+    stepwise.addLayer(4, 8);
+    stepwise.addLayer(2);
+    NeuralNetwork fused;
+    fused.addLayer(4, 8);
+    fused.addLayer(2);
+    for (size_t l = 0; l < stepwise.getLayerCount(); ++l) {
+        std::vector<float> weights, biases;
+        stepwise.getLayer(l).downloadParameters(weights, biases);
+        fused.getLayer(l).uploadParameters(weights, biases);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto microsPerStep = [&](auto &&epoch) {
+        const auto start = Clock::now();
+        for (int e = 0; e < EPOCHS; ++e) {
+            dataset.shuffle(e);
+            epoch();
+        }
+        glFinish();
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / (EPOCHS * SAMPLES);
+    };
+    const double stepwiseStep = microsPerStep([&] {
+        for (size_t i = 0; i < dataset.size(); ++i) stepwise.train(dataset, i);
+    });
+    const double fusedStep = microsPerStep([&] {
+        for (size_t i = 0; i < dataset.size(); i += STEPS_PER_DISPATCH) fused.trainFused(dataset, i, STEPS_PER_DISPATCH);
+    });
+
+    // Both took the same steps in the same order
+    float maxDiff = 0.0f;
+    for (int i = 0; i < SAMPLES; i += 64) {
+        const auto a = stepwise.predict(data.inputs[i]);
+        const auto b = fused.predict(data.inputs[i]);
+        for (size_t o = 0; o < a.size(); ++o) maxDiff = std::max(maxDiff, std::abs(a[o] - b[o]));
+    }
+
+    std::cout << "Step by step: " << stepwiseStep << " us/step" << std::endl;
+    std::cout << "Megakernel:   " << fusedStep << " us/step (" << stepwiseStep / fusedStep << "x, "
+            << STEPS_PER_DISPATCH << " steps per dispatch), max output difference " << maxDiff << std::endl;
+
+    cleanupOpenGLWindow();
+    return 0;
+}
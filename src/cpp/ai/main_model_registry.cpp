@@ -0,0 +1,70 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include <iostream>
+#include <random>
+
+#include "nn/NeuralNetwork.h"
+#include "serve/ModelRegistry.h"
+#include "utils/SetupUtil.h"
+
+// Serves requests for many small models with room on the device for only a few of them. Requests follow
+// a skewed distribution, and the model of the next request is prefetched while the current one runs.
+int mainModelRegistry() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int MODELS = 16;
+    constexpr int REQUESTS = 2000;
+    const std::vector<int> sizes = {64, 256, 10};
+
+    for (int m = 0; m < MODELS; ++m) {
+        NeuralNetwork nn;
+        nn.setWeightInit({WeightInitScheme::XAVIER, static_cast<uint64_t>(m)});
+        nn.addLayer(sizes[0], sizes[1]);
+        nn.addLayer(sizes[2]);
+        nn.saveToFile("registry_model_" + std::to_string(m) + ".json");
+    }
+
+    {
+        ModelRegistryConfig config;
+        config.deviceBudgetBytes = 4 * ModelRegistry::estimateDeviceBytes(
+                                       *CpuModel::load("registry_model_0.json"));
+        ModelRegistry registry(config);
+        for (int m = 0; m < MODELS; ++m) {
+            registry.add("model" + std::to_string(m), "registry_model_" + std::to_string(m) + ".json");
+        }
+
+        // Model m is requested with probability ~ 1 / (m + 1)
+        std::vector<double> weights(MODELS);
+        for (int m = 0; m < MODELS; ++m) weights[m] = 1.0 / (m + 1);
+        std::mt19937 gen(42);
+        std::discrete_distribution<int> pick(weights.begin(), weights.end());
+        std::uniform_real_distribution dis(0.0f, 1.0f);
+
+        std::vector<float> input(sizes[0]);
+        int next = pick(gen);
+        for (int i = 0; i < REQUESTS; ++i) {
+            const int current = next;
+            next = pick(gen);
+            registry.prefetch("model" + std::to_string(next));
+
+            for (float &x: input) x = dis(gen);
+            registry.acquire("model" + std::to_string(current))->predict(input);
+        }
+
+        const auto stats = registry.stats();
+        std::cout << "Hits: " << stats.hits << ", misses: " << stats.misses << " (hit rate "
+                << static_cast<double>(stats.hits) / REQUESTS << ")" << std::endl;
+        std::cout << "Disk loads: " << stats.diskLoads << ", prefetches: " << stats.prefetches << ", evictions: "
+                << stats.evictions << std::endl;
+        std::cout << "Resident: " << stats.residentModels << " models, " << stats.deviceBytes << " of "
+                << config.deviceBudgetBytes << " device bytes, " << stats.hostBytes << " host bytes" << std::endl;
+    }
+
+    cleanupOpenGLWindow();
+    return 0;
+}
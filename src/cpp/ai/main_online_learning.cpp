@@ -0,0 +1,73 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+
+#include "serve/InferenceServer.h"
+#include "serve/LoadGenerator.h"
+#include "serve/OnlineModel.h"
+#include "utils/SetupUtil.h"
+
+// Serves the min/max model (written by min_max_function_ai.cpp) while a trainer thread keeps training it
+// on fresh samples and publishes a new version every few steps.
+int mainOnlineLearning() {
+    const std::string modelPath = "min_max_model.json";
+    constexpr int engineCount = 2;
+    constexpr int publishEvery = 50;
+
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    auto model = std::make_shared<OnlineModel>(modelPath);
+    std::vector<std::unique_ptr<InferenceEngine> > engines;
+    for (int i = 0; i < engineCount; ++i) {
+        engines.push_back(std::make_unique<GlInferenceEngine>(model));
+    }
+
+    {
+        InferenceServer server(std::move(engines));
+
+        std::atomic<bool> stop{false};
+        std::thread trainer([&model, &stop] {
+            model->attachTrainer();
+            std::mt19937 gen(1);
+            std::uniform_int_distribution dis(0, 99);
+            for (int step = 1; !stop.load(std::memory_order_relaxed); ++step) {
+                const auto a = static_cast<float>(dis(gen));
+                const auto b = static_cast<float>(dis(gen));
+                model->train({a, b}, {a >= b ? 1.0f : 0.0f, b >= a ? 1.0f : 0.0f});
+                if (step % publishEvery == 0) model->publish();
+            }
+            model->detachTrainer();
+        });
+
+        auto makeInput = [](const size_t i) {
+            std::mt19937 gen(static_cast<unsigned>(i));
+            std::uniform_real_distribution dis(0.0f, 100.0f);
+            return std::vector{dis(gen), dis(gen)};
+        };
+        model->resetStats();
+        const auto result = LoadGenerator::run(server, makeInput, 5000, std::chrono::milliseconds(3000));
+        stop.store(true, std::memory_order_relaxed);
+        trainer.join();
+
+        const auto stats = model->stats();
+        std::cout << "Served " << result.achievedRps << " req/s (p99 " << result.p99Micros << " us) while training "
+                << stats.trainingSteps << " steps" << std::endl;
+        std::cout << "Published " << stats.publishes << " versions (" << stats.skippedPublishes
+                << " skipped), staleness mean " << stats.meanStalenessSteps << " / max " << stats.maxStalenessSteps
+                << " steps" << std::endl;
+        model->publishLatency().print(std::cout, "publish");
+        model->swapLatency().print(std::cout, "swap");
+    }
+
+    model.reset(); // the engines are gone, its context goes before GLFW shuts down
+    cleanupOpenGLWindow();
+    return 0;
+}
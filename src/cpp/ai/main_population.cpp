@@ -0,0 +1,96 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "nn/NeuralNetwork.h"
+#include "nn/PopulationTrainer.h"
+#include "utils/SetupUtil.h"
+
+// Sweeps the learning rate of the min/max network (min_max_function_ai.cpp) with a population and with
+// one network per learning rate, and compares the wall-clock time. Saves the best member.
+int mainPopulationSweep() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int MEMBERS = 16;
+    constexpr int SAMPLES = 500;
+    constexpr int EPOCHS = 10;
+    const std::vector<int> sizes = {2, 2};
+
+    // [a, b] -> [a >= b, b >= a], scaled to [0, 1]
+    std::mt19937 gen(7);
+    std::uniform_real_distribution dis(0.0f, 1.0f);
+    std::vector<std::vector<float> > inputs, targets;
+    for (int i = 0; i < SAMPLES; ++i) {
+        const float a = dis(gen), b = dis(gen);
+        inputs.push_back({a, b});
+        targets.push_back({a >= b ? 1.0f : 0.0f, b >= a ? 1.0f : 0.0f});
+    }
+
+    // Learning rates from 0.01 to 1, log-spaced, all members start from the same weights
+    std::vector<float> learningRates(MEMBERS);
+    for (int m = 0; m < MEMBERS; ++m) {
+        learningRates[m] = 0.01f * std::pow(100.0f, static_cast<float>(m) / (MEMBERS - 1));
+    }
+    const std::vector<uint64_t> seeds(MEMBERS, 1234);
+
+    PopulationTrainer population(sizes, seeds);
+    for (int m = 0; m < MEMBERS; ++m) population.setLearningRate(m, learningRates[m]);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int epoch = 0; epoch < EPOCHS; ++epoch) {
+        for (int i = 0; i < SAMPLES; ++i) population.train(inputs[i], targets[i]);
+    }
+    glFinish();
+    const double populationSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<NeuralNetwork> > networks;
+    for (int m = 0; m < MEMBERS; ++m) {
+        auto nn = std::make_unique<NeuralNetwork>();
+        nn->setWeightInit({WeightInitScheme::UNIFORM, seeds[m]});
+        nn->learningRate = learningRates[m];
+        nn->addLayer(sizes[0], sizes[1]);
+        for (int epoch = 0; epoch < EPOCHS; ++epoch) {
+            for (int i = 0; i < SAMPLES; ++i) nn->train(inputs[i], targets[i]);
+        }
+        networks.push_back(std::move(nn));
+    }
+    glFinish();
+    const double separateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Mean squared error of every member, and how far it is from its stand-alone twin
+    std::vector<double> loss(MEMBERS, 0.0);
+    float maxDiff = 0.0f;
+    for (int i = 0; i < SAMPLES; ++i) {
+        const auto outputs = population.predict(inputs[i]);
+        for (int m = 0; m < MEMBERS; ++m) {
+            const auto twin = networks[m]->predict(inputs[i]);
+            for (int o = 0; o < sizes.back(); ++o) {
+                const float output = outputs[m * sizes.back() + o];
+                loss[m] += (output - targets[i][o]) * (output - targets[i][o]) / SAMPLES;
+                maxDiff = std::max(maxDiff, std::abs(output - twin[o]));
+            }
+        }
+    }
+    for (int m = 0; m < MEMBERS; ++m) {
+        std::cout << "lr " << learningRates[m] << ": loss " << loss[m] << std::endl;
+    }
+
+    const int best = static_cast<int>(std::ranges::min_element(loss) - loss.begin());
+    population.saveMember(best, "population_best.json");
+    std::cout << "Best learning rate: " << learningRates[best] << std::endl;
+    std::cout << "Population: " << populationSeconds << " s, one network at a time: " << separateSeconds << " s ("
+            << separateSeconds / populationSeconds << "x), max difference " << maxDiff << std::endl;
+
+    cleanupOpenGLWindow();
+    return 0;
+}
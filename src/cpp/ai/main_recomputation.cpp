@@ -0,0 +1,77 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "graph/ExecutionPlan.h"
+#include "nn/Layer.h"
+#include "nn/NeuralNetwork.h"
+#include "utils/SetupUtil.h"
+
+// Trains a deep, wide network with every activation kept and with activation checkpoints every
+// sqrt(depth) layers, from the same weights, and reports activation memory and time per step.
+int mainRecomputationReport() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int DEPTH = 16;
+    constexpr int WIDTH = 512;
+    constexpr int STEPS = 50;
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution dis(0.0f, 1.0f);
+    std::vector<std::vector<float> > inputs, targets;
+    for (int i = 0; i < STEPS; ++i) {
+        std::vector<float> input(WIDTH), target(WIDTH);
+        for (auto &x: input) x = dis(gen);
+        for (auto &y: target) y = dis(gen);
+        inputs.push_back(std::move(input));
+        targets.push_back(std::move(target));
+    }
+
+    const int interval = static_cast<int>(std::round(std::sqrt(DEPTH)));
+    std::vector<int> checkpoints;
+    for (int l = interval; l < DEPTH; l += interval) checkpoints.push_back(l);
+
+    std::vector<std::unique_ptr<NeuralNetwork> > networks;
+    for (const bool recompute: {false, true}) {
+        auto nn = std::make_unique<NeuralNetwork>();
+        nn->setWeightInit({WeightInitScheme::XAVIER, 11});
+        nn->addLayer(WIDTH, WIDTH);
+        for (int l = 1; l < DEPTH; ++l) nn->addLayer(WIDTH);
+        if (recompute) nn->setActivationCheckpoints(checkpoints);
+
+        nn->train(inputs[0], targets[0]); // compiles the plan
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 1; i < STEPS; ++i) nn->train(inputs[i], targets[i]);
+        glFinish();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const ExecutionPlan &plan = nn->getExecutionPlan();
+        std::cout << (recompute ? "Checkpoints every " + std::to_string(interval) + " layers" : "All activations kept")
+                << ": " << plan.activationBytes() / 1024.0 << " KB of activations, " << plan.training.dispatchCount()
+                << " dispatches and " << seconds / (STEPS - 1) * 1e3 << " ms per step" << std::endl;
+        plan.printSummary(std::cout);
+        networks.push_back(std::move(nn));
+    }
+
+    // Recomputation repeats the same dispatches, so both runs end with the same weights
+    float maxDiff = 0.0f;
+    for (int l = 0; l < DEPTH; ++l) {
+        std::vector<float> w0, b0, w1, b1;
+        networks[0]->getLayer(l).downloadParameters(w0, b0);
+        networks[1]->getLayer(l).downloadParameters(w1, b1);
+        for (size_t i = 0; i < w0.size(); ++i) maxDiff = std::max(maxDiff, std::abs(w0[i] - w1[i]));
+    }
+    std::cout << "Max weight difference: " << maxDiff << std::endl;
+
+    networks.clear();
+    cleanupOpenGLWindow();
+    return 0;
+}
@@ -0,0 +1,89 @@
+//
+// Created by CorruptionHades on 15/10/2025.
+//
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "nn/NeuralNetwork.h"
+#include "nn/StaticNetwork.h"
+#include "utils/SetupUtil.h"
+
+// Trains the 2 -> 2 min/max model on the GPU and with StaticNetwork and compares the time per step.
+int mainStaticBenchmark() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int SAMPLES = 500;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution dis(0, 99);
+    std::vector<std::vector<float> > inputs;
+    std::vector<std::vector<float> > targets;
+    for (int i = 0; i < SAMPLES; ++i) {
+        const auto a = static_cast<float>(dis(gen));
+        const auto b = static_cast<float>(dis(gen));
+        inputs.push_back({a, b});
+        targets.push_back({a >= b ? 1.0f : 0.0f, b >= a ? 1.0f : 0.0f});
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto microsPerStep = [](const Clock::time_point start, const Clock::time_point end, const int steps) {
+        return std::chrono::duration<double, std::micro>(end - start).count() / steps;
+    };
+
+    // GL path
+    constexpr int GL_EPOCHS = 5;
+    NeuralNetwork nn;
+    nn.addLayer(2, 2);
+    auto start = Clock::now();
+    for (int epoch = 0; epoch < GL_EPOCHS; ++epoch) {
+        for (int i = 0; i < SAMPLES; ++i) {
+            nn.train(inputs[i], targets[i]);
+        }
+    }
+    glFinish();
+    const double glStep = microsPerStep(start, Clock::now(), GL_EPOCHS * SAMPLES);
+
+    // Static path, same data as fixed-size arrays
+    constexpr int STATIC_EPOCHS = 2000;
+    using MinMaxNetwork = StaticNetwork<2, 2>;
+    std::vector<MinMaxNetwork::Input> staticInputs(SAMPLES);
+    std::vector<MinMaxNetwork::Output> staticTargets(SAMPLES);
+    for (int i = 0; i < SAMPLES; ++i) {
+        staticInputs[i] = {inputs[i][0], inputs[i][1]};
+        staticTargets[i] = {targets[i][0], targets[i][1]};
+    }
+
+    MinMaxNetwork staticNn;
+    start = Clock::now();
+    for (int epoch = 0; epoch < STATIC_EPOCHS; ++epoch) {
+        for (int i = 0; i < SAMPLES; ++i) {
+            staticNn.train(staticInputs[i], staticTargets[i]);
+        }
+    }
+    const double staticStep = microsPerStep(start, Clock::now(), STATIC_EPOCHS * SAMPLES);
+
+    int correct = 0;
+    for (int i = 0; i < SAMPLES; ++i) {
+        const auto &output = staticNn.predict(staticInputs[i]);
+        correct += (output[0] > 0.5f) == (staticTargets[i][0] > 0.5f);
+    }
+
+    std::cout << "GL:     " << glStep << " us/step" << std::endl;
+    std::cout << "Static: " << staticStep * 1000.0 << " ns/step (" << glStep / staticStep << "x faster), "
+            << correct << "/" << SAMPLES << " correct" << std::endl;
+
+    // Same file format both ways
+    staticNn.saveToFile("min_max_static.json");
+    const auto reloaded = NeuralNetwork::loadFromFile("min_max_static.json");
+    const auto glOutput = reloaded->predict(inputs[0]);
+    const auto &staticOutput = staticNn.predict(staticInputs[0]);
+    std::cout << "Reloaded on the GPU: [" << glOutput[0] << ", " << glOutput[1] << "] vs static ["
+            << staticOutput[0] << ", " << staticOutput[1] << "]" << std::endl;
+
+    cleanupOpenGLWindow();
+    return 0;
+}
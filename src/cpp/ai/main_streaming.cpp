@@ -0,0 +1,92 @@
+//
+// Created by CorruptionHades on 17/10/2025.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "nn/NeuralNetwork.h"
+#include "utils/SetupUtil.h"
+
+// Trains the same 4096 -> 2048 -> 10 model with the first layer in device memory and streamed from a
+// memory-mapped file, and compares the time per step.
+int mainStreamingBenchmark() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int INPUT = 4096;
+    constexpr int HIDDEN = 2048;
+    constexpr int OUTPUT = 10;
+    constexpr int SAMPLES = 32;
+    constexpr int EPOCHS = 4;
+    const std::string weightFile = "streamed_weights.bin";
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution dis(0.0f, 1.0f);
+    std::vector<std::vector<float> > inputs(SAMPLES, std::vector<float>(INPUT));
+    std::vector<std::vector<float> > targets(SAMPLES, std::vector<float>(OUTPUT, 0.0f));
+    for (int i = 0; i < SAMPLES; ++i) {
+        for (auto &x: inputs[i]) x = dis(gen);
+        targets[i][i % OUTPUT] = 1.0f;
+    }
+
+    NeuralNetwork inMemory;
+    inMemory.addLayer(INPUT, HIDDEN);
+    inMemory.addLayer(OUTPUT);
+
+    // 8 MiB tiles, so W takes several tiles and uploads overlap with compute
+    NeuralNetwork streamed;
+    Layer::setMaxShardBytes(8u << 20);
+    streamed.addStreamedLayer(INPUT, HIDDEN, weightFile);
+    Layer::setMaxShardBytes(0);
+    streamed.addLayer(OUTPUT);
+
+    // Same starting point for both
+    for (size_t l = 0; l < inMemory.getLayerCount(); ++l) {
+        std::vector<float> weights, biases;
+        inMemory.getLayer(l).downloadParameters(weights, biases);
+        streamed.getLayer(l).uploadParameters(weights, biases);
+    }
+
+    // Compared before training: with 4096 inputs per neuron, rounding differences grow quickly once both train
+    float maxDiff = 0.0f;
+    for (int i = 0; i < SAMPLES; ++i) {
+        const auto a = inMemory.predict(inputs[i]);
+        const auto b = streamed.predict(inputs[i]);
+        for (int o = 0; o < OUTPUT; ++o) maxDiff = std::max(maxDiff, std::abs(a[o] - b[o]));
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto microsPerStep = [&](NeuralNetwork &nn) {
+        const auto start = Clock::now();
+        for (int epoch = 0; epoch < EPOCHS; ++epoch) {
+            for (int i = 0; i < SAMPLES; ++i) {
+                nn.train(inputs[i], targets[i]);
+            }
+        }
+        glFinish();
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / (EPOCHS * SAMPLES);
+    };
+    const double inMemoryStep = microsPerStep(inMemory);
+    const double streamedStep = microsPerStep(streamed);
+
+    // Per step, W goes to the device for the forward pass and ∇W comes back (the first layer needs no W^T δ)
+    const auto &layer = streamed.getLayer(0);
+    const double matrixBytes = static_cast<double>(INPUT) * HIDDEN * sizeof(float);
+    auto gigabytesPerSecond = [&](const double micros) { return 2.0 * matrixBytes / (micros * 1e3); };
+
+    std::cout << "W: " << matrixBytes / (1 << 20) << " MiB, streamed in " << layer.shards.size() << " tiles"
+            << std::endl;
+    std::cout << "In memory: " << inMemoryStep << " us/step (" << gigabytesPerSecond(inMemoryStep) << " GB/s)"
+            << std::endl;
+    std::cout << "Streamed:  " << streamedStep << " us/step (" << gigabytesPerSecond(streamedStep) << " GB/s, "
+            << inMemoryStep / streamedStep << "x), max output difference " << maxDiff << std::endl;
+
+    cleanupOpenGLWindow();
+    return 0;
+}
@@ -2,81 +2,244 @@
 #include <vector>
 #include <iomanip>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
 #include <numeric>
 #include <random>
 
+#include "graph/ExecutionPlan.h"
+#include "nn/Checkpointer.h"
+#include "nn/DeviceDataset.h"
+#include "nn/GpuMetrics.h"
 #include "nn/NeuralNetwork.h"
+#include "nn/PlacementPlanner.h"
+#include "nn/Pruner.h"
+#include "serve/InferenceEngine.h"
 #include "utils/DatasetLoader.h"
+#include "utils/ImageDatasetSource.h"
+#include "utils/Profiler.h"
 #include "utils/SetupUtil.h"
 
 int mainTrain() {
     setupOpenGLWindow();
 
     // --- 1. Network Setup ---
-    constexpr int INPUT_SIZE = 450 * 450;
+    constexpr int IMAGE_SIZE = 450; // grayscale, IMAGE_SIZE x IMAGE_SIZE
+    constexpr int INPUT_SIZE = IMAGE_SIZE * IMAGE_SIZE;
     constexpr int HIDDEN_SIZE = 128;
     constexpr int OUTPUT_SIZE = 1;
     constexpr int epochs = 10;
-
-    NeuralNetwork nn;
-    nn.learningRate = 0.01;
-    nn.addLayer(INPUT_SIZE, HIDDEN_SIZE);
-    nn.addLayer(OUTPUT_SIZE);
-    std::cout << "Created a " << INPUT_SIZE << " -> " << HIDDEN_SIZE << " -> " << OUTPUT_SIZE << " network." << std::endl;
+    constexpr uint64_t CHECKPOINT_INTERVAL = 2000; // steps
+    const std::string checkpointPath = "checkpoint.glnc";
+    // Optional prune-and-finetune: the dense layers reach 90% sparsity at epoch 6, the last epochs fine-tune
+    constexpr bool PRUNE = false;
+    constexpr PruneSchedule pruning{0.9f, 2, 6};
+    // Decode the image folders directly instead of reading the exported text files
+    constexpr bool FROM_IMAGES = false;
+    // Random shifts, flips, crops and noise on the GPU against overfitting
+    constexpr bool AUGMENT = false;
+
+    // Pick up where an interrupted run left off
+    TrainingProgress progress;
+    std::unique_ptr<NeuralNetwork> nn;
+    if (std::filesystem::exists(checkpointPath)) {
+        nn = Checkpointer::load(checkpointPath, progress);
+        std::cout << "Resuming from " << checkpointPath << " at epoch " << progress.epoch
+                  << ", step " << progress.step << "." << std::endl;
+    } else {
+        nn = std::make_unique<NeuralNetwork>();
+        nn->learningRate = 0.01;
+        // Convolutions shrink the image to 16 x 28 x 28 features before the dense layers
+        nn->setInputShape(1, IMAGE_SIZE, IMAGE_SIZE);
+        nn->addConv2D(8, 5, 2, 2); // 8 x 225 x 225
+        nn->addPool(PoolType::MAX, 2); // 8 x 112 x 112
+        nn->addConv2D(16, 3, 1, 1); // 16 x 112 x 112
+        nn->addPool(PoolType::MAX, 4); // 16 x 28 x 28
+        nn->addLayer(HIDDEN_SIZE);
+        nn->addLayer(OUTPUT_SIZE);
+        progress.seed = std::random_device{}();
+        std::cout << "Created a 1x" << IMAGE_SIZE << "x" << IMAGE_SIZE << " -> conv/pool -> "
+                  << nn->getLayerSizes().front() << " -> " << HIDDEN_SIZE << " -> " << OUTPUT_SIZE << " network."
+                  << std::endl;
+    }
+    // Small tail layers (128 -> 1) are cheaper on the CPU than a round of dispatches and barriers
+    Profiler::global().setEnabled(true);
+    PlacementPlanner::optimize(*nn);
+    if (nn->getFirstCpuLayer() > 0) nn->getExecutionPlan().printSummary(std::cout);
+
+    if (AUGMENT) {
+        AugmentationConfig augmentation;
+        augmentation.maxShift = 16;
+        augmentation.flipHorizontal = true;
+        augmentation.minCropScale = 0.85f;
+        augmentation.noiseStddev = 0.05f;
+        augmentation.seed = progress.seed;
+        nn->setAugmentation(augmentation);
+        // Steps count from the start of the run, a resumed run continues the same sequence
+        nn->setAugmentationStep(progress.step);
+    }
 
     // --- 2. Load Dataset ---
-    TrainingData data = DatasetLoader::load("H:/Dart/LearnAI/src/fromscratch/img_class/datasets/dataset_players.txt",
+    std::unique_ptr<ImageDatasetSource> images;
+    SampleMatrix samples;
+    if (FROM_IMAGES) {
+        ImageDatasetConfig imageConfig;
+        imageConfig.width = imageConfig.height = IMAGE_SIZE;
+        imageConfig.cachePath = "images.glni";
+        images = std::make_unique<ImageDatasetSource>("H:/Dart/LearnAI/src/fromscratch/img_class/datasets/players",
+                                                      "H:/Dart/LearnAI/src/fromscratch/img_class/datasets/not_players",
+                                                      imageConfig);
+    } else {
+        samples = DatasetLoader::loadMatrix("H:/Dart/LearnAI/src/fromscratch/img_class/datasets/dataset_players.txt",
                                             "H:/Dart/LearnAI/src/fromscratch/img_class/datasets/dataset_not_players.txt",
                                             INPUT_SIZE);
+    }
+    const size_t sampleCount = images ? images->size() : samples.rows;
 
     // --- 3. Training Loop ---
-    std::cout << "\n--- Starting Training for " << epochs << " epochs on " << data.inputs.size() << " samples ---" << std::endl;
+    std::cout << "\n--- Starting Training for " << epochs << " epochs on " << sampleCount << " samples ---" << std::endl;
+
+    // Keep the whole dataset on the GPU if it fits; shuffling and sample gathering then happen
+    // on the device and the host only sends a seed per epoch.
+    std::unique_ptr<DeviceDataset> deviceData;
+    TrainingData data;
+    if (DeviceDataset::fits(sampleCount, INPUT_SIZE, OUTPUT_SIZE)) {
+        if (images) samples = images->loadAll();
+        deviceData = std::make_unique<DeviceDataset>(samples);
+    } else {
+        std::cout << "Dataset does not fit on the device, streaming samples from the host." << std::endl;
+        if (!images) data = samples.toTrainingData();
+    }
+    samples = {}; // the device or `data` holds the samples now
 
     // Create an index vector to shuffle data without copying it
-    std::vector<size_t> indices(data.inputs.size());
+    std::vector<size_t> indices(sampleCount);
     std::iota(indices.begin(), indices.end(), 0);
 
-    for (int epoch = 0; epoch < epochs; ++epoch) {
-        std::ranges::shuffle(indices, std::mt19937{std::random_device{}()});
+    // Validation metrics are reduced on the GPU and read back a round later, so an epoch
+    // costs one tiny readback instead of a stall per sample.
+    GpuMetrics metrics;
+    auto printMetrics = [&](const MetricsResult &m) {
+        std::cout << "Epoch " << std::setw(2) << m.tag << "/" << epochs
+                  << " - Accuracy: " << std::fixed << std::setprecision(2) << m.accuracy() * 100.0 << "%"
+                  << " - Loss: " << std::setprecision(4) << m.meanLoss()
+                  << " - TP/FP/TN/FN: " << m.truePositives << "/" << m.falsePositives << "/"
+                  << m.trueNegatives << "/" << m.falseNegatives << std::endl;
+    };
+
+    // Checkpoints are copied on the GPU and written by a background thread, so taking one
+    // costs the training loop a few GPU commands.
+    Checkpointer checkpointer(checkpointPath);
+    auto afterStep = [&] {
+        ++progress.step;
+        if (progress.step % CHECKPOINT_INTERVAL == 0) {
+            checkpointer.snapshot(*nn, progress);
+        }
+        checkpointer.poll();
+    };
 
+    for (int epoch = progress.epoch; epoch < epochs; ++epoch) {
         auto epoch_start = std::chrono::high_resolution_clock::now();
-        int correctPredictions = 0;
+        progress.epoch = epoch;
+
+        if (PRUNE && pruning.prunesAt(epoch)) {
+            const auto sparsity = Pruner::pruneByMagnitude(*nn, pruning.sparsityAt(epoch));
+            std::cout << "Pruned to " << pruning.sparsityAt(epoch) * 100.0f << "% sparsity:" << std::endl
+                    << Pruner::describe(sparsity, nn->getLayerSizes());
+            // Sparse layers cost less on both devices, the best split may have moved
+            PlacementPlanner::optimize(*nn);
+        }
+
+        // Every epoch's order derives from the run's seed, so a resumed run sees the same samples
+        std::mt19937_64 epochGen{progress.seed + static_cast<uint64_t>(epoch)};
+        const uint64_t epochStart = static_cast<uint64_t>(epoch) * sampleCount;
+        const size_t first = progress.step > epochStart ? progress.step - epochStart : 0;
 
-        for (size_t i = 0; i < data.inputs.size(); ++i) {
-            // Use the shuffled index to get the training sample
-            const size_t sample_idx = indices[i];
-            nn.train(data.inputs[sample_idx], data.targets[sample_idx]);
+        if (deviceData) {
+            deviceData->shuffle(epochGen());
+            for (size_t i = first; i < deviceData->size(); ++i) {
+                nn->train(*deviceData, i);
+                afterStep();
+            }
+        } else if (images) {
+            // Decode threads stay up to prefetchSamples ahead of the network
+            images->start(epochGen(), first);
+            std::vector<float> input, target;
+            while (images->next(input, target)) {
+                nn->train(input, target);
+                afterStep();
+            }
+        } else {
+            std::iota(indices.begin(), indices.end(), 0);
+            std::ranges::shuffle(indices, epochGen);
+            for (size_t i = first; i < sampleCount; ++i) {
+                // Use the shuffled index to get the training sample
+                const size_t sample_idx = indices[i];
+                nn->train(data.inputs[sample_idx], data.targets[sample_idx]);
+                afterStep();
+            }
         }
+        progress.epoch = epoch + 1;
+        checkpointer.snapshot(*nn, progress);
 
         // --- Validation and Metrics after each epoch ---
-        for (size_t i = 0; i < data.inputs.size(); ++i) {
-            std::vector<float> prediction = nn.predict(data.inputs[i]);
-            const int predictedLabel = (prediction[0] > 0.5f) ? 1 : 0;
-            const int actualLabel = static_cast<int>(data.targets[i][0]);
-            if (predictedLabel == actualLabel) {
-                correctPredictions++;
+        if (images && !deviceData) {
+            images->start(0, 0, false);
+            std::vector<float> input, target;
+            while (images->next(input, target)) nn->evaluate(input, target, metrics);
+        } else {
+            for (size_t i = 0; i < sampleCount; ++i) {
+                if (deviceData) nn->evaluate(*deviceData, i, metrics);
+                else nn->evaluate(data.inputs[i], data.targets[i], metrics);
             }
         }
+        metrics.submit(epoch + 1);
 
         auto epoch_end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(epoch_end - epoch_start);
-
-        const double accuracy = static_cast<double>(correctPredictions) / data.inputs.size() * 100.0;
         std::cout << "Epoch " << std::setw(2) << (epoch + 1) << "/" << epochs
-                  << " - Accuracy: " << std::fixed << std::setprecision(2) << accuracy << "%"
                   << " - Time: " << duration.count() << "s" << std::endl;
+
+        // Results of earlier epochs arrive once the GPU is done with them
+        MetricsResult result;
+        while (metrics.poll(result)) {
+            printMetrics(result);
+        }
     }
 
-    std::cout << "--- Training Complete ---" << std::endl;
+    while (metrics.hasPending()) {
+        printMetrics(metrics.wait());
+    }
+
+    checkpointer.finish();
+    std::cout << "--- Training Complete --- (" << checkpointer.checkpointsWritten() << " checkpoints written)" << std::endl;
 
     const long msSinceEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::high_resolution_clock::now().time_since_epoch()).count();
 
     const std::string modelPath = "model_" + std::to_string(msSinceEpoch) + ".json";
-    nn.saveToFile(modelPath);
+    nn->saveToFile(modelPath);
     std::cout << "Model saved to " << modelPath << std::endl;
 
+    if (PRUNE) {
+        // Pruned layers are saved as CSR; the CPU engine serves them from the same file
+        CpuInferenceEngine cpuEngine(modelPath);
+        std::mt19937 probeGen{progress.seed};
+        std::uniform_real_distribution<float> pixel(0.0f, 1.0f);
+        std::vector<float> probe(nn->getInputSize());
+        for (auto &value: probe) value = pixel(probeGen);
+        const auto gpuOutput = nn->predict(probe);
+        const auto cpuOutput = cpuEngine.predictBatch({&probe}).front();
+        float maxDiff = 0.0f;
+        for (size_t i = 0; i < gpuOutput.size(); ++i) {
+            maxDiff = std::max(maxDiff, std::abs(gpuOutput[i] - cpuOutput[i]));
+        }
+        std::cout << "CPU engine on the saved pruned model: max difference to the GPU " << maxDiff << std::endl;
+    }
+    Profiler::global().report(std::cout);
+
     cleanupOpenGLWindow();
 
     std::cout << "Press Enter to exit...";
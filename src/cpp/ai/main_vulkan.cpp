@@ -0,0 +1,81 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifdef GLNN_VULKAN
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "nn/Layer.h"
+#include "nn/NeuralNetwork.h"
+#include "utils/SetupUtil.h"
+#include "vk/VulkanContext.h"
+#include "vk/VulkanNetwork.h"
+
+// Trains the same network on the OpenGL and the Vulkan backend from the same weights, and compares the
+// results and the time per step. Runs on Mesa's lavapipe with GLNN_VULKAN_DEVICE=llvmpipe.
+int mainVulkanComparison() {
+    if (setupOpenGLWindow() != 0) {
+        std::cerr << "Failed to set up OpenGL window." << std::endl;
+        return -1;
+    }
+
+    constexpr int STEPS = 500;
+    const std::vector<int> sizes = {64, 128, 128, 10};
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution dis(0.0f, 1.0f);
+    std::vector<std::vector<float> > inputs, targets;
+    for (int i = 0; i < STEPS; ++i) {
+        std::vector<float> input(sizes.front()), target(sizes.back(), 0.0f);
+        for (auto &x: input) x = dis(gen);
+        target[i % sizes.back()] = 1.0f;
+        inputs.push_back(std::move(input));
+        targets.push_back(std::move(target));
+    }
+
+    {
+        NeuralNetwork gl;
+        gl.setWeightInit({WeightInitScheme::XAVIER, 21});
+        gl.addLayer(sizes[0], sizes[1]);
+        for (size_t l = 2; l < sizes.size(); ++l) gl.addLayer(sizes[l]);
+
+        VulkanContext context;
+        VulkanNetwork vk(context, sizes);
+        vk.learningRate = gl.learningRate;
+        for (size_t l = 0; l < gl.getLayerCount(); ++l) {
+            std::vector<float> weights, biases;
+            gl.getLayer(l).downloadParameters(weights, biases);
+            vk.uploadParameters(l, weights, biases);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < STEPS; ++i) gl.train(inputs[i], targets[i]);
+        glFinish();
+        const double glSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < STEPS; ++i) vk.train(inputs[i], targets[i]);
+        const double vkSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        float maxDiff = 0.0f;
+        for (int i = 0; i < 20; ++i) {
+            const auto a = gl.predict(inputs[i]);
+            const auto b = vk.predict(inputs[i]);
+            for (size_t o = 0; o < a.size(); ++o) maxDiff = std::max(maxDiff, std::abs(a[o] - b[o]));
+        }
+
+        std::cout << "Vulkan train step: " << vk.getTrainDispatches() << " dispatches, " << vk.getTrainBarriers()
+                << " barriers, recorded once" << std::endl;
+        std::cout << "OpenGL: " << glSeconds / STEPS * 1e3 << " ms per step, Vulkan: " << vkSeconds / STEPS * 1e3
+                << " ms per step, max output difference " << maxDiff << std::endl;
+    }
+
+    cleanupOpenGLWindow();
+    return 0;
+}
+
+#endif
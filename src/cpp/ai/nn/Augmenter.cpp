@@ -0,0 +1,59 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "Augmenter.h"
+
+#include <stdexcept>
+
+Augmenter::Augmenter(const TensorShape shape, const AugmentationConfig &config)
+    : shape(shape), config(config) {
+    if (config.maxShift < 0 || config.minCropScale <= 0.0f || config.minCropScale > 1.0f ||
+        config.noiseStddev < 0.0f) {
+        throw std::invalid_argument("Invalid augmentation settings.");
+    }
+    if (shape.size() <= 0) {
+        throw std::invalid_argument("Augmentation needs a non-empty input.");
+    }
+
+    shader.loadComputeShader("shaders/augment.comp");
+    if (config.isGeometric()) {
+        glGenBuffers(1, &sourceCopy);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, sourceCopy);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, shape.size() * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+Augmenter::~Augmenter() {
+    glDeleteBuffers(1, &sourceCopy);
+    glDeleteProgram(shader.ID);
+}
+
+void Augmenter::apply(const GLuint input, const uint64_t step) const {
+    const GLsizeiptr bytes = shape.size() * sizeof(float);
+    if (sourceCopy) {
+        // Whatever wrote the input (an upload or the gather shader) has to land before the copy
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_COPY_READ_BUFFER, input);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, sourceCopy);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, bytes);
+    }
+
+    shader.use();
+    shader.setInt("u_channels", shape.channels);
+    shader.setInt("u_height", shape.height);
+    shader.setInt("u_width", shape.width);
+    shader.setInt("u_max_shift", config.maxShift);
+    shader.setInt("u_flip_horizontal", config.flipHorizontal ? 1 : 0);
+    shader.setInt("u_flip_vertical", config.flipVertical ? 1 : 0);
+    shader.setFloat("u_min_crop_scale", config.minCropScale);
+    shader.setFloat("u_noise_stddev", config.noiseStddev);
+    shader.setUInt("u_seed_lo", static_cast<GLuint>(config.seed));
+    shader.setUInt("u_seed_hi", static_cast<GLuint>(config.seed >> 32));
+    shader.setUInt("u_step_lo", static_cast<GLuint>(step));
+    shader.setUInt("u_step_hi", static_cast<GLuint>(step >> 32));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sourceCopy ? sourceCopy : input);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, input);
+    shader.dispatch((shape.size() + 255) / 256, 1, 1);
+}
@@ -0,0 +1,65 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef AUGMENTER_H
+#define AUGMENTER_H
+
+#include <GL/glew.h>
+#include <cstdint>
+
+#include "FeatureLayer.h"
+#include "../gl/Shader.h"
+
+struct AugmentationConfig {
+    // Random shift of up to maxShift pixels along x and y, shifted-in pixels are 0.
+    int maxShift = 0;
+    bool flipHorizontal = false;
+    bool flipVertical = false;
+    // Crops a random window of [minCropScale, 1] times the image side and stretches it back to full size.
+    float minCropScale = 1.0f;
+    // Standard deviation of the Gaussian noise added to every input value.
+    float noiseStddev = 0.0f;
+    uint64_t seed = 0;
+
+    [[nodiscard]] bool isGeometric() const {
+        return maxShift > 0 || flipHorizontal || flipVertical || minCropScale < 1.0f;
+    }
+
+    [[nodiscard]] bool isEnabled() const { return isGeometric() || noiseStddev > 0.0f; }
+};
+
+/**
+ * @brief Augments the network input in its GPU buffer before the first layer runs. All randomness comes
+ * from Philox keyed by the seed with the training step as counter, so a step gets the same augmentation
+ * in every run and no data crosses the bus. Geometric transforms read from a copy of the input made on
+ * the device.
+ */
+class Augmenter {
+public:
+    /**
+     * @param shape Shape of the input; plain vector inputs (0 channels) only support noise.
+     */
+    Augmenter(TensorShape shape, const AugmentationConfig &config);
+
+    ~Augmenter();
+
+    Augmenter(const Augmenter &) = delete;
+
+    Augmenter &operator=(const Augmenter &) = delete;
+
+    /**
+     * @brief Replaces the contents of `input` with their augmentation for the given step.
+     */
+    void apply(GLuint input, uint64_t step) const;
+
+    [[nodiscard]] const AugmentationConfig &getConfig() const { return config; }
+
+private:
+    TensorShape shape;
+    AugmentationConfig config;
+    Shader shader;
+    GLuint sourceCopy = 0; // only for geometric transforms
+};
+
+#endif //AUGMENTER_H
@@ -0,0 +1,429 @@
+//
+// Created by CorruptionHades on 12/10/2025.
+//
+
+#include "Checkpointer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "NeuralNetwork.h"
+
+namespace {
+    constexpr char MAGIC[4] = {'G', 'L', 'N', 'C'};
+    constexpr size_t PAYLOAD_ALIGNMENT = 64;
+
+    void readOrThrow(std::ifstream &file, void *data, const size_t bytes, const std::string &path) {
+        if (!file.read(static_cast<char *>(data), static_cast<std::streamsize>(bytes))) {
+            throw std::runtime_error("Truncated checkpoint file: " + path);
+        }
+    }
+}
+
+size_t Checkpointer::payloadOffset(const size_t layerCount, const size_t featureSpecBytes) {
+    size_t raw = sizeof(CheckpointHeader) + (layerCount + 1) * sizeof(uint32_t);
+    if (featureSpecBytes > 0) raw += sizeof(uint32_t) + featureSpecBytes;
+    return (raw + PAYLOAD_ALIGNMENT - 1) / PAYLOAD_ALIGNMENT * PAYLOAD_ALIGNMENT;
+}
+
+Checkpointer::Checkpointer(std::string path) : path(std::move(path)) {
+    writer = std::thread(&Checkpointer::writerLoop, this);
+}
+
+Checkpointer::~Checkpointer() {
+    try {
+        finish();
+    } catch (const std::exception &e) {
+        std::cerr << "Checkpoint could not be written: " << e.what() << std::endl;
+    }
+
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    writer.join();
+
+    if (fence) glDeleteSync(fence);
+    glDeleteBuffers(1, &staging);
+}
+
+bool Checkpointer::snapshot(const NeuralNetwork &network, const TrainingProgress &progress) {
+    poll();
+    if (stage != Stage::IDLE) {
+        return false;
+    }
+    if (network.layers.empty()) {
+        throw std::runtime_error("Cannot checkpoint a network without layers.");
+    }
+
+    // Layers placed on the CPU keep their state on the host
+    network.syncCpuLayers();
+
+    // Plain SGD keeps no optimizer state, but gradients accumulated so far are part of the step in progress
+    const bool withGradients = network.accumulatedMicroBatches > 0;
+    size_t parameterBytes = 0;
+    for (const auto &feature: network.features) {
+        for (const auto &parameter: feature->parameters()) {
+            parameterBytes += parameter.count * sizeof(float);
+        }
+    }
+    for (const auto &layer: network.layers) {
+        parameterBytes += (static_cast<size_t>(layer->inputSize) * layer->neuronCount + layer->neuronCount) * sizeof(float);
+    }
+    payloadBytes = withGradients ? 2 * parameterBytes : parameterBytes;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+    if (!staging || stagingSize < static_cast<GLsizeiptr>(payloadBytes)) {
+        if (!staging) {
+            glGenBuffers(1, &staging);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+        }
+        stagingSize = static_cast<GLsizeiptr>(payloadBytes);
+        glBufferData(GL_COPY_WRITE_BUFFER, stagingSize, nullptr, GL_STREAM_READ);
+    }
+
+    // Everything is copied on the GPU, in file order, so the payload can be written straight from the mapping
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    GLintptr offset = 0;
+    auto copy = [&offset](const GLuint source, const GLsizeiptr bytes, const GLintptr sourceOffset = 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, source);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, sourceOffset, offset, bytes);
+        offset += bytes;
+    };
+    // The file keeps W row-major; a sharded layer's column blocks are interleaved back row by row
+    auto copyWeights = [&copy, &offset](const Layer &layer, GLuint WeightShard::*buffer) {
+        if (layer.isStreamed() || layer.isSparse()) {
+            // Already on the host, or in CSR form: expanded on the host and written into the staging buffer
+            std::vector<float> matrix(static_cast<size_t>(layer.inputSize) * layer.neuronCount);
+            std::vector<float> biases;
+            if (buffer == &WeightShard::weights) layer.downloadParameters(matrix, biases);
+            else layer.downloadWeightGradients(matrix.data());
+            const auto bytes = static_cast<GLsizeiptr>(matrix.size() * sizeof(float));
+            glBufferSubData(GL_COPY_WRITE_BUFFER, offset, bytes, matrix.data());
+            offset += bytes;
+            return;
+        }
+        if (!layer.isSharded()) {
+            copy(layer.shards.front().*buffer, static_cast<GLsizeiptr>(layer.inputSize) * layer.neuronCount * sizeof(float));
+            return;
+        }
+        for (int r = 0; r < layer.neuronCount; ++r) {
+            for (const auto &shard: layer.shards) {
+                const auto rowBytes = static_cast<GLsizeiptr>(shard.columns * sizeof(float));
+                copy(shard.*buffer, rowBytes, r * rowBytes);
+            }
+        }
+    };
+    for (const auto &feature: network.features) {
+        for (const auto &parameter: feature->parameters()) {
+            copy(parameter.values, static_cast<GLsizeiptr>(parameter.count * sizeof(float)));
+        }
+    }
+    for (const auto &layer: network.layers) {
+        copyWeights(*layer, &WeightShard::weights);
+        copy(layer->biasesBuffer, layer->neuronCount * sizeof(float));
+    }
+    if (withGradients) {
+        for (const auto &feature: network.features) {
+            for (const auto &parameter: feature->parameters()) {
+                copy(parameter.gradients, static_cast<GLsizeiptr>(parameter.count * sizeof(float)));
+            }
+        }
+        for (const auto &layer: network.layers) {
+            copyWeights(*layer, &WeightShard::gradWeights);
+            copy(layer->gradBiasesBuffer, layer->neuronCount * sizeof(float));
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // make sure the fence actually reaches the GPU
+
+    // Header and architecture are known now, the writer only needs the payload later
+    const auto &sizes = network.getLayerSizes();
+    nlohmann::json spec = nlohmann::json::object();
+    const bool withFeatures = network.inputShape.channels > 0;
+    if (withFeatures) {
+        const TensorShape &shape = network.inputShape;
+        spec["input_shape"] = {shape.channels, shape.height, shape.width};
+        spec["features"] = nlohmann::json::array();
+        for (const auto &feature: network.features) {
+            spec["features"].push_back(feature->toJson(false));
+        }
+    }
+    const bool withStreamed = std::ranges::any_of(network.layers,
+                                                  [](const auto &layer) { return layer->isStreamed(); });
+    if (withStreamed) {
+        spec["weight_files"] = nlohmann::json::array();
+        for (const auto &layer: network.layers) {
+            spec["weight_files"].push_back(layer->getWeightFile());
+        }
+    }
+    const std::string featureSpec = spec.empty() ? std::string() : spec.dump();
+    prefix.assign(payloadOffset(network.layers.size(), featureSpec.size()), 0);
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.layerCount = static_cast<uint32_t>(network.layers.size());
+    header.flags = (withGradients ? FLAG_GRADIENTS : 0u) | (withFeatures ? FLAG_FEATURES : 0u) |
+                   (withStreamed ? FLAG_STREAMED : 0u);
+    header.epoch = progress.epoch;
+    header.accumulationSteps = network.accumulationSteps;
+    header.step = progress.step;
+    header.learningRate = network.learningRate;
+    header.accumulatedMicroBatches = network.accumulatedMicroBatches;
+    header.payloadBytes = payloadBytes;
+    header.seed = progress.seed;
+    std::memcpy(prefix.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        const auto size = static_cast<uint32_t>(sizes[i]);
+        std::memcpy(prefix.data() + sizeof(header) + i * sizeof(uint32_t), &size, sizeof(size));
+    }
+    if (!featureSpec.empty()) {
+        char *out = prefix.data() + sizeof(header) + sizes.size() * sizeof(uint32_t);
+        const auto length = static_cast<uint32_t>(featureSpec.size());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), featureSpec.data(), featureSpec.size());
+    }
+
+    stage = Stage::COPYING;
+    return true;
+}
+
+void Checkpointer::poll() {
+    if (stage == Stage::COPYING) {
+        const GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+            startWrite();
+        }
+    }
+    if (stage == Stage::WRITING) {
+        bool done;
+        {
+            std::lock_guard lock(mutex);
+            done = jobDone;
+        }
+        if (done) {
+            completeWrite();
+        }
+    }
+}
+
+void Checkpointer::finish() {
+    if (stage == Stage::COPYING) {
+        GLenum status;
+        do {
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        if (status == GL_WAIT_FAILED) {
+            throw std::runtime_error("glClientWaitSync failed while waiting for a checkpoint.");
+        }
+        startWrite();
+    }
+    if (stage == Stage::WRITING) {
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [this] { return jobDone; });
+        }
+        completeWrite();
+    }
+}
+
+void Checkpointer::startWrite() {
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    const void *payload = glMapBufferRange(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(payloadBytes),
+                                           GL_MAP_READ_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    if (!payload) {
+        stage = Stage::IDLE;
+        throw std::runtime_error("Could not map checkpoint staging buffer.");
+    }
+
+    // The mapping stays valid until completeWrite() unmaps it on this (the GL) thread
+    {
+        std::lock_guard lock(mutex);
+        job = payload;
+        jobDone = false;
+    }
+    cv.notify_all();
+    stage = Stage::WRITING;
+}
+
+void Checkpointer::completeWrite() {
+    glBindBuffer(GL_COPY_READ_BUFFER, staging);
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    stage = Stage::IDLE;
+
+    std::exception_ptr error;
+    {
+        std::lock_guard lock(mutex);
+        std::swap(error, writeError);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    ++written;
+}
+
+void Checkpointer::writerLoop() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        cv.wait(lock, [this] { return stopping || job != nullptr; });
+        if (!job) {
+            return; // stopping with nothing left to write
+        }
+
+        const void *payload = job;
+        lock.unlock();
+        std::exception_ptr error;
+        try {
+            writeFile(payload);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        job = nullptr;
+        jobDone = true;
+        writeError = error;
+        cv.notify_all();
+    }
+}
+
+void Checkpointer::writeFile(const void *payload) const {
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file for writing: " + tempPath);
+        }
+        file.write(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+        file.write(static_cast<const char *>(payload), static_cast<std::streamsize>(payloadBytes));
+        file.flush();
+        if (!file) {
+            throw std::runtime_error("Failed to write checkpoint: " + tempPath);
+        }
+    }
+    // Replaces the previous checkpoint in one step, readers never see a partial file
+    std::filesystem::rename(tempPath, path);
+}
+
+std::unique_ptr<NeuralNetwork> Checkpointer::load(const std::string &path, TrainingProgress &progress) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file for reading: " + path);
+    }
+
+    CheckpointHeader header{};
+    readOrThrow(file, &header, sizeof(header), path);
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("Not a checkpoint file: " + path);
+    }
+    if (header.version < 1 || header.version > VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.layerCount < 1) {
+        throw std::runtime_error("Invalid architecture in checkpoint file.");
+    }
+
+    std::vector<uint32_t> arch(header.layerCount + 1);
+    readOrThrow(file, arch.data(), arch.size() * sizeof(uint32_t), path);
+
+    auto nn = std::make_unique<NeuralNetwork>();
+    nn->learningRate = header.learningRate;
+
+    std::string featureSpec;
+    std::vector<std::string> weightFiles(header.layerCount);
+    if (header.flags & (FLAG_FEATURES | FLAG_STREAMED)) {
+        uint32_t length = 0;
+        readOrThrow(file, &length, sizeof(length), path);
+        featureSpec.resize(length);
+        readOrThrow(file, featureSpec.data(), length, path);
+    }
+    const auto spec = featureSpec.empty() ? nlohmann::json::object() : nlohmann::json::parse(featureSpec);
+    if (header.flags & FLAG_STREAMED) {
+        weightFiles = spec.at("weight_files").get<std::vector<std::string> >();
+        if (weightFiles.size() != header.layerCount) {
+            throw std::runtime_error("Mismatched weight files in checkpoint file.");
+        }
+    }
+
+    if (header.flags & FLAG_FEATURES) {
+        const auto shape = spec.at("input_shape").get<std::vector<int> >();
+        if (shape.size() != 3) {
+            throw std::runtime_error("Invalid input shape in checkpoint file.");
+        }
+        nn->setInputShape(shape[0], shape[1], shape[2]);
+        for (const auto &description: spec.at("features")) {
+            const TensorShape input = nn->features.empty() ? nn->inputShape : nn->features.back()->outputShape();
+            nn->addFeature(FeatureLayer::fromJson(description, input, nn->getFeatureKernels()));
+        }
+    } else {
+        nn->addInput(static_cast<int>(arch[0]));
+    }
+    file.seekg(static_cast<std::streamoff>(payloadOffset(header.layerCount, featureSpec.size())));
+    // Nothing to initialize, every parameter is read below; streamed layers write it into a new weight file
+    for (size_t i = 1; i < arch.size(); ++i) {
+        nn->appendLayer(static_cast<int>(arch[i]), weightFiles[i - 1], false);
+    }
+    if (nn->layerSizes.front() != static_cast<int>(arch[0])) {
+        throw std::runtime_error("Feature layers do not match the architecture in checkpoint file.");
+    }
+    nn->setGradientAccumulationSteps(header.accumulationSteps);
+
+    std::vector<float> weights;
+    std::vector<float> biases;
+    auto readLayer = [&](const Layer &layer) {
+        weights.resize(static_cast<size_t>(layer.inputSize) * layer.neuronCount);
+        biases.resize(layer.neuronCount);
+        readOrThrow(file, weights.data(), weights.size() * sizeof(float), path);
+        readOrThrow(file, biases.data(), biases.size() * sizeof(float), path);
+    };
+
+    auto readFeatures = [&](const bool gradients) {
+        for (const auto &feature: nn->features) {
+            for (const auto &parameter: feature->parameters()) {
+                weights.resize(parameter.count);
+                readOrThrow(file, weights.data(), weights.size() * sizeof(float), path);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradients ? parameter.gradients : parameter.values);
+                glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, weights.size() * sizeof(float), weights.data());
+            }
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    };
+
+    readFeatures(false);
+    for (const auto &layer: nn->layers) {
+        readLayer(*layer);
+        layer->uploadParameters(weights, biases);
+    }
+
+    if (header.flags & FLAG_GRADIENTS) {
+        readFeatures(true);
+        for (const auto &layer: nn->layers) {
+            readLayer(*layer);
+            layer->uploadWeightGradients(weights.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer->gradBiasesBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases.size() * sizeof(float), biases.data());
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        nn->accumulatedMicroBatches = header.accumulatedMicroBatches;
+    }
+
+    progress.epoch = header.epoch;
+    progress.step = header.step;
+    progress.seed = header.seed;
+    return nn;
+}
@@ -0,0 +1,148 @@
+//
+// Created by CorruptionHades on 12/10/2025.
+//
+
+#ifndef CHECKPOINTER_H
+#define CHECKPOINTER_H
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class NeuralNetwork;
+
+// Where training was when a checkpoint was taken
+struct TrainingProgress {
+    int epoch = 0; // epochs fully completed
+    uint64_t step = 0; // train() calls so far
+    uint64_t seed = 0; // lets the caller replay the shuffles of the interrupted run
+};
+
+/**
+ * @brief Writes training checkpoints in the background.
+ *
+ * snapshot() only records GPU commands: every parameter buffer (and, while gradients are being
+ * accumulated, the partial gradients) is copied into one staging buffer, followed by a fence.
+ * poll() maps the staging buffer once the fence has signalled and hands the mapped memory to a
+ * writer thread, which streams it into "<path>.tmp" and renames it over <path>. A crash therefore
+ * always leaves the previous complete checkpoint behind.
+ *
+ * File layout (native byte order): CheckpointHeader, the architecture as uint32 values, padding to
+ * 64 bytes, then per layer the weights (neuronCount x inputSize, row-major) and biases, followed by
+ * the same again for the accumulated gradients if FLAG_GRADIENTS is set.
+ *
+ * With FLAG_FEATURES, the architecture is followed by a uint32 length and the JSON description of the
+ * input shape and feature layers, and the parameters of every feature layer precede the dense ones
+ * (in the order of FeatureLayer::parameters()), both in the parameter and in the gradient section.
+ *
+ * With FLAG_STREAMED, that JSON also (or only) holds "weight_files": the file of every streamed dense layer,
+ * "" for the others. Their weights are in the payload like any other, load() writes them back into the file.
+ */
+class Checkpointer {
+public:
+    static constexpr uint32_t VERSION = 3;
+    static constexpr uint32_t FLAG_GRADIENTS = 1u;
+    static constexpr uint32_t FLAG_FEATURES = 2u; // since version 2
+    static constexpr uint32_t FLAG_STREAMED = 4u; // since version 3
+
+    struct CheckpointHeader {
+        char magic[4]; // "GLNC"
+        uint32_t version;
+        uint32_t layerCount;
+        uint32_t flags;
+        int32_t epoch;
+        int32_t accumulationSteps;
+        uint64_t step;
+        float learningRate;
+        int32_t accumulatedMicroBatches;
+        uint64_t payloadBytes;
+        uint64_t seed;
+    };
+
+    explicit Checkpointer(std::string path);
+
+    /**
+     * @brief Waits for the checkpoint in flight (if any) to reach the disk.
+     */
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer &) = delete;
+
+    Checkpointer &operator=(const Checkpointer &) = delete;
+
+    /**
+     * @brief Schedules a checkpoint of the network's current state. Never waits for the GPU or the disk.
+     * @return false if the previous checkpoint is still being written; nothing is scheduled then.
+     */
+    bool snapshot(const NeuralNetwork &network, const TrainingProgress &progress);
+
+    /**
+     * @brief Advances the checkpoint in flight without blocking. Call this regularly from the GL thread,
+     * e.g. once per step. Rethrows errors of the writer thread.
+     */
+    void poll();
+
+    /**
+     * @brief Blocks until the checkpoint in flight has been written.
+     */
+    void finish();
+
+    [[nodiscard]] bool busy() const { return stage != Stage::IDLE; }
+
+    [[nodiscard]] uint64_t checkpointsWritten() const { return written; }
+
+    [[nodiscard]] const std::string &getPath() const { return path; }
+
+    /**
+     * @brief Recreates a network from a checkpoint file, including partially accumulated gradients.
+     * Streamed layers are streamed again, from their weight file rewritten with the checkpoint's weights.
+     * @param progress Receives the epoch and step the checkpoint was taken at.
+     */
+    static std::unique_ptr<NeuralNetwork> load(const std::string &path, TrainingProgress &progress);
+
+    /**
+     * @brief Where the parameters start in a checkpoint file (a multiple of 64 bytes), for readers that
+     * map the file instead of loading it (see CpuModel).
+     */
+    static size_t payloadOffset(size_t layerCount, size_t featureSpecBytes);
+
+private:
+    enum class Stage { IDLE, COPYING, WRITING };
+
+    std::string path;
+    Stage stage = Stage::IDLE;
+    uint64_t written = 0;
+
+    GLuint staging = 0;
+    GLsizeiptr stagingSize = 0;
+    GLsync fence = nullptr;
+
+    // Header and architecture of the checkpoint in flight, payload comes from the mapped staging buffer
+    std::vector<char> prefix;
+    size_t payloadBytes = 0;
+
+    // Writer thread
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    const void *job = nullptr;
+    bool jobDone = false;
+    bool stopping = false;
+    std::exception_ptr writeError;
+
+    void writerLoop();
+
+    void writeFile(const void *payload) const;
+
+    void startWrite();
+
+    void completeWrite();
+};
+
+#endif //CHECKPOINTER_H
@@ -0,0 +1,288 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#include "Conv2DLayer.h"
+#include "WeightInitializer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+    // Must match conv2d_direct.comp
+    constexpr int TILE = 16;
+    constexpr int MAX_SPAN = 48;
+    // The smallest GL_MAX_COMPUTE_WORK_GROUP_COUNT a GL 4.3 implementation may have, per dimension
+    constexpr GLuint MAX_GROUPS = 65535;
+
+    const char *activationName(const FeatureActivation activation) {
+        switch (activation) {
+            case FeatureActivation::SIGMOID: return "sigmoid";
+            case FeatureActivation::RELU: return "relu";
+            default: return "none";
+        }
+    }
+
+    GLuint createBuffer(const size_t floats, const void *data = nullptr) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, floats * sizeof(float), data, GL_DYNAMIC_COPY);
+        return buffer;
+    }
+}
+
+bool Conv2DLayer::directFits(const int kernelSize, const int stride) {
+    return (TILE - 1) * stride + kernelSize <= MAX_SPAN;
+}
+
+TensorShape Conv2DLayer::outputShapeFor(const TensorShape input, const int outChannels, const int kernelSize,
+                                        const int stride, const int padding) {
+    if (kernelSize < 1 || stride < 1 || padding < 0 || outChannels < 1) {
+        throw std::invalid_argument("Invalid convolution parameters.");
+    }
+    const int height = (input.height + 2 * padding - kernelSize) / stride + 1;
+    const int width = (input.width + 2 * padding - kernelSize) / stride + 1;
+    if (height < 1 || width < 1) {
+        throw std::invalid_argument("Convolution kernel is larger than its (padded) input.");
+    }
+    return {outChannels, height, width};
+}
+
+Conv2DLayer::Conv2DLayer(const TensorShape input, const int outChannels, const int kernelSize, const int stride,
+                         const int padding, const FeatureActivation activation, const ConvAlgorithm algorithm,
+                         FeatureKernels *kernels)
+    : FeatureLayer(input, outputShapeFor(input, outChannels, kernelSize, stride, padding)),
+      outChannels(outChannels),
+      kernelSize(kernelSize),
+      stride(stride),
+      padding(padding),
+      activation(activation),
+      kernels(kernels),
+      algorithm(algorithm) {
+    if (this->algorithm == ConvAlgorithm::AUTO) {
+        this->algorithm = directFits(kernelSize, stride) ? ConvAlgorithm::DIRECT : ConvAlgorithm::IM2COL;
+    }
+    if (this->algorithm == ConvAlgorithm::DIRECT && !directFits(kernelSize, stride)) {
+        throw std::invalid_argument("Kernel size/stride too large for the direct convolution, use IM2COL.");
+    }
+
+    std::cout << "Initializing Conv2D (" << input.channels << "x" << input.height << "x" << input.width << " -> "
+            << outShape.channels << "x" << outShape.height << "x" << outShape.width << ", " << kernelSize << "x"
+            << kernelSize << "/" << stride << (this->algorithm == ConvAlgorithm::DIRECT ? ", direct" : ", im2col")
+            << ")..." << std::endl;
+
+    const int fanIn = input.channels * kernelSize * kernelSize;
+    const std::vector<float> biases(outChannels, 0.0f);
+
+    weightsBuffer = createBuffer(weightCount());
+    biasesBuffer = createBuffer(biases.size(), biases.data());
+    gradWeightsBuffer = createBuffer(weightCount());
+    gradBiasesBuffer = createBuffer(biases.size());
+    preActivationBuffer = createBuffer(outShape.size());
+    deltaBuffer = createBuffer(outShape.size());
+    if (this->algorithm == ConvAlgorithm::IM2COL) {
+        columnsBuffer = createBuffer(static_cast<size_t>(fanIn) * outShape.height * outShape.width);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+Conv2DLayer::~Conv2DLayer() {
+    glDeleteBuffers(1, &weightsBuffer);
+    glDeleteBuffers(1, &biasesBuffer);
+    glDeleteBuffers(1, &gradWeightsBuffer);
+    glDeleteBuffers(1, &gradBiasesBuffer);
+    glDeleteBuffers(1, &preActivationBuffer);
+    glDeleteBuffers(1, &deltaBuffer);
+    if (columnsBuffer) glDeleteBuffers(1, &columnsBuffer);
+}
+
+void Conv2DLayer::initializeWeights(const WeightInitializer &initializer, const uint64_t seed,
+                                    const uint32_t stream) {
+    // He initialization for ReLU, Xavier otherwise
+    const int fanIn = inShape.channels * kernelSize * kernelSize;
+    const int fanOut = outChannels * kernelSize * kernelSize;
+    const auto scheme = activation == FeatureActivation::RELU ? WeightInitScheme::HE : WeightInitScheme::XAVIER;
+    initializer.fill(weightsBuffer, outChannels, 0, fanIn, WeightInitializer::limit(scheme, fanIn, fanOut), seed,
+                     stream);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Conv2DLayer::setGeometry(const Shader &shader) const {
+    shader.setInt("u_in_channels", inShape.channels);
+    shader.setInt("u_in_height", inShape.height);
+    shader.setInt("u_in_width", inShape.width);
+    shader.setInt("u_out_height", outShape.height);
+    shader.setInt("u_out_width", outShape.width);
+    shader.setInt("u_kernel", kernelSize);
+    shader.setInt("u_stride", stride);
+    shader.setInt("u_padding", padding);
+}
+
+void Conv2DLayer::forward(const GLuint inputBuffer, const GLuint outputBuffer) {
+    const int pixels = outShape.height * outShape.width;
+
+    if (algorithm == ConvAlgorithm::DIRECT) {
+        const Shader &conv = kernels->convDirect;
+        conv.use();
+        setGeometry(conv);
+        conv.setInt("u_activation", static_cast<int>(activation));
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, weightsBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, biasesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, preActivationBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, outputBuffer);
+        conv.dispatch((outShape.width + TILE - 1) / TILE, (outShape.height + TILE - 1) / TILE, outChannels);
+        return;
+    }
+
+    // Step 1: unfold the input into columns
+    const int rows = inShape.channels * kernelSize * kernelSize;
+    const Shader &unfold = kernels->im2col;
+    unfold.use();
+    setGeometry(unfold);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, columnsBuffer);
+    unfold.dispatch((pixels + 15) / 16, (rows + 15) / 16, 1);
+
+    // Step 2: z = W * columns (OC x pixels, already CHW)
+    const Shader &matmul = *kernels->matmul;
+    matmul.use();
+    matmul.setInt("u_A_rows", outChannels);
+    matmul.setInt("u_A_cols", rows);
+    matmul.setInt("u_B_cols", pixels);
+    matmul.setInt("u_B_offset", 0);
+    matmul.setInt("u_accumulate", 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, columnsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, preActivationBuffer);
+    matmul.dispatch((pixels + 15) / 16, (outChannels + 15) / 16, 1);
+
+    // Step 3: z += b, a = g(z)
+    const Shader &epilogue = kernels->convBiasActivation;
+    epilogue.use();
+    epilogue.setInt("u_channel_size", pixels);
+    epilogue.setInt("u_element_count", outShape.size());
+    epilogue.setInt("u_activation", static_cast<int>(activation));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, preActivationBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, biasesBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, outputBuffer);
+    epilogue.dispatch((outShape.size() + 255) / 256, 1, 1);
+}
+
+void Conv2DLayer::backward(const GLuint inputBuffer, const GLuint errorFromOutput, const GLuint errorForInput,
+                           const bool accumulate) {
+    // δ = dL/da .* g'(z)
+    const Shader &delta = kernels->convDelta;
+    delta.use();
+    delta.setInt("u_element_count", outShape.size());
+    delta.setInt("u_activation", static_cast<int>(activation));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, errorFromOutput);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, preActivationBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, deltaBuffer);
+    delta.dispatch((outShape.size() + 255) / 256, 1, 1);
+
+    // ∇W and ∇b, one workgroup per parameter, in rows of at most MAX_GROUPS workgroups
+    const auto parameterCount = static_cast<GLuint>(weightCount()) + outChannels;
+    const GLuint groupsX = std::min(parameterCount, MAX_GROUPS);
+    const Shader &grads = kernels->convGradParams;
+    grads.use();
+    setGeometry(grads);
+    grads.setInt("u_weight_count", static_cast<int>(weightCount()));
+    grads.setInt("u_param_count", static_cast<int>(parameterCount));
+    grads.setInt("u_accumulate", accumulate ? 1 : 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deltaBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, inputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gradWeightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, gradBiasesBuffer);
+    grads.dispatch(groupsX, (parameterCount + groupsX - 1) / groupsX, 1);
+
+    if (errorForInput == 0) {
+        return;
+    }
+
+    // dL/dx = transposed convolution of δ
+    const Shader &input = kernels->convGradInput;
+    input.use();
+    setGeometry(input);
+    input.setInt("u_out_channels", outChannels);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deltaBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, weightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorForInput);
+    input.dispatch((inShape.size() + 255) / 256, 1, 1);
+}
+
+void Conv2DLayer::update(const float learningRate) {
+    const Shader &sgd = *kernels->sgdUpdate;
+    sgd.use();
+    sgd.setFloat("u_learning_rate", learningRate);
+
+    sgd.setInt("u_element_count", static_cast<int>(weightCount()));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weightsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gradWeightsBuffer);
+    sgd.dispatch((weightCount() + 255) / 256, 1, 1);
+
+    sgd.setInt("u_element_count", outChannels);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, biasesBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gradBiasesBuffer);
+    sgd.dispatch((outChannels + 255) / 256, 1, 1);
+}
+
+std::vector<ParameterBuffer> Conv2DLayer::parameters() const {
+    return {
+        {weightsBuffer, gradWeightsBuffer, weightCount()},
+        {biasesBuffer, gradBiasesBuffer, static_cast<size_t>(outChannels)}
+    };
+}
+
+nlohmann::json Conv2DLayer::toJson(const bool withParameters) const {
+    nlohmann::json j;
+    j["type"] = "conv2d";
+    j["out_channels"] = outChannels;
+    j["kernel"] = kernelSize;
+    j["stride"] = stride;
+    j["padding"] = padding;
+    j["activation"] = activationName(activation);
+    j["algorithm"] = algorithm == ConvAlgorithm::DIRECT ? "direct" : "im2col";
+
+    if (withParameters) {
+        std::vector<float> weights, biases;
+        downloadParameters(weights, biases);
+        j["weights"] = weights;
+        j["biases"] = biases;
+    }
+    return j;
+}
+
+void Conv2DLayer::loadParameters(const nlohmann::json &j) {
+    uploadParameters(j.at("weights").get<std::vector<float> >(), j.at("biases").get<std::vector<float> >());
+}
+
+void Conv2DLayer::downloadParameters(std::vector<float> &weights, std::vector<float> &biases) const {
+    weights.resize(weightCount());
+    biases.resize(outChannels);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, weightsBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, weights.size() * sizeof(float), weights.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases.size() * sizeof(float), biases.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Conv2DLayer::uploadParameters(const std::vector<float> &weights, const std::vector<float> &biases) {
+    if (weights.size() != weightCount() || biases.size() != static_cast<size_t>(outChannels)) {
+        throw std::runtime_error("Mismatched data size when loading convolution parameters.");
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, weightsBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, weights.size() * sizeof(float), weights.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases.size() * sizeof(float), biases.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,88 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#ifndef CONV2DLAYER_H
+#define CONV2DLAYER_H
+
+#include <cstdint>
+
+#include "FeatureLayer.h"
+
+class WeightInitializer;
+
+enum class ConvAlgorithm {
+    AUTO, // DIRECT when its shared-memory tile fits, IM2COL otherwise
+    DIRECT, // tiled direct convolution, input patches staged in shared memory
+    IM2COL // unfold the input, then one GEMM with matmul.comp
+};
+
+/**
+ * @brief 2D convolution (cross-correlation) with bias and activation: a = g(W * x + b).
+ * Weights are OC x C x K x K, row-major.
+ */
+class Conv2DLayer : public FeatureLayer {
+public:
+    const int outChannels;
+    const int kernelSize;
+    const int stride;
+    const int padding;
+    const FeatureActivation activation;
+
+    Conv2DLayer(TensorShape input, int outChannels, int kernelSize, int stride, int padding,
+                FeatureActivation activation, ConvAlgorithm algorithm, FeatureKernels *kernels);
+
+    ~Conv2DLayer() override;
+
+    /**
+     * @brief Draws W on the device (see WeightInitializer): He for ReLU, Xavier otherwise.
+     * The constructor leaves it uninitialized.
+     */
+    void initializeWeights(const WeightInitializer &initializer, uint64_t seed, uint32_t stream);
+
+    void forward(GLuint inputBuffer, GLuint outputBuffer) override;
+
+    void backward(GLuint inputBuffer, GLuint errorFromOutput, GLuint errorForInput, bool accumulate) override;
+
+    void update(float learningRate) override;
+
+    [[nodiscard]] std::vector<ParameterBuffer> parameters() const override;
+
+    [[nodiscard]] nlohmann::json toJson(bool withParameters = true) const override;
+
+    void loadParameters(const nlohmann::json &j) override;
+
+    void downloadParameters(std::vector<float> &weights, std::vector<float> &biases) const;
+
+    void uploadParameters(const std::vector<float> &weights, const std::vector<float> &biases);
+
+    [[nodiscard]] ConvAlgorithm getAlgorithm() const { return algorithm; }
+
+    [[nodiscard]] size_t weightCount() const {
+        return static_cast<size_t>(outChannels) * inShape.channels * kernelSize * kernelSize;
+    }
+
+    /**
+     * @brief Whether conv2d_direct.comp can stage the input patch of one tile in shared memory.
+     */
+    static bool directFits(int kernelSize, int stride);
+
+    static TensorShape outputShapeFor(TensorShape input, int outChannels, int kernelSize, int stride, int padding);
+
+private:
+    FeatureKernels *kernels;
+    ConvAlgorithm algorithm;
+
+    GLuint weightsBuffer = 0;
+    GLuint biasesBuffer = 0;
+    GLuint gradWeightsBuffer = 0;
+    GLuint gradBiasesBuffer = 0;
+    GLuint preActivationBuffer = 0; // z, kept for the backward pass
+    GLuint deltaBuffer = 0;
+    GLuint columnsBuffer = 0; // im2col only
+
+    // Sets the shape uniforms shared by all convolution kernels
+    void setGeometry(const Shader &shader) const;
+};
+
+#endif //CONV2DLAYER_H
@@ -0,0 +1,189 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#include "CpuKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace CpuKernels {
+    void matVec(const float *W, const float *x, float *y, const int rows, const int cols) {
+        for (int r = 0; r < rows; ++r) {
+            const float *row = W + static_cast<size_t>(r) * cols;
+            float sum = 0.0f;
+            for (int c = 0; c < cols; ++c) {
+                sum += row[c] * x[c];
+            }
+            y[r] = sum;
+        }
+    }
+
+    void matVecBatch(const float *W, const float *X, float *Y, const int rows, const int cols, const int batch) {
+        for (int r = 0; r < rows; ++r) {
+            const float *row = W + static_cast<size_t>(r) * cols;
+            // The row stays in cache while it is applied to every sample
+            for (int b = 0; b < batch; ++b) {
+                const float *x = X + static_cast<size_t>(b) * cols;
+                float sum = 0.0f;
+                for (int c = 0; c < cols; ++c) {
+                    sum += row[c] * x[c];
+                }
+                Y[static_cast<size_t>(b) * rows + r] = sum;
+            }
+        }
+    }
+
+    void matVecTransposed(const float *W, const float *x, float *y, const int rows, const int cols) {
+        for (int c = 0; c < cols; ++c) y[c] = 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            const float *row = W + static_cast<size_t>(r) * cols;
+            const float xr = x[r];
+            for (int c = 0; c < cols; ++c) {
+                y[c] += row[c] * xr;
+            }
+        }
+    }
+
+    void spmvCsr(const int *rowStart, const int *columns, const float *values, const float *x, float *y,
+                 const int rows) {
+        for (int r = 0; r < rows; ++r) {
+            float sum = 0.0f;
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                sum += values[k] * x[columns[k]];
+            }
+            y[r] = sum;
+        }
+    }
+
+    void spmvCsrTransposed(const int *rowStart, const int *columns, const float *values, const float *x, float *y,
+                           const int rows, const int cols) {
+        for (int c = 0; c < cols; ++c) y[c] = 0.0f;
+        for (int r = 0; r < rows; ++r) {
+            const float xr = x[r];
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                y[columns[k]] += values[k] * xr;
+            }
+        }
+    }
+
+    void csrOuterProduct(const int *rowStart, const int *columns, const float *a, const float *b, float *grad,
+                         const int rows, const bool accumulate) {
+        for (int r = 0; r < rows; ++r) {
+            const float ar = a[r];
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                grad[k] = accumulate ? grad[k] + ar * b[columns[k]] : ar * b[columns[k]];
+            }
+        }
+    }
+
+    void addInPlace(float *a, const float *b, const int count) {
+        for (int i = 0; i < count; ++i) a[i] += b[i];
+    }
+
+    void outerProduct(const float *a, const float *b, float *out, const int rows, const int cols,
+                      const bool accumulate) {
+        for (int r = 0; r < rows; ++r) {
+            float *row = out + static_cast<size_t>(r) * cols;
+            const float ar = a[r];
+            if (accumulate) {
+                for (int c = 0; c < cols; ++c) row[c] += ar * b[c];
+            } else {
+                for (int c = 0; c < cols; ++c) row[c] = ar * b[c];
+            }
+        }
+    }
+
+    void sgdUpdate(float *p, const float *g, const float learningRate, const size_t count) {
+        for (size_t i = 0; i < count; ++i) p[i] -= learningRate * g[i];
+    }
+
+    void sigmoid(const float *z, float *a, const int count) {
+        for (int i = 0; i < count; ++i) a[i] = 1.0f / (1.0f + std::exp(-z[i]));
+    }
+
+    void sigmoidDerivative(const float *z, float *out, const int count) {
+        for (int i = 0; i < count; ++i) {
+            const float s = 1.0f / (1.0f + std::exp(-z[i]));
+            out[i] = s * (1.0f - s);
+        }
+    }
+
+    void relu(const float *z, float *a, const int count) {
+        for (int i = 0; i < count; ++i) a[i] = std::max(z[i], 0.0f);
+    }
+
+    void conv2d(const float *x, const float *W, const float *b, float *z, const int inChannels, const int inHeight,
+                const int inWidth, const int outChannels, const int kernel, const int stride, const int padding) {
+        const int outHeight = (inHeight + 2 * padding - kernel) / stride + 1;
+        const int outWidth = (inWidth + 2 * padding - kernel) / stride + 1;
+        const size_t pixels = static_cast<size_t>(outHeight) * outWidth;
+
+        for (int oc = 0; oc < outChannels; ++oc) {
+            float *plane = z + oc * pixels;
+            std::fill(plane, plane + pixels, b[oc]);
+
+            // Accumulate one kernel tap at a time over the whole output plane, so the inner loop is contiguous
+            for (int c = 0; c < inChannels; ++c) {
+                const float *input = x + static_cast<size_t>(c) * inHeight * inWidth;
+                const float *taps = W + (static_cast<size_t>(oc) * inChannels + c) * kernel * kernel;
+                for (int ky = 0; ky < kernel; ++ky) {
+                    for (int kx = 0; kx < kernel; ++kx) {
+                        const float w = taps[ky * kernel + kx];
+                        for (int oy = 0; oy < outHeight; ++oy) {
+                            const int iy = oy * stride + ky - padding;
+                            if (iy < 0 || iy >= inHeight) continue;
+                            const float *row = input + static_cast<size_t>(iy) * inWidth;
+                            float *out = plane + static_cast<size_t>(oy) * outWidth;
+                            for (int ox = 0; ox < outWidth; ++ox) {
+                                const int ix = ox * stride + kx - padding;
+                                if (ix >= 0 && ix < inWidth) out[ox] += w * row[ix];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void maxPool2d(const float *x, float *y, const int channels, const int inHeight, const int inWidth,
+                   const int window, const int stride) {
+        const int outHeight = (inHeight - window) / stride + 1;
+        const int outWidth = (inWidth - window) / stride + 1;
+        for (int c = 0; c < channels; ++c) {
+            const float *input = x + static_cast<size_t>(c) * inHeight * inWidth;
+            for (int oy = 0; oy < outHeight; ++oy) {
+                for (int ox = 0; ox < outWidth; ++ox) {
+                    float best = -std::numeric_limits<float>::max();
+                    for (int wy = 0; wy < window; ++wy) {
+                        const float *row = input + static_cast<size_t>(oy * stride + wy) * inWidth + ox * stride;
+                        for (int wx = 0; wx < window; ++wx) best = std::max(best, row[wx]);
+                    }
+                    *y++ = best;
+                }
+            }
+        }
+    }
+
+    void avgPool2d(const float *x, float *y, const int channels, const int inHeight, const int inWidth,
+                   const int window, const int stride) {
+        const int outHeight = (inHeight - window) / stride + 1;
+        const int outWidth = (inWidth - window) / stride + 1;
+        const float scale = 1.0f / static_cast<float>(window * window);
+        for (int c = 0; c < channels; ++c) {
+            const float *input = x + static_cast<size_t>(c) * inHeight * inWidth;
+            for (int oy = 0; oy < outHeight; ++oy) {
+                for (int ox = 0; ox < outWidth; ++ox) {
+                    float sum = 0.0f;
+                    for (int wy = 0; wy < window; ++wy) {
+                        const float *row = input + static_cast<size_t>(oy * stride + wy) * inWidth + ox * stride;
+                        for (int wx = 0; wx < window; ++wx) sum += row[wx];
+                    }
+                    *y++ = sum * scale;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#ifndef CPUKERNELS_H
+#define CPUKERNELS_H
+
+// Host-side versions of the compute shaders in src/shaders, used by the CPU backends.
+// All matrices are row-major, like on the GPU.
+#include <cstddef>
+
+namespace CpuKernels {
+    /**
+     * @brief y = W * x for a rows x cols matrix W.
+     */
+    void matVec(const float *W, const float *x, float *y, int rows, int cols);
+
+    /**
+     * @brief Y[b] = W * X[b] for every sample b of a batch. X is batch x cols, Y is batch x rows.
+     * Walks W once per batch instead of once per sample.
+     */
+    void matVecBatch(const float *W, const float *X, float *Y, int rows, int cols, int batch);
+
+    /**
+     * @brief y = transpose(W) * x for a rows x cols matrix W (y has cols entries).
+     */
+    void matVecTransposed(const float *W, const float *x, float *y, int rows, int cols);
+
+    /**
+     * @brief y = A * x for a sparse rows-row matrix A in CSR form: the nonzeros of row r are
+     * values[rowStart[r] .. rowStart[r + 1]), at the columns in `columns`. Like spmv_csr.comp.
+     */
+    void spmvCsr(const int *rowStart, const int *columns, const float *values, const float *x, float *y, int rows);
+
+    /**
+     * @brief y = transpose(A) * x for the same CSR matrix (y has cols entries).
+     */
+    void spmvCsrTransposed(const int *rowStart, const int *columns, const float *values, const float *x, float *y,
+                           int rows, int cols);
+
+    /**
+     * @brief grad = a * transpose(b), only at the nonzeros of the CSR matrix, like csr_outer_product.comp.
+     */
+    void csrOuterProduct(const int *rowStart, const int *columns, const float *a, const float *b, float *grad,
+                         int rows, bool accumulate);
+
+    void addInPlace(float *a, const float *b, int count);
+
+    /**
+     * @brief out = a * transpose(b) (rows x cols), or out += ... if accumulate is set.
+     */
+    void outerProduct(const float *a, const float *b, float *out, int rows, int cols, bool accumulate);
+
+    /**
+     * @brief p -= learningRate * g
+     */
+    void sgdUpdate(float *p, const float *g, float learningRate, size_t count);
+
+    void sigmoid(const float *z, float *a, int count);
+
+    void sigmoidDerivative(const float *z, float *out, int count);
+
+    void relu(const float *z, float *a, int count);
+
+    /**
+     * @brief z = W * x + b for CHW images (cross-correlation, zero padding), like conv2d_direct.comp.
+     * W is outChannels x inChannels x kernel x kernel; z is outChannels x outHeight x outWidth.
+     */
+    void conv2d(const float *x, const float *W, const float *b, float *z, int inChannels, int inHeight,
+                int inWidth, int outChannels, int kernel, int stride, int padding);
+
+    /**
+     * @brief Max over window x window regions of every channel, output size (in - window) / stride + 1.
+     */
+    void maxPool2d(const float *x, float *y, int channels, int inHeight, int inWidth, int window, int stride);
+
+    void avgPool2d(const float *x, float *y, int channels, int inHeight, int inWidth, int window, int stride);
+}
+
+#endif //CPUKERNELS_H
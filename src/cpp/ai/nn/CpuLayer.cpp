@@ -0,0 +1,133 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#include "CpuLayer.h"
+#include "CpuKernels.h"
+#include "Layer.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+    void download(const GLuint buffer, std::vector<float> &data) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(float), data.data());
+    }
+
+    void upload(const GLuint buffer, const std::vector<float> &data) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(float), data.data());
+    }
+}
+
+CpuLayer::CpuLayer(const int inputSize, const int neuronCount)
+    : inputSize(inputSize),
+      neuronCount(neuronCount),
+      weights(static_cast<size_t>(neuronCount) * inputSize),
+      biases(neuronCount),
+      gradWeights(weights.size()),
+      gradBiases(neuronCount),
+      input(inputSize),
+      weightedSum(neuronCount),
+      output(neuronCount),
+      delta(neuronCount),
+      propagated(neuronCount) {
+}
+
+CpuLayer::CpuLayer(const Layer &layer) : CpuLayer(layer.inputSize, layer.neuronCount) {
+    layer.downloadWeightGradients(gradWeights.data());
+    if (layer.isSparse()) {
+        layer.downloadSparse(rowStart, columns, weights);
+        download(layer.biasesBuffer, biases);
+        // Keep the gradients of the nonzeros only
+        std::vector<float> sparseGradients(weights.size());
+        for (int r = 0; r < neuronCount; ++r) {
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                sparseGradients[k] = gradWeights[static_cast<size_t>(r) * inputSize + columns[k]];
+            }
+        }
+        gradWeights = std::move(sparseGradients);
+    } else {
+        layer.downloadParameters(weights, biases);
+    }
+    download(layer.gradBiasesBuffer, gradBiases);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void CpuLayer::copyTo(Layer &layer) const {
+    if (isSparse()) {
+        // The layer keeps the same pattern
+        std::vector<float> dense(static_cast<size_t>(neuronCount) * inputSize, 0.0f);
+        std::vector<float> denseGradients(dense.size(), 0.0f);
+        for (int r = 0; r < neuronCount; ++r) {
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                dense[static_cast<size_t>(r) * inputSize + columns[k]] = weights[k];
+                denseGradients[static_cast<size_t>(r) * inputSize + columns[k]] = gradWeights[k];
+            }
+        }
+        layer.uploadParameters(dense, biases);
+        layer.uploadWeightGradients(denseGradients.data());
+    } else {
+        layer.uploadParameters(weights, biases);
+        layer.uploadWeightGradients(gradWeights.data());
+    }
+    upload(layer.gradBiasesBuffer, gradBiases);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void CpuLayer::forward(const float *x) {
+    std::copy_n(x, inputSize, input.begin());
+    if (isSparse()) {
+        CpuKernels::spmvCsr(rowStart.data(), columns.data(), weights.data(), x, weightedSum.data(), neuronCount);
+    } else {
+        CpuKernels::matVec(weights.data(), x, weightedSum.data(), neuronCount, inputSize);
+    }
+    CpuKernels::addInPlace(weightedSum.data(), biases.data(), neuronCount);
+    CpuKernels::sigmoid(weightedSum.data(), output.data(), neuronCount);
+}
+
+void CpuLayer::backward(const float *errorFromOutput, const bool accumulate) {
+    std::copy_n(errorFromOutput, neuronCount, delta.begin());
+    computeGradients(accumulate);
+}
+
+void CpuLayer::backwardFromTarget(const float *target, const bool accumulate) {
+    for (int i = 0; i < neuronCount; ++i) delta[i] = output[i] - target[i];
+    computeGradients(accumulate);
+}
+
+void CpuLayer::backward(const CpuLayer &next, const bool accumulate) {
+    next.propagate(propagated.data());
+    CpuKernels::sigmoidDerivative(weightedSum.data(), delta.data(), neuronCount);
+    for (int i = 0; i < neuronCount; ++i) delta[i] *= propagated[i];
+    computeGradients(accumulate);
+}
+
+void CpuLayer::propagate(float *errorForInput) const {
+    if (isSparse()) {
+        CpuKernels::spmvCsrTransposed(rowStart.data(), columns.data(), weights.data(), delta.data(), errorForInput,
+                                      neuronCount, inputSize);
+    } else {
+        CpuKernels::matVecTransposed(weights.data(), delta.data(), errorForInput, neuronCount, inputSize);
+    }
+}
+
+void CpuLayer::computeGradients(const bool accumulate) {
+    if (isSparse()) {
+        CpuKernels::csrOuterProduct(rowStart.data(), columns.data(), delta.data(), input.data(), gradWeights.data(),
+                                    neuronCount, accumulate);
+    } else {
+        CpuKernels::outerProduct(delta.data(), input.data(), gradWeights.data(), neuronCount, inputSize, accumulate);
+    }
+    if (accumulate) {
+        CpuKernels::addInPlace(gradBiases.data(), delta.data(), neuronCount);
+    } else {
+        gradBiases = delta;
+    }
+}
+
+void CpuLayer::update(const float learningRate) {
+    CpuKernels::sgdUpdate(weights.data(), gradWeights.data(), learningRate, weights.size());
+    CpuKernels::sgdUpdate(biases.data(), gradBiases.data(), learningRate, biases.size());
+}
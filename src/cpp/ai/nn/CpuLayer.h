@@ -0,0 +1,82 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#ifndef CPULAYER_H
+#define CPULAYER_H
+
+#include <vector>
+
+class Layer;
+
+/**
+ * @brief Host-side twin of a Layer: same math (a = sigmoid(W * x + b)), same parameter layout, no GL.
+ * Used for the layers the placement planner moves to the CPU.
+ */
+class CpuLayer {
+public:
+    const int inputSize;
+    const int neuronCount;
+
+    std::vector<float> weights; // neuronCount x inputSize, row-major
+    std::vector<float> biases;
+    std::vector<float> gradWeights;
+    std::vector<float> gradBiases;
+
+    // CSR pattern of W once the layer is pruned (see Layer::prune()); weights and gradWeights then only
+    // hold the nonzeros, in this order. Empty for a dense layer.
+    std::vector<int> rowStart;
+    std::vector<int> columns;
+
+    // Kept from the last forward() for the backward pass
+    std::vector<float> input;
+    std::vector<float> weightedSum;
+    std::vector<float> output;
+    std::vector<float> delta;
+
+    // Zero parameters
+    CpuLayer(int inputSize, int neuronCount);
+
+    /**
+     * @brief Copies the parameters and gradients of a GPU layer.
+     */
+    explicit CpuLayer(const Layer &layer);
+
+    void forward(const float *x);
+
+    /**
+     * @brief Backward pass for the OUTPUT layer: δ = errorFromOutput (prediction - target).
+     */
+    void backward(const float *errorFromOutput, bool accumulate = false);
+
+    /**
+     * @brief Same, with δ = prediction - target computed from the last forward().
+     */
+    void backwardFromTarget(const float *target, bool accumulate = false);
+
+    /**
+     * @brief Backward pass for HIDDEN layers: δ = (transpose(W_next) * δ_next) .* g'(z).
+     */
+    void backward(const CpuLayer &next, bool accumulate = false);
+
+    /**
+     * @brief errorForInput = transpose(W) * δ, the propagated error for whatever feeds this layer.
+     */
+    void propagate(float *errorForInput) const;
+
+    void update(float learningRate);
+
+    [[nodiscard]] bool isSparse() const { return !rowStart.empty(); }
+
+    /**
+     * @brief Writes parameters and gradients back into the GPU layer's buffers.
+     */
+    void copyTo(Layer &layer) const;
+
+private:
+    std::vector<float> propagated;
+
+    void computeGradients(bool accumulate);
+};
+
+#endif //CPULAYER_H
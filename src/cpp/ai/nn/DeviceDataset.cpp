@@ -0,0 +1,172 @@
+//
+// Created by CorruptionHades on 11/10/2025.
+//
+
+#include "DeviceDataset.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+size_t DeviceDataset::rowsPerPageFor(const int inputSize, const int targetSize) {
+    GLint64 maxBlockSize = 0;
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxBlockSize);
+    // Offsets inside a page are 32-bit in the gather shader
+    const auto pageBytes = static_cast<size_t>(std::min<GLint64>(maxBlockSize, GLint64{1} << 31));
+    const size_t rowBytes = static_cast<size_t>(inputSize + targetSize) * sizeof(float);
+    return pageBytes / rowBytes;
+}
+
+bool DeviceDataset::fits(const size_t sampleCount, const int inputSize, const int targetSize) {
+    const size_t rows = rowsPerPageFor(inputSize, targetSize);
+    return rows > 0 && sampleCount <= rows * MAX_PAGES;
+}
+
+DeviceDataset::DeviceDataset(const TrainingData &data)
+    : sampleCount(data.inputs.size()),
+      inputSize(data.inputs.empty() ? 0 : static_cast<int>(data.inputs.front().size())),
+      targetSize(data.targets.empty() ? 0 : static_cast<int>(data.targets.front().size())),
+      rowsPerPage(0) {
+    if (data.targets.size() != sampleCount) {
+        throw std::invalid_argument("DeviceDataset needs a non-empty dataset with one target per input.");
+    }
+    prepare();
+
+    const size_t rowSize = inputSize + targetSize;
+    const size_t pageCount = (sampleCount + rowsPerPage - 1) / rowsPerPage;
+
+    std::cout << "Uploading " << sampleCount << " samples to the device in " << pageCount << " page(s)..." << std::endl;
+
+    // Pack row by row straight into the pages, no full host-side copy
+    std::vector<float> row(rowSize);
+    for (size_t p = 0; p < pageCount; ++p) {
+        const size_t first = p * rowsPerPage;
+        const size_t count = std::min(rowsPerPage, sampleCount - first);
+
+        GLuint page;
+        glGenBuffers(1, &page);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, page);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * rowSize * sizeof(float), nullptr, GL_STATIC_DRAW);
+
+        for (size_t r = 0; r < count; ++r) {
+            const auto &input = data.inputs[first + r];
+            const auto &target = data.targets[first + r];
+            if (input.size() != static_cast<size_t>(inputSize) || target.size() != static_cast<size_t>(targetSize)) {
+                glDeleteBuffers(1, &page);
+                throw std::invalid_argument("All samples of a DeviceDataset must have the same size.");
+            }
+            std::copy(input.begin(), input.end(), row.begin());
+            std::copy(target.begin(), target.end(), row.begin() + inputSize);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, r * rowSize * sizeof(float), rowSize * sizeof(float), row.data());
+        }
+        pages.push_back(page);
+    }
+
+    createIndexBuffer();
+}
+
+DeviceDataset::DeviceDataset(const SampleMatrix &data)
+    : sampleCount(data.rows),
+      inputSize(static_cast<int>(data.inputSize)),
+      targetSize(static_cast<int>(data.targetSize)),
+      rowsPerPage(0) {
+    prepare();
+
+    const size_t rowSize = data.rowSize();
+    const size_t pageCount = (sampleCount + rowsPerPage - 1) / rowsPerPage;
+
+    std::cout << "Uploading " << sampleCount << " samples to the device in " << pageCount << " page(s)..." << std::endl;
+
+    // One upload per page, straight from the matrix
+    for (size_t p = 0; p < pageCount; ++p) {
+        const size_t first = p * rowsPerPage;
+        const size_t count = std::min(rowsPerPage, sampleCount - first);
+
+        GLuint page;
+        glGenBuffers(1, &page);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, page);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, count * rowSize * sizeof(float), data.input(first), GL_STATIC_DRAW);
+        pages.push_back(page);
+    }
+
+    createIndexBuffer();
+}
+
+void DeviceDataset::prepare() {
+    if (sampleCount == 0) {
+        throw std::invalid_argument("DeviceDataset needs a non-empty dataset with one target per input.");
+    }
+    if (!fits(sampleCount, inputSize, targetSize)) {
+        throw std::runtime_error("Dataset is too large to be kept on the device.");
+    }
+
+    shuffleShader.loadComputeShader("shaders/shuffle_indices.comp");
+    gatherShader.loadComputeShader("shaders/gather.comp", "#define MAX_PAGES " + std::to_string(MAX_PAGES) + "\n");
+
+    rowsPerPage = rowsPerPageFor(inputSize, targetSize);
+}
+
+void DeviceDataset::createIndexBuffer() {
+    glGenBuffers(1, &indexBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sampleCount * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+DeviceDataset::~DeviceDataset() {
+    glDeleteBuffers(pages.size(), pages.data());
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteProgram(shuffleShader.ID);
+    glDeleteProgram(gatherShader.ID);
+}
+
+void DeviceDataset::shuffle(const uint64_t seed) {
+    // Smallest even bit count whose domain covers every index
+    GLuint bits = 2;
+    while (bits < 32 && (uint64_t{1} << bits) < sampleCount) bits += 2;
+
+    shuffleShader.use();
+    shuffleShader.setUInt("u_count", static_cast<GLuint>(sampleCount));
+    shuffleShader.setUInt("u_half_bits", bits / 2);
+    shuffleShader.setUInt("u_seed_lo", static_cast<GLuint>(seed));
+    shuffleShader.setUInt("u_seed_hi", static_cast<GLuint>(seed >> 32));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, indexBuffer);
+    shuffleShader.dispatch((sampleCount + 255) / 256, 1, 1);
+    hasShuffled = true;
+}
+
+void DeviceDataset::gather(const size_t position, const GLuint inputBuffer, const GLuint targetBuffer,
+                           const bool shuffled) {
+    if (position >= sampleCount) {
+        throw std::out_of_range("Dataset position out of range.");
+    }
+    if (shuffled && !hasShuffled) {
+        shuffle(0);
+    }
+
+    gatherShader.use();
+    gatherShader.setUInt("u_position", static_cast<GLuint>(position));
+    gatherShader.setInt("u_shuffled", shuffled ? 1 : 0);
+    gatherShader.setUInt("u_rows_per_page", static_cast<GLuint>(rowsPerPage));
+    gatherShader.setInt("u_input_size", inputSize);
+    gatherShader.setInt("u_target_size", targetSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, indexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, inputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, targetBuffer);
+    for (int p = 0; p < MAX_PAGES; ++p) {
+        // Unused page slots still get a valid buffer bound
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3 + p, pages[std::min<size_t>(p, pages.size() - 1)]);
+    }
+    gatherShader.dispatch((inputSize + targetSize + 255) / 256, 1, 1);
+}
+
+void DeviceDataset::bindForReading(const GLuint binding) {
+    if (!hasShuffled) {
+        shuffle(0);
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, indexBuffer);
+    for (int p = 0; p < MAX_PAGES; ++p) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding + 1 + p, pages[std::min<size_t>(p, pages.size() - 1)]);
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Created by CorruptionHades on 11/10/2025.
+//
+
+#ifndef DEVICEDATASET_H
+#define DEVICEDATASET_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+
+#include "../gl/Shader.h"
+#include "../utils/DatasetLoader.h"
+
+/**
+ * @brief A dataset that lives entirely in GPU memory.
+ *
+ * Samples are packed once into large SSBOs ("pages", each below GL_MAX_SHADER_STORAGE_BLOCK_SIZE).
+ * Every epoch, shuffle() generates a random permutation on the GPU and gather() copies one sample
+ * into the network's input/target buffers, so the host only sends a seed per epoch and a uniform
+ * per step instead of every sample.
+ */
+class DeviceDataset {
+public:
+    static constexpr int MAX_PAGES = 5;
+
+    explicit DeviceDataset(const TrainingData &data);
+
+    /**
+     * @brief Uploads the matrix page by page, its rows already have the layout of a page.
+     */
+    explicit DeviceDataset(const SampleMatrix &data);
+
+    ~DeviceDataset();
+
+    DeviceDataset(const DeviceDataset &) = delete;
+
+    DeviceDataset &operator=(const DeviceDataset &) = delete;
+
+    /**
+     * @brief Returns true if a dataset of this shape fits into MAX_PAGES storage buffers.
+     */
+    static bool fits(size_t sampleCount, int inputSize, int targetSize);
+
+    /**
+     * @brief Generates a new sample order on the GPU. The same seed always gives the same order.
+     */
+    void shuffle(uint64_t seed);
+
+    /**
+     * @brief Copies a sample into the given buffers on the GPU.
+     * @param position Position in the epoch (0 .. size() - 1).
+     * @param shuffled Whether position goes through the permutation of the last shuffle().
+     */
+    void gather(size_t position, GLuint inputBuffer, GLuint targetBuffer, bool shuffled = true);
+
+    /**
+     * @brief Binds the permutation of the last shuffle() at `binding` and the MAX_PAGES pages at the bindings
+     * after it, for kernels that read samples themselves. Shuffles with seed 0 if shuffle() was never called.
+     */
+    void bindForReading(GLuint binding);
+
+    [[nodiscard]] size_t getRowsPerPage() const { return rowsPerPage; }
+
+    [[nodiscard]] size_t size() const { return sampleCount; }
+
+    [[nodiscard]] int getInputSize() const { return inputSize; }
+
+    [[nodiscard]] int getTargetSize() const { return targetSize; }
+
+private:
+    size_t sampleCount;
+    int inputSize;
+    int targetSize;
+    size_t rowsPerPage;
+
+    std::vector<GLuint> pages;
+    GLuint indexBuffer = 0;
+    bool hasShuffled = false;
+
+    Shader shuffleShader;
+    Shader gatherShader;
+
+    static size_t rowsPerPageFor(int inputSize, int targetSize);
+
+    /**
+     * @brief Checks the shape, loads the shaders and sizes the pages.
+     */
+    void prepare();
+
+    void createIndexBuffer();
+};
+
+#endif //DEVICEDATASET_H
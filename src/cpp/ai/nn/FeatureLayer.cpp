@@ -0,0 +1,61 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#include "FeatureLayer.h"
+#include "Conv2DLayer.h"
+#include "PoolLayer.h"
+
+#include <stdexcept>
+
+FeatureKernels::FeatureKernels(const Shader *matmul, const Shader *sgdUpdate) : matmul(matmul),
+    sgdUpdate(sgdUpdate) {
+    convDirect.loadComputeShader("shaders/conv2d_direct.comp");
+    im2col.loadComputeShader("shaders/im2col.comp");
+    convBiasActivation.loadComputeShader("shaders/conv_bias_activation.comp");
+    convDelta.loadComputeShader("shaders/conv_delta.comp");
+    convGradParams.loadComputeShader("shaders/conv_grad_params.comp");
+    convGradInput.loadComputeShader("shaders/conv_grad_input.comp");
+    pool.loadComputeShader("shaders/pool.comp");
+    poolBackward.loadComputeShader("shaders/pool_backward.comp");
+}
+
+FeatureKernels::~FeatureKernels() {
+    for (const Shader *shader: {
+             &convDirect, &im2col, &convBiasActivation, &convDelta, &convGradParams, &convGradInput, &pool,
+             &poolBackward
+         }) {
+        glDeleteProgram(shader->ID);
+    }
+}
+
+namespace {
+    FeatureActivation parseActivation(const std::string &name) {
+        if (name == "none") return FeatureActivation::NONE;
+        if (name == "sigmoid") return FeatureActivation::SIGMOID;
+        if (name == "relu") return FeatureActivation::RELU;
+        throw std::runtime_error("Unknown feature activation: " + name);
+    }
+
+    ConvAlgorithm parseAlgorithm(const std::string &name) {
+        if (name == "direct") return ConvAlgorithm::DIRECT;
+        if (name == "im2col") return ConvAlgorithm::IM2COL;
+        return ConvAlgorithm::AUTO;
+    }
+}
+
+std::unique_ptr<FeatureLayer> FeatureLayer::fromJson(const nlohmann::json &j, const TensorShape input,
+                                                     FeatureKernels &kernels) {
+    const auto type = j.at("type").get<std::string>();
+    if (type == "conv2d") {
+        return std::make_unique<Conv2DLayer>(input, j.at("out_channels").get<int>(), j.at("kernel").get<int>(),
+                                             j.value("stride", 1), j.value("padding", 0),
+                                             parseActivation(j.value("activation", "relu")),
+                                             parseAlgorithm(j.value("algorithm", "auto")), &kernels);
+    }
+    if (type == "max_pool" || type == "avg_pool") {
+        return std::make_unique<PoolLayer>(input, type == "max_pool" ? PoolType::MAX : PoolType::AVERAGE,
+                                           j.at("window").get<int>(), j.value("stride", 0), &kernels);
+    }
+    throw std::runtime_error("Unknown feature layer type: " + type);
+}
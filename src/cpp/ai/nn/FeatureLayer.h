@@ -0,0 +1,119 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#ifndef FEATURELAYER_H
+#define FEATURELAYER_H
+
+#include <GL/glew.h>
+#include <memory>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../gl/Shader.h"
+
+// Channels x height x width, stored channel-major (CHW) in buffers
+struct TensorShape {
+    int channels = 0;
+    int height = 0;
+    int width = 0;
+
+    [[nodiscard]] int size() const { return channels * height * width; }
+
+    bool operator==(const TensorShape &) const = default;
+};
+
+// Activation applied by a feature layer, matches shaders/feature_activation.glsl
+enum class FeatureActivation {
+    NONE = 0,
+    SIGMOID = 1,
+    RELU = 2
+};
+
+// A trainable parameter tensor and its gradient
+struct ParameterBuffer {
+    GLuint values;
+    GLuint gradients;
+    size_t count;
+};
+
+/**
+ * @brief Shaders of the feature layers. Owned by the network, loaded when the first feature layer is added.
+ */
+struct FeatureKernels {
+    Shader convDirect;
+    Shader im2col;
+    Shader convBiasActivation;
+    Shader convDelta;
+    Shader convGradParams;
+    Shader convGradInput;
+    Shader pool;
+    Shader poolBackward;
+    // Shared with the dense layers
+    const Shader *matmul;
+    const Shader *sgdUpdate;
+
+    FeatureKernels(const Shader *matmul, const Shader *sgdUpdate);
+
+    ~FeatureKernels();
+
+    FeatureKernels(const FeatureKernels &) = delete;
+
+    FeatureKernels &operator=(const FeatureKernels &) = delete;
+};
+
+/**
+ * @brief A layer in front of the dense stack that works on CHW images (convolution, pooling).
+ * The last feature layer's output is flattened into the input of the first dense Layer.
+ */
+class FeatureLayer {
+public:
+    FeatureLayer(const TensorShape input, const TensorShape output) : inShape(input), outShape(output) {
+    }
+
+    virtual ~FeatureLayer() = default;
+
+    FeatureLayer(const FeatureLayer &) = delete;
+
+    FeatureLayer &operator=(const FeatureLayer &) = delete;
+
+    [[nodiscard]] TensorShape inputShape() const { return inShape; }
+
+    [[nodiscard]] TensorShape outputShape() const { return outShape; }
+
+    virtual void forward(GLuint inputBuffer, GLuint outputBuffer) = 0;
+
+    /**
+     * @brief Computes the parameter gradients and the error for the previous layer.
+     * @param inputBuffer The input of the last forward() call.
+     * @param errorFromOutput dL/d(output).
+     * @param errorForInput Receives dL/d(input); 0 for the first layer, where it is not needed.
+     * @param accumulate If true, the gradients are added to the existing ones instead of replacing them.
+     */
+    virtual void backward(GLuint inputBuffer, GLuint errorFromOutput, GLuint errorForInput, bool accumulate) = 0;
+
+    // Layers without parameters have nothing to update
+    virtual void update(float /*learningRate*/) {
+    }
+
+    [[nodiscard]] virtual std::vector<ParameterBuffer> parameters() const { return {}; }
+
+    /**
+     * @brief Layer description, plus weights/biases if `withParameters` is set.
+     */
+    [[nodiscard]] virtual nlohmann::json toJson(bool withParameters = true) const = 0;
+
+    virtual void loadParameters(const nlohmann::json & /*j*/) {
+    }
+
+    /**
+     * @brief Creates a layer from a toJson() description (without loading parameters).
+     */
+    static std::unique_ptr<FeatureLayer> fromJson(const nlohmann::json &j, TensorShape input, FeatureKernels &kernels);
+
+protected:
+    TensorShape inShape;
+    TensorShape outShape;
+};
+
+#endif //FEATURELAYER_H
@@ -0,0 +1,127 @@
+//
+// Created by CorruptionHades on 09/10/2025.
+//
+
+#include "GpuMetrics.h"
+
+#include <stdexcept>
+
+GpuMetrics::GpuMetrics(const float threshold) : threshold(threshold) {
+    metricsShader.loadComputeShader("shaders/metrics.comp");
+
+    glGenBuffers(1, &counterBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, COUNTER_COUNT * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    clearCounters();
+}
+
+GpuMetrics::~GpuMetrics() {
+    for (const auto &readback: inFlight) {
+        glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.staging);
+    }
+    glDeleteBuffers(freeStaging.size(), freeStaging.data());
+    glDeleteBuffers(1, &counterBuffer);
+    glDeleteProgram(metricsShader.ID);
+}
+
+void GpuMetrics::clearCounters() const {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void GpuMetrics::accumulate(const GLuint predictionBuffer, const GLuint targetBuffer, const int outputCount) {
+    metricsShader.use();
+    metricsShader.setInt("u_output_count", outputCount);
+    glUniform1f(glGetUniformLocation(metricsShader.ID, "u_threshold"), threshold);
+    glUniform1f(glGetUniformLocation(metricsShader.ID, "u_loss_scale"), LOSS_SCALE);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, predictionBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, targetBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, counterBuffer);
+    metricsShader.dispatch(1, 1, 1);
+}
+
+void GpuMetrics::submit(const int tag) {
+    // Staging buffers are recycled once their result has been read
+    GLuint staging;
+    if (!freeStaging.empty()) {
+        staging = freeStaging.back();
+        freeStaging.pop_back();
+    } else {
+        glGenBuffers(1, &staging);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+        glBufferData(GL_COPY_WRITE_BUFFER, COUNTER_COUNT * sizeof(GLuint), nullptr, GL_STREAM_READ);
+    }
+
+    // Make the atomics visible to the copy, then snapshot the counters on the GPU
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, counterBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, staging);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, COUNTER_COUNT * sizeof(GLuint));
+
+    const GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush(); // make sure the fence actually reaches the GPU
+    inFlight.push_back({tag, staging, fence});
+
+    clearCounters();
+}
+
+bool GpuMetrics::poll(MetricsResult &result) {
+    if (inFlight.empty()) return false;
+
+    const GLenum status = glClientWaitSync(inFlight.front().fence, 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        return false;
+    }
+
+    result = read(inFlight.front());
+    inFlight.pop_front();
+    return true;
+}
+
+MetricsResult GpuMetrics::wait() {
+    if (inFlight.empty()) {
+        throw std::runtime_error("No metrics have been submitted.");
+    }
+
+    GLenum status;
+    do {
+        status = glClientWaitSync(inFlight.front().fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    if (status == GL_WAIT_FAILED) {
+        throw std::runtime_error("glClientWaitSync failed while waiting for metrics.");
+    }
+
+    MetricsResult result = read(inFlight.front());
+    inFlight.pop_front();
+    return result;
+}
+
+MetricsResult GpuMetrics::read(const Readback &readback) {
+    glBindBuffer(GL_COPY_READ_BUFFER, readback.staging);
+    const auto *c = static_cast<const GLuint *>(
+        glMapBufferRange(GL_COPY_READ_BUFFER, 0, COUNTER_COUNT * sizeof(GLuint), GL_MAP_READ_BIT));
+    if (!c) {
+        throw std::runtime_error("Could not map metrics staging buffer.");
+    }
+
+    MetricsResult result;
+    result.tag = readback.tag;
+    result.samples = c[0];
+    result.correct = c[1];
+    result.truePositives = c[2];
+    result.falsePositives = c[3];
+    result.trueNegatives = c[4];
+    result.falseNegatives = c[5];
+    const uint64_t fixedLoss = (static_cast<uint64_t>(c[7]) << 32) | c[6];
+    result.lossSum = static_cast<double>(fixedLoss) / LOSS_SCALE;
+
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    glDeleteSync(readback.fence);
+    freeStaging.push_back(readback.staging);
+    return result;
+}
@@ -0,0 +1,92 @@
+//
+// Created by CorruptionHades on 09/10/2025.
+//
+
+#ifndef GPUMETRICS_H
+#define GPUMETRICS_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "../gl/Shader.h"
+
+struct MetricsResult {
+    int tag = 0; // whatever was passed to submit(), e.g. the epoch
+    uint64_t samples = 0;
+    uint64_t correct = 0; // every output on the right side of the threshold
+    // Confusion counts of the first output
+    uint64_t truePositives = 0;
+    uint64_t falsePositives = 0;
+    uint64_t trueNegatives = 0;
+    uint64_t falseNegatives = 0;
+    double lossSum = 0.0; // sum of squared errors
+
+    [[nodiscard]] double accuracy() const { return samples ? static_cast<double>(correct) / samples : 0.0; }
+
+    [[nodiscard]] double meanLoss() const { return samples ? lossSum / samples : 0.0; }
+};
+
+/**
+ * @brief Accumulates validation metrics on the GPU so predictions never have to be read back.
+ *
+ * accumulate() reduces one prediction/target pair into a small counter buffer. submit() copies the
+ * counters into a staging buffer guarded by a fence and starts a new round; the result is picked up
+ * later with poll() (non-blocking) or wait(), typically one epoch later, once the GPU has caught up.
+ */
+class GpuMetrics {
+public:
+    explicit GpuMetrics(float threshold = 0.5f);
+
+    ~GpuMetrics();
+
+    GpuMetrics(const GpuMetrics &) = delete;
+
+    GpuMetrics &operator=(const GpuMetrics &) = delete;
+
+    /**
+     * @brief Adds one sample to the current round. No host/device synchronization.
+     */
+    void accumulate(GLuint predictionBuffer, GLuint targetBuffer, int outputCount);
+
+    /**
+     * @brief Closes the current round: schedules its readback and clears the counters for the next one.
+     */
+    void submit(int tag);
+
+    /**
+     * @brief Returns the oldest submitted round if the GPU has finished it, without blocking.
+     */
+    bool poll(MetricsResult &result);
+
+    /**
+     * @brief Blocks until the oldest submitted round is available.
+     */
+    MetricsResult wait();
+
+    [[nodiscard]] bool hasPending() const { return !inFlight.empty(); }
+
+private:
+    static constexpr int COUNTER_COUNT = 8;
+    static constexpr float LOSS_SCALE = 1048576.0f; // 2^20 fixed point
+
+    struct Readback {
+        int tag;
+        GLuint staging;
+        GLsync fence;
+    };
+
+    Shader metricsShader;
+    float threshold;
+    GLuint counterBuffer = 0;
+
+    std::deque<Readback> inFlight;
+    std::vector<GLuint> freeStaging;
+
+    void clearCounters() const;
+
+    MetricsResult read(const Readback &readback);
+};
+
+#endif //GPUMETRICS_H
@@ -4,10 +4,85 @@
 
 #include "Layer.h"
 #include "Matrix.h" // For initialization
+#include "CpuKernels.h"
+#include "WeightInitializer.h"
+#include "../utils/MappedFile.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
+
+namespace {
+    // Tile size of streamed layers: big enough to keep the GPU busy, small enough to overlap uploads
+    constexpr size_t STREAM_TILE_BYTES = 32u << 20;
+
+    template<typename T>
+    void download(const GLuint buffer, std::vector<T> &data) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(data.size() * sizeof(T)), data.data());
+    }
+
+    // Never empty, so a layer pruned down to nothing still binds valid buffers
+    template<typename T>
+    GLuint createBuffer(const std::vector<T> &data) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        const auto bytes = static_cast<GLsizeiptr>(data.size() * sizeof(T));
+        glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<GLsizeiptr>(bytes, sizeof(T)), nullptr, GL_DYNAMIC_COPY);
+        if (bytes > 0) glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, bytes, data.data());
+        return buffer;
+    }
+
+    // CSR of the entries of a row-major matrix with |w| > threshold
+    void compress(const float *matrix, const int rows, const int cols, const float threshold, std::vector<int> &rowStart,
+                  std::vector<int> &columns, std::vector<float> &values) {
+        rowStart.assign(1, 0);
+        columns.clear();
+        values.clear();
+        for (int r = 0; r < rows; ++r) {
+            const float *row = matrix + static_cast<size_t>(r) * cols;
+            for (int c = 0; c < cols; ++c) {
+                if (std::abs(row[c]) > threshold) {
+                    columns.push_back(c);
+                    values.push_back(row[c]);
+                }
+            }
+            rowStart.push_back(static_cast<int>(columns.size()));
+        }
+    }
+}
+
+SparseKernels::SparseKernels() {
+    spmv.loadComputeShader("shaders/spmv_csr.comp");
+    outerProduct.loadComputeShader("shaders/csr_outer_product.comp");
+}
+
+SparseKernels::~SparseKernels() {
+    glDeleteProgram(spmv.ID);
+    glDeleteProgram(outerProduct.ID);
+}
+
+size_t Layer::maxShardBytes = 0;
+
+void Layer::setMaxShardBytes(const size_t bytes) {
+    maxShardBytes = bytes;
+}
+
+size_t Layer::getMaxShardBytes() {
+    if (maxShardBytes > 0) return maxShardBytes;
+    // The largest buffer a shader can address as one array
+    static const size_t deviceLimit = [] {
+        GLint64 limit = 0;
+        glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &limit);
+        return static_cast<size_t>(limit);
+    }();
+    return deviceLimit;
+}
 
 Layer::Layer(int inSize, int outSize, Shader *matmul, Shader *matmul_T, Shader *elementwise,
-             Shader *activation, Shader *outer_prod, Shader *sgd_update)
+             Shader *activation, Shader *outer_prod, Shader *sgd_update, const std::string &weightFile,
+             const int tileColumns)
     : inputSize(inSize),
       neuronCount(outSize),
       matmulShader(matmul),
@@ -16,40 +91,105 @@ Layer::Layer(int inSize, int outSize, Shader *matmul, Shader *matmul_T, Shader *
       activationShader(activation),
       outerProductShader(outer_prod),
       sgdUpdateShader(sgd_update) {
-    // 1. Initialize weights and biases on the CPU first for random values
-    const Matrix weights = Matrix::random(neuronCount, inputSize);
     const auto biases = Matrix(neuronCount, 1); // Biases initialized to zero
 
-    std::cout << "Initializing Layer (" << inputSize << " -> " << neuronCount << ")..." << std::endl;
+    // Split W by input columns so that no shard exceeds the shard limit (or the tile size, if streamed); a mapped
+    // weight file keeps the tiles it was written in
+    const size_t rowBytes = static_cast<size_t>(neuronCount) * sizeof(float);
+    const size_t maxBytes = weightFile.empty() ? getMaxShardBytes() : std::min(getMaxShardBytes(), STREAM_TILE_BYTES);
+    if (tileColumns < 0 || tileColumns > inputSize || (tileColumns > 0 && weightFile.empty())) {
+        throw std::invalid_argument("Invalid tile width for the weight file.");
+    }
+    const int columnsPerShard = tileColumns > 0
+                                    ? tileColumns
+                                    : static_cast<int>(std::clamp<size_t>(maxBytes / rowBytes, 1, inputSize));
+    for (int first = 0; first < inputSize; first += columnsPerShard) {
+        shards.push_back({first, std::min(columnsPerShard, inputSize - first), 0, 0});
+    }
 
-    // 2. Generate all necessary GPU buffers
-    glGenBuffers(1, &weightsBuffer);
+    std::cout << "Initializing Layer (" << inputSize << " -> " << neuronCount << ")";
+    if (!weightFile.empty()) std::cout << " streamed from " << weightFile << " in " << shards.size() << " tiles";
+    else if (isSharded()) std::cout << " in " << shards.size() << " shards";
+    std::cout << "..." << std::endl;
+
+    // 1. + 2. W (left for initializeWeights()) and all necessary GPU buffers
+    if (weightFile.empty()) {
+        for (auto &shard: shards) {
+            glGenBuffers(1, &shard.weights);
+            glGenBuffers(1, &shard.gradWeights);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, shard.weights);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, shard.columns * rowBytes, nullptr, GL_DYNAMIC_COPY);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, shard.gradWeights);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, shard.columns * rowBytes, nullptr, GL_DYNAMIC_COPY);
+        }
+    } else {
+        // W and ∇W (zero) in the file, only two tiles of each on the device
+        const size_t weightCount = static_cast<size_t>(neuronCount) * inputSize;
+        const size_t fileBytes = 2 * weightCount * sizeof(float);
+        if (tileColumns > 0) {
+            weightStore = std::make_unique<MappedFile>(MappedFile::open(weightFile, true));
+            if (weightStore->size() != fileBytes) {
+                throw std::runtime_error("Weight file " + weightFile + " does not match the layer size.");
+            }
+        } else {
+            weightStore = std::make_unique<MappedFile>(MappedFile::create(weightFile, fileBytes));
+        }
+
+        const size_t tileBytes = shards.front().columns * rowBytes;
+        glGenBuffers(2, tileBuffers);
+        glGenBuffers(2, gradientTileBuffers);
+        for (int slot = 0; slot < 2; ++slot) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileBuffers[slot]);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(tileBytes), nullptr, GL_STREAM_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradientTileBuffers[slot]);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(tileBytes), nullptr, GL_STREAM_READ);
+        }
+    }
+    weightsBuffer = shards.front().weights;
+    gradWeightsBuffer = shards.front().gradWeights;
     glGenBuffers(1, &biasesBuffer);
-    glGenBuffers(1, &lastInputBuffer);
-    glGenBuffers(1, &lastWeightedSumBuffer);
-    glGenBuffers(1, &gradWeightsBuffer);
-    glGenBuffers(1, &gradBiasesBuffer);
-    glGenBuffers(1, &deltaBuffer);
-
-    // 3. Allocate and upload initial data for weights and biases
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, weightsBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, weights.data.size() * sizeof(float), weights.data.data(), GL_DYNAMIC_COPY);
 
+    // 3. Upload initial data for biases
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, biases.data.size() * sizeof(float), biases.data.data(), GL_DYNAMIC_COPY);
 
     // 4. Allocate empty buffers for intermediate and gradient values
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lastInputBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, inputSize * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    allocateWorkBuffers();
+}
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lastWeightedSumBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+Layer::Layer(const Layer &parameters, Shader *matmul, Shader *matmul_T, Shader *elementwise, Shader *activation,
+             Shader *outer_prod, Shader *sgd_update)
+    : inputSize(parameters.inputSize),
+      neuronCount(parameters.neuronCount),
+      sharedParameters(true),
+      matmulShader(matmul),
+      matmulTransposeAShader(matmul_T),
+      elementwiseShader(elementwise),
+      activationShader(activation),
+      outerProductShader(outer_prod),
+      sgdUpdateShader(sgd_update) {
+    if (parameters.isStreamed() || parameters.isSparse()) {
+        throw std::invalid_argument("Only dense layers in device memory can share their parameters.");
+    }
+    // Same W and b, but no ∇W: a layer sharing its parameters is never trained
+    for (const auto &shard: parameters.shards) {
+        shards.push_back({shard.firstColumn, shard.columns, shard.weights, 0});
+    }
+    weightsBuffer = shards.front().weights;
+    gradWeightsBuffer = 0;
+    biasesBuffer = parameters.biasesBuffer;
+    allocateWorkBuffers();
+}
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradWeightsBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, weights.data.size() * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+void Layer::allocateWorkBuffers() {
+    // The saved input and z are only needed when the layer runs by itself, see allocateActivationBuffers()
+    lastInputBuffer = 0;
+    lastWeightedSumBuffer = 0;
+    glGenBuffers(1, &gradBiasesBuffer);
+    glGenBuffers(1, &deltaBuffer);
 
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradBiasesBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, biases.data.size() * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
 
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, deltaBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
@@ -57,32 +197,87 @@ Layer::Layer(int inSize, int outSize, Shader *matmul, Shader *matmul_T, Shader *
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0); // Unbind
 }
 
+void Layer::allocateActivationBuffers() {
+    glGenBuffers(1, &lastInputBuffer);
+    glGenBuffers(1, &lastWeightedSumBuffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lastInputBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, inputSize * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, lastWeightedSumBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 Layer::~Layer() {
-    // Free all GPU resources when the layer is destroyed
-    glDeleteBuffers(1, &weightsBuffer);
-    glDeleteBuffers(1, &biasesBuffer);
+    // Free all GPU resources when the layer is destroyed, shared parameters belong to their owner
+    if (!sharedParameters) {
+        releaseWeights();
+        glDeleteBuffers(1, &biasesBuffer);
+    }
     glDeleteBuffers(1, &lastInputBuffer);
     glDeleteBuffers(1, &lastWeightedSumBuffer);
-    glDeleteBuffers(1, &gradWeightsBuffer);
     glDeleteBuffers(1, &gradBiasesBuffer);
     glDeleteBuffers(1, &deltaBuffer);
 }
 
+void Layer::initializeWeights(const WeightInitializer &initializer, const WeightInitConfig &config,
+                              const uint32_t stream) {
+    if (isSparse()) {
+        throw std::runtime_error("Pruned layers cannot be initialized again.");
+    }
+    const float limit = WeightInitializer::limit(config.scheme, inputSize, neuronCount);
+    for (const auto &shard: shards) {
+        if (isStreamed()) {
+            WeightInitializer::fillHost(hostShard(&WeightShard::weights, shard), neuronCount, shard.firstColumn,
+                                        shard.columns, limit, config.seed, stream);
+        } else {
+            initializer.fill(shard.weights, neuronCount, shard.firstColumn, shard.columns, limit, config.seed,
+                             stream);
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 void Layer::forward(GLuint inputBuffer, GLuint outputBuffer) {
+    if (lastInputBuffer == 0) allocateActivationBuffers();
+
     // Step 0: Save the input for the backward pass
     glBindBuffer(GL_COPY_READ_BUFFER, inputBuffer);
     glBindBuffer(GL_COPY_WRITE_BUFFER, lastInputBuffer);
     glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, inputSize * sizeof(float));
 
-    // Step 1: Weighted Sum (z = W * a_prev)
-    matmulShader->use();
-    matmulShader->setInt("u_A_rows", neuronCount);
-    matmulShader->setInt("u_A_cols", inputSize);
-    matmulShader->setInt("u_B_cols", 1);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weightsBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, inputBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lastWeightedSumBuffer);
-    matmulShader->dispatch(1, (neuronCount + 15) / 16, 1);
+    // Step 1: Weighted Sum (z = W * a_prev), the shards after the first add their partial sums
+    if (isSparse()) {
+        const Shader &spmv = sparseKernels->spmv;
+        spmv.use();
+        spmv.setInt("u_rows", neuronCount);
+        spmv.setInt("u_indirect", 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, rowStartBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, columnIndexBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, valuesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, inputBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, lastWeightedSumBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, valuesBuffer); // unused
+        dispatchRows(spmv, neuronCount);
+    } else {
+        matmulShader->use();
+        matmulShader->setInt("u_A_rows", neuronCount);
+        matmulShader->setInt("u_B_cols", 1);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, inputBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, lastWeightedSumBuffer);
+        for (size_t s = 0; s < shards.size(); ++s) {
+            const WeightShard &shard = shards[s];
+            const GLuint weights = isStreamed() ? uploadTile(s) : shard.weights;
+            matmulShader->setInt("u_A_cols", shard.columns);
+            matmulShader->setInt("u_B_offset", shard.firstColumn);
+            matmulShader->setInt("u_accumulate", shard.firstColumn > 0 ? 1 : 0);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weights);
+            matmulShader->dispatch(1, (neuronCount + 15) / 16, 1);
+            if (isStreamed()) releaseTile(s);
+        }
+    }
 
     // Step 2: Add Biases (z = z + b)
     elementwiseShader->use();
@@ -102,8 +297,48 @@ void Layer::forward(GLuint inputBuffer, GLuint outputBuffer) {
     activationShader->dispatch((neuronCount + 255) / 256, 1, 1);
 }
 
+void Layer::forwardBatch(const GLuint inputBuffer, const GLuint outputBuffer, const int batchSize,
+                         const GLuint onesBuffer) const {
+    if (isStreamed() || isSparse()) {
+        throw std::runtime_error("Streamed and pruned layers run one sample at a time.");
+    }
+    const GLuint groupsX = (batchSize + 15) / 16;
+    const GLuint groupsY = (neuronCount + 15) / 16;
+
+    // Step 1: Z = W * X, a shard's columns of W meet rows of X
+    matmulShader->use();
+    matmulShader->setInt("u_A_rows", neuronCount);
+    matmulShader->setInt("u_B_cols", batchSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, inputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, outputBuffer);
+    for (const WeightShard &shard: shards) {
+        matmulShader->setInt("u_A_cols", shard.columns);
+        matmulShader->setInt("u_B_offset", shard.firstColumn * batchSize);
+        matmulShader->setInt("u_accumulate", shard.firstColumn > 0 ? 1 : 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, shard.weights);
+        matmulShader->dispatch(groupsX, groupsY, 1);
+    }
+
+    // Step 2: Z += b * 1^T, the biases as a neuronCount x 1 matrix times a row of ones
+    matmulShader->setInt("u_A_cols", 1);
+    matmulShader->setInt("u_B_offset", 0);
+    matmulShader->setInt("u_accumulate", 1);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, biasesBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, onesBuffer);
+    matmulShader->dispatch(groupsX, groupsY, 1);
+
+    // Step 3: A = g(Z) in place
+    const int elements = neuronCount * batchSize;
+    activationShader->use();
+    activationShader->setInt("u_func_type", SIGMOID);
+    activationShader->setInt("u_element_count", elements);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, outputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, outputBuffer);
+    activationShader->dispatch((elements + 255) / 256, 1, 1);
+}
+
 // For the OUTPUT layer
-void Layer::backward(GLuint errorFromOutput) {
+void Layer::backward(GLuint errorFromOutput, bool accumulate) {
     // For the last layer, the error δ is simply (prediction - target), which is computed
     // in the train function and passed here. We just copy it to our internal deltaBuffer.
     glBindBuffer(GL_COPY_READ_BUFFER, errorFromOutput);
@@ -111,23 +346,12 @@ void Layer::backward(GLuint errorFromOutput) {
     glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, neuronCount * sizeof(float));
 
     // --- Calculate Gradients ---
-    // ∇W = δ * transpose(a_prev) -> outer product
-    outerProductShader->use();
-    outerProductShader->setInt("u_A_rows", neuronCount);
-    outerProductShader->setInt("u_B_cols", inputSize);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deltaBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lastInputBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gradWeightsBuffer);
-    outerProductShader->dispatch((inputSize + 15) / 16, (neuronCount + 15) / 16, 1);
-
-    // ∇b = δ -> it's just a copy
-    glBindBuffer(GL_COPY_READ_BUFFER, deltaBuffer);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, gradBiasesBuffer);
-    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, neuronCount * sizeof(float));
+    computeGradients(accumulate);
 }
 
 // For HIDDEN layers
-void Layer::backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuint errorForPrevLayer) {
+void Layer::backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuint errorForPrevLayer,
+                     bool accumulate) {
     // --- Calculate δ_l = (transpose(W_{l+1}) * δ_{l+1}) .* g'(z_l) ---
     // Part A: Propagated error: (transpose(W_{l+1}) * δ_{l+1})
     GLint nextLayerNeuronCount;
@@ -139,11 +363,16 @@ void Layer::backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuin
     matmulTransposeAShader->setInt("u_A_rows", nextLayerNeuronCount);
     matmulTransposeAShader->setInt("u_A_cols", neuronCount);
     matmulTransposeAShader->setInt("u_B_cols", 1);
+    matmulTransposeAShader->setInt("u_C_offset", 0);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weightsOfNextLayer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, errorFromNextLayer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorForPrevLayer);
     matmulTransposeAShader->dispatch(1, (neuronCount + 15) / 16, 1);
 
+    backwardFromError(errorForPrevLayer, accumulate);
+}
+
+void Layer::backwardFromError(GLuint propagatedError, bool accumulate) {
     // Part B: Activation derivative: g'(z_l)
     activationShader->use();
     activationShader->setInt("u_func_type", SIGMOID_DERIVATIVE);
@@ -156,34 +385,123 @@ void Layer::backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuin
     elementwiseShader->use();
     elementwiseShader->setInt("u_op_type", 2); // Multiplication
     elementwiseShader->setInt("u_element_count", neuronCount);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, errorForPrevLayer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, propagatedError);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, deltaBuffer);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, deltaBuffer); // Overwrite with final result
     elementwiseShader->dispatch((neuronCount + 255) / 256, 1, 1);
 
     // --- Calculate Gradients (same as for the output layer) ---
-    outerProductShader->use();
-    outerProductShader->setInt("u_A_rows", neuronCount);
-    outerProductShader->setInt("u_B_cols", inputSize);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deltaBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lastInputBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gradWeightsBuffer);
-    outerProductShader->dispatch((inputSize + 15) / 16, (neuronCount + 15) / 16, 1);
-
-    glBindBuffer(GL_COPY_READ_BUFFER, deltaBuffer);
-    glBindBuffer(GL_COPY_WRITE_BUFFER, gradBiasesBuffer);
-    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, neuronCount * sizeof(float));
+    computeGradients(accumulate);
+}
+
+void Layer::propagateError(GLuint errorForInput) {
+    if (isSparse()) {
+        // transpose(W) * δ through the CSC view: one row of transpose(W) per input
+        const Shader &spmv = sparseKernels->spmv;
+        spmv.use();
+        spmv.setInt("u_rows", inputSize);
+        spmv.setInt("u_indirect", 1);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, columnStartBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, rowIndexBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, valuesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, deltaBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, errorForInput);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, valueIndexBuffer);
+        dispatchRows(spmv, inputSize);
+        return;
+    }
+
+    // transpose(W) * δ, every shard writes its own block of input columns
+    matmulTransposeAShader->use();
+    matmulTransposeAShader->setInt("u_A_rows", neuronCount);
+    matmulTransposeAShader->setInt("u_B_cols", 1);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, deltaBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorForInput);
+    for (size_t s = 0; s < shards.size(); ++s) {
+        const WeightShard &shard = shards[s];
+        const GLuint weights = isStreamed() ? uploadTile(s) : shard.weights;
+        matmulTransposeAShader->setInt("u_A_cols", shard.columns);
+        matmulTransposeAShader->setInt("u_C_offset", shard.firstColumn);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weights);
+        matmulTransposeAShader->dispatch(1, (shard.columns + 15) / 16, 1);
+        if (isStreamed()) releaseTile(s);
+    }
+}
+
+void Layer::computeGradients(bool accumulate) {
+    // ∇W = δ * transpose(a_prev) -> outer product, per shard with its block of a_prev
+    // A streamed layer computes each ∇W tile on the device and reads it back while the next one computes;
+    // accumulation then happens on the host, where ∇W lives
+    if (isSparse()) {
+        // Only the kept weights get a gradient
+        const Shader &outer = sparseKernels->outerProduct;
+        outer.use();
+        outer.setInt("u_rows", neuronCount);
+        outer.setInt("u_accumulate", accumulate ? 1 : 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, rowStartBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, columnIndexBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, deltaBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, lastInputBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, gradValuesBuffer);
+        dispatchRows(outer, neuronCount);
+    } else {
+        outerProductShader->use();
+        outerProductShader->setInt("u_A_rows", neuronCount);
+        outerProductShader->setInt("u_accumulate", accumulate && !isStreamed() ? 1 : 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deltaBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, lastInputBuffer);
+        for (size_t s = 0; s < shards.size(); ++s) {
+            const WeightShard &shard = shards[s];
+            outerProductShader->setInt("u_B_cols", shard.columns);
+            outerProductShader->setInt("u_B_offset", shard.firstColumn);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, isStreamed() ? gradientTileBuffers[s % 2] : shard.gradWeights);
+            outerProductShader->dispatch((shard.columns + 15) / 16, (neuronCount + 15) / 16, 1);
+            if (isStreamed() && s > 0) downloadGradientTile(s - 1, accumulate);
+        }
+        if (isStreamed()) downloadGradientTile(shards.size() - 1, accumulate);
+    }
+
+    if (accumulate) {
+        // ∇b += δ
+        elementwiseShader->use();
+        elementwiseShader->setInt("u_op_type", 0); // Addition
+        elementwiseShader->setInt("u_element_count", neuronCount);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, gradBiasesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, deltaBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, gradBiasesBuffer); // In-place
+        elementwiseShader->dispatch((neuronCount + 255) / 256, 1, 1);
+    } else {
+        // ∇b = δ -> it's just a copy
+        glBindBuffer(GL_COPY_READ_BUFFER, deltaBuffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, gradBiasesBuffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, neuronCount * sizeof(float));
+    }
 }
 
 void Layer::update(float learningRate) {
     sgdUpdateShader->use();
     glUniform1f(glGetUniformLocation(sgdUpdateShader->ID, "u_learning_rate"), learningRate);
 
-    // Update Weights: W = W - lr * ∇W
-    sgdUpdateShader->setInt("u_element_count", neuronCount * inputSize);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, weightsBuffer);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gradWeightsBuffer);
-    sgdUpdateShader->dispatch(((neuronCount * inputSize) + 255) / 256, 1, 1);
+    // Update Weights: W = W - lr * ∇W; a streamed layer updates the file in place, where both already are
+    if (isStreamed()) {
+        auto *weights = static_cast<float *>(weightStore->data());
+        const size_t weightCount = static_cast<size_t>(neuronCount) * inputSize;
+        CpuKernels::sgdUpdate(weights, weights + weightCount, learningRate, weightCount);
+    } else if (isSparse()) {
+        const auto count = static_cast<int>(nonZeros);
+        sgdUpdateShader->setInt("u_element_count", count);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, valuesBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gradValuesBuffer);
+        sgdUpdateShader->dispatch((count + 255) / 256, 1, 1);
+    } else {
+        for (const auto &shard: shards) {
+            const int count = neuronCount * shard.columns;
+            sgdUpdateShader->setInt("u_element_count", count);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, shard.weights);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, shard.gradWeights);
+            sgdUpdateShader->dispatch((count + 255) / 256, 1, 1);
+        }
+    }
 
     // Update Biases: b = b - lr * ∇b
     sgdUpdateShader->setInt("u_element_count", neuronCount);
@@ -193,43 +511,366 @@ void Layer::update(float learningRate) {
 }
 
 nlohmann::json Layer::toJson() const {
-    // 1. Create CPU-side vectors to hold the data
-    std::vector<float> weights_data(neuronCount * inputSize);
-    std::vector<float> biases_data(neuronCount);
-
-    // 2. Download data from GPU buffers to CPU vectors
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, weightsBuffer);
-    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, weights_data.size() * sizeof(float), weights_data.data());
+    nlohmann::json j;
+    if (isSparse()) {
+        // Only the nonzeros and their positions, about 2 * nonzeros numbers instead of neuronCount * inputSize
+        std::vector<int> rowStart, columns;
+        std::vector<float> values;
+        downloadSparse(rowStart, columns, values);
+        std::vector<float> biases_data(neuronCount);
+        download(biasesBuffer, biases_data);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        j["sparse"] = {{"row_start", rowStart}, {"columns", columns}, {"values", values}};
+        j["biases"] = biases_data;
+        return j;
+    }
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
-    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases_data.size() * sizeof(float), biases_data.data());
+    if (isStreamed()) {
+        // W stays in its file, which is made durable first so the description never points at stale weights
+        weightStore->flush();
+        std::vector<float> biases_data(neuronCount);
+        download(biasesBuffer, biases_data);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        j["weight_file"] = getWeightFile();
+        j["tile_columns"] = getTileColumns();
+        j["biases"] = biases_data;
+        return j;
+    }
 
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    std::vector<float> weights_data;
+    std::vector<float> biases_data;
+    downloadParameters(weights_data, biases_data);
 
-    // 3. Create JSON object and populate it
-    nlohmann::json j;
     j["weights"] = weights_data;
     j["biases"] = biases_data;
 
     return j;
 }
 
-void Layer::loadParameters(const nlohmann::json &j) {
+void Layer::loadParameters(const nlohmann::json &j, const SparseKernels *sparseKernels) {
+    if (j.contains("sparse")) {
+        if (!sparseKernels) {
+            throw std::runtime_error("Loading a pruned layer requires the sparse kernels.");
+        }
+        const nlohmann::json &csr = j.at("sparse");
+        setSparse(csr.at("row_start").get<std::vector<int> >(), csr.at("columns").get<std::vector<int> >(),
+                  csr.at("values").get<std::vector<float> >(), *sparseKernels);
+        uploadBiases(j.at("biases").get<std::vector<float> >());
+        return;
+    }
+
+    if (isStreamed() && !j.contains("weights")) {
+        // W is whatever the mapped file holds
+        uploadBiases(j.at("biases").get<std::vector<float> >());
+        return;
+    }
+
     // 1. Extract data from JSON into CPU-side vectors
     std::vector<float> weights_data = j.at("weights").get<std::vector<float> >();
     std::vector<float> biases_data = j.at("biases").get<std::vector<float> >();
 
+    // 2. Upload data from CPU vectors to existing GPU buffers
+    uploadParameters(weights_data, biases_data);
+}
+
+void Layer::downloadParameters(std::vector<float> &weights, std::vector<float> &biases) const {
+    weights.resize(static_cast<size_t>(neuronCount) * inputSize);
+    biases.resize(neuronCount);
+
+    readMatrix(&WeightShard::weights, weights.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases.size() * sizeof(float), biases.data());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Layer::uploadParameters(const std::vector<float> &weights, const std::vector<float> &biases) {
     // Verify sizes to prevent buffer overflows
-    if (weights_data.size() != neuronCount * inputSize || biases_data.size() != neuronCount) {
+    if (weights.size() != static_cast<size_t>(neuronCount) * inputSize ||
+        biases.size() != static_cast<size_t>(neuronCount)) {
         throw std::runtime_error("Mismatched data size when loading layer parameters.");
     }
 
-    // 2. Upload data from CPU vectors to existing GPU buffers
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, weightsBuffer);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, weights_data.size() * sizeof(float), weights_data.data());
+    writeMatrix(&WeightShard::weights, weights.data());
+    uploadBiases(biases);
+}
 
+void Layer::uploadBiases(const std::vector<float> &biases) {
+    if (biases.size() != static_cast<size_t>(neuronCount)) {
+        throw std::runtime_error("Mismatched data size when loading layer parameters.");
+    }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, biasesBuffer);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, biases_data.size() * sizeof(float), biases_data.data());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(biases.size() * sizeof(float)),
+                    biases.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Layer::downloadWeightGradients(float *weights) const {
+    readMatrix(&WeightShard::gradWeights, weights);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
+void Layer::uploadWeightGradients(const float *weights) {
+    writeMatrix(&WeightShard::gradWeights, weights);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+std::vector<std::pair<GLuint, size_t> > Layer::gradientBuffers() const {
+    std::vector<std::pair<GLuint, size_t> > buffers;
+    if (isStreamed()) return buffers;
+    if (isSparse()) {
+        buffers.emplace_back(gradValuesBuffer, nonZeros);
+    } else {
+        for (const auto &shard: shards) {
+            buffers.emplace_back(shard.gradWeights, static_cast<size_t>(neuronCount) * shard.columns);
+        }
+    }
+    buffers.emplace_back(gradBiasesBuffer, neuronCount);
+    return buffers;
+}
+
+void Layer::prune(const float threshold, const SparseKernels &kernels) {
+    std::vector<float> weights(static_cast<size_t>(neuronCount) * inputSize);
+    readMatrix(&WeightShard::weights, weights.data());
+
+    std::vector<int> rowStart, columns;
+    std::vector<float> values;
+    compress(weights.data(), neuronCount, inputSize, threshold, rowStart, columns, values);
+    setSparse(rowStart, columns, values, kernels);
+}
+
+void Layer::setSparse(const std::vector<int> &rowStart, const std::vector<int> &columns,
+                      const std::vector<float> &values, const SparseKernels &kernels) {
+    if (rowStart.size() != static_cast<size_t>(neuronCount) + 1 || rowStart.front() != 0 ||
+        rowStart.back() != static_cast<int>(columns.size()) || columns.size() != values.size() ||
+        !std::is_sorted(rowStart.begin(), rowStart.end()) ||
+        std::ranges::any_of(columns, [this](const int c) { return c < 0 || c >= inputSize; })) {
+        throw std::invalid_argument("Invalid CSR matrix for this layer.");
+    }
+
+    // CSC view: the entries sorted by column, pointing back at their value
+    std::vector<int> columnStart(static_cast<size_t>(inputSize) + 1, 0);
+    for (const int c: columns) ++columnStart[c + 1];
+    for (int c = 0; c < inputSize; ++c) columnStart[c + 1] += columnStart[c];
+    std::vector<int> rowIndex(columns.size());
+    std::vector<int> valueIndex(columns.size());
+    std::vector<int> next(columnStart.begin(), columnStart.end() - 1);
+    for (int r = 0; r < neuronCount; ++r) {
+        for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+            const int position = next[columns[k]]++;
+            rowIndex[position] = r;
+            valueIndex[position] = k;
+        }
+    }
+
+    releaseWeights();
+    shards = {{0, inputSize, 0, 0}};
+    sparseKernels = &kernels;
+    nonZeros = values.size();
+    rowStartBuffer = createBuffer(rowStart);
+    columnIndexBuffer = createBuffer(columns);
+    valuesBuffer = createBuffer(values);
+    gradValuesBuffer = createBuffer(std::vector<float>(nonZeros, 0.0f));
+    columnStartBuffer = createBuffer(columnStart);
+    rowIndexBuffer = createBuffer(rowIndex);
+    valueIndexBuffer = createBuffer(valueIndex);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Layer::downloadSparse(std::vector<int> &rowStart, std::vector<int> &columns, std::vector<float> &values) const {
+    if (!isSparse()) throw std::runtime_error("Layer is not pruned.");
+    rowStart.resize(static_cast<size_t>(neuronCount) + 1);
+    columns.resize(nonZeros);
+    values.resize(nonZeros);
+    download(rowStartBuffer, rowStart);
+    download(columnIndexBuffer, columns);
+    download(valuesBuffer, values);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void Layer::releaseWeights() {
+    for (auto &shard: shards) {
+        glDeleteBuffers(1, &shard.weights);
+        glDeleteBuffers(1, &shard.gradWeights);
+        shard.weights = shard.gradWeights = 0;
+    }
+    weightsBuffer = gradWeightsBuffer = 0;
+
+    glDeleteBuffers(2, tileBuffers);
+    glDeleteBuffers(2, gradientTileBuffers);
+    for (int slot = 0; slot < 2; ++slot) {
+        tileBuffers[slot] = gradientTileBuffers[slot] = 0;
+        if (tileFences[slot]) glDeleteSync(tileFences[slot]);
+        tileFences[slot] = nullptr;
+    }
+    weightStore.reset();
+
+    for (GLuint *buffer: {
+             &rowStartBuffer, &columnIndexBuffer, &valuesBuffer, &gradValuesBuffer, &columnStartBuffer,
+             &rowIndexBuffer, &valueIndexBuffer
+         }) {
+        glDeleteBuffers(1, buffer);
+        *buffer = 0;
+    }
+    sparseKernels = nullptr;
+    nonZeros = 0;
+}
+
+void Layer::dispatchRows(const Shader &shader, const int rows) {
+    // At most 65535 work groups per dimension
+    constexpr int MAX_GROUPS = 65535;
+    const int x = std::clamp(rows, 1, MAX_GROUPS);
+    shader.dispatch(x, (rows + x - 1) / x, 1);
+}
+
+void Layer::readMatrix(GLuint WeightShard::*buffer, float *matrix) const {
+    if (isSparse()) {
+        std::vector<int> rowStart(static_cast<size_t>(neuronCount) + 1), columns(nonZeros);
+        std::vector<float> values(nonZeros);
+        download(rowStartBuffer, rowStart);
+        download(columnIndexBuffer, columns);
+        download(buffer == &WeightShard::weights ? valuesBuffer : gradValuesBuffer, values);
+        std::fill_n(matrix, static_cast<size_t>(neuronCount) * inputSize, 0.0f);
+        for (int r = 0; r < neuronCount; ++r) {
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                matrix[static_cast<size_t>(r) * inputSize + columns[k]] = values[k];
+            }
+        }
+        return;
+    }
+    if (!isSharded() && !isStreamed()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, shards.front().*buffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(neuronCount) * inputSize * sizeof(float),
+                           matrix);
+        return;
+    }
+    std::vector<float> block;
+    for (const auto &shard: shards) {
+        const float *source;
+        if (isStreamed()) {
+            source = hostShard(buffer, shard);
+        } else {
+            block.resize(static_cast<size_t>(neuronCount) * shard.columns);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, shard.*buffer);
+            glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, block.size() * sizeof(float), block.data());
+            source = block.data();
+        }
+        for (int r = 0; r < neuronCount; ++r) {
+            std::copy_n(source + static_cast<size_t>(r) * shard.columns, shard.columns,
+                        matrix + static_cast<size_t>(r) * inputSize + shard.firstColumn);
+        }
+    }
+}
+
+void Layer::writeMatrix(GLuint WeightShard::*buffer, const float *matrix) {
+    if (isSparse()) {
+        std::vector<int> rowStart, columns;
+        std::vector<float> values;
+        if (buffer == &WeightShard::weights) {
+            // Whatever is nonzero is kept
+            compress(matrix, neuronCount, inputSize, 0.0f, rowStart, columns, values);
+            setSparse(rowStart, columns, values, *sparseKernels);
+            return;
+        }
+        // ∇W at the kept weights
+        rowStart.resize(static_cast<size_t>(neuronCount) + 1);
+        columns.resize(nonZeros);
+        download(rowStartBuffer, rowStart);
+        download(columnIndexBuffer, columns);
+        values.resize(nonZeros);
+        for (int r = 0; r < neuronCount; ++r) {
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                values[k] = matrix[static_cast<size_t>(r) * inputSize + columns[k]];
+            }
+        }
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradValuesBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(values.size() * sizeof(float)),
+                        values.data());
+        return;
+    }
+    if (!isSharded() && !isStreamed()) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, shards.front().*buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(neuronCount) * inputSize * sizeof(float),
+                        matrix);
+        return;
+    }
+    std::vector<float> block;
+    for (const auto &shard: shards) {
+        float *destination;
+        if (isStreamed()) {
+            destination = hostShard(buffer, shard);
+        } else {
+            block.resize(static_cast<size_t>(neuronCount) * shard.columns);
+            destination = block.data();
+        }
+        for (int r = 0; r < neuronCount; ++r) {
+            std::copy_n(matrix + static_cast<size_t>(r) * inputSize + shard.firstColumn, shard.columns,
+                        destination + static_cast<size_t>(r) * shard.columns);
+        }
+        if (!isStreamed()) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, shard.*buffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, block.size() * sizeof(float), block.data());
+        }
+    }
+}
+
+std::string Layer::getWeightFile() const {
+    return isStreamed() ? weightStore->path() : std::string();
+}
+
+float *Layer::hostShard(GLuint WeightShard::*buffer, const WeightShard &shard) const {
+    auto *base = static_cast<float *>(weightStore->data());
+    // Shards are stored one after another, so shard s starts after neuronCount * firstColumn values
+    const size_t matrixOffset = buffer == &WeightShard::gradWeights ? static_cast<size_t>(neuronCount) * inputSize : 0;
+    return base + matrixOffset + static_cast<size_t>(neuronCount) * shard.firstColumn;
+}
+
+GLuint Layer::uploadTile(const size_t s) {
+    const size_t slot = s % 2;
+    if (tileFences[slot]) {
+        // The dispatch two tiles back; it has usually finished while the previous tile was uploaded
+        GLenum status;
+        do {
+            status = glClientWaitSync(tileFences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(tileFences[slot]);
+        tileFences[slot] = nullptr;
+        if (status == GL_WAIT_FAILED) {
+            throw std::runtime_error("glClientWaitSync failed while streaming weights.");
+        }
+    }
+
+    const WeightShard &shard = shards[s];
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileBuffers[slot]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(neuronCount) * shard.columns * sizeof(float),
+                    hostShard(&WeightShard::weights, shard));
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return tileBuffers[slot];
+}
+
+void Layer::releaseTile(const size_t s) {
+    const size_t slot = s % 2;
+    if (tileFences[slot]) glDeleteSync(tileFences[slot]);
+    tileFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void Layer::downloadGradientTile(const size_t s, const bool accumulate) {
+    const WeightShard &shard = shards[s];
+    const size_t count = static_cast<size_t>(neuronCount) * shard.columns;
+    float *destination = hostShard(&WeightShard::gradWeights, shard);
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradientTileBuffers[s % 2]);
+    if (accumulate) {
+        const auto *tile = static_cast<const float *>(glMapBufferRange(
+            GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(float)), GL_MAP_READ_BIT));
+        for (size_t i = 0; i < count; ++i) {
+            destination[i] += tile[i];
+        }
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    } else {
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(count * sizeof(float)), destination);
+    }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
@@ -8,6 +8,15 @@
 #include <GL/glew.h>
 #include "../gl/Shader.h"
 #include <nlohmann/json.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class MappedFile;
+class WeightInitializer;
+struct WeightInitConfig;
 
 // Enum for activation function types, making the code more readable.
 enum ActivationType {
@@ -15,22 +24,70 @@ enum ActivationType {
     SIGMOID_DERIVATIVE = 1
 };
 
+// A block of input columns [firstColumn, firstColumn + columns) of W and ∇W, stored neuronCount x columns, row-major
+struct WeightShard {
+    int firstColumn;
+    int columns;
+    GLuint weights;
+    GLuint gradWeights;
+};
+
+/**
+ * @brief Shaders of pruned (CSR) layers. Owned by the network, loaded when the first layer is pruned.
+ */
+struct SparseKernels {
+    Shader spmv;
+    Shader outerProduct;
+
+    SparseKernels();
+
+    ~SparseKernels();
+
+    SparseKernels(const SparseKernels &) = delete;
+
+    SparseKernels &operator=(const SparseKernels &) = delete;
+};
+
 class Layer {
 public:
     int inputSize;
     int neuronCount;
 
+    // W and ∇W, split by input columns when a single buffer would exceed the shard limit.
+    // z = sum over shards of W_s * x_s; every shard gets its own slice of W^T δ and ∇W = δ * transpose(x_s).
+    // The shards of a streamed layer are its tiles and have no buffers of their own.
+    std::vector<WeightShard> shards;
+
     // --- GPU Buffer Handles ---
-    GLuint weightsBuffer;
+    GLuint weightsBuffer; // W of the first shard, i.e. all of W unless isSharded(); 0 if streamed or sparse
     GLuint biasesBuffer;
-    GLuint lastInputBuffer;
+    GLuint lastInputBuffer; // 0 until the layer first runs by itself (not through the execution plan)
     GLuint lastWeightedSumBuffer;
-    GLuint gradWeightsBuffer;
+    GLuint gradWeightsBuffer; // ∇W of the first shard
     GLuint gradBiasesBuffer;
     GLuint deltaBuffer; // To store the error δ for this layer
 
+    /**
+     * W is not initialized, see initializeWeights(). The biases start at zero.
+     * @param weightFile If set, W and ∇W are kept in this memory-mapped file (created or overwritten)
+     * instead of device memory. Every pass then pages W through two tile buffers, uploading tile k + 1
+     * while tile k computes, so the layer may be larger than device memory.
+     * @param tileColumns If positive, weightFile is mapped as it is instead of overwritten, so the layer starts
+     * with the W already in it (e.g. when a saved model is loaded). It must have been written in tiles of that
+     * many input columns (see getTileColumns()) and have the size this layer needs.
+     */
     Layer(int inSize, int outSize, Shader *matmul, Shader *matmul_T, Shader *elementwise,
-          Shader *activation, Shader *outer_prod, Shader *sgd_update);
+          Shader *activation, Shader *outer_prod, Shader *sgd_update, const std::string &weightFile = {},
+          int tileColumns = 0);
+
+    /**
+     * @brief A layer that reads W and b of `parameters` instead of owning a copy, with buffers of its own
+     * only for its activations. The current GL context must share objects with the one `parameters` was
+     * created in, and `parameters` must outlive this layer. For inference only: nothing may update the
+     * shared parameters, and this layer has no ∇W. Dense layers in device memory only.
+     */
+    Layer(const Layer &parameters, Shader *matmul, Shader *matmul_T, Shader *elementwise, Shader *activation,
+          Shader *outer_prod, Shader *sgd_update);
 
     ~Layer();
 
@@ -39,33 +96,202 @@ public:
 
     Layer &operator=(const Layer &) = delete;
 
+    /**
+     * @brief Draws W with the given scheme and seed (see WeightInitializer): on the device, or on all host
+     * threads straight into the file of a streamed layer.
+     * @param stream Distinguishes the layers of a network, each needs its own.
+     */
+    void initializeWeights(const WeightInitializer &initializer, const WeightInitConfig &config, uint32_t stream);
+
     void forward(GLuint inputBuffer, GLuint outputBuffer);
 
+    /**
+     * @brief Inference over a whole batch with one matrix product per shard: A = g(W * X + b * 1^T).
+     * X is inputSize x batchSize and A neuronCount x batchSize, row-major (one column per sample).
+     * Nothing is kept for a backward pass. Not for streamed or pruned layers.
+     * @param onesBuffer At least batchSize ones, broadcasts the biases over the batch.
+     */
+    void forwardBatch(GLuint inputBuffer, GLuint outputBuffer, int batchSize, GLuint onesBuffer) const;
+
     /**
      * @brief Backward pass for the OUTPUT layer.
      * @param errorFromOutput The SSBO containing the initial error (prediction - target).
+     * @param accumulate If true, the gradients are added to the existing ones instead of replacing them.
      */
-    void backward(GLuint errorFromOutput);
+    void backward(GLuint errorFromOutput, bool accumulate = false);
 
     /**
      * @brief Backward pass for HIDDEN layers.
      * @param errorFromNextLayer The SSBO containing the error δ from the layer ahead.
-     * @param weightsOfNextLayer The SSBO containing the weights W of the layer ahead.
+     * @param weightsOfNextLayer The SSBO containing the weights W of the layer ahead. Must hold all of W,
+     * for a sharded layer ahead use its propagateError() and backwardFromError().
      * @param errorForPrevLayer The SSBO where this function will store the calculated error for the previous layer.
+     * @param accumulate If true, the gradients are added to the existing ones instead of replacing them.
+     */
+    void backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuint errorForPrevLayer,
+                  bool accumulate = false);
+
+    /**
+     * @brief Backward pass for a HIDDEN layer whose propagated error transpose(W_{l+1}) * δ_{l+1} is already
+     * known, e.g. because the next layer runs on the CPU.
+     * @param propagatedError The SSBO holding transpose(W_{l+1}) * δ_{l+1}.
+     */
+    void backwardFromError(GLuint propagatedError, bool accumulate = false);
+
+    /**
+     * @brief Writes transpose(W) * δ of the last backward pass, i.e. dL/d(input) before the previous layer's
+     * activation derivative, into `errorForInput` (inputSize floats).
      */
-    void backward(GLuint errorFromNextLayer, GLuint weightsOfNextLayer, GLuint errorForPrevLayer);
+    void propagateError(GLuint errorForInput);
 
     /**
      * @brief Updates the layer's weights and biases using the computed gradients and learning rate.
      */
     void update(float learningRate);
 
-    // saving/loading
+    /**
+     * @brief Drops every weight with |w| <= threshold and keeps the rest in CSR form. From then on the
+     * layer only reads, trains and updates the kept weights, so the pruned ones stay zero while fine-tuning.
+     * Can be called again with a higher threshold. Sharded and streamed layers become regular device buffers.
+     * The weight gradients are reset.
+     */
+    void prune(float threshold, const SparseKernels &kernels);
+
+    /**
+     * @brief Replaces W with the given CSR matrix: the nonzeros of row r are values[rowStart[r] .. rowStart[r + 1]),
+     * at the input columns in `columns`.
+     */
+    void setSparse(const std::vector<int> &rowStart, const std::vector<int> &columns, const std::vector<float> &values,
+                   const SparseKernels &kernels);
+
+    void downloadSparse(std::vector<int> &rowStart, std::vector<int> &columns, std::vector<float> &values) const;
+
+    [[nodiscard]] bool isSparse() const { return sparseKernels != nullptr; }
+
+    // Stored weights: all of W, or the nonzeros once pruned
+    [[nodiscard]] size_t getNonZeroCount() const {
+        return isSparse() ? nonZeros : static_cast<size_t>(neuronCount) * inputSize;
+    }
+
+    // saving/loading; a streamed layer is saved as its "weight_file", "tile_columns" and the biases, W stays in
+    // the file
     [[nodiscard]] nlohmann::json toJson() const;
 
-    void loadParameters(const nlohmann::json &j);
+    /**
+     * @brief Downloads the weights (row-major, neuronCount x inputSize, with the zeros of a pruned layer)
+     * and biases into host vectors.
+     */
+    void downloadParameters(std::vector<float> &weights, std::vector<float> &biases) const;
+
+    /**
+     * @brief Uploads dense weights and biases. A pruned layer keeps the nonzeros of `weights`.
+     */
+    void uploadParameters(const std::vector<float> &weights, const std::vector<float> &biases);
+
+    void uploadBiases(const std::vector<float> &biases);
+
+    /**
+     * @brief Loads the parameters written by toJson(). A streamed layer only loads the biases, unless the
+     * description carries "weights" too (files written before the weights stayed in the weight file).
+     * @param sparseKernels Needed if the layer was saved pruned ("sparse" instead of "weights").
+     */
+    void loadParameters(const nlohmann::json &j, const SparseKernels *sparseKernels = nullptr);
+
+    /**
+     * @brief Downloads ∇W (row-major, neuronCount x inputSize, gathered from all shards) into `weights`.
+     */
+    void downloadWeightGradients(float *weights) const;
+
+    // Only the entries at the nonzeros are used by a pruned layer
+    void uploadWeightGradients(const float *weights);
+
+    /**
+     * @brief The device buffers holding ∇W in the form they are stored in (one per shard, or the nonzeros of a
+     * pruned layer), followed by ∇b, each with its size in floats. Empty for a streamed layer, whose ∇W lives
+     * in its file.
+     */
+    [[nodiscard]] std::vector<std::pair<GLuint, size_t> > gradientBuffers() const;
+
+    [[nodiscard]] bool isSharded() const { return shards.size() > 1; }
+
+    [[nodiscard]] bool isStreamed() const { return weightStore != nullptr; }
+
+    [[nodiscard]] bool sharesParameters() const { return sharedParameters; }
+
+    /**
+     * @brief The file a streamed layer keeps its weights in, empty otherwise.
+     */
+    [[nodiscard]] std::string getWeightFile() const;
+
+    /**
+     * @brief Input columns per tile of a streamed layer; its file stores W (and ∇W) tile after tile.
+     */
+    [[nodiscard]] int getTileColumns() const { return shards.front().columns; }
+
+    /**
+     * @brief Largest W (and ∇W) buffer or streamed tile of layers created from now on, in bytes.
+     * @param bytes 0 restores the default, GL_MAX_SHADER_STORAGE_BLOCK_SIZE.
+     */
+    static void setMaxShardBytes(size_t bytes);
+
+    static size_t getMaxShardBytes();
 
 private:
+    static size_t maxShardBytes;
+
+    // W and b belong to another layer (see the sharing constructor)
+    bool sharedParameters = false;
+
+    // Buffers for δ and ∇b of one sample
+    void allocateWorkBuffers();
+
+    // On the first forward(): networks running through the execution plan keep activations in its buffers
+    void allocateActivationBuffers();
+
+    // --- Streaming (weightFile set) ---
+    std::unique_ptr<MappedFile> weightStore; // all tiles of W, then all tiles of ∇W, each neuronCount x columns
+    GLuint tileBuffers[2] = {}; // W tiles, alternating
+    GLuint gradientTileBuffers[2] = {}; // ∇W tiles on their way back to the host
+    GLsync tileFences[2] = {}; // set when the last dispatch reading a tile buffer was issued
+
+    // Host copy of W or ∇W of one shard
+    [[nodiscard]] float *hostShard(GLuint WeightShard::*buffer, const WeightShard &shard) const;
+
+    // Waits until tile buffer `slot` is free, uploads W of shard `s` into it and returns it
+    GLuint uploadTile(size_t s);
+
+    // Marks the tile buffer used for shard `s` as busy until the dispatches issued so far are done
+    void releaseTile(size_t s);
+
+    // Reads the ∇W tile of shard `s` back into the file (adding to it if `accumulate`)
+    void downloadGradientTile(size_t s, bool accumulate);
+
+    // --- Pruned (sparseKernels set) ---
+    const SparseKernels *sparseKernels = nullptr;
+    GLuint rowStartBuffer = 0; // neuronCount + 1 offsets into the nonzeros
+    GLuint columnIndexBuffer = 0;
+    GLuint valuesBuffer = 0;
+    GLuint gradValuesBuffer = 0;
+    // The same nonzeros by input column (CSC), as indices into valuesBuffer, for transpose(W) * δ
+    GLuint columnStartBuffer = 0;
+    GLuint rowIndexBuffer = 0;
+    GLuint valueIndexBuffer = 0;
+    size_t nonZeros = 0;
+
+    // Frees W and ∇W in whatever form they are (shards, tiles, CSR)
+    void releaseWeights();
+
+    // Dispatches a one-work-group-per-row CSR kernel over `rows` rows
+    static void dispatchRows(const Shader &shader, int rows);
+
+    // Copies a row-major neuronCount x inputSize matrix from/to the shards' W (or ∇W) buffers
+    void readMatrix(GLuint WeightShard::*buffer, float *matrix) const;
+
+    void writeMatrix(GLuint WeightShard::*buffer, const float *matrix);
+
+    // ∇W = δ * transpose(a_prev) and ∇b = δ, written or accumulated into the gradient buffers
+    void computeGradients(bool accumulate);
+
     Shader *matmulShader;
     Shader *matmulTransposeAShader;
     Shader *elementwiseShader;
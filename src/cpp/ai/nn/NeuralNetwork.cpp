@@ -3,11 +3,25 @@
 //
 
 #include "NeuralNetwork.h"
-
+#include "DeviceDataset.h"
+#include "GpuMetrics.h"
+#include "../dist/Communicator.h"
+#include "../dist/GradientBucketer.h"
+#include "../graph/ExecutionPlan.h"
+#include "../graph/Megakernel.h"
+#include "../utils/Profiler.h"
+
+#include <algorithm>
 #include <fstream>
+#include <random>
 #include <stdexcept>
 #include <iostream>
 
+namespace {
+    // Weight init streams of the feature layers, the dense layers use their index
+    constexpr uint32_t FEATURE_INIT_STREAM = 0x80000000u;
+}
+
 NeuralNetwork::NeuralNetwork() : learningRate(0.1f) {
     // Load all the shaders once when the network is created
     matmulShader.loadComputeShader("shaders/matmul.comp");
@@ -16,18 +30,152 @@ NeuralNetwork::NeuralNetwork() : learningRate(0.1f) {
     activationShader.loadComputeShader("shaders/activation.comp");
     outerProductShader.loadComputeShader("shaders/outer_product.comp");
     sgdUpdateShader.loadComputeShader("shaders/sgd_update.comp");
+
+    std::random_device rd;
+    weightInit.seed = static_cast<uint64_t>(rd()) << 32 | rd();
 }
 
 NeuralNetwork::~NeuralNetwork() {
     // Clean up all the network-managed GPU buffers
     glDeleteBuffers(activationBuffers.size(), activationBuffers.data());
     glDeleteBuffers(errorBuffers.size(), errorBuffers.data());
+    glDeleteBuffers(1, &targetBuffer);
+    // The last feature buffer doubles as the first activation buffer
+    const size_t shared = !featureBuffers.empty() && !activationBuffers.empty() ? 1 : 0;
+    glDeleteBuffers(featureBuffers.size() - shared, featureBuffers.data());
+    glDeleteBuffers(featureErrorBuffers.size(), featureErrorBuffers.data());
+    glDeleteBuffers(2, batchBuffers);
+    glDeleteBuffers(1, &batchOnes);
+}
+
+void NeuralNetwork::setInputShape(const int channels, const int height, const int width) {
+    if (!layerSizes.empty() || inputShape.channels > 0) {
+        throw std::runtime_error("The input shape must be set first, and only once.");
+    }
+    if (channels < 1 || height < 1 || width < 1) {
+        throw std::invalid_argument("Invalid input shape.");
+    }
+    inputShape = {channels, height, width};
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, inputShape.size() * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    featureBuffers.push_back(buffer);
+}
+
+FeatureKernels &NeuralNetwork::getFeatureKernels() {
+    if (!featureKernels) {
+        featureKernels = std::make_unique<FeatureKernels>(&matmulShader, &sgdUpdateShader);
+    }
+    return *featureKernels;
+}
+
+WeightInitializer &NeuralNetwork::getWeightInitializer() {
+    if (!weightInitializer) {
+        weightInitializer = std::make_unique<WeightInitializer>();
+    }
+    return *weightInitializer;
+}
+
+void NeuralNetwork::setWeightInit(const WeightInitConfig &config) {
+    WeightInitializer::limit(config.scheme, 1, 1); // rejects unknown schemes
+    weightInit = config;
+}
+
+SparseKernels &NeuralNetwork::getSparseKernels() {
+    if (!sparseKernels) {
+        sparseKernels = std::make_unique<SparseKernels>();
+    }
+    return *sparseKernels;
+}
+
+void NeuralNetwork::addConv2D(const int outChannels, const int kernelSize, const int stride, const int padding,
+                              const FeatureActivation activation, const ConvAlgorithm algorithm) {
+    if (inputShape.channels == 0) {
+        throw std::runtime_error("Call setInputShape() before adding convolution layers.");
+    }
+    const TensorShape input = features.empty() ? inputShape : features.back()->outputShape();
+    auto layer = std::make_unique<Conv2DLayer>(input, outChannels, kernelSize, stride, padding, activation, algorithm,
+                                               &getFeatureKernels());
+    layer->initializeWeights(getWeightInitializer(), weightInit.seed,
+                             FEATURE_INIT_STREAM + static_cast<uint32_t>(features.size()));
+    addFeature(std::move(layer));
+}
+
+void NeuralNetwork::addPool(const PoolType type, const int window, const int stride) {
+    if (inputShape.channels == 0) {
+        throw std::runtime_error("Call setInputShape() before adding pooling layers.");
+    }
+    const TensorShape input = features.empty() ? inputShape : features.back()->outputShape();
+    addFeature(std::make_unique<PoolLayer>(input, type, window, stride, &getFeatureKernels()));
+}
+
+void NeuralNetwork::addFeature(std::unique_ptr<FeatureLayer> layer) {
+    if (!layerSizes.empty()) {
+        throw std::runtime_error("Feature layers must be added before the dense layers.");
+    }
+    const int outputSize = layer->outputShape().size();
+    features.push_back(std::move(layer));
+
+    GLuint newOutBuffer, newErrorBuffer;
+    glGenBuffers(1, &newOutBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, newOutBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, outputSize * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    featureBuffers.push_back(newOutBuffer);
+
+    glGenBuffers(1, &newErrorBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, newErrorBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, outputSize * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+    featureErrorBuffers.push_back(newErrorBuffer);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+GLuint NeuralNetwork::inputBuffer() const {
+    return featureBuffers.empty() ? activationBuffers.front() : featureBuffers.front();
+}
+
+void NeuralNetwork::featureForward() {
+    for (size_t i = 0; i < features.size(); ++i) {
+        features[i]->forward(featureBuffers[i], featureBuffers[i + 1]);
+    }
+}
+
+void NeuralNetwork::featureBackward(const bool accumulate) {
+    for (int i = static_cast<int>(features.size()) - 1; i >= 0; --i) {
+        // The first layer has nobody to pass its error to
+        const GLuint errorForInput = i > 0 ? featureErrorBuffers[i - 1] : 0;
+        features[i]->backward(featureBuffers[i], featureErrorBuffers[i], errorForInput, accumulate);
+    }
 }
 
 void NeuralNetwork::addLayer(int inputSize, int neuronCount) {
+    addInput(inputSize);
+    appendLayer(neuronCount, {});
+}
+
+void NeuralNetwork::addLayer(int neuronCount) {
+    appendLayer(neuronCount, {});
+}
+
+void NeuralNetwork::addStreamedLayer(const int inputSize, const int neuronCount, const std::string &weightFile) {
+    addInput(inputSize);
+    appendLayer(neuronCount, weightFile);
+}
+
+void NeuralNetwork::addStreamedLayer(const int neuronCount, const std::string &weightFile) {
+    appendLayer(neuronCount, weightFile);
+}
+
+void NeuralNetwork::addInput(const int inputSize) {
     if (!layers.empty()) {
         throw std::runtime_error("This method can only be used for the first layer.");
     }
+    if (inputShape.channels > 0) {
+        throw std::runtime_error("The input size follows from setInputShape(), use addLayer(neuronCount).");
+    }
     layerSizes.push_back(inputSize);
 
     // Create the very first activation buffer, which will hold the network's input
@@ -36,20 +184,38 @@ void NeuralNetwork::addLayer(int inputSize, int neuronCount) {
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputActBuffer);
     glBufferData(GL_SHADER_STORAGE_BUFFER, inputSize * sizeof(float), nullptr, GL_DYNAMIC_COPY);
     activationBuffers.push_back(inputActBuffer);
-
-    // Now add the actual layer
-    addLayer(neuronCount);
 }
 
-void NeuralNetwork::addLayer(int neuronCount) {
+void NeuralNetwork::appendLayer(const int neuronCount, const std::string &weightFile, const bool initialize,
+                                const Layer *sharedParameters, const int tileColumns) {
     if (layerSizes.empty()) {
-        throw std::runtime_error("You must call the addLayer(inputSize, neuronCount) overload for the first layer.");
+        if (inputShape.channels == 0) {
+            throw std::runtime_error(
+                "You must call the addLayer(inputSize, neuronCount) overload for the first layer.");
+        }
+        // The first dense layer reads the flattened output of the last feature layer (or the image itself)
+        layerSizes.push_back(featureBuffers.size() > 1 ? features.back()->outputShape().size() : inputShape.size());
+        activationBuffers.push_back(featureBuffers.back());
     }
 
+    // The new layer would land behind the CPU layers, start over on the GPU
+    if (!cpuLayers.empty()) setPlacement(layers.size());
+
     int inputSize = layerSizes.back();
-    layers.emplace_back(std::make_unique<Layer>(inputSize, neuronCount, &matmulShader, &matmulTransposeAShader,
-                                                &elementwiseShader, &activationShader, &outerProductShader,
-                                                &sgdUpdateShader));
+    plan.reset();
+    megakernel.reset();
+    if (sharedParameters) {
+        layers.emplace_back(std::make_unique<Layer>(*sharedParameters, &matmulShader, &matmulTransposeAShader,
+                                                    &elementwiseShader, &activationShader, &outerProductShader,
+                                                    &sgdUpdateShader));
+    } else {
+        layers.emplace_back(std::make_unique<Layer>(inputSize, neuronCount, &matmulShader, &matmulTransposeAShader,
+                                                    &elementwiseShader, &activationShader, &outerProductShader,
+                                                    &sgdUpdateShader, weightFile, tileColumns));
+    }
+    if (initialize && !sharedParameters) {
+        layers.back()->initializeWeights(getWeightInitializer(), weightInit, static_cast<uint32_t>(layers.size() - 1));
+    }
     layerSizes.push_back(neuronCount);
 
     // Create a new activation buffer and error buffer for the output of this new layer
@@ -64,79 +230,585 @@ void NeuralNetwork::addLayer(int neuronCount) {
     glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_COPY);
     errorBuffers.push_back(newErrorBuffer);
 
+    // The target buffer always matches the current output layer
+    if (targetBuffer == 0) glGenBuffers(1, &targetBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, targetBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, neuronCount * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
-std::vector<float> NeuralNetwork::predict(const std::vector<float> &inputData) {
+void NeuralNetwork::uploadInput(const std::span<const float> inputData) {
     if (layers.empty()) throw std::runtime_error("Cannot predict with an empty network.");
-    if (inputData.size() != layerSizes.front())
+    if (inputData.size() != static_cast<size_t>(getInputSize()))
         throw std::invalid_argument(
             "Input data size does not match network input size.");
 
-    // Step 1: Upload input data to the first activation buffer
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, activationBuffers[0]);
+    if (getFirstCpuLayer() == 0 && features.empty()) {
+        // Only the CPU needs it
+        std::ranges::copy(inputData, boundaryActivation.begin());
+        hostInputPending = true;
+        return;
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputBuffer());
     glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, inputData.size() * sizeof(float), inputData.data());
+}
 
-    // Step 2: Propagate through all layers
-    for (size_t i = 0; i < layers.size(); ++i) {
-        layers[i]->forward(activationBuffers[i], activationBuffers[i + 1]);
+void NeuralNetwork::uploadTarget(const std::span<const float> targetData) {
+    if (targetData.size() != static_cast<size_t>(layerSizes.back()))
+        throw std::invalid_argument(
+            "Target data size does not match network output size.");
+
+    if (!cpuLayers.empty()) hostTarget.assign(targetData.begin(), targetData.end());
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, targetBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, targetData.size() * sizeof(float), targetData.data());
+}
+
+void NeuralNetwork::setAugmentation(const AugmentationConfig &config) {
+    if (!config.isEnabled()) {
+        augmenter.reset();
+        return;
     }
+    if (layerSizes.empty() && inputShape.channels == 0) {
+        throw std::runtime_error("Add the input before enabling augmentation.");
+    }
+    if (config.isGeometric() && inputShape.channels == 0) {
+        throw std::runtime_error("Shifts, flips and crops need an image input, see setInputShape().");
+    }
+    // Plain vector inputs are a 1 x 1 x n image, for the noise
+    const TensorShape shape = inputShape.channels > 0 ? inputShape : TensorShape{1, 1, getInputSize()};
+    augmenter = std::make_unique<Augmenter>(shape, config);
+}
+
+void NeuralNetwork::augmentInput() {
+    if (!augmenter) return;
+    if (hostInputPending) {
+        // Only the CPU layers need the input, but it is augmented on the GPU like everywhere else
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputBuffer());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, boundaryActivation.size() * sizeof(float),
+                        boundaryActivation.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        hostInputPending = false;
+    }
+    augmenter->apply(inputBuffer(), augmentationStep++);
+}
+
+void NeuralNetwork::setCompiledExecution(const bool enabled) {
+    compiledExecution = enabled;
+}
+
+void NeuralNetwork::setActivationCheckpoints(std::vector<int> layerIndices) {
+    if (std::ranges::any_of(layerIndices, [](const int l) { return l < 0; })) {
+        throw std::invalid_argument("Activation checkpoints must be layer indices.");
+    }
+    std::ranges::sort(layerIndices);
+    activationCheckpoints = std::move(layerIndices);
+    plan.reset();
+}
+
+bool NeuralNetwork::usesExecutionPlan() const {
+    const size_t gpuLayers = getFirstCpuLayer();
+    return compiledExecution && gpuLayers > 0 &&
+           std::none_of(layers.begin(), layers.begin() + static_cast<std::ptrdiff_t>(gpuLayers),
+                        [](const auto &layer) { return layer->isStreamed() || layer->isSparse(); });
+}
+
+ExecutionPlan &NeuralNetwork::getExecutionPlan() {
+    if (layers.empty()) throw std::runtime_error("Cannot compile an empty network.");
+    if (!plan) {
+        // Only the GPU part: layers [0, gpuLayers)
+        const size_t gpuLayers = getFirstCpuLayer();
+        if (gpuLayers == 0) throw std::runtime_error("No layers run on the GPU.");
+        if (std::any_of(layers.begin(), layers.begin() + static_cast<std::ptrdiff_t>(gpuLayers),
+                        [](const auto &layer) { return layer->isStreamed() || layer->isSparse(); })) {
+            throw std::runtime_error("Streamed and pruned layers cannot be compiled, they run layer by layer.");
+        }
+
+        GraphBindings bindings;
+        bindings.input = activationBuffers.front();
+        bindings.output = activationBuffers[gpuLayers];
+        bindings.target = targetBuffer;
+        bindings.inputGradient = features.empty() ? 0 : featureErrorBuffers.back();
+        if (gpuLayers < layers.size()) bindings.outputError = errorBuffers[gpuLayers - 1];
+
+        GraphKernels kernels;
+        kernels.matmul = &matmulShader;
+        kernels.matmulTransposed = &matmulTransposeAShader;
+        kernels.outerProduct = &outerProductShader;
+        kernels.sgdUpdate = &sgdUpdateShader;
+        plan = std::make_unique<ExecutionPlan>(std::span(layers).first(gpuLayers), bindings, kernels,
+                                               activationCheckpoints);
+    }
+    return *plan;
+}
+
+void NeuralNetwork::forwardPass() {
+    featureForward();
+    const size_t gpuLayers = getFirstCpuLayer();
+    if (gpuLayers > 0) {
+        if (usesExecutionPlan()) {
+            getExecutionPlan().inference.run();
+        } else {
+            for (size_t i = 0; i < gpuLayers; ++i) {
+                layers[i]->forward(activationBuffers[i], activationBuffers[i + 1]);
+            }
+        }
+    }
+    if (!cpuLayers.empty()) cpuForward();
+}
+
+void NeuralNetwork::cpuForward() {
+    Profiler::Scope scope("NeuralNetwork: CPU layers forward");
+    if (!hostInputPending) {
+        // The one transfer of the forward pass
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, activationBuffers[getFirstCpuLayer()]);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, boundaryActivation.size() * sizeof(float),
+                           boundaryActivation.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    hostInputPending = false;
+
+    const float *x = boundaryActivation.data();
+    for (const auto &layer: cpuLayers) {
+        layer->forward(x);
+        x = layer->output.data();
+    }
+}
+
+std::vector<float> NeuralNetwork::predict(const std::vector<float> &inputData) {
+    std::vector<float> outputData(layerSizes.empty() ? 0 : layerSizes.back());
+    predict(inputData, outputData);
+    return outputData;
+}
+
+void NeuralNetwork::predict(const std::span<const float> inputData, const std::span<float> outputData) {
+    // Step 1: Upload input data to the first activation buffer
+    uploadInput(inputData);
+    if (outputData.size() != static_cast<size_t>(layerSizes.back()))
+        throw std::invalid_argument(
+            "Output buffer size does not match network output size.");
+
+    // Step 2: Propagate through all layers
+    forwardPass();
 
     // Step 3: Download the result from the last buffer
-    const int outputSize = layerSizes.back();
-    std::vector<float> outputData(outputSize);
+    if (!cpuLayers.empty()) {
+        std::ranges::copy(cpuLayers.back()->output, outputData.begin());
+        return;
+    }
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, activationBuffers.back());
     glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, outputData.size() * sizeof(float), outputData.data());
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
 
-    return outputData;
+bool NeuralNetwork::canPredictBatched() const {
+    return !layers.empty() && features.empty() && cpuLayers.empty() &&
+           std::none_of(layers.begin(), layers.end(),
+                        [](const auto &layer) { return layer->isStreamed() || layer->isSparse(); });
+}
+
+void NeuralNetwork::predictBatch(const std::span<const float> inputData, const size_t batchSize,
+                                 const std::span<float> outputData) {
+    if (layers.empty()) throw std::runtime_error("Cannot predict with an empty network.");
+    const size_t inSize = getInputSize();
+    const size_t outSize = layerSizes.back();
+    if (inputData.size() != batchSize * inSize)
+        throw std::invalid_argument(
+            "Input data size does not match batch size times network input size.");
+    if (outputData.size() != batchSize * outSize)
+        throw std::invalid_argument(
+            "Output buffer size does not match batch size times network output size.");
+    if (batchSize == 0) return;
+
+    if (!canPredictBatched()) {
+        for (size_t b = 0; b < batchSize; ++b) {
+            predict(inputData.subspan(b * inSize, inSize), outputData.subspan(b * outSize, outSize));
+        }
+        return;
+    }
+
+    const size_t widest = *std::ranges::max_element(layerSizes);
+    if (batchBufferFloats < widest * batchSize) {
+        batchBufferFloats = widest * batchSize;
+        if (batchBuffers[0] == 0) glGenBuffers(2, batchBuffers);
+        for (const GLuint buffer: batchBuffers) {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, batchBufferFloats * sizeof(float), nullptr, GL_DYNAMIC_COPY);
+        }
+    }
+    if (batchOnesCount < batchSize) {
+        batchOnesCount = batchSize;
+        const std::vector ones(batchOnesCount, 1.0f);
+        if (batchOnes == 0) glGenBuffers(1, &batchOnes);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, batchOnes);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, ones.size() * sizeof(float), ones.data(), GL_STATIC_DRAW);
+    }
+
+    // The layers want one column per sample, the caller has one row per sample
+    batchHost.resize(widest * batchSize);
+    for (size_t b = 0; b < batchSize; ++b) {
+        for (size_t i = 0; i < inSize; ++i) {
+            batchHost[i * batchSize + b] = inputData[b * inSize + i];
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, batchBuffers[0]);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, inSize * batchSize * sizeof(float), batchHost.data());
+
+    const auto batch = static_cast<int>(batchSize);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        layers[i]->forwardBatch(batchBuffers[i % 2], batchBuffers[(i + 1) % 2], batch, batchOnes);
+    }
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, batchBuffers[layers.size() % 2]);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, outSize * batchSize * sizeof(float), batchHost.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    for (size_t b = 0; b < batchSize; ++b) {
+        for (size_t o = 0; o < outSize; ++o) {
+            outputData[b * outSize + o] = batchHost[o * batchSize + b];
+        }
+    }
+}
+
+void NeuralNetwork::evaluate(const std::vector<float> &inputData, const std::vector<float> &targetData,
+                             GpuMetrics &metrics) {
+    uploadInput(inputData);
+    forwardPass();
+    uploadTarget(targetData);
+    if (!cpuLayers.empty()) {
+        // The metrics are reduced on the GPU
+        const auto &output = cpuLayers.back()->output;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, activationBuffers.back());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, output.size() * sizeof(float), output.data());
+    }
+    metrics.accumulate(activationBuffers.back(), targetBuffer, layerSizes.back());
+}
+
+void NeuralNetwork::evaluate(DeviceDataset &dataset, const size_t position, GpuMetrics &metrics) {
+    checkDataset(dataset);
+    dataset.gather(position, inputBuffer(), targetBuffer, false);
+    forwardPass();
+    if (!cpuLayers.empty()) {
+        const auto &output = cpuLayers.back()->output;
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, activationBuffers.back());
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, output.size() * sizeof(float), output.data());
+    }
+    metrics.accumulate(activationBuffers.back(), targetBuffer, layerSizes.back());
 }
 
 void NeuralNetwork::train(const std::vector<float> &inputData, const std::vector<float> &targetData) {
-    // 1. Forward pass (leaves activations in GPU buffers)
-    predict(inputData);
+    train(std::span(inputData), std::span(targetData));
+}
 
-    // 2. Calculate initial error at the output layer: δ_L = prediction - target
-    const int outputSize = layerSizes.back();
-    GLuint targetBuffer;
-    glGenBuffers(1, &targetBuffer);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, targetBuffer);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, targetData.size() * sizeof(float), targetData.data(), GL_STATIC_DRAW);
-
-    elementwiseShader.use();
-    elementwiseShader.setInt("u_op_type", 1); // Subtract
-    elementwiseShader.setInt("u_element_count", outputSize);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, activationBuffers.back()); // prediction
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, targetBuffer); // target
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorBuffers.back()); // result -> output error δ_L
-    elementwiseShader.dispatch((outputSize + 255) / 256, 1, 1);
-    glDeleteBuffers(1, &targetBuffer);
+void NeuralNetwork::train(const std::span<const float> inputData, const std::span<const float> targetData) {
+    uploadInput(inputData);
+    augmentInput();
+    uploadTarget(targetData);
+    trainStep();
+}
 
-    // 3. Backward Pass
-    // First, process the output layer (L) using its specialized backward method
-    layers.back()->backward(errorBuffers.back());
+void NeuralNetwork::train(DeviceDataset &dataset, const size_t position) {
+    checkDataset(dataset);
+    dataset.gather(position, inputBuffer(), targetBuffer, true);
+    augmentInput();
+    if (!cpuLayers.empty()) {
+        hostTarget.resize(layerSizes.back());
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, targetBuffer);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, hostTarget.size() * sizeof(float), hostTarget.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+    trainStep();
+}
 
-    // Then, propagate the error backward through the hidden layers (L-1 to 1)
-    for (int i = layers.size() - 2; i >= 0; --i) {
-        const GLuint errorFromNextLayer = errorBuffers[i + 1];
-        const GLuint weightsOfNextLayer = layers[i + 1]->weightsBuffer;
-        const GLuint errorForPrevLayer = errorBuffers[i];
-        layers[i]->backward(errorFromNextLayer, weightsOfNextLayer, errorForPrevLayer);
+bool NeuralNetwork::canTrainFused() const {
+    return features.empty() && cpuLayers.empty() && !augmenter && !gradientSync && Megakernel::supports(layers);
+}
+
+void NeuralNetwork::trainFused(DeviceDataset &dataset, const size_t position, const int steps, const int batchSize) {
+    checkDataset(dataset);
+    if (!canTrainFused()) {
+        throw std::runtime_error("This network cannot be trained by a megakernel, see canTrainFused().");
+    }
+    checkOwnsParameters();
+    // Gradients of earlier train() calls belong to an update of their own
+    flushGradients();
+    if (!megakernel) {
+        megakernel = std::make_unique<Megakernel>(layers);
     }
+    megakernel->train(layers, dataset, position, steps, batchSize, learningRate);
+}
+
+void NeuralNetwork::checkDataset(const DeviceDataset &dataset) const {
+    if (layers.empty()) throw std::runtime_error("Cannot train an empty network.");
+    if (dataset.getInputSize() != getInputSize() || dataset.getTargetSize() != layerSizes.back()) {
+        throw std::invalid_argument("Dataset sample size does not match the network.");
+    }
+}
+
+void NeuralNetwork::trainStep() {
+    Profiler::Scope scope("NeuralNetwork: train step");
+    checkOwnsParameters();
+    // The first micro-batch overwrites the gradient buffers, the following ones add to them
+    const bool accumulate = accumulatedMicroBatches > 0;
+    const bool lastMicroBatch = accumulatedMicroBatches + 1 >= accumulationSteps;
+    // Only the final accumulated gradients need to be averaged across ranks
+    GradientBucketer *sync = lastMicroBatch ? gradientSync.get() : nullptr;
+
+    featureForward();
+    if (getFirstCpuLayer() == 0) {
+        cpuTrainStep(accumulate);
+    } else if (usesExecutionPlan()) {
+        // Forward and backward in one replayed schedule; layers report their gradients in the same
+        // order as below so they can be averaged while the earlier layers are still running
+        const ExecutionPlan &compiled = getExecutionPlan();
+        const Schedule &schedule = accumulate ? compiled.trainingAccumulate : compiled.training;
+        std::function<void()> onOutputReady;
+        if (!cpuLayers.empty()) {
+            // Between the GPU forward and backward pass
+            onOutputReady = [this, accumulate] { cpuTrainStep(accumulate); };
+        }
+        if (sync) {
+            schedule.run(0.0f, [this, sync](const int layer) { sync->submit(*layers[layer]); }, onOutputReady);
+        } else {
+            schedule.run(0.0f, {}, onOutputReady);
+        }
+    } else {
+        layerwiseTrainStep(accumulate, sync);
+    }
+    featureBackward(accumulate);
+
+    if (sync) sync->finish();
+    ++accumulatedMicroBatches;
 
     // 4. Update Parameters for all layers
+    if (lastMicroBatch) {
+        applyGradients(accumulatedMicroBatches);
+    }
+}
+
+void NeuralNetwork::cpuTrainStep(const bool accumulate) {
+    cpuForward();
+
+    Profiler::Scope scope("NeuralNetwork: CPU layers backward");
+    cpuLayers.back()->backwardFromTarget(hostTarget.data(), accumulate);
+    for (int i = static_cast<int>(cpuLayers.size()) - 2; i >= 0; --i) {
+        cpuLayers[i]->backward(*cpuLayers[i + 1], accumulate);
+    }
+
+    // The one transfer of the backward pass: the error for the GPU layers (or the feature layers)
+    const size_t gpuLayers = getFirstCpuLayer();
+    if (gpuLayers == 0 && features.empty()) return;
+    cpuLayers.front()->propagate(boundaryError.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, gpuLayers > 0 ? errorBuffers[gpuLayers - 1] : featureErrorBuffers.back());
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, boundaryError.size() * sizeof(float), boundaryError.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void NeuralNetwork::layerwiseTrainStep(const bool accumulate, GradientBucketer *sync) {
+    const int gpuLayers = static_cast<int>(getFirstCpuLayer());
+
+    // 1. Forward pass (leaves activations in GPU buffers, nothing is read back)
+    for (int i = 0; i < gpuLayers; ++i) {
+        layers[i]->forward(activationBuffers[i], activationBuffers[i + 1]);
+    }
+
+    if (cpuLayers.empty()) {
+        // 2. Calculate initial error at the output layer: δ_L = prediction - target
+        const int outputSize = layerSizes.back();
+
+        elementwiseShader.use();
+        elementwiseShader.setInt("u_op_type", 1); // Subtract
+        elementwiseShader.setInt("u_element_count", outputSize);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, activationBuffers.back()); // prediction
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, targetBuffer); // target
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorBuffers.back()); // result -> output error δ_L
+        elementwiseShader.dispatch((outputSize + 255) / 256, 1, 1);
+
+        // 3. Backward Pass
+        // First, process the output layer (L) using its specialized backward method
+        layers.back()->backward(errorBuffers.back(), accumulate);
+        if (sync) sync->submit(*layers.back());
+    } else {
+        // The CPU layers finish the forward pass and hand back the propagated error of the last GPU layer
+        cpuTrainStep(accumulate);
+        layers[gpuLayers - 1]->backwardFromError(errorBuffers[gpuLayers - 1], accumulate);
+    }
+
+    // Then, propagate the error backward through the hidden layers (L-1 to 1)
+    for (int i = gpuLayers - 2; i >= 0; --i) {
+        // transpose(W_{l+1}) * δ_{l+1} from the next layer's final δ (its deltaBuffer), shard by shard
+        layers[i + 1]->propagateError(errorBuffers[i]);
+        layers[i]->backwardFromError(errorBuffers[i], accumulate);
+        // Start averaging this layer's gradients while the earlier layers are still running
+        if (sync) sync->submit(*layers[i]);
+    }
+
+    // dL/d(input) for the feature layers: W_0^T δ_0
+    if (!features.empty()) {
+        layers.front()->propagateError(featureErrorBuffers.back());
+    }
+}
+
+void NeuralNetwork::setPlacement(const size_t firstCpuLayer) {
+    if (firstCpuLayer > layers.size()) {
+        throw std::invalid_argument("Placement boundary is past the last layer.");
+    }
+    if (firstCpuLayer < layers.size() && gradientSync) {
+        throw std::runtime_error("Data-parallel training requires all layers on the GPU.");
+    }
+    if (firstCpuLayer == getFirstCpuLayer()) return;
+    checkOwnsParameters();
+
+    // Pending gradients belong to the current placement
+    flushGradients();
+    syncCpuLayers();
+    cpuLayers.clear();
+    for (size_t i = firstCpuLayer; i < layers.size(); ++i) {
+        cpuLayers.push_back(std::make_unique<CpuLayer>(*layers[i]));
+    }
+    boundaryActivation.assign(layerSizes[firstCpuLayer], 0.0f);
+    boundaryError.assign(layerSizes[firstCpuLayer], 0.0f);
+    hostInputPending = false;
+    plan.reset();
+}
+
+void NeuralNetwork::pruneLayer(const size_t index, const float threshold) {
+    if (index >= layers.size()) {
+        throw std::out_of_range("Layer index out of range.");
+    }
+    checkOwnsParameters();
+    // Pruned on the GPU; CPU layers are synced back first and recreated from the result
+    const size_t firstCpuLayer = getFirstCpuLayer();
+    setPlacement(layers.size());
+    flushGradients();
+    layers[index]->prune(threshold, getSparseKernels());
+    plan.reset();
+    megakernel.reset();
+    setPlacement(firstCpuLayer);
+}
+
+std::unique_ptr<NeuralNetwork> NeuralNetwork::createReplica() const {
+    if (layers.empty()) {
+        throw std::runtime_error("Cannot replicate an empty network.");
+    }
+    if (!features.empty()) {
+        throw std::runtime_error("Replicas do not support convolution/pooling layers yet.");
+    }
+    // The replica reads the GPU layers, layers placed on the CPU have the current parameters
+    syncCpuLayers();
+
+    auto replica = std::make_unique<NeuralNetwork>();
+    replica->learningRate = learningRate;
+    replica->compiledExecution = compiledExecution;
+    replica->parameterOwner = this;
+    replica->addInput(layerSizes.front());
     for (const auto &layer: layers) {
-        layer->update(learningRate);
+        replica->appendLayer(layer->neuronCount, {}, false, layer.get());
+    }
+    return replica;
+}
+
+void NeuralNetwork::checkOwnsParameters() const {
+    if (parameterOwner) {
+        throw std::runtime_error("A replica only runs inference, its parameters belong to another network.");
+    }
+}
+
+void NeuralNetwork::syncCpuLayers() const {
+    const size_t first = getFirstCpuLayer();
+    for (size_t i = 0; i < cpuLayers.size(); ++i) {
+        cpuLayers[i]->copyTo(*layers[first + i]);
+    }
+}
+
+void NeuralNetwork::setGradientAccumulationSteps(const int steps) {
+    if (steps < 1) {
+        throw std::invalid_argument("Gradient accumulation steps must be at least 1.");
+    }
+    flushGradients();
+    accumulationSteps = steps;
+}
+
+void NeuralNetwork::flushGradients() {
+    if (accumulatedMicroBatches == 0) return;
+
+    if (gradientSync) {
+        for (auto it = layers.rbegin(); it != layers.rend(); ++it) {
+            gradientSync->submit(**it);
+        }
+        gradientSync->finish();
+    }
+    applyGradients(accumulatedMicroBatches);
+}
+
+void NeuralNetwork::applyGradients(const int microBatches) {
+    // The gradient buffers hold the sum over the micro-batches; scale the step so it
+    // matches the mean gradient, like one update on the whole batch would.
+    const float scaledRate = learningRate / static_cast<float>(microBatches);
+    if (usesExecutionPlan()) {
+        getExecutionPlan().update.run(scaledRate);
+    } else {
+        for (size_t i = 0; i < getFirstCpuLayer(); ++i) {
+            layers[i]->update(scaledRate);
+        }
+    }
+    for (const auto &layer: cpuLayers) {
+        layer->update(scaledRate);
+    }
+    for (const auto &feature: features) {
+        feature->update(scaledRate);
+    }
+    accumulatedMicroBatches = 0;
+}
+
+void NeuralNetwork::setCommunicator(Communicator *communicator) {
+    if (communicator) checkOwnsParameters();
+    if (communicator && communicator->worldSize() > 1 && !features.empty()) {
+        throw std::runtime_error("Data-parallel training does not support convolution/pooling layers yet.");
+    }
+    if (communicator && communicator->worldSize() > 1 && !cpuLayers.empty()) {
+        throw std::runtime_error("Data-parallel training requires all layers on the GPU.");
+    }
+    gradientSync.reset();
+    this->communicator = communicator;
+    if (communicator && communicator->worldSize() > 1) {
+        gradientSync = std::make_unique<GradientBucketer>(*communicator);
+    }
+}
+
+void NeuralNetwork::synchronizeParameters() {
+    if (!communicator) {
+        throw std::runtime_error("synchronizeParameters() requires a communicator.");
+    }
+
+    std::vector<float> weights, biases;
+    for (const auto &layer: layers) {
+        layer->downloadParameters(weights, biases);
+        communicator->broadcast(weights.data(), weights.size());
+        communicator->broadcast(biases.data(), biases.size());
+        layer->uploadParameters(weights, biases);
     }
 }
 
 using json = nlohmann::json;
 
 void NeuralNetwork::saveToFile(const std::string &path) const {
+    syncCpuLayers();
     json j;
     j["learning_rate"] = this->learningRate;
     j["architecture"] = this->layerSizes; // Save the full architecture [input, hidden1, ..., output]
 
+    if (inputShape.channels > 0) {
+        j["input_shape"] = {inputShape.channels, inputShape.height, inputShape.width};
+        j["features"] = json::array();
+        for (const auto &feature: features) {
+            j["features"].push_back(feature->toJson());
+        }
+    }
+
     j["layers"] = json::array();
     for (const auto &layer: layers) {
         j["layers"].push_back(layer->toJson());
@@ -168,17 +840,39 @@ std::unique_ptr<NeuralNetwork> NeuralNetwork::loadFromFile(const std::string &pa
     }
 
     // Create the network layer by layer
-    nn->addLayer(arch[0], arch[1]);
-    for (size_t i = 2; i < arch.size(); ++i) {
-        nn->addLayer(arch[i]);
+    if (j.contains("input_shape")) {
+        const auto shape = j.at("input_shape").get<std::vector<int> >();
+        if (shape.size() != 3) {
+            throw std::runtime_error("Invalid input shape in model file.");
+        }
+        nn->setInputShape(shape[0], shape[1], shape[2]);
+        for (const auto &spec: j.value("features", json::array())) {
+            const TensorShape input = nn->features.empty() ? nn->inputShape : nn->features.back()->outputShape();
+            auto feature = FeatureLayer::fromJson(spec, input, nn->getFeatureKernels());
+            feature->loadParameters(spec);
+            nn->addFeature(std::move(feature));
+        }
+    } else {
+        nn->addInput(arch[0]);
     }
-
-    // Load the parameters into each layer
-    if (j.at("layers").size() != nn->layers.size()) {
+    // Streamed layers map the file they were saved with again, their weights are in it
+    const json &layerSpecs = j.at("layers");
+    if (layerSpecs.size() != arch.size() - 1) {
         throw std::runtime_error("Mismatched layer count in model file.");
     }
+    for (size_t i = 1; i < arch.size(); ++i) {
+        const json &spec = layerSpecs[i - 1];
+        nn->appendLayer(arch[i], spec.value("weight_file", std::string()), false, nullptr,
+                        spec.contains("weights") ? 0 : spec.value("tile_columns", 0));
+    }
+    if (nn->layerSizes.front() != arch[0]) {
+        throw std::runtime_error("Feature layers do not match the architecture in model file.");
+    }
+
+    // Load the parameters into each layer
     for (size_t i = 0; i < nn->layers.size(); ++i) {
-        nn->layers[i]->loadParameters(j["layers"][i]);
+        const json &spec = j["layers"][i];
+        nn->layers[i]->loadParameters(spec, spec.contains("sparse") ? &nn->getSparseKernels() : nullptr);
     }
 
     return nn;
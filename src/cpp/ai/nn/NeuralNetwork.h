@@ -7,10 +7,23 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 #include <string>
 #include "Layer.h"
+#include "Conv2DLayer.h"
+#include "PoolLayer.h"
+#include "CpuLayer.h"
+#include "Augmenter.h"
+#include "WeightInitializer.h"
 #include "../gl/Shader.h"
 
+class Communicator;
+class GradientBucketer;
+class GpuMetrics;
+class DeviceDataset;
+class ExecutionPlan;
+class Megakernel;
+
 class NeuralNetwork {
 public:
     float learningRate;
@@ -19,6 +32,35 @@ public:
 
     ~NeuralNetwork();
 
+    /**
+     * @brief Declares the input as a channels x height x width image (CHW), so convolution and pooling
+     * layers can be added in front of the dense layers. Must be called first.
+     */
+    void setInputShape(int channels, int height, int width);
+
+    /**
+     * @brief Adds a convolution layer. All feature layers must be added before the first dense layer,
+     * whose input is then the flattened output of the last one.
+     */
+    void addConv2D(int outChannels, int kernelSize, int stride = 1, int padding = 0,
+                   FeatureActivation activation = FeatureActivation::RELU,
+                   ConvAlgorithm algorithm = ConvAlgorithm::AUTO);
+
+    /**
+     * @brief Adds a max or average pooling layer.
+     * @param stride Distance between windows, 0 uses the window size.
+     */
+    void addPool(PoolType type, int window, int stride = 0);
+
+    /**
+     * @brief How the weights of layers added from now on are initialized (see WeightInitializer). The same
+     * seed and architecture always give the same network. Without a call the scheme is UNIFORM with a
+     * random seed. Convolution layers always use He (ReLU) or Xavier, only the seed applies to them.
+     */
+    void setWeightInit(const WeightInitConfig &config);
+
+    [[nodiscard]] const WeightInitConfig &getWeightInit() const { return weightInit; }
+
     /**
      * Adds input layer. Must be called first.
      * @param inputSize The size of the input vector.
@@ -28,16 +70,171 @@ public:
 
     void addLayer(int neuronCount);
 
+    /**
+     * @brief Like addLayer(), but the layer keeps its weights in a memory-mapped file and streams them
+     * through the device tile by tile, for layers that do not fit in device memory. The file is overwritten.
+     * Networks with streamed layers run layer by layer instead of through the execution plan.
+     */
+    void addStreamedLayer(int inputSize, int neuronCount, const std::string &weightFile);
+
+    void addStreamedLayer(int neuronCount, const std::string &weightFile);
+
     /**
      * @brief Performs a full forward pass through all layers.
      */
     std::vector<float> predict(const std::vector<float> &inputData);
 
+    /**
+     * @brief Same as above, but reads the input from and writes the output to caller-owned memory, without
+     * an intermediate std::vector (e.g. for buffers handed in through the C API, see capi/glnn_c.h).
+     * @param outputData Must hold getLayerSizes().back() floats.
+     */
+    void predict(std::span<const float> inputData, std::span<float> outputData);
+
+    /**
+     * @brief Runs batchSize samples in a single pass: each dense layer is one matrix product over the whole batch
+     * (see Layer::forwardBatch()), and the outputs come back in one read. Networks with feature, streamed,
+     * pruned or CPU layers run the samples one by one instead.
+     * @param inputData batchSize * getInputSize() floats, one sample after the other.
+     * @param outputData batchSize * getLayerSizes().back() floats, in the same order.
+     */
+    void predictBatch(std::span<const float> inputData, size_t batchSize, std::span<float> outputData);
+
+    /**
+     * @brief Runs a forward pass and adds the result to the GPU-side metrics, without reading anything back.
+     */
+    void evaluate(const std::vector<float> &inputData, const std::vector<float> &targetData, GpuMetrics &metrics);
+
+    /**
+     * @brief Same as above for the sample at the given (unshuffled) position of a device-resident dataset.
+     */
+    void evaluate(DeviceDataset &dataset, size_t position, GpuMetrics &metrics);
+
     /**
      * @brief Performs one full training step (forward pass, backpropagation, and parameter update).
+     * With gradient accumulation enabled, the update only happens every N-th call.
      */
     void train(const std::vector<float> &inputData, const std::vector<float> &targetData);
 
+    /**
+     * @brief Same as above for caller-owned memory.
+     */
+    void train(std::span<const float> inputData, std::span<const float> targetData);
+
+    /**
+     * @brief Training step on the sample at the given position of the dataset's current shuffle.
+     * The sample is gathered on the GPU, nothing is uploaded.
+     */
+    void train(DeviceDataset &dataset, size_t position);
+
+    /**
+     * @brief Trains `steps` mini-batches of `batchSize` consecutive positions of the dataset's current shuffle,
+     * starting at `position`, in a single dispatch of a kernel generated for this network (see Megakernel).
+     * Same result as steps * batchSize train() calls with setGradientAccumulationSteps(batchSize).
+     * Keep a call well below the driver's watchdog (about 2 s on Windows).
+     * Needs a small dense network on the GPU without augmentation or data-parallel training, see canTrainFused().
+     */
+    void trainFused(DeviceDataset &dataset, size_t position, int steps, int batchSize = 1);
+
+    [[nodiscard]] bool canTrainFused() const;
+
+    /**
+     * @brief Accumulates the gradients of `steps` train() calls (micro-batches) in place and applies them
+     * in a single update, scaled by 1/steps. Reaches larger effective batch sizes without extra gradient memory.
+     * @param steps Micro-batches per update, 1 (the default) updates after every sample.
+     */
+    void setGradientAccumulationSteps(int steps);
+
+    /**
+     * @brief Augments the input of every train() call on the GPU before the first layer (see Augmenter);
+     * predict() and evaluate() see the input unchanged. Shifts, flips and crops need setInputShape().
+     * A default-constructed config turns augmentation off.
+     */
+    void setAugmentation(const AugmentationConfig &config);
+
+    /**
+     * @brief The step used as the augmentation counter by the next train() call. Set it when resuming a
+     * run, so the remaining steps get the same augmentations as without the interruption.
+     */
+    void setAugmentationStep(uint64_t step) { augmentationStep = step; }
+
+    [[nodiscard]] uint64_t getAugmentationStep() const { return augmentationStep; }
+
+    [[nodiscard]] int getGradientAccumulationSteps() const { return accumulationSteps; }
+
+    /**
+     * @brief Applies any partially accumulated gradients now (e.g. at the end of an epoch).
+     */
+    void flushGradients();
+
+    /**
+     * @brief Enables data-parallel training. Every train() call averages the gradients across all
+     * ranks of the communicator before the update. Pass nullptr to go back to local training.
+     * The communicator must outlive the network (or be detached first).
+     */
+    void setCommunicator(Communicator *communicator);
+
+    /**
+     * @brief Copies the parameters of rank 0 to every other rank, so all replicas start identical.
+     */
+    void synchronizeParameters();
+
+    /**
+     * @brief Chooses between the compiled execution plan (the default) and issuing every layer's
+     * shader calls one by one. Both compute the same result. Streamed layers always run one by one.
+     */
+    void setCompiledExecution(bool enabled);
+
+    [[nodiscard]] bool isCompiledExecution() const { return compiledExecution; }
+
+    /**
+     * @brief Trades compute for memory in the compiled training step: only the inputs of the given layers
+     * (and of layer 0) are kept from the forward pass, and the layers in front of each checkpoint run
+     * forward again during the backward pass. Layers after the last checkpoint keep their activations.
+     * E.g. {4, 8} for 12 layers recomputes layers 0-7. Empty (the default) keeps every activation.
+     * Layers that run one by one (see setCompiledExecution()) always keep theirs.
+     */
+    void setActivationCheckpoints(std::vector<int> layerIndices);
+
+    [[nodiscard]] const std::vector<int> &getActivationCheckpoints() const { return activationCheckpoints; }
+
+    /**
+     * @brief The fused and buffer-planned dispatch schedules of this network, compiled on first use.
+     * With layers placed on the CPU, it only covers the GPU part.
+     */
+    ExecutionPlan &getExecutionPlan();
+
+    /**
+     * @brief Runs the dense layers [firstCpuLayer, layerCount) on the CPU and the others on the GPU, with a
+     * single transfer where they meet. getLayerCount() (the default) keeps everything on the GPU.
+     * See PlacementPlanner for choosing the split from measurements. Adding a layer resets the placement.
+     * While layers run on the CPU, their parameters only reach the GPU buffers (getLayer()) when the
+     * network is saved or checkpointed.
+     */
+    void setPlacement(size_t firstCpuLayer);
+
+    [[nodiscard]] size_t getFirstCpuLayer() const { return layers.size() - cpuLayers.size(); }
+
+    /**
+     * @brief Prunes dense layer `index`: weights with |w| <= threshold are dropped for good and the rest is
+     * kept in CSR form (see Layer::prune()), on the GPU and the CPU alike. Pending gradients are applied first.
+     * See Pruner for choosing thresholds by sparsity.
+     */
+    void pruneLayer(size_t index, float threshold);
+
+    /**
+     * @brief Creates an inference-only copy of this network, in the current GL context, that reads this
+     * network's weight and bias buffers instead of holding its own. A replica only allocates its shaders and
+     * activation buffers, so N workers cost one set of parameters plus N sets of activations.
+     * The current context must share objects with the one this network lives in (see
+     * createOffscreenContext()); this network must outlive its replicas and must not be trained while
+     * they run. Replicas can run on different threads at the same time. Dense layers only (sharded is fine,
+     * streamed and pruned layers are not). Training, pruning or placing layers of a replica throws.
+     */
+    [[nodiscard]] std::unique_ptr<NeuralNetwork> createReplica() const;
+
+    [[nodiscard]] bool isReplica() const { return parameterOwner != nullptr; }
+
     void saveToFile(const std::string &path) const;
 
     /**
@@ -47,8 +244,25 @@ public:
      */
     static std::unique_ptr<NeuralNetwork> loadFromFile(const std::string &path);
 
+    // [input, hidden1, ..., output]
+    [[nodiscard]] const std::vector<int> &getLayerSizes() const { return layerSizes; }
+
+    [[nodiscard]] size_t getLayerCount() const { return layers.size(); }
+
+    [[nodiscard]] Layer &getLayer(size_t index) const { return *layers.at(index); }
+
+    // Zero channels if the input is a plain vector
+    [[nodiscard]] const TensorShape &getInputShape() const { return inputShape; }
+
+    [[nodiscard]] size_t getFeatureLayerCount() const { return features.size(); }
+
+    [[nodiscard]] FeatureLayer &getFeatureLayer(size_t index) const { return *features.at(index); }
+
     // get input size
     [[nodiscard]] int getInputSize() const {
+        if (inputShape.channels > 0) {
+            return inputShape.size();
+        }
         if (layerSizes.empty()) {
             throw std::runtime_error("Network has no layers.");
         }
@@ -69,10 +283,138 @@ private:
     // Buffers to hold the activations and errors of each layer.
     std::vector<GLuint> activationBuffers;
     std::vector<GLuint> errorBuffers;
+    // Holds the expected output while training/evaluating
+    GLuint targetBuffer = 0;
 
     // Stores the number of neurons in each layer, starting with the input size.
     std::vector<int> layerSizes;
 
+    // Convolution/pooling layers in front of the dense ones (optional)
+    TensorShape inputShape;
+    std::unique_ptr<FeatureKernels> featureKernels;
+    std::vector<std::unique_ptr<FeatureLayer> > features;
+    // [input, output of feature 0, ...]; the last one is also activationBuffers[0]
+    std::vector<GLuint> featureBuffers;
+    // dL/d(output) of each feature layer
+    std::vector<GLuint> featureErrorBuffers;
+
+    FeatureKernels &getFeatureKernels();
+
+    // Initial weights of new layers, the shader is loaded with the first layer
+    WeightInitConfig weightInit;
+    std::unique_ptr<WeightInitializer> weightInitializer;
+
+    WeightInitializer &getWeightInitializer();
+
+    // Loaded when the first layer is pruned
+    std::unique_ptr<SparseKernels> sparseKernels;
+
+    SparseKernels &getSparseKernels();
+
+    void addFeature(std::unique_ptr<FeatureLayer> layer);
+
+    // Where the network's input is uploaded to
+    [[nodiscard]] GLuint inputBuffer() const;
+
+    void featureForward();
+
+    // Backpropagates featureErrorBuffers.back() (written by the dense backward pass) through the feature layers
+    void featureBackward(bool accumulate);
+
+    void uploadInput(std::span<const float> inputData);
+
+    void uploadTarget(std::span<const float> targetData);
+
+    // Optional input augmentation of train()
+    std::unique_ptr<Augmenter> augmenter;
+    uint64_t augmentationStep = 0;
+
+    // Augments whatever was uploaded or gathered into the input buffer
+    void augmentInput();
+
+    // Runs every layer on whatever is in activationBuffers[0]
+    void forwardPass();
+
+    // predictBatch(): two ping-pong activation buffers of batchBufferFloats floats each, a row of ones for the
+    // biases and the host side of the transposes, all grown to the largest batch seen
+    GLuint batchBuffers[2] = {0, 0};
+    GLuint batchOnes = 0;
+    size_t batchBufferFloats = 0;
+    size_t batchOnesCount = 0;
+    std::vector<float> batchHost;
+
+    // Whether predictBatch() can run the batch as matrices (plain dense layers on the GPU)
+    [[nodiscard]] bool canPredictBatched() const;
+
+    // Forward, backward and update on the input/target already in activationBuffers[0]/targetBuffer
+    void trainStep();
+
+    // Forward and backward through Layer's own shader calls (compiled execution disabled)
+    void layerwiseTrainStep(bool accumulate, GradientBucketer *sync);
+
+    void checkDataset(const DeviceDataset &dataset) const;
+
+    // Gradient accumulation
+    int accumulationSteps = 1;
+    int accumulatedMicroBatches = 0;
+
+    void applyGradients(int microBatches);
+
+    // Data-parallel training (optional)
+    Communicator *communicator = nullptr;
+    std::unique_ptr<GradientBucketer> gradientSync;
+
+    // Dense layers [getFirstCpuLayer(), layerCount) mirrored on the host; empty = everything on the GPU
+    std::vector<std::unique_ptr<CpuLayer> > cpuLayers;
+    // Input of the first CPU layer, read back from the GPU (or the input itself)
+    std::vector<float> boundaryActivation;
+    // dL/d(input) of the first CPU layer, uploaded to the GPU part
+    std::vector<float> boundaryError;
+    std::vector<float> hostTarget;
+    // uploadInput() already left the input in boundaryActivation (nothing runs on the GPU before the CPU layers)
+    bool hostInputPending = false;
+
+    // Finishes the forward pass on the CPU layers
+    void cpuForward();
+
+    // Forward and backward through the CPU layers, leaves the error for the GPU part in its buffer
+    void cpuTrainStep(bool accumulate);
+
+    // Writes the parameters and gradients of the CPU layers back into the GPU layers
+    void syncCpuLayers() const;
+
+    // Compiled schedules, dropped whenever the architecture changes
+    bool compiledExecution = true;
+    std::unique_ptr<ExecutionPlan> plan;
+    std::vector<int> activationCheckpoints;
+
+    // Generated on the first trainFused(), dropped whenever the architecture changes
+    std::unique_ptr<Megakernel> megakernel;
+
+    // Whether the GPU layers run through the execution plan (not with streamed or pruned layers)
+    [[nodiscard]] bool usesExecutionPlan() const;
+
+    // Creates the buffer for the network's input; the first dense layer follows
+    void addInput(int inputSize);
+
+    // `initialize` is false when the parameters are loaded right after; a replica passes the layer whose
+    // parameters it shares; a positive `tileColumns` maps the existing weight file (see Layer::Layer())
+    void appendLayer(int neuronCount, const std::string &weightFile, bool initialize = true,
+                     const Layer *sharedParameters = nullptr, int tileColumns = 0);
+
+    // The network whose parameters a replica reads, nullptr if this network owns its parameters
+    const NeuralNetwork *parameterOwner = nullptr;
+
+    // Throws for replicas, before anything would write the shared parameters
+    void checkOwnsParameters() const;
+
+    // Snapshots and restores the accumulation state along with the parameters
+    friend class Checkpointer;
+    // Measures layers with the network's shaders
+    friend class PlacementPlanner;
+    // Uploads pruned layers with the network's sparse kernels
+    friend class ModelRegistry;
+
     // Disallow copying.
     NeuralNetwork(const NeuralNetwork &) = delete;
 
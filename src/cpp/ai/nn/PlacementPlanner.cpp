@@ -0,0 +1,183 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#include "PlacementPlanner.h"
+#include "CpuLayer.h"
+#include "NeuralNetwork.h"
+#include "../utils/Profiler.h"
+
+#include <chrono>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Stop early once a measurement has taken this long, huge layers on the CPU are slow
+    constexpr double TIME_BUDGET_MICROS = 250000.0;
+
+    double since(const Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    GLuint zeroBuffer(const size_t floats) {
+        const std::vector<float> zeros(floats, 0.0f);
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, floats * sizeof(float), zeros.data(), GL_DYNAMIC_COPY);
+        return buffer;
+    }
+
+    // Runs `step` until `repetitions` are done or the budget is used up, returns the mean in microseconds
+    template<typename Step, typename Finish>
+    double timeSteps(const int repetitions, Step &&step, Finish &&finish) {
+        step(); // warm-up (shader caches, page faults)
+        finish();
+        const auto start = Clock::now();
+        int done = 0;
+        while (done < repetitions) {
+            step();
+            ++done;
+            if (since(start) > TIME_BUDGET_MICROS) break;
+        }
+        finish();
+        return since(start) / done;
+    }
+}
+
+Placement PlacementPlanner::measure(NeuralNetwork &network, const int repetitions) {
+    if (network.layers.empty()) {
+        throw std::runtime_error("Cannot place an empty network.");
+    }
+
+    Placement placement;
+    const auto &sizes = network.layerSizes;
+    for (size_t l = 0; l < network.layers.size(); ++l) {
+        const int in = sizes[l];
+        const int out = sizes[l + 1];
+        LayerCost cost;
+
+        if (network.layers[l]->isStreamed()) {
+            // Streamed because it does not fit in device memory; a scratch copy would not either.
+            // It stays on the GPU, where its tiles are paged in.
+            cost.cpuMicros = std::numeric_limits<double>::infinity();
+            placement.layers.push_back(cost);
+            placement.transferMicros.push_back(0.0);
+            continue;
+        }
+
+        // GPU: the layer's own shader calls on scratch buffers; only the final glFinish waits
+        // A pruned layer is measured with its own sparsity pattern
+        const Layer &original = *network.layers[l];
+        {
+            Layer layer(in, out, &network.matmulShader, &network.matmulTransposeAShader, &network.elementwiseShader,
+                        &network.activationShader, &network.outerProductShader, &network.sgdUpdateShader);
+            if (original.isSparse()) {
+                std::vector<int> rowStart, columns;
+                std::vector<float> values;
+                original.downloadSparse(rowStart, columns, values);
+                layer.setSparse(rowStart, columns, values, network.getSparseKernels());
+            }
+            const GLuint input = zeroBuffer(in);
+            const GLuint output = zeroBuffer(out);
+            const GLuint error = zeroBuffer(out);
+            cost.gpuMicros = timeSteps(repetitions, [&] {
+                layer.forward(input, output);
+                layer.backward(error);
+                layer.update(0.0f);
+            }, [] { glFinish(); });
+            glDeleteBuffers(1, &input);
+            glDeleteBuffers(1, &output);
+            glDeleteBuffers(1, &error);
+        }
+
+        // CPU: the same step on the host
+        {
+            CpuLayer layer = original.isSparse() ? CpuLayer(original) : CpuLayer(in, out);
+            const std::vector<float> input(in, 0.0f);
+            const std::vector<float> target(out, 0.0f);
+            cost.cpuMicros = timeSteps(repetitions, [&] {
+                layer.forward(input.data());
+                layer.backwardFromTarget(target.data());
+                layer.update(0.0f);
+            }, [] {
+            });
+        }
+        placement.layers.push_back(cost);
+
+        // Boundary in front of this layer: wait for a dispatch, read its input back, upload the error
+        {
+            const GLuint activation = zeroBuffer(in);
+            const GLuint gradient = zeroBuffer(in);
+            std::vector<float> host(in);
+            const Shader &touch = network.sgdUpdateShader;
+            placement.transferMicros.push_back(timeSteps(repetitions, [&] {
+                touch.use();
+                touch.setFloat("u_learning_rate", 0.0f);
+                touch.setInt("u_element_count", in);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, activation);
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, gradient);
+                touch.dispatch((in + 255) / 256, 1, 1);
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, activation);
+                glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, in * sizeof(float), host.data());
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, gradient);
+                glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, in * sizeof(float), host.data());
+            }, [] { glFinish(); }));
+            glDeleteBuffers(1, &activation);
+            glDeleteBuffers(1, &gradient);
+        }
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return placement;
+}
+
+void PlacementPlanner::choose(Placement &placement, const bool inputOnHost) {
+    const size_t n = placement.layers.size();
+
+    // cost(k) = GPU layers [0, k) + CPU layers [k, n) + the transfer at k (none if k == n)
+    double best = -1.0;
+    for (size_t k = 0; k <= n; ++k) {
+        double cost = 0.0;
+        for (size_t l = 0; l < n; ++l) {
+            cost += l < k ? placement.layers[l].gpuMicros : placement.layers[l].cpuMicros;
+        }
+        if (k < n && !(k == 0 && inputOnHost)) {
+            cost += placement.transferMicros[k];
+        }
+        if (k == n) placement.allGpuMicros = cost;
+        // Ties go to the GPU, which needs no host round trip
+        if (best < 0.0 || cost <= best) {
+            best = cost;
+            placement.firstCpuLayer = k;
+        }
+    }
+    placement.estimatedMicros = best;
+}
+
+Placement PlacementPlanner::optimize(NeuralNetwork &network, const int repetitions) {
+    Placement placement = measure(network, repetitions);
+    choose(placement, network.features.empty());
+    network.setPlacement(placement.firstCpuLayer);
+    Profiler::global().note("Layer placement", placement.describe(network.getLayerSizes()));
+    return placement;
+}
+
+std::string Placement::describe(const std::vector<int> &layerSizes) const {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << "  layer  shape                 GPU us      CPU us  boundary us  device" << std::endl;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        std::ostringstream shape;
+        shape << layerSizes[l] << " -> " << layerSizes[l + 1];
+        out << "  " << std::left << std::setw(7) << l << std::setw(18) << shape.str() << std::right
+                << std::setw(10) << layers[l].gpuMicros << std::setw(12) << layers[l].cpuMicros << std::setw(13)
+                << transferMicros[l] << "  " << (l < firstCpuLayer ? "GPU" : "CPU") << std::endl;
+    }
+    out << "  estimated " << estimatedMicros << " us/step (all on the GPU: " << allGpuMicros << " us/step)"
+            << std::endl;
+    return out.str();
+}
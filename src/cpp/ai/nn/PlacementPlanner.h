@@ -0,0 +1,62 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#ifndef PLACEMENTPLANNER_H
+#define PLACEMENTPLANNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class NeuralNetwork;
+
+// Measured cost of one training step (forward, backward, update) of a dense layer
+struct LayerCost {
+    double gpuMicros = 0.0;
+    double cpuMicros = 0.0;
+};
+
+struct Placement {
+    size_t firstCpuLayer = 0; // layers before it run on the GPU
+    std::vector<LayerCost> layers;
+    // transferMicros[k]: read back the input of layer k and upload its error, i.e. the price of a
+    // boundary in front of layer k
+    std::vector<double> transferMicros;
+    double estimatedMicros = 0.0; // per training step
+    double allGpuMicros = 0.0;
+
+    /**
+     * @brief Human-readable table of the measurements and the decision.
+     */
+    [[nodiscard]] std::string describe(const std::vector<int> &layerSizes) const;
+};
+
+/**
+ * @brief Decides which dense layers run on the GPU and which on the CPU. Small layers cost far more in
+ * dispatches and barriers than in math, so the tail of a network (e.g. 128 -> 1) is usually cheaper on
+ * the CPU. The GPU keeps a prefix of the layers and the CPU the rest, so there is at most one transfer
+ * each way per step.
+ */
+class PlacementPlanner {
+public:
+    /**
+     * @brief Times every layer on both devices and the transfer at every possible boundary, using
+     * scratch copies of the layers (the network itself is not touched).
+     * @param repetitions Timed training steps per layer and device.
+     */
+    static Placement measure(NeuralNetwork &network, int repetitions = 20);
+
+    /**
+     * @brief Picks the boundary with the lowest total cost.
+     * @param inputOnHost The input arrives from the host, so an all-CPU network needs no transfer.
+     */
+    static void choose(Placement &placement, bool inputOnHost);
+
+    /**
+     * @brief Measures, chooses, applies the placement to the network and records it in the profiler.
+     */
+    static Placement optimize(NeuralNetwork &network, int repetitions = 20);
+};
+
+#endif //PLACEMENTPLANNER_H
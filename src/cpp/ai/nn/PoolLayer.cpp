@@ -0,0 +1,85 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#include "PoolLayer.h"
+
+#include <iostream>
+#include <stdexcept>
+
+TensorShape PoolLayer::outputShapeFor(const TensorShape input, const int window, const int stride) {
+    if (window < 1 || stride < 1) {
+        throw std::invalid_argument("Invalid pooling parameters.");
+    }
+    if (window > input.height || window > input.width) {
+        throw std::invalid_argument("Pooling window is larger than its input.");
+    }
+    return {input.channels, (input.height - window) / stride + 1, (input.width - window) / stride + 1};
+}
+
+PoolLayer::PoolLayer(const TensorShape input, const PoolType type, const int window, const int stride,
+                     FeatureKernels *kernels)
+    : FeatureLayer(input, outputShapeFor(input, window, stride > 0 ? stride : window)),
+      type(type),
+      window(window),
+      stride(stride > 0 ? stride : window),
+      kernels(kernels) {
+    std::cout << "Initializing " << (type == PoolType::MAX ? "MaxPool" : "AvgPool") << " (" << input.channels << "x"
+            << input.height << "x" << input.width << " -> " << outShape.channels << "x" << outShape.height << "x"
+            << outShape.width << ")..." << std::endl;
+
+    if (type == PoolType::MAX) {
+        glGenBuffers(1, &argmaxBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, argmaxBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, outShape.size() * sizeof(int), nullptr, GL_DYNAMIC_COPY);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    }
+}
+
+PoolLayer::~PoolLayer() {
+    if (argmaxBuffer) glDeleteBuffers(1, &argmaxBuffer);
+}
+
+void PoolLayer::setGeometry(const Shader &shader) const {
+    shader.setInt("u_channels", inShape.channels);
+    shader.setInt("u_in_height", inShape.height);
+    shader.setInt("u_in_width", inShape.width);
+    shader.setInt("u_out_height", outShape.height);
+    shader.setInt("u_out_width", outShape.width);
+    shader.setInt("u_window", window);
+    shader.setInt("u_stride", stride);
+    shader.setInt("u_mode", type == PoolType::MAX ? 0 : 1);
+}
+
+void PoolLayer::forward(const GLuint inputBuffer, const GLuint outputBuffer) {
+    const Shader &pool = kernels->pool;
+    pool.use();
+    setGeometry(pool);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, inputBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, outputBuffer);
+    // Average pooling never touches binding 2, but it must not be left unbound
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, argmaxBuffer ? argmaxBuffer : outputBuffer);
+    pool.dispatch((outShape.size() + 255) / 256, 1, 1);
+}
+
+void PoolLayer::backward(GLuint, const GLuint errorFromOutput, const GLuint errorForInput, bool) {
+    if (errorForInput == 0) {
+        return; // Nothing to learn here
+    }
+
+    const Shader &pool = kernels->poolBackward;
+    pool.use();
+    setGeometry(pool);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, errorFromOutput);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, argmaxBuffer ? argmaxBuffer : errorFromOutput);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, errorForInput);
+    pool.dispatch((inShape.size() + 255) / 256, 1, 1);
+}
+
+nlohmann::json PoolLayer::toJson(bool) const {
+    nlohmann::json j;
+    j["type"] = type == PoolType::MAX ? "max_pool" : "avg_pool";
+    j["window"] = window;
+    j["stride"] = stride;
+    return j;
+}
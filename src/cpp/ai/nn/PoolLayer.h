@@ -0,0 +1,48 @@
+//
+// Created by CorruptionHades on 14/10/2025.
+//
+
+#ifndef POOLLAYER_H
+#define POOLLAYER_H
+
+#include "FeatureLayer.h"
+
+enum class PoolType {
+    MAX,
+    AVERAGE
+};
+
+/**
+ * @brief Max or average pooling over window x window regions, per channel. No parameters.
+ */
+class PoolLayer : public FeatureLayer {
+public:
+    const PoolType type;
+    const int window;
+    const int stride;
+
+    /**
+     * @param stride Distance between windows; 0 uses the window size (non-overlapping).
+     */
+    PoolLayer(TensorShape input, PoolType type, int window, int stride, FeatureKernels *kernels);
+
+    ~PoolLayer() override;
+
+    void forward(GLuint inputBuffer, GLuint outputBuffer) override;
+
+    void backward(GLuint inputBuffer, GLuint errorFromOutput, GLuint errorForInput, bool accumulate) override;
+
+    [[nodiscard]] nlohmann::json toJson(bool withParameters = true) const override;
+
+    static TensorShape outputShapeFor(TensorShape input, int window, int stride);
+
+private:
+    FeatureKernels *kernels;
+
+    // Input index of every maximum, max pooling only
+    GLuint argmaxBuffer = 0;
+
+    void setGeometry(const Shader &shader) const;
+};
+
+#endif //POOLLAYER_H
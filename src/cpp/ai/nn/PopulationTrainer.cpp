@@ -0,0 +1,254 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "PopulationTrainer.h"
+
+#include <iostream>
+#include <stdexcept>
+
+#include "DeviceDataset.h"
+#include "NeuralNetwork.h"
+
+namespace {
+    constexpr int LOCAL_SIZE = 64; // of the population shaders
+
+    GLuint createBuffer(const size_t floats) {
+        GLuint buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(floats * sizeof(float)), nullptr,
+                     GL_DYNAMIC_COPY);
+        return buffer;
+    }
+
+    GLuint groups(const int invocations) {
+        return static_cast<GLuint>((invocations + LOCAL_SIZE - 1) / LOCAL_SIZE);
+    }
+}
+
+PopulationTrainer::PopulationTrainer(std::vector<int> layerSizes, const std::vector<uint64_t> &seeds,
+                                     const WeightInitScheme scheme, const float learningRate)
+    : layerSizes(std::move(layerSizes)),
+      memberCount(static_cast<int>(seeds.size())),
+      learningRates(seeds.size(), learningRate) {
+    if (this->layerSizes.size() < 2) {
+        throw std::invalid_argument("A population needs at least an input and an output layer.");
+    }
+    for (const int size: this->layerSizes) {
+        if (size < 1) throw std::invalid_argument("Layer sizes must be positive.");
+    }
+    if (memberCount < 1 || memberCount > 65535) {
+        throw std::invalid_argument("A population has between 1 and 65535 members.");
+    }
+
+    std::cout << "Initializing population of " << memberCount << " networks..." << std::endl;
+    forwardShader.loadComputeShader("shaders/population_forward.comp");
+    deltaShader.loadComputeShader("shaders/population_delta.comp");
+    updateShader.loadComputeShader("shaders/population_update.comp");
+
+    // Every member is drawn like the layers of a NeuralNetwork with its seed, then copied into its block
+    const WeightInitializer initializer;
+    for (size_t l = 0; l + 1 < this->layerSizes.size(); ++l) {
+        const int inputSize = this->layerSizes[l];
+        const int neuronCount = this->layerSizes[l + 1];
+        const size_t weightCount = static_cast<size_t>(neuronCount) * inputSize;
+        StackedLayer layer{inputSize, neuronCount, 0, 0, 0, 0};
+        layer.weights = createBuffer(weightCount * memberCount);
+        layer.biases = createBuffer(static_cast<size_t>(neuronCount) * memberCount);
+        layer.activations = createBuffer(static_cast<size_t>(neuronCount) * memberCount);
+        layer.deltas = createBuffer(static_cast<size_t>(neuronCount) * memberCount);
+        layers.push_back(layer);
+
+        const std::vector<float> zeros(static_cast<size_t>(neuronCount) * memberCount, 0.0f);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer.biases);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(zeros.size() * sizeof(float)),
+                        zeros.data());
+
+        const GLuint memberWeights = createBuffer(weightCount);
+        const float limit = WeightInitializer::limit(scheme, inputSize, neuronCount);
+        const auto bytes = static_cast<GLsizeiptr>(weightCount * sizeof(float));
+        for (int m = 0; m < memberCount; ++m) {
+            initializer.fill(memberWeights, neuronCount, 0, inputSize, limit, seeds[m], static_cast<uint32_t>(l));
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            glBindBuffer(GL_COPY_READ_BUFFER, memberWeights);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, layer.weights);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, m * bytes, bytes);
+        }
+        glDeleteBuffers(1, &memberWeights);
+    }
+
+    inputBuffer = createBuffer(static_cast<size_t>(this->layerSizes.front()) * memberCount);
+    targetBuffer = createBuffer(static_cast<size_t>(this->layerSizes.back()) * memberCount);
+    learningRateBuffer = createBuffer(memberCount);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+PopulationTrainer::~PopulationTrainer() {
+    for (const auto &layer: layers) {
+        for (const GLuint buffer: {layer.weights, layer.biases, layer.activations, layer.deltas}) {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+    glDeleteBuffers(1, &inputBuffer);
+    glDeleteBuffers(1, &targetBuffer);
+    glDeleteBuffers(1, &learningRateBuffer);
+    glDeleteProgram(forwardShader.ID);
+    glDeleteProgram(deltaShader.ID);
+    glDeleteProgram(updateShader.ID);
+}
+
+void PopulationTrainer::setLearningRate(const int member, const float learningRate) {
+    learningRates.at(member) = learningRate;
+    learningRatesChanged = true;
+}
+
+void PopulationTrainer::uploadInput(const std::vector<float> &inputData) {
+    const int inputSize = layerSizes.front();
+    if (inputData.size() == static_cast<size_t>(inputSize)) {
+        inputStride = 0;
+    } else if (inputData.size() == static_cast<size_t>(inputSize) * memberCount) {
+        inputStride = inputSize;
+    } else {
+        throw std::invalid_argument("Input data size must be the network input size, once or per member.");
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, inputBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(inputData.size() * sizeof(float)),
+                    inputData.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void PopulationTrainer::train(const std::vector<float> &inputData, const std::vector<float> &targetData) {
+    const int outputSize = layerSizes.back();
+    if (targetData.size() == static_cast<size_t>(outputSize)) {
+        targetStride = 0;
+    } else if (targetData.size() == static_cast<size_t>(outputSize) * memberCount) {
+        targetStride = outputSize;
+    } else {
+        throw std::invalid_argument("Target data size must be the network output size, once or per member.");
+    }
+    uploadInput(inputData);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, targetBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(targetData.size() * sizeof(float)),
+                    targetData.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    trainStep();
+}
+
+void PopulationTrainer::train(DeviceDataset &dataset, const size_t position) {
+    if (dataset.getInputSize() != layerSizes.front() || dataset.getTargetSize() != layerSizes.back()) {
+        throw std::invalid_argument("Dataset sample size does not match the population.");
+    }
+    dataset.gather(position, inputBuffer, targetBuffer, true);
+    inputStride = 0;
+    targetStride = 0;
+    trainStep();
+}
+
+std::vector<float> PopulationTrainer::predict(const std::vector<float> &inputData) {
+    uploadInput(inputData);
+    forwardPass();
+
+    std::vector<float> outputData(static_cast<size_t>(layerSizes.back()) * memberCount);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, layers.back().activations);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(outputData.size() * sizeof(float)),
+                       outputData.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return outputData;
+}
+
+void PopulationTrainer::forwardPass() const {
+    forwardShader.use();
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const StackedLayer &layer = layers[l];
+        forwardShader.setInt("u_inputs", layer.inputSize);
+        forwardShader.setInt("u_neurons", layer.neuronCount);
+        forwardShader.setInt("u_input_stride", l == 0 ? inputStride : layer.inputSize);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, layer.weights);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, layer.biases);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, l == 0 ? inputBuffer : layers[l - 1].activations);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, layer.activations);
+        forwardShader.dispatch(groups(layer.neuronCount), memberCount, 1);
+    }
+}
+
+void PopulationTrainer::trainStep() {
+    if (learningRatesChanged) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, learningRateBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, static_cast<GLsizeiptr>(learningRates.size() * sizeof(float)),
+                        learningRates.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        learningRatesChanged = false;
+    }
+
+    forwardPass();
+
+    deltaShader.use();
+    deltaShader.setInt("u_target_stride", targetStride);
+    for (size_t l = layers.size(); l-- > 0;) {
+        const StackedLayer &layer = layers[l];
+        const bool output = l + 1 == layers.size();
+        // The output layer binds its own buffers in place of the (unused) layer ahead
+        const StackedLayer &next = output ? layer : layers[l + 1];
+        deltaShader.setInt("u_neurons", layer.neuronCount);
+        deltaShader.setInt("u_next_neurons", next.neuronCount);
+        deltaShader.setInt("u_output", output ? 1 : 0);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, next.weights);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, next.deltas);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, layer.activations);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, targetBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, layer.deltas);
+        deltaShader.dispatch(groups(layer.neuronCount), memberCount, 1);
+    }
+
+    updateShader.use();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, learningRateBuffer);
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const StackedLayer &layer = layers[l];
+        updateShader.setInt("u_inputs", layer.inputSize);
+        updateShader.setInt("u_neurons", layer.neuronCount);
+        updateShader.setInt("u_input_stride", l == 0 ? inputStride : layer.inputSize);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, layer.weights);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, layer.biases);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, layer.deltas);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, l == 0 ? inputBuffer : layers[l - 1].activations);
+        // One column per weight plus one for the bias
+        updateShader.dispatch(groups(layer.inputSize + 1), layer.neuronCount, memberCount);
+    }
+}
+
+std::unique_ptr<NeuralNetwork> PopulationTrainer::extract(const int member) const {
+    if (member < 0 || member >= memberCount) {
+        throw std::out_of_range("Population member out of range.");
+    }
+    auto network = std::make_unique<NeuralNetwork>();
+    network->learningRate = learningRates[member];
+    network->addLayer(layerSizes[0], layerSizes[1]);
+    for (size_t l = 2; l < layerSizes.size(); ++l) {
+        network->addLayer(layerSizes[l]);
+    }
+
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    std::vector<float> weights, biases;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const StackedLayer &layer = layers[l];
+        weights.resize(static_cast<size_t>(layer.neuronCount) * layer.inputSize);
+        biases.resize(layer.neuronCount);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer.weights);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(member * weights.size() * sizeof(float)),
+                           static_cast<GLsizeiptr>(weights.size() * sizeof(float)), weights.data());
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, layer.biases);
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(member * biases.size() * sizeof(float)),
+                           static_cast<GLsizeiptr>(biases.size() * sizeof(float)), biases.data());
+        network->getLayer(l).uploadParameters(weights, biases);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    return network;
+}
+
+void PopulationTrainer::saveMember(const int member, const std::string &path) const {
+    extract(member)->saveToFile(path);
+}
@@ -0,0 +1,119 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef POPULATIONTRAINER_H
+#define POPULATIONTRAINER_H
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "WeightInitializer.h"
+#include "../gl/Shader.h"
+
+class DeviceDataset;
+class NeuralNetwork;
+
+/**
+ * @brief Trains M independent dense networks of the same architecture at once, e.g. for a sweep over
+ * learning rates or seeds.
+ *
+ * Every layer keeps the weights, biases, activations and errors of all members back to back in one buffer
+ * each. A training step is one forward, one error and one update dispatch per layer, each covering every
+ * member with its own parameters and learning rate (one work group row per member), instead of a dozen
+ * tiny dispatches per layer and member. The math is that of NeuralNetwork::train() without gradient
+ * accumulation: sigmoid layers, δ = prediction - target at the output, one SGD step per sample.
+ */
+class PopulationTrainer {
+public:
+    /**
+     * @param layerSizes [input, hidden..., output], as NeuralNetwork::getLayerSizes().
+     * @param seeds One per member. Member m starts with the weights of a NeuralNetwork built with
+     * setWeightInit({scheme, seeds[m]}).
+     */
+    PopulationTrainer(std::vector<int> layerSizes, const std::vector<uint64_t> &seeds,
+                      WeightInitScheme scheme = WeightInitScheme::UNIFORM, float learningRate = 0.1f);
+
+    ~PopulationTrainer();
+
+    PopulationTrainer(const PopulationTrainer &) = delete;
+
+    PopulationTrainer &operator=(const PopulationTrainer &) = delete;
+
+    void setLearningRate(int member, float learningRate);
+
+    [[nodiscard]] float getLearningRate(int member) const { return learningRates.at(member); }
+
+    /**
+     * @brief One training step of every member.
+     * @param inputData One input for all members (inputSize values), or one per member (M * inputSize).
+     * @param targetData Likewise, outputSize or M * outputSize values.
+     */
+    void train(const std::vector<float> &inputData, const std::vector<float> &targetData);
+
+    /**
+     * @brief One training step of every member on the sample at the given position of the dataset's
+     * current shuffle, gathered on the GPU.
+     */
+    void train(DeviceDataset &dataset, size_t position);
+
+    /**
+     * @brief Forward pass of every member.
+     * @param inputData As for train().
+     * @return The outputs of all members, member after member (M * outputSize values).
+     */
+    std::vector<float> predict(const std::vector<float> &inputData);
+
+    /**
+     * @brief Copies member `member` into a regular network, e.g. to save it or to keep training it alone.
+     */
+    [[nodiscard]] std::unique_ptr<NeuralNetwork> extract(int member) const;
+
+    void saveMember(int member, const std::string &path) const;
+
+    [[nodiscard]] int getMemberCount() const { return memberCount; }
+
+    [[nodiscard]] const std::vector<int> &getLayerSizes() const { return layerSizes; }
+
+private:
+    // One dense layer of all members; every buffer holds memberCount blocks
+    struct StackedLayer {
+        int inputSize;
+        int neuronCount;
+        GLuint weights; // neuronCount x inputSize per member, row-major
+        GLuint biases;
+        GLuint activations;
+        GLuint deltas;
+    };
+
+    std::vector<int> layerSizes;
+    int memberCount;
+    std::vector<StackedLayer> layers;
+
+    std::vector<float> learningRates;
+    bool learningRatesChanged = true;
+    GLuint learningRateBuffer = 0;
+
+    // Room for one input and target per member
+    GLuint inputBuffer = 0;
+    GLuint targetBuffer = 0;
+    // 0 while all members share the input/target at the start of the buffers
+    int inputStride = 0;
+    int targetStride = 0;
+
+    Shader forwardShader;
+    Shader deltaShader;
+    Shader updateShader;
+
+    void uploadInput(const std::vector<float> &inputData);
+
+    void forwardPass() const;
+
+    // Errors of all layers from the output back, then the updates, so every error sees the old weights
+    void trainStep();
+};
+
+#endif //POPULATIONTRAINER_H
@@ -0,0 +1,87 @@
+//
+// Created by CorruptionHades on 18/10/2025.
+//
+
+#include "Pruner.h"
+#include "NeuralNetwork.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+float PruneSchedule::sparsityAt(const int epoch) const {
+    if (epoch < startEpoch) return 0.0f;
+    if (epoch >= endEpoch) return finalSparsity;
+    const float progress = static_cast<float>(epoch - startEpoch) / static_cast<float>(endEpoch - startEpoch);
+    return finalSparsity * (1.0f - std::pow(1.0f - progress, 3.0f));
+}
+
+namespace {
+    LayerSparsity prune(NeuralNetwork &network, const size_t index, const float threshold) {
+        network.pruneLayer(index, threshold);
+        const Layer &layer = network.getLayer(index);
+        return {static_cast<size_t>(layer.neuronCount) * layer.inputSize, layer.getNonZeroCount(), threshold};
+    }
+}
+
+std::vector<LayerSparsity> Pruner::pruneByMagnitude(NeuralNetwork &network, const float sparsity) {
+    if (sparsity < 0.0f || sparsity >= 1.0f) {
+        throw std::invalid_argument("Sparsity must be in [0, 1).");
+    }
+
+    // The thresholds come from the current weights: pending gradients applied, CPU layers synced to the GPU
+    const size_t firstCpuLayer = network.getFirstCpuLayer();
+    network.setPlacement(network.getLayerCount());
+    network.flushGradients();
+
+    std::vector<LayerSparsity> result;
+    std::vector<float> weights, biases;
+    for (size_t l = 0; l < network.getLayerCount(); ++l) {
+        network.getLayer(l).downloadParameters(weights, biases);
+        const auto dropped = static_cast<size_t>(sparsity * static_cast<float>(weights.size()));
+        if (dropped == 0) {
+            result.push_back({weights.size(), network.getLayer(l).getNonZeroCount(), 0.0f});
+            continue;
+        }
+        // The largest of the `dropped` smallest magnitudes
+        for (float &w: weights) w = std::abs(w);
+        std::nth_element(weights.begin(), weights.begin() + static_cast<std::ptrdiff_t>(dropped - 1), weights.end());
+        result.push_back(prune(network, l, weights[dropped - 1]));
+    }
+    network.setPlacement(firstCpuLayer);
+    return result;
+}
+
+std::vector<LayerSparsity> Pruner::pruneByThreshold(NeuralNetwork &network, const float threshold) {
+    std::vector<LayerSparsity> result;
+    for (size_t l = 0; l < network.getLayerCount(); ++l) {
+        result.push_back(prune(network, l, threshold));
+    }
+    return result;
+}
+
+std::string Pruner::describe(const std::vector<LayerSparsity> &layers, const std::vector<int> &layerSizes) {
+    constexpr double MB = 1024.0 * 1024.0;
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "  layer  shape                 kept       sparsity  dense MB  CSR MB" << std::endl;
+    size_t denseBytes = 0;
+    size_t sparseBytes = 0;
+    for (size_t l = 0; l < layers.size(); ++l) {
+        std::ostringstream shape;
+        shape << layerSizes[l] << " -> " << layerSizes[l + 1];
+        const size_t dense = layers[l].weights * sizeof(float);
+        // A value and a column index per kept weight, plus the row offsets
+        const size_t sparse = layers[l].nonZeros * (sizeof(float) + sizeof(int)) +
+                              (static_cast<size_t>(layerSizes[l + 1]) + 1) * sizeof(int);
+        denseBytes += dense;
+        sparseBytes += sparse;
+        out << "  " << std::left << std::setw(7) << l << std::setw(18) << shape.str() << std::right
+                << std::setw(10) << layers[l].nonZeros << std::setw(10) << layers[l].sparsity() * 100.0 << "%"
+                << std::setw(10) << dense / MB << std::setw(8) << sparse / MB << std::endl;
+    }
+    out << "  total " << denseBytes / MB << " MB dense, " << sparseBytes / MB << " MB as CSR" << std::endl;
+    return out.str();
+}
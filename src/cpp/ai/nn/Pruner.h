@@ -0,0 +1,65 @@
+//
+// Created by CorruptionHades on 18/10/2025.
+//
+
+#ifndef PRUNER_H
+#define PRUNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class NeuralNetwork;
+
+// Weights of one dense layer after pruning
+struct LayerSparsity {
+    size_t weights = 0; // neuronCount x inputSize
+    size_t nonZeros = 0; // kept
+    float threshold = 0.0f; // |w| <= threshold was dropped
+
+    [[nodiscard]] double sparsity() const {
+        return weights > 0 ? 1.0 - static_cast<double>(nonZeros) / static_cast<double>(weights) : 0.0;
+    }
+};
+
+/**
+ * @brief Gradual prune-and-finetune: from startEpoch on, the layers are pruned to sparsityAt(epoch) at the start
+ * of every epoch. It ramps from 0 to finalSparsity at endEpoch along a cubic (most weights go early, while there
+ * is still time to recover), and the training in between fine-tunes the kept weights. After endEpoch pruning
+ * changes nothing, except for a network resumed from a checkpoint, which is stored dense.
+ */
+struct PruneSchedule {
+    float finalSparsity = 0.9f;
+    int startEpoch = 0;
+    int endEpoch = 0;
+
+    [[nodiscard]] bool prunesAt(int epoch) const { return epoch >= startEpoch; }
+
+    [[nodiscard]] float sparsityAt(int epoch) const;
+};
+
+/**
+ * @brief Magnitude pruning of the dense layers. Pruned layers keep their weights in CSR form and run sparse
+ * kernels (spmv_csr.comp, CpuKernels::spmvCsr), so at 90% sparsity they read and store about a fifth of the
+ * dense bytes (a value and a column index per kept weight).
+ */
+class Pruner {
+public:
+    /**
+     * @brief In every dense layer, drops the `sparsity` fraction of weights with the smallest |w|.
+     * Weights that are already pruned count as the smallest, so a growing sparsity only prunes further.
+     */
+    static std::vector<LayerSparsity> pruneByMagnitude(NeuralNetwork &network, float sparsity);
+
+    /**
+     * @brief Drops every weight with |w| <= threshold in every dense layer.
+     */
+    static std::vector<LayerSparsity> pruneByThreshold(NeuralNetwork &network, float threshold);
+
+    /**
+     * @brief Human-readable table of the kept weights and the size of each layer, dense vs. CSR.
+     */
+    static std::string describe(const std::vector<LayerSparsity> &layers, const std::vector<int> &layerSizes);
+};
+
+#endif //PRUNER_H
@@ -0,0 +1,303 @@
+//
+// Created by CorruptionHades on 15/10/2025.
+//
+
+#ifndef STATICNETWORK_H
+#define STATICNETWORK_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace StaticDetail {
+    // Loops up to this length are unrolled at compile time, longer ones stay loops
+    constexpr std::size_t MAX_UNROLL = 32;
+
+    template<std::size_t N, typename F>
+    inline void staticFor(F &&f) {
+        if constexpr (N <= MAX_UNROLL) {
+            [&]<std::size_t... I>(std::index_sequence<I...>) {
+                (f(I), ...);
+            }(std::make_index_sequence<N>{});
+        } else {
+            for (std::size_t i = 0; i < N; ++i) f(i);
+        }
+    }
+
+    inline float sigmoid(const float z) {
+        return 1.0f / (1.0f + std::exp(-z));
+    }
+
+    /**
+     * @brief One dense layer with compile-time sizes: a = sigmoid(W * x + b), W is Out x In, row-major.
+     */
+    template<int In, int Out>
+    struct StaticLayer {
+        std::array<float, static_cast<std::size_t>(In) * Out> weights{};
+        std::array<float, Out> biases{};
+
+        // Kept from the last forward() for the backward pass
+        std::array<float, In> input{};
+        std::array<float, Out> output{};
+
+        void forward(const std::array<float, In> &x) {
+            input = x;
+            staticFor<Out>([&](const std::size_t r) {
+                float sum = biases[r];
+                staticFor<In>([&](const std::size_t c) { sum += weights[r * In + c] * x[c]; });
+                output[r] = sigmoid(sum);
+            });
+        }
+
+        /**
+         * @brief Turns dL/d(output) into δ, writes W^T δ to `errorForInput` and applies the SGD step.
+         * The propagated error is computed with the weights from before the update, like on the GPU.
+         */
+        void backwardAndUpdate(const std::array<float, Out> &delta, std::array<float, In> *errorForInput,
+                               const float learningRate) {
+            if (errorForInput) {
+                errorForInput->fill(0.0f);
+                staticFor<Out>([&](const std::size_t r) {
+                    staticFor<In>([&](const std::size_t c) {
+                        (*errorForInput)[c] += weights[r * In + c] * delta[r];
+                    });
+                });
+            }
+            staticFor<Out>([&](const std::size_t r) {
+                const float step = learningRate * delta[r];
+                staticFor<In>([&](const std::size_t c) { weights[r * In + c] -= step * input[c]; });
+                biases[r] -= step;
+            });
+        }
+    };
+
+    // Layers In -> Out -> Rest..., stored inline as one nested struct
+    template<int In, int Out, int... Rest>
+    struct StaticStack {
+        static constexpr int OutputSize = StaticStack<Out, Rest...>::OutputSize;
+
+        StaticLayer<In, Out> layer;
+        StaticStack<Out, Rest...> next;
+
+        const std::array<float, OutputSize> &forward(const std::array<float, In> &x) {
+            layer.forward(x);
+            return next.forward(layer.output);
+        }
+
+        void backward(const std::array<float, OutputSize> &target, std::array<float, In> *errorForInput,
+                      const float learningRate) {
+            std::array<float, Out> error;
+            next.backward(target, &error, learningRate);
+            // δ = e .* σ'(z), with σ'(z) = a (1 - a)
+            staticFor<Out>([&](const std::size_t i) {
+                const float a = layer.output[i];
+                error[i] *= a * (1.0f - a);
+            });
+            layer.backwardAndUpdate(error, errorForInput, learningRate);
+        }
+
+        template<typename F>
+        void forEachLayer(F &&f) {
+            f(layer);
+            next.forEachLayer(f);
+        }
+
+        template<typename F>
+        void forEachLayer(F &&f) const {
+            f(layer);
+            next.forEachLayer(f);
+        }
+    };
+
+    template<int In, int Out>
+    struct StaticStack<In, Out> {
+        static constexpr int OutputSize = Out;
+
+        StaticLayer<In, Out> layer;
+
+        const std::array<float, Out> &forward(const std::array<float, In> &x) {
+            layer.forward(x);
+            return layer.output;
+        }
+
+        void backward(const std::array<float, Out> &target, std::array<float, In> *errorForInput,
+                      const float learningRate) {
+            // δ_L = prediction - target
+            std::array<float, Out> delta;
+            staticFor<Out>([&](const std::size_t i) { delta[i] = layer.output[i] - target[i]; });
+            layer.backwardAndUpdate(delta, errorForInput, learningRate);
+        }
+
+        template<typename F>
+        void forEachLayer(F &&f) {
+            f(layer);
+        }
+
+        template<typename F>
+        void forEachLayer(F &&f) const {
+            f(layer);
+        }
+    };
+}
+
+/**
+ * @brief A NeuralNetwork with compile-time layer sizes that runs entirely on the CPU, e.g.
+ * StaticNetwork<2, 2> for the min/max model. All parameters and activations live inside the
+ * object (no heap, no GL), and small loops are unrolled, so a train() call on a tiny model costs
+ * nanoseconds instead of a GL round trip. Same math and model file format as NeuralNetwork.
+ */
+template<int... Sizes>
+class StaticNetwork {
+    static_assert(sizeof...(Sizes) >= 2, "A StaticNetwork needs an input size and at least one layer.");
+    static_assert(((Sizes > 0) && ...), "Layer sizes must be positive.");
+
+    using Stack = StaticDetail::StaticStack<Sizes...>;
+
+public:
+    static constexpr std::array<int, sizeof...(Sizes)> LayerSizes = {Sizes...};
+    static constexpr int InputSize = LayerSizes.front();
+    static constexpr int OutputSize = LayerSizes.back();
+
+    using Input = std::array<float, InputSize>;
+    using Output = std::array<float, OutputSize>;
+
+    float learningRate = 0.1f;
+
+    /**
+     * @brief Random weights in [-1, 1] and zero biases, like Layer.
+     */
+    StaticNetwork() {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_real_distribution dis(-1.0f, 1.0f);
+        stack.forEachLayer([&](auto &layer) {
+            for (auto &w: layer.weights) w = dis(gen);
+        });
+    }
+
+    const Output &predict(const Input &input) {
+        return stack.forward(input);
+    }
+
+    /**
+     * @brief Forward pass, backpropagation and SGD update for one sample.
+     */
+    void train(const Input &input, const Output &target) {
+        stack.forward(input);
+        stack.backward(target, nullptr, learningRate);
+    }
+
+    std::vector<float> predict(const std::vector<float> &input) {
+        const Output &output = predict(toArray<InputSize>(input, "Input"));
+        return {output.begin(), output.end()};
+    }
+
+    void train(const std::vector<float> &input, const std::vector<float> &target) {
+        train(toArray<InputSize>(input, "Input"), toArray<OutputSize>(target, "Target"));
+    }
+
+    void saveToFile(const std::string &path) const {
+        nlohmann::json j;
+        j["learning_rate"] = learningRate;
+        j["architecture"] = LayerSizes;
+        j["layers"] = nlohmann::json::array();
+        stack.forEachLayer([&](const auto &layer) {
+            nlohmann::json l;
+            l["weights"] = layer.weights;
+            l["biases"] = layer.biases;
+            j["layers"].push_back(l);
+        });
+
+        std::ofstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file for writing: " + path);
+        }
+        file << j.dump(4);
+    }
+
+    /**
+     * @brief Loads a model saved by NeuralNetwork or StaticNetwork. The architecture must match Sizes exactly.
+     */
+    static StaticNetwork loadFromFile(const std::string &path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open file for reading: " + path);
+        }
+        const nlohmann::json j = nlohmann::json::parse(file);
+
+        if (j.contains("features") || j.at("architecture").get<std::vector<int> >() !=
+            std::vector<int>(LayerSizes.begin(), LayerSizes.end())) {
+            throw std::runtime_error("Model architecture does not match this StaticNetwork: " + path);
+        }
+
+        StaticNetwork network;
+        network.learningRate = j.at("learning_rate");
+        std::size_t index = 0;
+        network.stack.forEachLayer([&](auto &layer) {
+            const auto &l = j.at("layers").at(index++);
+            const auto biases = l.at("biases").get<std::vector<float> >();
+            if (l.contains("sparse")) {
+                // Pruned layer, saved in CSR form: expanded back to a dense matrix
+                readSparse(l.at("sparse"), layer);
+            } else {
+                const auto weights = l.at("weights").get<std::vector<float> >();
+                if (weights.size() != layer.weights.size()) {
+                    throw std::runtime_error("Mismatched data size when loading layer parameters.");
+                }
+                std::copy(weights.begin(), weights.end(), layer.weights.begin());
+            }
+            if (biases.size() != layer.biases.size()) {
+                throw std::runtime_error("Mismatched data size when loading layer parameters.");
+            }
+            std::copy(biases.begin(), biases.end(), layer.biases.begin());
+        });
+        return network;
+    }
+
+private:
+    Stack stack;
+
+    template<typename Layer>
+    static void readSparse(const nlohmann::json &csr, Layer &layer) {
+        const auto rowStart = csr.at("row_start").get<std::vector<int> >();
+        const auto columns = csr.at("columns").get<std::vector<int> >();
+        const auto values = csr.at("values").get<std::vector<float> >();
+        constexpr int rows = static_cast<int>(std::tuple_size_v<decltype(layer.biases)>);
+        constexpr int cols = static_cast<int>(std::tuple_size_v<decltype(layer.input)>);
+        if (rowStart.size() != static_cast<std::size_t>(rows) + 1 || columns.size() != values.size() ||
+            rowStart.front() != 0 || rowStart.back() != static_cast<int>(values.size()) ||
+            !std::is_sorted(rowStart.begin(), rowStart.end())) {
+            throw std::runtime_error("Mismatched data size when loading layer parameters.");
+        }
+        layer.weights.fill(0.0f);
+        for (int r = 0; r < rows; ++r) {
+            for (int k = rowStart[r]; k < rowStart[r + 1]; ++k) {
+                if (columns[k] < 0 || columns[k] >= cols) {
+                    throw std::runtime_error("Invalid column in sparse layer parameters.");
+                }
+                layer.weights[static_cast<std::size_t>(r) * cols + columns[k]] = values[k];
+            }
+        }
+    }
+
+    template<int N>
+    static std::array<float, N> toArray(const std::vector<float> &data, const char *what) {
+        if (data.size() != N) {
+            throw std::invalid_argument(std::string(what) + " data size does not match network size.");
+        }
+        std::array<float, N> array;
+        std::copy(data.begin(), data.end(), array.begin());
+        return array;
+    }
+};
+
+#endif //STATICNETWORK_H
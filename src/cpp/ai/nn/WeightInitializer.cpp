@@ -0,0 +1,108 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "WeightInitializer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    // Below this many weights fillHost() stays on the calling thread
+    constexpr size_t MIN_WEIGHTS_PER_THREAD = 1u << 16;
+    // One dispatch dimension may be limited to 65535 work groups, the shader loops over the rest
+    constexpr GLuint MAX_GROUPS = 65535;
+
+    // Philox4x32-10, as in philox.glsl
+    std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> key) {
+        for (int i = 0; i < 10; ++i) {
+            const uint64_t product0 = 0xD2511F53ull * ctr[0];
+            const uint64_t product1 = 0xCD9E8D57ull * ctr[2];
+            ctr = {
+                static_cast<uint32_t>(product1 >> 32) ^ ctr[1] ^ key[0], static_cast<uint32_t>(product1),
+                static_cast<uint32_t>(product0 >> 32) ^ ctr[3] ^ key[1], static_cast<uint32_t>(product0)
+            };
+            key[0] += 0x9E3779B9u;
+            key[1] += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+
+    float philoxToFloat(const uint32_t x) {
+        return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+    }
+}
+
+WeightInitializer::WeightInitializer() {
+    shader.loadComputeShader("shaders/weight_init.comp");
+}
+
+WeightInitializer::~WeightInitializer() {
+    glDeleteProgram(shader.ID);
+}
+
+float WeightInitializer::limit(const WeightInitScheme scheme, const int fanIn, const int fanOut) {
+    switch (scheme) {
+        case WeightInitScheme::UNIFORM: return 1.0f;
+        case WeightInitScheme::XAVIER: return std::sqrt(6.0f / static_cast<float>(fanIn + fanOut));
+        case WeightInitScheme::HE: return std::sqrt(6.0f / static_cast<float>(fanIn));
+    }
+    throw std::invalid_argument("Unknown weight initialization scheme.");
+}
+
+void WeightInitializer::fill(const GLuint buffer, const int rows, const int firstColumn, const int columns,
+                             const float limit, const uint64_t seed, const uint32_t stream) const {
+    const size_t count = static_cast<size_t>(rows) * columns;
+    if (count > UINT32_MAX) {
+        throw std::invalid_argument("Weight block too large to initialize in one buffer.");
+    }
+
+    shader.use();
+    shader.setInt("u_rows", rows);
+    shader.setInt("u_columns", columns);
+    shader.setInt("u_first_column", firstColumn);
+    shader.setFloat("u_limit", limit);
+    shader.setUInt("u_seed_lo", static_cast<GLuint>(seed));
+    shader.setUInt("u_seed_hi", static_cast<GLuint>(seed >> 32));
+    shader.setUInt("u_stream", stream);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, buffer);
+    shader.dispatch(static_cast<GLuint>(std::clamp<size_t>((count + 255) / 256, 1, MAX_GROUPS)), 1, 1);
+}
+
+void WeightInitializer::fillHost(float *weights, const int rows, const int firstColumn, const int columns,
+                                 const float limit, const uint64_t seed, const uint32_t stream) {
+    const std::array key = {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    const auto fillRows = [&](const int first, const int last) {
+        for (int r = first; r < last; ++r) {
+            float *row = weights + static_cast<size_t>(r) * columns;
+            std::array<uint32_t, 4> draw{};
+            for (int c = 0; c < columns; ++c) {
+                const auto column = static_cast<uint32_t>(firstColumn + c);
+                if (c == 0 || (column & 3u) == 0) {
+                    draw = philox4x32({column >> 2, static_cast<uint32_t>(r), stream, 0u}, key);
+                }
+                row[c] = limit * (2.0f * philoxToFloat(draw[column & 3u]) - 1.0f);
+            }
+        }
+    };
+
+    const size_t count = static_cast<size_t>(rows) * columns;
+    const size_t threads = std::clamp<size_t>(count / MIN_WEIGHTS_PER_THREAD, 1,
+                                              std::max(1u, std::thread::hardware_concurrency()));
+    if (threads == 1) {
+        fillRows(0, rows);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t t = 0; t < threads; ++t) {
+        const int first = static_cast<int>(rows * t / threads);
+        const int last = static_cast<int>(rows * (t + 1) / threads);
+        workers.emplace_back(fillRows, first, last);
+    }
+    for (auto &worker: workers) worker.join();
+}
@@ -0,0 +1,66 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef WEIGHTINITIALIZER_H
+#define WEIGHTINITIALIZER_H
+
+#include <GL/glew.h>
+#include <cstdint>
+
+#include "../gl/Shader.h"
+
+enum class WeightInitScheme {
+    UNIFORM = 0, // [-1, 1], the original initialization
+    XAVIER = 1, // [-sqrt(6 / (fanIn + fanOut)), +], for sigmoid layers
+    HE = 2 // [-sqrt(6 / fanIn), +], for ReLU layers
+};
+
+struct WeightInitConfig {
+    WeightInitScheme scheme = WeightInitScheme::UNIFORM;
+    // The same seed and architecture always give the same weights.
+    uint64_t seed = 0;
+};
+
+/**
+ * @brief Draws initial weights where they are stored, instead of filling a host matrix with one
+ * std::mt19937 and uploading it.
+ *
+ * Weight (row, column) of a layer is word column % 4 of Philox with (column / 4, row, stream) as counter
+ * and the seed as key; every layer uses its own stream. The value therefore depends only on its position
+ * in the full W: device buffers (fill()) and memory-mapped tiles (fillHost(), on all hardware threads) get the
+ * same weights however the matrix is split.
+ */
+class WeightInitializer {
+public:
+    WeightInitializer();
+
+    ~WeightInitializer();
+
+    WeightInitializer(const WeightInitializer &) = delete;
+
+    WeightInitializer &operator=(const WeightInitializer &) = delete;
+
+    /**
+     * @brief Half-width of the uniform range of the scheme.
+     */
+    static float limit(WeightInitScheme scheme, int fanIn, int fanOut);
+
+    /**
+     * @brief Fills `buffer` with the rows x columns block of W (row-major) that holds the input columns
+     * [firstColumn, firstColumn + columns).
+     */
+    void fill(GLuint buffer, int rows, int firstColumn, int columns, float limit, uint64_t seed,
+              uint32_t stream) const;
+
+    /**
+     * @brief Same values as fill(), written into host memory.
+     */
+    static void fillHost(float *weights, int rows, int firstColumn, int columns, float limit, uint64_t seed,
+                         uint32_t stream);
+
+private:
+    Shader shader;
+};
+
+#endif //WEIGHTINITIALIZER_H
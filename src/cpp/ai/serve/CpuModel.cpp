@@ -0,0 +1,238 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "CpuModel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "../nn/Checkpointer.h"
+#include "../nn/Conv2DLayer.h"
+#include "../nn/PoolLayer.h"
+#include "../utils/MappedFile.h"
+
+namespace {
+    constexpr char CHECKPOINT_MAGIC[4] = {'G', 'L', 'N', 'C'};
+
+    FeatureActivation parseActivation(const std::string &name) {
+        if (name == "relu") return FeatureActivation::RELU;
+        if (name == "sigmoid") return FeatureActivation::SIGMOID;
+        return FeatureActivation::NONE;
+    }
+}
+
+CpuModel::CpuModel() = default;
+
+CpuModel::~CpuModel() = default;
+
+std::shared_ptr<const CpuModel> CpuModel::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file for reading: " + path);
+    }
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {};
+    file.read(magic, sizeof(magic));
+    file.close();
+
+    std::shared_ptr<CpuModel> model(new CpuModel());
+    if (std::memcmp(magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) == 0) {
+        model->mapCheckpoint(path);
+    } else {
+        model->loadModelFile(path);
+    }
+    return model;
+}
+
+const float *CpuModel::keep(std::vector<float> values) {
+    storage.push_back(std::move(values));
+    return storage.back().data();
+}
+
+const int *CpuModel::keep(std::vector<int> indices) {
+    indexStorage.push_back(std::move(indices));
+    return indexStorage.back().data();
+}
+
+void CpuModel::parseFeatures(const nlohmann::json &description, const bool withParameters) {
+    const auto shape = description.at("input_shape").get<std::vector<int> >();
+    if (shape.size() != 3) {
+        throw std::runtime_error("Invalid input shape in model file.");
+    }
+    inputShape = {shape[0], shape[1], shape[2]};
+
+    TensorShape current = inputShape;
+    for (const auto &spec: description.value("features", nlohmann::json::array())) {
+        FeatureStage stage;
+        stage.type = spec.at("type").get<std::string>();
+        stage.input = current;
+        if (stage.type == "conv2d") {
+            const int outChannels = spec.at("out_channels").get<int>();
+            stage.kernel = spec.at("kernel").get<int>();
+            stage.stride = spec.value("stride", 1);
+            stage.padding = spec.value("padding", 0);
+            stage.activation = parseActivation(spec.value("activation", "relu"));
+            stage.output = Conv2DLayer::outputShapeFor(current, outChannels, stage.kernel, stage.stride,
+                                                       stage.padding);
+            if (withParameters) {
+                auto weights = spec.at("weights").get<std::vector<float> >();
+                auto biases = spec.at("biases").get<std::vector<float> >();
+                if (weights.size() != static_cast<size_t>(outChannels) * current.channels * stage.kernel *
+                    stage.kernel || biases.size() != static_cast<size_t>(outChannels)) {
+                    throw std::runtime_error("Mismatched data size when loading convolution parameters.");
+                }
+                stage.weights = keep(std::move(weights));
+                stage.biases = keep(std::move(biases));
+            }
+        } else if (stage.type == "max_pool" || stage.type == "avg_pool") {
+            stage.kernel = spec.at("window").get<int>();
+            stage.stride = spec.value("stride", stage.kernel);
+            stage.output = PoolLayer::outputShapeFor(current, stage.kernel, stage.stride);
+        } else {
+            throw std::runtime_error("Unknown feature layer type: " + stage.type);
+        }
+        current = stage.output;
+        features.push_back(std::move(stage));
+    }
+    if (current.size() != layerSizes.front()) {
+        throw std::runtime_error("Feature layers do not match the architecture in model file.");
+    }
+}
+
+void CpuModel::loadModelFile(const std::string &path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file for reading: " + path);
+    }
+    const nlohmann::json j = nlohmann::json::parse(file);
+
+    layerSizes = j.at("architecture").get<std::vector<int> >();
+    if (layerSizes.size() < 2 || j.at("layers").size() != layerSizes.size() - 1) {
+        throw std::runtime_error("Invalid architecture in model file.");
+    }
+    if (j.contains("input_shape")) {
+        parseFeatures(j, true);
+    }
+
+    for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+        const auto &spec = j["layers"][i];
+        const int inputs = layerSizes[i];
+        const int neurons = layerSizes[i + 1];
+        auto biases = spec.at("biases").get<std::vector<float> >();
+        if (biases.size() != static_cast<size_t>(neurons)) {
+            throw std::runtime_error("Mismatched data size when loading layer parameters.");
+        }
+
+        if (spec.contains("sparse")) {
+            // Pruned layer: kept as CSR, the forward pass only touches the nonzeros
+            const auto &csr = spec["sparse"];
+            auto rowStart = csr.at("row_start").get<std::vector<int> >();
+            auto columns = csr.at("columns").get<std::vector<int> >();
+            auto values = csr.at("values").get<std::vector<float> >();
+            if (rowStart.size() != static_cast<size_t>(neurons) + 1 || rowStart.front() != 0 ||
+                rowStart.back() != static_cast<int>(columns.size()) || columns.size() != values.size() ||
+                !std::is_sorted(rowStart.begin(), rowStart.end()) ||
+                std::ranges::any_of(columns, [inputs](const int c) { return c < 0 || c >= inputs; })) {
+                throw std::runtime_error("Invalid sparse layer in model file.");
+            }
+            DenseLayer layer{keep(std::move(values)), keep(std::move(biases))};
+            layer.rowStart = keep(std::move(rowStart));
+            layer.columns = keep(std::move(columns));
+            layers.push_back(layer);
+            continue;
+        }
+
+        std::vector<float> weights;
+        if (spec.contains("weights")) {
+            weights = spec.at("weights").get<std::vector<float> >();
+        } else {
+            // Streamed layer: W is in its weight file, tile after tile of `tile_columns` input columns each
+            const auto weightFile = spec.at("weight_file").get<std::string>();
+            const int tileColumns = spec.at("tile_columns").get<int>();
+            const MappedFile store = MappedFile::open(weightFile, false);
+            if (tileColumns < 1 || store.size() != 2 * static_cast<size_t>(inputs) * neurons * sizeof(float)) {
+                throw std::runtime_error("Weight file " + weightFile + " does not match the layer size.");
+            }
+            const auto *tiles = static_cast<const float *>(store.data());
+            weights.resize(static_cast<size_t>(inputs) * neurons);
+            for (int first = 0; first < inputs; first += tileColumns) {
+                const int columns = std::min(tileColumns, inputs - first);
+                const float *tile = tiles + static_cast<size_t>(neurons) * first;
+                for (int r = 0; r < neurons; ++r) {
+                    std::copy_n(tile + static_cast<size_t>(r) * columns, columns,
+                                weights.data() + static_cast<size_t>(r) * inputs + first);
+                }
+            }
+        }
+        if (weights.size() != static_cast<size_t>(inputs) * neurons) {
+            throw std::runtime_error("Mismatched data size when loading layer parameters.");
+        }
+        const float *w = keep(std::move(weights));
+        layers.push_back({w, keep(std::move(biases))});
+    }
+}
+
+void CpuModel::mapCheckpoint(const std::string &path) {
+    mapped = std::make_unique<MappedFile>(MappedFile::open(path, false));
+    const auto *bytes = static_cast<const char *>(mapped->data());
+    const size_t size = mapped->size();
+    auto checkSize = [&](const size_t end) {
+        if (end > size) throw std::runtime_error("Truncated checkpoint file: " + path);
+    };
+
+    Checkpointer::CheckpointHeader header{};
+    checkSize(sizeof(header));
+    std::memcpy(&header, bytes, sizeof(header));
+    if (header.version < 1 || header.version > Checkpointer::VERSION) {
+        throw std::runtime_error("Unsupported checkpoint version " + std::to_string(header.version) + ": " + path);
+    }
+    if (header.layerCount < 1) {
+        throw std::runtime_error("Invalid architecture in checkpoint file.");
+    }
+
+    size_t offset = sizeof(header);
+    checkSize(offset + (header.layerCount + 1) * sizeof(uint32_t));
+    const auto *arch = reinterpret_cast<const uint32_t *>(bytes + offset);
+    layerSizes.assign(arch, arch + header.layerCount + 1);
+    offset += layerSizes.size() * sizeof(uint32_t);
+
+    size_t featureSpecBytes = 0;
+    if (header.flags & (Checkpointer::FLAG_FEATURES | Checkpointer::FLAG_STREAMED)) {
+        uint32_t length = 0;
+        checkSize(offset + sizeof(length));
+        std::memcpy(&length, bytes + offset, sizeof(length));
+        checkSize(offset + sizeof(length) + length);
+        featureSpecBytes = length;
+        // The weights of streamed layers are in the payload as well, their files are not needed here
+        if (header.flags & Checkpointer::FLAG_FEATURES) {
+            parseFeatures(nlohmann::json::parse(bytes + offset + sizeof(length),
+                                                bytes + offset + sizeof(length) + length), false);
+        }
+    }
+
+    // The parameters are used where they are; the payload is 64-byte aligned, so they are aligned floats
+    const auto *parameter = reinterpret_cast<const float *>(bytes + Checkpointer::payloadOffset(
+                                                                header.layerCount, featureSpecBytes));
+    const auto *end = reinterpret_cast<const float *>(bytes + size);
+    auto take = [&](const size_t count) {
+        if (static_cast<size_t>(end - parameter) < count) {
+            throw std::runtime_error("Truncated checkpoint file: " + path);
+        }
+        const float *values = parameter;
+        parameter += count;
+        return values;
+    };
+    for (auto &stage: features) {
+        if (stage.type == "conv2d") {
+            stage.weights = take(static_cast<size_t>(stage.output.channels) * stage.input.channels * stage.kernel *
+                                 stage.kernel);
+            stage.biases = take(stage.output.channels);
+        }
+    }
+    for (size_t i = 0; i + 1 < layerSizes.size(); ++i) {
+        const float *weights = take(static_cast<size_t>(layerSizes[i]) * layerSizes[i + 1]);
+        layers.push_back({weights, take(layerSizes[i + 1])});
+    }
+}
@@ -0,0 +1,94 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef CPUMODEL_H
+#define CPUMODEL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../nn/FeatureLayer.h"
+
+class MappedFile;
+
+/**
+ * @brief The parameters of a model for CpuInferenceEngine. Read-only once loaded, so any number of engines
+ * on any threads can share one instance and only keep their own activations.
+ *
+ * A model file (JSON) is parsed into memory. A checkpoint (see Checkpointer) is mapped read-only and used
+ * in place instead: its parameters are never copied, so every engine, and every process that maps the
+ * same checkpoint, reads the same pages of the OS page cache.
+ */
+class CpuModel {
+public:
+    // Convolution/pooling layer, see FeatureLayer::toJson
+    struct FeatureStage {
+        std::string type;
+        TensorShape input;
+        TensorShape output;
+        int kernel = 0; // kernel size or pooling window
+        int stride = 1;
+        int padding = 0;
+        FeatureActivation activation = FeatureActivation::NONE;
+        const float *weights = nullptr; // conv2d only
+        const float *biases = nullptr;
+    };
+
+    // W (neuronCount x inputSize, row-major) and b of one dense layer. For a pruned layer (saved as "sparse",
+    // see Layer::toJson) `weights` holds only the nonzeros, in CSR form: those of row r are
+    // weights[rowStart[r] .. rowStart[r + 1]), at the columns in `columns`.
+    struct DenseLayer {
+        const float *weights;
+        const float *biases;
+        const int *rowStart = nullptr;
+        const int *columns = nullptr;
+
+        [[nodiscard]] bool isSparse() const { return rowStart != nullptr; }
+    };
+
+    /**
+     * @brief Loads a model file or a checkpoint, told apart by the checkpoint magic.
+     */
+    static std::shared_ptr<const CpuModel> load(const std::string &path);
+
+    ~CpuModel();
+
+    CpuModel(const CpuModel &) = delete;
+
+    CpuModel &operator=(const CpuModel &) = delete;
+
+    TensorShape inputShape; // zero channels without feature layers
+    std::vector<FeatureStage> features;
+    std::vector<int> layerSizes;
+    std::vector<DenseLayer> layers;
+
+    [[nodiscard]] int inputSize() const {
+        return inputShape.channels > 0 ? inputShape.size() : layerSizes.front();
+    }
+
+    // Whether the parameters live in a mapped checkpoint
+    [[nodiscard]] bool isMapped() const { return mapped != nullptr; }
+
+private:
+    CpuModel();
+
+    // Parameters parsed from a model file
+    std::vector<std::vector<float> > storage;
+    std::vector<std::vector<int> > indexStorage; // CSR positions of pruned layers
+    std::unique_ptr<MappedFile> mapped;
+
+    void loadModelFile(const std::string &path);
+
+    void mapCheckpoint(const std::string &path);
+
+    // Reads the input shape and feature layers of a model file or checkpoint description
+    void parseFeatures(const nlohmann::json &description, bool withParameters);
+
+    [[nodiscard]] const float *keep(std::vector<float> values);
+
+    [[nodiscard]] const int *keep(std::vector<int> indices);
+};
+
+#endif //CPUMODEL_H
@@ -0,0 +1,189 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#include "InferenceEngine.h"
+#include "../nn/CpuKernels.h"
+#include "../utils/SetupUtil.h"
+
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+SharedGlModel::SharedGlModel(const std::string &modelPath) {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    context = createOffscreenContext();
+
+    glfwMakeContextCurrent(context);
+    network = NeuralNetwork::loadFromFile(modelPath);
+    // Other contexts only see the uploaded parameters once they have landed
+    glFinish();
+    glfwMakeContextCurrent(previous);
+}
+
+SharedGlModel::~SharedGlModel() {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    glfwMakeContextCurrent(context);
+    network.reset();
+    glfwMakeContextCurrent(previous == context ? nullptr : previous);
+    destroyOffscreenContext(context);
+}
+
+GlInferenceEngine::GlInferenceEngine(const std::string &modelPath) {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    context = createOffscreenContext();
+
+    // Shaders and buffers must be created inside the context that will use them
+    glfwMakeContextCurrent(context);
+    network = NeuralNetwork::loadFromFile(modelPath);
+    glfwMakeContextCurrent(previous);
+}
+
+GlInferenceEngine::GlInferenceEngine(std::shared_ptr<const SharedGlModel> model) : model(std::move(model)) {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    context = createOffscreenContext(this->model->getContext());
+
+    glfwMakeContextCurrent(context);
+    network = this->model->getNetwork().createReplica();
+    glfwMakeContextCurrent(previous);
+}
+
+GlInferenceEngine::GlInferenceEngine(std::shared_ptr<OnlineModel> model) : onlineModel(std::move(model)) {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    context = createOffscreenContext(onlineModel->getContext());
+
+    // A replica per snapshot, so a swap only changes which one runs: their execution plans stay valid
+    glfwMakeContextCurrent(context);
+    for (int i = 0; i < onlineModel->snapshotCount(); ++i) {
+        snapshotReplicas.push_back(onlineModel->getSnapshot(i).createReplica());
+    }
+    glfwMakeContextCurrent(previous);
+}
+
+GlInferenceEngine::~GlInferenceEngine() {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    glfwMakeContextCurrent(context);
+    network.reset();
+    snapshotReplicas.clear();
+    glfwMakeContextCurrent(previous == context ? nullptr : previous);
+    destroyOffscreenContext(context);
+}
+
+void GlInferenceEngine::attachToThread() {
+    glfwMakeContextCurrent(context);
+}
+
+void GlInferenceEngine::detachFromThread() {
+    glfwMakeContextCurrent(nullptr);
+}
+
+std::vector<std::vector<float> > GlInferenceEngine::predictBatch(const std::vector<const std::vector<float> *> &inputs) {
+    NeuralNetwork *target = network.get();
+    std::optional<OnlineModel::Lease> lease;
+    if (onlineModel) {
+        // The whole batch sees one version
+        lease.emplace(onlineModel->acquire(seenVersion));
+        target = snapshotReplicas[lease->index()].get();
+    }
+
+    // One upload, one pass over the layers and one readback for the whole batch
+    const size_t inSize = target->getInputSize();
+    const size_t outSize = target->getLayerSizes().back();
+    batchInput.resize(inputs.size() * inSize);
+    for (size_t b = 0; b < inputs.size(); ++b) {
+        if (inputs[b]->size() != inSize) {
+            throw std::invalid_argument("Input data size does not match network input size.");
+        }
+        std::ranges::copy(*inputs[b], batchInput.begin() + static_cast<std::ptrdiff_t>(b * inSize));
+    }
+    batchOutput.resize(inputs.size() * outSize);
+    target->predictBatch(batchInput, inputs.size(), batchOutput);
+
+    std::vector<std::vector<float> > outputs(inputs.size());
+    for (size_t b = 0; b < inputs.size(); ++b) {
+        const auto first = batchOutput.begin() + static_cast<std::ptrdiff_t>(b * outSize);
+        outputs[b].assign(first, first + static_cast<std::ptrdiff_t>(outSize));
+    }
+    return outputs;
+}
+
+CpuInferenceEngine::CpuInferenceEngine(const std::string &modelPath)
+    : CpuInferenceEngine(CpuModel::load(modelPath)) {
+}
+
+CpuInferenceEngine::CpuInferenceEngine(std::shared_ptr<const CpuModel> model) : model(std::move(model)) {
+}
+
+std::vector<std::vector<float> > CpuInferenceEngine::predictBatch(const std::vector<const std::vector<float> *> &inputs) {
+    const int batch = static_cast<int>(inputs.size());
+    const auto &layerSizes = model->layerSizes;
+    const int inSize = layerSizes.front();
+
+    current.resize(static_cast<size_t>(batch) * inSize);
+    for (int b = 0; b < batch; ++b) {
+        if (inputs[b]->size() != static_cast<size_t>(inputSize())) {
+            throw std::invalid_argument("Input data size does not match network input size.");
+        }
+        if (model->features.empty()) {
+            std::copy(inputs[b]->begin(), inputs[b]->end(), current.begin() + static_cast<size_t>(b) * inSize);
+            continue;
+        }
+
+        // Feature layers run per sample, their flattened output is the dense input
+        featureIn = *inputs[b];
+        for (const auto &stage: model->features) {
+            featureOut.resize(stage.output.size());
+            const TensorShape &in = stage.input;
+            if (stage.type == "conv2d") {
+                CpuKernels::conv2d(featureIn.data(), stage.weights, stage.biases, featureOut.data(),
+                                   in.channels, in.height, in.width, stage.output.channels, stage.kernel,
+                                   stage.stride, stage.padding);
+                if (stage.activation == FeatureActivation::RELU) {
+                    CpuKernels::relu(featureOut.data(), featureOut.data(), stage.output.size());
+                } else if (stage.activation == FeatureActivation::SIGMOID) {
+                    CpuKernels::sigmoid(featureOut.data(), featureOut.data(), stage.output.size());
+                }
+            } else if (stage.type == "max_pool") {
+                CpuKernels::maxPool2d(featureIn.data(), featureOut.data(), in.channels, in.height, in.width,
+                                      stage.kernel, stage.stride);
+            } else {
+                CpuKernels::avgPool2d(featureIn.data(), featureOut.data(), in.channels, in.height, in.width,
+                                      stage.kernel, stage.stride);
+            }
+            std::swap(featureIn, featureOut);
+        }
+        std::copy(featureIn.begin(), featureIn.end(), current.begin() + static_cast<size_t>(b) * inSize);
+    }
+
+    // Same math as Layer::forward: a = sigmoid(W * a_prev + b)
+    for (size_t l = 0; l < model->layers.size(); ++l) {
+        const int rows = layerSizes[l + 1];
+        const int cols = layerSizes[l];
+        const CpuModel::DenseLayer &layer = model->layers[l];
+        next.resize(static_cast<size_t>(batch) * rows);
+        if (layer.isSparse()) {
+            for (int b = 0; b < batch; ++b) {
+                CpuKernels::spmvCsr(layer.rowStart, layer.columns, layer.weights,
+                                    current.data() + static_cast<size_t>(b) * cols,
+                                    next.data() + static_cast<size_t>(b) * rows, rows);
+            }
+        } else {
+            CpuKernels::matVecBatch(layer.weights, current.data(), next.data(), rows, cols, batch);
+        }
+        for (int b = 0; b < batch; ++b) {
+            float *z = next.data() + static_cast<size_t>(b) * rows;
+            CpuKernels::addInPlace(z, layer.biases, rows);
+            CpuKernels::sigmoid(z, z, rows);
+        }
+        std::swap(current, next);
+    }
+
+    const int outSize = layerSizes.back();
+    std::vector<std::vector<float> > outputs(batch);
+    for (int b = 0; b < batch; ++b) {
+        outputs[b].assign(current.begin() + static_cast<size_t>(b) * outSize,
+                          current.begin() + static_cast<size_t>(b + 1) * outSize);
+    }
+    return outputs;
+}
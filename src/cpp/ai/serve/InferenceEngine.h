@@ -0,0 +1,143 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#ifndef INFERENCEENGINE_H
+#define INFERENCEENGINE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CpuModel.h"
+#include "OnlineModel.h"
+#include "../nn/NeuralNetwork.h"
+
+struct GLFWwindow;
+
+/**
+ * @brief Something that can run a forward pass over a batch of inputs.
+ * An engine is only ever driven by one worker thread at a time.
+ */
+class InferenceEngine {
+public:
+    virtual ~InferenceEngine() = default;
+
+    /**
+     * @brief Called once on the worker thread before the first batch (e.g. to make a GL context current).
+     */
+    virtual void attachToThread() {
+    }
+
+    /**
+     * @brief Called once on the worker thread after the last batch.
+     */
+    virtual void detachFromThread() {
+    }
+
+    [[nodiscard]] virtual int inputSize() const = 0;
+
+    /**
+     * @brief Runs every input through the network. Returns one output vector per input, in order.
+     */
+    virtual std::vector<std::vector<float> > predictBatch(const std::vector<const std::vector<float> *> &inputs) = 0;
+};
+
+/**
+ * @brief A model loaded once into its own hidden GL context, for GlInferenceEngines that share its
+ * parameters instead of loading a copy each. Must be constructed and destroyed on the main thread.
+ */
+class SharedGlModel {
+public:
+    explicit SharedGlModel(const std::string &modelPath);
+
+    ~SharedGlModel();
+
+    SharedGlModel(const SharedGlModel &) = delete;
+
+    SharedGlModel &operator=(const SharedGlModel &) = delete;
+
+    [[nodiscard]] GLFWwindow *getContext() const { return context; }
+
+    [[nodiscard]] const NeuralNetwork &getNetwork() const { return *network; }
+
+private:
+    GLFWwindow *context = nullptr;
+    std::unique_ptr<NeuralNetwork> network;
+};
+
+/**
+ * @brief Runs a NeuralNetwork in its own hidden GL context, so several engines can serve in parallel.
+ * Must be constructed and destroyed on the main thread (GLFW requirement); the worker thread only
+ * borrows the context.
+ */
+class GlInferenceEngine : public InferenceEngine {
+public:
+    explicit GlInferenceEngine(const std::string &modelPath);
+
+    /**
+     * @brief Runs a replica of the shared model (see NeuralNetwork::createReplica()): its context shares
+     * objects with the model's, and the engine only allocates its own shaders and activation buffers.
+     */
+    explicit GlInferenceEngine(std::shared_ptr<const SharedGlModel> model);
+
+    /**
+     * @brief Serves a model that is still training: the engine keeps a replica of every snapshot and runs
+     * each batch on the latest published one (see OnlineModel::acquire()).
+     */
+    explicit GlInferenceEngine(std::shared_ptr<OnlineModel> model);
+
+    ~GlInferenceEngine() override;
+
+    void attachToThread() override;
+
+    void detachFromThread() override;
+
+    [[nodiscard]] int inputSize() const override {
+        return network ? network->getInputSize() : onlineModel->getInputSize();
+    }
+
+    std::vector<std::vector<float> > predictBatch(const std::vector<const std::vector<float> *> &inputs) override;
+
+private:
+    std::shared_ptr<const SharedGlModel> model; // null if the engine loaded its own network
+    GLFWwindow *context = nullptr;
+    std::unique_ptr<NeuralNetwork> network; // null when serving an online model
+
+    std::shared_ptr<OnlineModel> onlineModel;
+    std::vector<std::unique_ptr<NeuralNetwork> > snapshotReplicas; // one per snapshot of the online model
+    uint64_t seenVersion = 0;
+
+    // The batch packed for NeuralNetwork::predictBatch(), reused across calls
+    std::vector<float> batchInput;
+    std::vector<float> batchOutput;
+};
+
+/**
+ * @brief Runs a model on the CPU. No GL involved, so any number of these can run on any thread.
+ */
+class CpuInferenceEngine : public InferenceEngine {
+public:
+    explicit CpuInferenceEngine(const std::string &modelPath);
+
+    /**
+     * @brief Runs a model shared with other engines, e.g. a mapped checkpoint (see CpuModel).
+     */
+    explicit CpuInferenceEngine(std::shared_ptr<const CpuModel> model);
+
+    [[nodiscard]] int inputSize() const override { return model->inputSize(); }
+
+    std::vector<std::vector<float> > predictBatch(const std::vector<const std::vector<float> *> &inputs) override;
+
+private:
+    std::shared_ptr<const CpuModel> model;
+
+    std::vector<float> featureIn;
+    std::vector<float> featureOut;
+
+    // Per-batch activations, reused across calls
+    std::vector<float> current;
+    std::vector<float> next;
+};
+
+#endif //INFERENCEENGINE_H
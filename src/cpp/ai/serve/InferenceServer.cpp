@@ -0,0 +1,221 @@
+//
+// Created by CorruptionHades on 07/10/2025.
+//
+
+#include "InferenceServer.h"
+
+#include <stdexcept>
+
+namespace {
+    uint64_t microsBetween(const std::chrono::steady_clock::time_point from,
+                           const std::chrono::steady_clock::time_point to) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+    }
+}
+
+InferenceServer::InferenceServer(std::vector<std::unique_ptr<InferenceEngine> > engines,
+                                 const InferenceServerConfig config)
+    : config(config), engines(std::move(engines)) {
+    if (this->engines.empty()) {
+        throw std::invalid_argument("InferenceServer needs at least one engine.");
+    }
+    if (config.maxBatchSize < 1) {
+        throw std::invalid_argument("maxBatchSize must be at least 1.");
+    }
+
+    liveWorkers = this->engines.size();
+    for (auto &engine: this->engines) {
+        workers.emplace_back(&InferenceServer::runWorker, this, std::ref(*engine));
+    }
+    batcher = std::thread(&InferenceServer::runBatcher, this);
+}
+
+InferenceServer::~InferenceServer() {
+    // A null request marks the end of the stream; everything queued before it is still served.
+    stopping.store(true);
+    incoming.push(nullptr);
+    pending.fetch_add(1);
+    if (batcherAsleep.load()) {
+        std::lock_guard lock(wakeMutex);
+    }
+    wakeUp.notify_one();
+    batcher.join();
+
+    {
+        std::lock_guard lock(batchMutex);
+        batcherDone = true;
+    }
+    batchAvailable.notify_all();
+    for (auto &worker: workers) worker.join();
+
+    // Only left over if no engine attached, or if submit() raced with the shutdown
+    const auto error = std::make_exception_ptr(std::runtime_error("InferenceServer is shutting down."));
+    for (auto &batch: batches) failBatch(batch, attachError ? attachError : error);
+    std::unique_ptr<Request> request;
+    while (incoming.tryPop(request)) {
+        if (request) request->result.set_exception(error);
+    }
+}
+
+void InferenceServer::failBatch(Batch &batch, const std::exception_ptr &error) {
+    for (const auto &request: batch) {
+        request->result.set_exception(error);
+    }
+}
+
+std::future<std::vector<float> > InferenceServer::submit(std::vector<float> input) {
+    if (stopping.load(std::memory_order_relaxed)) {
+        throw std::runtime_error("InferenceServer is shutting down.");
+    }
+
+    auto request = std::make_unique<Request>();
+    request->input = std::move(input);
+    request->enqueued = Clock::now();
+    auto future = request->result.get_future();
+
+    incoming.push(std::move(request));
+    // Sequentially consistent with the batcher's flag and re-check, so either it sees the request or we see it
+    // asleep; taking the mutex then ensures it is inside wait() before the notification
+    pending.fetch_add(1);
+    if (batcherAsleep.load()) {
+        std::lock_guard lock(wakeMutex);
+    }
+    wakeUp.notify_one();
+    requestCount.fetch_add(1, std::memory_order_relaxed);
+    return future;
+}
+
+void InferenceServer::runBatcher() {
+    Batch current;
+    current.reserve(config.maxBatchSize);
+    Clock::time_point deadline{};
+
+    while (true) {
+        std::unique_ptr<Request> request;
+        if (incoming.tryPop(request)) {
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+            if (!request) break; // shutdown marker
+
+            if (current.empty()) deadline = request->enqueued + config.maxBatchDelay;
+            current.push_back(std::move(request));
+            if (current.size() >= static_cast<size_t>(config.maxBatchSize)) {
+                dispatch(std::move(current));
+                current = Batch();
+                current.reserve(config.maxBatchSize);
+            }
+            continue;
+        }
+
+        if (!current.empty()) {
+            // A partial batch is open: wait for more requests until its deadline.
+            const auto now = Clock::now();
+            if (now >= deadline) {
+                dispatch(std::move(current));
+                current = Batch();
+                current.reserve(config.maxBatchSize);
+            } else {
+                waitForRequests(&deadline);
+            }
+            continue;
+        }
+
+        // Nothing to do: sleep until a producer bumps the counter.
+        waitForRequests(nullptr);
+    }
+
+    if (!current.empty()) dispatch(std::move(current));
+}
+
+void InferenceServer::waitForRequests(const Clock::time_point *deadline) {
+    std::unique_lock lock(wakeMutex);
+    batcherAsleep.store(true);
+    // A push that is still half done counts as pending, the caller then spins until it can be popped
+    const auto arrived = [this] { return pending.load() != 0; };
+    if (deadline) {
+        wakeUp.wait_until(lock, *deadline, arrived);
+    } else {
+        wakeUp.wait(lock, arrived);
+    }
+    batcherAsleep.store(false);
+}
+
+void InferenceServer::dispatch(Batch &&batch) {
+    {
+        std::lock_guard lock(batchMutex);
+        if (liveWorkers == 0) {
+            failBatch(batch, attachError);
+            return;
+        }
+        batches.push_back(std::move(batch));
+    }
+    batchCount.fetch_add(1, std::memory_order_relaxed);
+    batchAvailable.notify_one();
+}
+
+void InferenceServer::runWorker(InferenceEngine &engine) {
+    try {
+        engine.attachToThread();
+    } catch (...) {
+        // The other engines take over; without any left, nothing queued could ever run
+        std::lock_guard lock(batchMutex);
+        attachError = std::current_exception();
+        if (--liveWorkers == 0) {
+            for (auto &batch: batches) failBatch(batch, attachError);
+            batches.clear();
+        }
+        return;
+    }
+
+    std::vector<const std::vector<float> *> inputs;
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock lock(batchMutex);
+            batchAvailable.wait(lock, [this] { return batcherDone || !batches.empty(); });
+            if (batches.empty()) break;
+            batch = std::move(batches.front());
+            batches.pop_front();
+        }
+
+        const auto start = Clock::now();
+        inputs.clear();
+        for (const auto &request: batch) {
+            queueHistogram.record(microsBetween(request->enqueued, start));
+            inputs.push_back(&request->input);
+        }
+
+        std::vector<std::vector<float> > outputs;
+        try {
+            outputs = engine.predictBatch(inputs);
+            if (outputs.size() != batch.size()) {
+                throw std::runtime_error("Engine returned the wrong number of outputs.");
+            }
+        } catch (...) {
+            for (const auto &request: batch) {
+                request->result.set_exception(std::current_exception());
+            }
+            continue;
+        }
+
+        const auto end = Clock::now();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i]->result.set_value(std::move(outputs[i]));
+            endToEndHistogram.record(microsBetween(batch[i]->enqueued, end));
+        }
+    }
+
+    engine.detachFromThread();
+}
+
+InferenceServer::Stats InferenceServer::stats() const {
+    const uint64_t requests = requestCount.load(std::memory_order_relaxed);
+    const uint64_t batchTotal = batchCount.load(std::memory_order_relaxed);
+    return {requests, batchTotal, batchTotal ? static_cast<double>(requests) / static_cast<double>(batchTotal) : 0.0};
+}
+
+void InferenceServer::resetStats() {
+    queueHistogram.reset();
+    endToEndHistogram.reset();
+    requestCount.store(0, std::memory_order_relaxed);
+    batchCount.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,125 @@
+//
+// Created by CorruptionHades on 07/10/2025.
+//
+
+#ifndef INFERENCESERVER_H
+#define INFERENCESERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "InferenceEngine.h"
+#include "LatencyHistogram.h"
+#include "MpscQueue.h"
+
+struct InferenceServerConfig {
+    // Largest batch handed to an engine at once.
+    int maxBatchSize = 32;
+    // How long the oldest request of a partial batch may wait for company before it is dispatched anyway.
+    std::chrono::microseconds maxBatchDelay{2000};
+};
+
+/**
+ * @brief Serves predictions to many threads at once.
+ *
+ * submit() pushes into a lock-free MPSC queue. A batcher thread coalesces requests into batches
+ * (up to maxBatchSize, or whatever arrived within maxBatchDelay of the oldest request) and hands
+ * them to a pool of engines, each driven by its own worker thread. Results come back as futures.
+ */
+class InferenceServer {
+public:
+    struct Stats {
+        uint64_t requests;
+        uint64_t batches;
+        double meanBatchSize;
+    };
+
+    InferenceServer(std::vector<std::unique_ptr<InferenceEngine> > engines, InferenceServerConfig config = {});
+
+    /**
+     * @brief Stops accepting work, finishes every queued request and joins all threads. Requests that
+     * cannot be served any more (no engine could attach) get an exception instead of a result.
+     */
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer &) = delete;
+
+    InferenceServer &operator=(const InferenceServer &) = delete;
+
+    /**
+     * @brief Queues one input. Thread-safe and lock-free.
+     */
+    std::future<std::vector<float> > submit(std::vector<float> input);
+
+    // Time from submit() until the batch holding the request starts running.
+    [[nodiscard]] const LatencyHistogram &queueLatency() const { return queueHistogram; }
+
+    // Time from submit() until the result is available.
+    [[nodiscard]] const LatencyHistogram &endToEndLatency() const { return endToEndHistogram; }
+
+    [[nodiscard]] Stats stats() const;
+
+    void resetStats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Request {
+        std::vector<float> input;
+        std::promise<std::vector<float> > result;
+        Clock::time_point enqueued;
+    };
+
+    using Batch = std::vector<std::unique_ptr<Request> >;
+
+    InferenceServerConfig config;
+    std::vector<std::unique_ptr<InferenceEngine> > engines;
+
+    MpscQueue<std::unique_ptr<Request> > incoming;
+    // Number of requests pushed but not yet popped; the batcher sleeps until it changes or a batch is due.
+    std::atomic<uint64_t> pending{0};
+    std::atomic<bool> stopping{false};
+    // Producers only take wakeMutex while the batcher is (about to be) asleep, submit() stays lock-free otherwise.
+    std::atomic<bool> batcherAsleep{false};
+    std::mutex wakeMutex;
+    std::condition_variable wakeUp;
+
+    // Batches waiting for a free engine. Only touched once per batch, so a mutex is fine here.
+    std::mutex batchMutex;
+    std::condition_variable batchAvailable;
+    std::deque<Batch> batches;
+    bool batcherDone = false;
+    // Workers whose engine attached; once none is left, batches fail with the last attach error
+    size_t liveWorkers = 0;
+    std::exception_ptr attachError;
+
+    LatencyHistogram queueHistogram;
+    LatencyHistogram endToEndHistogram;
+    std::atomic<uint64_t> requestCount{0};
+    std::atomic<uint64_t> batchCount{0};
+
+    std::thread batcher;
+    std::vector<std::thread> workers;
+
+    void runBatcher();
+
+    // Blocks the batcher until a request was pushed, or until `deadline` if it has one
+    void waitForRequests(const Clock::time_point *deadline);
+
+    // Fails every request of the batch; the server never drops a promise
+    static void failBatch(Batch &batch, const std::exception_ptr &error);
+
+    void runWorker(InferenceEngine &engine);
+
+    void dispatch(Batch &&batch);
+};
+
+#endif //INFERENCESERVER_H
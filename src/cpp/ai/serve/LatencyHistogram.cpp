@@ -0,0 +1,73 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+int LatencyHistogram::bucketIndex(const uint64_t micros) {
+    if (micros < SUB_BUCKETS) return static_cast<int>(micros);
+
+    // The top SUB_BUCKET_BITS + 1 bits pick the bucket: the leading one selects the magnitude,
+    // the bits after it the linear sub-bucket.
+    const int msb = static_cast<int>(std::bit_width(micros)) - 1;
+    const int shift = msb - SUB_BUCKET_BITS;
+    const int sub = static_cast<int>((micros >> shift) & (SUB_BUCKETS - 1));
+    return std::min((shift + 1) * SUB_BUCKETS + sub, BUCKET_COUNT - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(const int index) {
+    if (index < SUB_BUCKETS) return index;
+    const int shift = index / SUB_BUCKETS - 1;
+    const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return lower + (uint64_t{1} << shift) - 1;
+}
+
+void LatencyHistogram::record(const uint64_t micros) {
+    buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t prevMax = maximum.load(std::memory_order_relaxed);
+    while (micros > prevMax && !maximum.compare_exchange_weak(prevMax, micros, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentile(const double q) const {
+    const uint64_t n = count();
+    if (n == 0) return 0;
+
+    const auto rank = static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * static_cast<double>(n - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), maxMicros());
+        }
+    }
+    return maxMicros();
+}
+
+double LatencyHistogram::meanMicros() const {
+    const uint64_t n = count();
+    return n == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(n);
+}
+
+void LatencyHistogram::reset() {
+    for (auto &bucket: buckets) bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    maximum.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::print(std::ostream &out, const std::string &name) const {
+    out << std::left << std::setw(10) << name << std::right
+            << " n=" << std::setw(8) << count()
+            << " mean=" << std::setw(8) << std::fixed << std::setprecision(1) << meanMicros() << "us"
+            << " p50=" << std::setw(7) << percentile(0.50) << "us"
+            << " p99=" << std::setw(7) << percentile(0.99) << "us"
+            << " max=" << std::setw(7) << maxMicros() << "us" << std::endl;
+}
@@ -0,0 +1,54 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Lock-free latency histogram with log-linear buckets (8 sub-buckets per power of two),
+ * covering 1 microsecond to ~1 hour with <= 12.5% relative error.
+ * record() can be called from any number of threads.
+ */
+class LatencyHistogram {
+public:
+    void record(uint64_t micros);
+
+    /**
+     * @brief Returns the latency (in microseconds) below which a fraction q of the samples fall.
+     */
+    [[nodiscard]] uint64_t percentile(double q) const;
+
+    [[nodiscard]] uint64_t count() const { return total.load(std::memory_order_relaxed); }
+
+    [[nodiscard]] double meanMicros() const;
+
+    [[nodiscard]] uint64_t maxMicros() const { return maximum.load(std::memory_order_relaxed); }
+
+    void reset();
+
+    void print(std::ostream &out, const std::string &name) const;
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAGNITUDES = 32;
+    static constexpr int BUCKET_COUNT = MAGNITUDES * SUB_BUCKETS;
+
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> total{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> maximum{0};
+
+    static int bucketIndex(uint64_t micros);
+
+    static uint64_t bucketUpperBound(int index);
+};
+
+#endif //LATENCYHISTOGRAM_H
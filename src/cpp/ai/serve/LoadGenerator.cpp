@@ -0,0 +1,82 @@
+//
+// Created by CorruptionHades on 07/10/2025.
+//
+
+#include "LoadGenerator.h"
+
+#include <atomic>
+#include <iomanip>
+#include <random>
+#include <thread>
+
+namespace LoadGenerator {
+    Result run(InferenceServer &server, const std::function<std::vector<float>(size_t)> &makeInput,
+               const double targetRps, const std::chrono::milliseconds duration, const int clientThreads) {
+        using Clock = std::chrono::steady_clock;
+
+        server.resetStats();
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> failures{0};
+
+        const auto start = Clock::now();
+        const auto stop = start + duration;
+
+        std::vector<std::thread> clients;
+        for (int t = 0; t < clientThreads; ++t) {
+            clients.emplace_back([&, t] {
+                std::mt19937_64 gen(12345 + t);
+                std::exponential_distribution<double> gap(targetRps / clientThreads);
+                std::vector<std::future<std::vector<float> > > futures;
+
+                // Open loop: arrivals follow the schedule no matter how slow the server is.
+                auto next = Clock::now();
+                for (size_t i = 0; ; ++i) {
+                    next += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(gen)));
+                    if (next >= stop) break;
+                    std::this_thread::sleep_until(next);
+                    futures.push_back(server.submit(makeInput(i * clientThreads + t)));
+                }
+
+                for (auto &future: futures) {
+                    try {
+                        future.get();
+                        completed.fetch_add(1, std::memory_order_relaxed);
+                    } catch (...) {
+                        failures.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+            });
+        }
+        for (auto &client: clients) client.join();
+
+        const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        const auto &latency = server.endToEndLatency();
+        return {
+            targetRps,
+            static_cast<double>(completed.load()) / elapsed,
+            latency.percentile(0.50),
+            latency.percentile(0.99),
+            server.stats().meanBatchSize,
+            failures.load()
+        };
+    }
+
+    std::vector<Result> sweep(InferenceServer &server, const std::function<std::vector<float>(size_t)> &makeInput,
+                              const std::vector<double> &rates, const std::chrono::milliseconds durationPerPoint,
+                              std::ostream &out, const int clientThreads) {
+        out << std::setw(12) << "offered/s" << std::setw(12) << "achieved/s" << std::setw(10) << "p50 us"
+                << std::setw(10) << "p99 us" << std::setw(8) << "batch" << std::setw(8) << "failed" << std::endl;
+
+        std::vector<Result> results;
+        for (const double rate: rates) {
+            const Result r = run(server, makeInput, rate, durationPerPoint, clientThreads);
+            out << std::fixed << std::setprecision(0)
+                    << std::setw(12) << r.offeredRps << std::setw(12) << r.achievedRps
+                    << std::setw(10) << r.p50Micros << std::setw(10) << r.p99Micros
+                    << std::setprecision(1) << std::setw(8) << r.meanBatchSize
+                    << std::setw(8) << r.failures << std::endl;
+            results.push_back(r);
+        }
+        return results;
+    }
+}
@@ -0,0 +1,41 @@
+//
+// Created by CorruptionHades on 07/10/2025.
+//
+
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+#include "InferenceServer.h"
+
+namespace LoadGenerator {
+    struct Result {
+        double offeredRps;
+        double achievedRps;
+        uint64_t p50Micros;
+        uint64_t p99Micros;
+        double meanBatchSize;
+        uint64_t failures;
+    };
+
+    /**
+     * @brief Open-loop load: clientThreads threads submit requests with exponentially distributed
+     * gaps (a Poisson process) at a combined rate of targetRps for the given duration, then wait for
+     * every result. Resets the server's stats first.
+     */
+    Result run(InferenceServer &server, const std::function<std::vector<float>(size_t)> &makeInput,
+               double targetRps, std::chrono::milliseconds duration, int clientThreads = 4);
+
+    /**
+     * @brief Runs one load point per rate and prints a latency vs throughput table.
+     */
+    std::vector<Result> sweep(InferenceServer &server, const std::function<std::vector<float>(size_t)> &makeInput,
+                              const std::vector<double> &rates, std::chrono::milliseconds durationPerPoint,
+                              std::ostream &out, int clientThreads = 4);
+}
+
+#endif //LOADGENERATOR_H
@@ -0,0 +1,277 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "ModelRegistry.h"
+
+#include <stdexcept>
+
+#include "../nn/Conv2DLayer.h"
+#include "../nn/Layer.h"
+#include "../nn/NeuralNetwork.h"
+#include "../nn/PoolLayer.h"
+
+ModelRegistry::ModelRegistry(const ModelRegistryConfig config) : config(config) {
+}
+
+ModelRegistry::~ModelRegistry() {
+    for (auto &[name, entry]: entries) {
+        if (entry.pendingHost.valid()) {
+            entry.pendingHost.wait();
+        }
+    }
+}
+
+void ModelRegistry::add(const std::string &name, const std::string &path) {
+    const auto [it, added] = entries.try_emplace(name);
+    if (!added) {
+        throw std::invalid_argument("Model already registered: " + name);
+    }
+    it->second.path = path;
+}
+
+ModelRegistry::Entry &ModelRegistry::find(const std::string &name) {
+    const auto it = entries.find(name);
+    if (it == entries.end()) {
+        throw std::invalid_argument("Unknown model: " + name);
+    }
+    return it->second;
+}
+
+std::shared_ptr<NeuralNetwork> ModelRegistry::acquire(const std::string &name) {
+    Entry &entry = find(name);
+    entry.lastUsed = ++clock;
+    if (entry.network) {
+        ++hits;
+        return entry.network;
+    }
+
+    ++misses;
+    releaseRetired();
+    const CpuModel &model = hostCopy(entry);
+    const size_t bytes = estimateDeviceBytes(model);
+    makeRoom(bytes, &entry);
+
+    entry.network = upload(model);
+    entry.deviceBytes = bytes;
+    deviceBytes += bytes;
+    trimHostCopies();
+    return entry.network;
+}
+
+void ModelRegistry::prefetch(const std::string &name) {
+    Entry &entry = find(name);
+    if (entry.network || entry.host || entry.pendingHost.valid()) {
+        return;
+    }
+    ++prefetches;
+    ++diskLoads;
+    entry.pendingHost = std::async(std::launch::async, CpuModel::load, entry.path);
+}
+
+void ModelRegistry::evict(const std::string &name) {
+    Entry &entry = find(name);
+    if (entry.network) {
+        evictEntry(entry);
+        trimHostCopies();
+    }
+}
+
+bool ModelRegistry::isResident(const std::string &name) const {
+    const auto it = entries.find(name);
+    return it != entries.end() && it->second.network != nullptr;
+}
+
+const CpuModel &ModelRegistry::hostCopy(Entry &entry) {
+    if (entry.pendingHost.valid()) {
+        // Rethrows what the prefetch ran into
+        entry.host = entry.pendingHost.get();
+    } else if (!entry.host) {
+        ++diskLoads;
+        entry.host = CpuModel::load(entry.path);
+    }
+    return *entry.host;
+}
+
+void ModelRegistry::evictEntry(Entry &entry) {
+    // The bytes are only given back once nobody holds the network any more
+    retired.push_back({entry.network, entry.deviceBytes});
+    entry.network.reset();
+    entry.deviceBytes = 0;
+    ++evictions;
+    releaseRetired();
+}
+
+void ModelRegistry::releaseRetired() {
+    std::erase_if(retired, [this](const Retired &r) {
+        if (!r.network.expired()) return false;
+        deviceBytes -= r.deviceBytes;
+        return true;
+    });
+}
+
+void ModelRegistry::makeRoom(const size_t incoming, const Entry *keep) {
+    while (deviceBytes > 0 && deviceBytes + incoming > config.deviceBudgetBytes) {
+        Entry *oldest = nullptr;
+        for (auto &[name, entry]: entries) {
+            if (&entry != keep && entry.network && (!oldest || entry.lastUsed < oldest->lastUsed)) {
+                oldest = &entry;
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+        evictEntry(*oldest);
+    }
+}
+
+size_t ModelRegistry::parameterBytes(const CpuModel &model) {
+    size_t floats = 0;
+    for (size_t i = 0; i < model.layers.size(); ++i) {
+        const CpuModel::DenseLayer &layer = model.layers[i];
+        const size_t neurons = model.layerSizes[i + 1];
+        if (layer.isSparse()) {
+            // The nonzeros with their columns, and the row starts (ints are as wide as floats)
+            const size_t nonZeros = layer.rowStart[neurons];
+            floats += 2 * nonZeros + neurons + 1 + neurons;
+        } else {
+            floats += static_cast<size_t>(model.layerSizes[i] + 1) * neurons;
+        }
+    }
+    for (const auto &stage: model.features) {
+        if (stage.weights) {
+            floats += static_cast<size_t>(stage.output.channels) * (stage.input.channels * stage.kernel *
+                                                                    stage.kernel + 1);
+        }
+    }
+    return floats * sizeof(float);
+}
+
+size_t ModelRegistry::hostBytesOf(const Entry &entry) {
+    return entry.host && !entry.host->isMapped() ? parameterBytes(*entry.host) : 0;
+}
+
+void ModelRegistry::trimHostCopies() {
+    if (config.hostBudgetBytes == 0) {
+        return;
+    }
+    size_t total = 0;
+    for (const auto &[name, entry]: entries) {
+        total += hostBytesOf(entry);
+    }
+    // Resident models keep their host copies, they are what an eviction falls back on
+    while (total > config.hostBudgetBytes) {
+        Entry *oldest = nullptr;
+        for (auto &[name, entry]: entries) {
+            if (!entry.network && hostBytesOf(entry) > 0 && (!oldest || entry.lastUsed < oldest->lastUsed)) {
+                oldest = &entry;
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+        total -= hostBytesOf(*oldest);
+        oldest->host.reset();
+        ++hostEvictions;
+    }
+}
+
+ModelRegistry::Stats ModelRegistry::stats() const {
+    Stats stats{hits, misses, diskLoads, prefetches, evictions, hostEvictions, 0, deviceBytes, 0, 0};
+    for (const auto &r: retired) {
+        // Released since the last call that cleaned up
+        if (r.network.expired()) stats.deviceBytes -= r.deviceBytes;
+    }
+    for (const auto &[name, entry]: entries) {
+        if (entry.network) ++stats.residentModels;
+        if (entry.host && entry.host->isMapped()) {
+            stats.mappedBytes += parameterBytes(*entry.host);
+        }
+        stats.hostBytes += hostBytesOf(entry);
+    }
+    return stats;
+}
+
+void ModelRegistry::resetStats() {
+    hits = misses = diskLoads = prefetches = evictions = hostEvictions = 0;
+}
+
+size_t ModelRegistry::estimateDeviceBytes(const CpuModel &model) {
+    size_t floats = 0;
+    for (const auto &stage: model.features) {
+        const size_t output = stage.output.size();
+        if (stage.type == "conv2d") {
+            // W, b and their gradients; z, δ and the output
+            const size_t parameters = static_cast<size_t>(stage.output.channels) *
+                                      (stage.input.channels * stage.kernel * stage.kernel + 1);
+            floats += 2 * parameters + 3 * output;
+        } else {
+            // Output, δ and the argmax
+            floats += 3 * output;
+        }
+    }
+    for (size_t i = 0; i + 1 < model.layerSizes.size(); ++i) {
+        const size_t inputs = model.layerSizes[i];
+        const size_t neurons = model.layerSizes[i + 1];
+        // W and ∇W; b, ∇b, z, δ, the activation and the error; the copy of the input
+        floats += 6 * neurons + inputs;
+        if (model.layers[i].isSparse()) {
+            // The nonzeros and their gradients, plus the CSR and CSC indices (see Layer::setSparse)
+            const size_t nonZeros = model.layers[i].rowStart[neurons];
+            floats += 2 * nonZeros + 3 * nonZeros + neurons + inputs + 2;
+        } else {
+            floats += 2 * inputs * neurons;
+        }
+    }
+    return floats * sizeof(float);
+}
+
+std::unique_ptr<NeuralNetwork> ModelRegistry::upload(const CpuModel &model) {
+    auto network = std::make_unique<NeuralNetwork>();
+    if (model.inputShape.channels > 0) {
+        network->setInputShape(model.inputShape.channels, model.inputShape.height, model.inputShape.width);
+        for (const auto &stage: model.features) {
+            if (stage.type == "conv2d") {
+                network->addConv2D(stage.output.channels, stage.kernel, stage.stride, stage.padding,
+                                   stage.activation);
+            } else {
+                network->addPool(stage.type == "max_pool" ? PoolType::MAX : PoolType::AVERAGE, stage.kernel,
+                                 stage.stride);
+            }
+        }
+        network->addLayer(model.layerSizes[1]);
+    } else {
+        network->addLayer(model.layerSizes[0], model.layerSizes[1]);
+    }
+    for (size_t i = 2; i < model.layerSizes.size(); ++i) {
+        network->addLayer(model.layerSizes[i]);
+    }
+
+    for (size_t f = 0; f < model.features.size(); ++f) {
+        const auto &stage = model.features[f];
+        if (stage.type == "conv2d") {
+            const size_t weightCount = static_cast<size_t>(stage.output.channels) * stage.input.channels *
+                                       stage.kernel * stage.kernel;
+            dynamic_cast<Conv2DLayer &>(network->getFeatureLayer(f)).uploadParameters(
+                {stage.weights, stage.weights + weightCount}, {stage.biases, stage.biases + stage.output.channels});
+        }
+    }
+    for (size_t i = 0; i < model.layers.size(); ++i) {
+        const CpuModel::DenseLayer &layer = model.layers[i];
+        const size_t inputs = model.layerSizes[i];
+        const size_t neurons = model.layerSizes[i + 1];
+        if (!layer.isSparse()) {
+            network->getLayer(i).uploadParameters({layer.weights, layer.weights + inputs * neurons},
+                                                  {layer.biases, layer.biases + neurons});
+            continue;
+        }
+
+        // Pruned layer: the stored CSR goes up as it is
+        Layer &target = network->getLayer(i);
+        target.setSparse({layer.rowStart, layer.rowStart + neurons + 1},
+                         {layer.columns, layer.columns + layer.rowStart[neurons]},
+                         {layer.weights, layer.weights + layer.rowStart[neurons]}, network->getSparseKernels());
+        target.uploadBiases({layer.biases, layer.biases + neurons});
+    }
+    return network;
+}
@@ -0,0 +1,162 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef MODELREGISTRY_H
+#define MODELREGISTRY_H
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CpuModel.h"
+
+class NeuralNetwork;
+
+struct ModelRegistryConfig {
+    // Device memory the resident models may use together. Beyond it, the least recently used models lose
+    // their device buffers. A single model larger than the budget is still loaded, alone.
+    size_t deviceBudgetBytes = size_t{1} << 30;
+    // Host memory for parsed model files, 0 for no limit. Beyond it, the host copies of the least recently
+    // used models that are not resident are dropped and read from disk again when needed. Mapped
+    // checkpoints do not count, their pages belong to the OS.
+    size_t hostBudgetBytes = 0;
+};
+
+/**
+ * @brief A catalog of models, far larger than device memory, of which only the recently used ones are
+ * kept on the device.
+ *
+ * Models are registered by name and read from disk on their first acquire() (or earlier, in the
+ * background, after a prefetch()). Every model keeps a host copy (a CpuModel: a parsed model file or a
+ * mapped checkpoint), so making an evicted model resident again is an upload, not a parse.
+ *
+ * Eviction only drops the registry's reference to the network: whoever still holds it from acquire()
+ * keeps using it, and its buffers are freed when the last reference goes. Until then they still count
+ * against the device budget. All calls, and the release
+ * of acquired networks, must happen on the thread whose GL context holds the models.
+ */
+class ModelRegistry {
+public:
+    struct Stats {
+        uint64_t hits; // acquire() found the model resident
+        uint64_t misses; // acquire() had to upload it
+        uint64_t diskLoads; // host copies read from disk, including prefetches
+        uint64_t prefetches;
+        uint64_t evictions; // device buffers dropped
+        uint64_t hostEvictions; // host copies dropped
+        size_t residentModels;
+        size_t deviceBytes; // estimated, see estimateDeviceBytes(); includes evicted networks still held
+        size_t hostBytes; // parsed host copies
+        size_t mappedBytes; // mapped checkpoints
+    };
+
+    explicit ModelRegistry(ModelRegistryConfig config = {});
+
+    /**
+     * @brief Waits for prefetches still running.
+     */
+    ~ModelRegistry();
+
+    ModelRegistry(const ModelRegistry &) = delete;
+
+    ModelRegistry &operator=(const ModelRegistry &) = delete;
+
+    /**
+     * @brief Registers a model file or checkpoint under `name`. Nothing is read yet.
+     */
+    void add(const std::string &name, const std::string &path);
+
+    /**
+     * @brief The model, made resident if needed: from its host copy, or from disk on first use. Marks it
+     * as the most recently used and evicts others if the device budget is exceeded.
+     */
+    std::shared_ptr<NeuralNetwork> acquire(const std::string &name);
+
+    /**
+     * @brief Hint that `name` will be needed soon: reads its host copy from disk on a background thread,
+     * so the next acquire() only uploads it.
+     */
+    void prefetch(const std::string &name);
+
+    /**
+     * @brief Drops the device buffers of `name` now, keeping its host copy.
+     */
+    void evict(const std::string &name);
+
+    [[nodiscard]] bool isResident(const std::string &name) const;
+
+    [[nodiscard]] size_t size() const { return entries.size(); }
+
+    [[nodiscard]] Stats stats() const;
+
+    /**
+     * @brief Zeroes the counters (not the memory figures).
+     */
+    void resetStats();
+
+    /**
+     * @brief Device memory a NeuralNetwork built from the model takes: parameters and their gradients,
+     * plus the per-layer activation and error buffers.
+     */
+    static size_t estimateDeviceBytes(const CpuModel &model);
+
+private:
+    struct Entry {
+        std::string path;
+        std::shared_ptr<const CpuModel> host;
+        std::future<std::shared_ptr<const CpuModel> > pendingHost; // prefetch in flight
+        std::shared_ptr<NeuralNetwork> network; // null while not resident
+        size_t deviceBytes = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    // An evicted network someone still holds, its buffers are only freed with the last reference
+    struct Retired {
+        std::weak_ptr<NeuralNetwork> network;
+        size_t deviceBytes;
+    };
+
+    ModelRegistryConfig config;
+    std::map<std::string, Entry> entries;
+    std::vector<Retired> retired;
+    uint64_t clock = 0;
+    size_t deviceBytes = 0; // resident and retired networks
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t diskLoads = 0;
+    uint64_t prefetches = 0;
+    uint64_t evictions = 0;
+    uint64_t hostEvictions = 0;
+
+    Entry &find(const std::string &name);
+
+    // Makes sure the entry has its host copy, waiting for a prefetch or reading the file
+    const CpuModel &hostCopy(Entry &entry);
+
+    void evictEntry(Entry &entry);
+
+    // Stops counting retired networks whose last reference is gone
+    void releaseRetired();
+
+    // Evicts least recently used models (never `keep`) until `incoming` more bytes fit the device budget
+    void makeRoom(size_t incoming, const Entry *keep);
+
+    // Drops host copies of models that are not resident until the parsed ones fit the host budget
+    void trimHostCopies();
+
+    // Size of the weights and biases
+    [[nodiscard]] static size_t parameterBytes(const CpuModel &model);
+
+    // Parsed host copy only, 0 if mapped or dropped
+    [[nodiscard]] static size_t hostBytesOf(const Entry &entry);
+
+    // Builds a network on the device from a host copy
+    static std::unique_ptr<NeuralNetwork> upload(const CpuModel &model);
+};
+
+#endif //MODELREGISTRY_H
@@ -0,0 +1,69 @@
+//
+// Created by CorruptionHades on 06/10/2025.
+//
+
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief Unbounded lock-free multi-producer/single-consumer queue (Vyukov's intrusive node queue).
+ * push() is wait-free apart from the allocation and may be called from any thread.
+ * tryPop() must only ever be called from one consumer thread.
+ */
+template<typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Node *stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue() {
+        T discarded;
+        while (tryPop(discarded)) {
+        }
+        delete tail;
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    void push(T value) {
+        Node *node = new Node();
+        node->value = std::move(value);
+        // Swing head to the new node, then link the previous head to it.
+        Node *prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * @brief Pops the oldest element. Returns false if the queue is empty (or a push is half done).
+     */
+    bool tryPop(T &out) {
+        Node *oldTail = tail;
+        Node *next = oldTail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+
+        // next becomes the new stub; its value is moved out.
+        out = std::move(next->value);
+        tail = next;
+        delete oldTail;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        T value{};
+    };
+
+    alignas(64) std::atomic<Node *> head;
+    alignas(64) Node *tail;
+};
+
+#endif //MPSCQUEUE_H
@@ -0,0 +1,192 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "OnlineModel.h"
+
+#include <GLFW/glfw3.h>
+#include <stdexcept>
+
+#include "../nn/Layer.h"
+#include "../utils/SetupUtil.h"
+
+OnlineModel::OnlineModel(const std::string &modelPath, const OnlineModelConfig config) {
+    if (config.snapshots < 2) {
+        throw std::invalid_argument("An online model needs at least 2 snapshots.");
+    }
+    GLFWwindow *previous = glfwGetCurrentContext();
+    context = createOffscreenContext();
+
+    glfwMakeContextCurrent(context);
+    network = NeuralNetwork::loadFromFile(modelPath);
+    if (network->getFeatureLayerCount() > 0) {
+        throw std::runtime_error("Online models do not support convolution/pooling layers yet.");
+    }
+    inputSize = network->getInputSize();
+    const std::vector<int> &sizes = network->getLayerSizes();
+    for (int i = 0; i < config.snapshots; ++i) {
+        auto snapshot = std::make_unique<Snapshot>();
+        snapshot->network = std::make_unique<NeuralNetwork>();
+        snapshot->network->addLayer(sizes[0], sizes[1]);
+        for (size_t l = 2; l < sizes.size(); ++l) {
+            snapshot->network->addLayer(sizes[l]);
+        }
+        snapshots.push_back(std::move(snapshot));
+    }
+    current.store(snapshotCount() - 1);
+    publish();
+    resetStats();
+    // Engine contexts created from now on see the first version without waiting
+    glFinish();
+    glfwMakeContextCurrent(previous);
+}
+
+OnlineModel::~OnlineModel() {
+    GLFWwindow *previous = glfwGetCurrentContext();
+    glfwMakeContextCurrent(context);
+    for (const auto &snapshot: snapshots) {
+        if (snapshot->fence) glDeleteSync(snapshot->fence);
+    }
+    snapshots.clear();
+    network.reset();
+    glfwMakeContextCurrent(previous == context ? nullptr : previous);
+    destroyOffscreenContext(context);
+}
+
+void OnlineModel::attachTrainer() {
+    glfwMakeContextCurrent(context);
+}
+
+void OnlineModel::detachTrainer() {
+    glfwMakeContextCurrent(nullptr);
+}
+
+void OnlineModel::train(const std::vector<float> &inputData, const std::vector<float> &targetData) {
+    network->train(inputData, targetData);
+    trainingSteps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OnlineModel::train(DeviceDataset &dataset, const size_t position) {
+    network->train(dataset, position);
+    trainingSteps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OnlineModel::copyParameters(Snapshot &snapshot) const {
+    if (network->getFirstCpuLayer() != network->getLayerCount()) {
+        throw std::runtime_error("Cannot publish layers placed on the CPU.");
+    }
+    auto copy = [](const GLuint source, const GLuint target, const size_t bytes) {
+        glBindBuffer(GL_COPY_READ_BUFFER, source);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, target);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(bytes));
+    };
+    for (size_t l = 0; l < network->getLayerCount(); ++l) {
+        const Layer &from = network->getLayer(l);
+        const Layer &to = snapshot.network->getLayer(l);
+        if (from.isStreamed() || from.isSparse() || from.shards.size() != to.shards.size()) {
+            throw std::runtime_error("Only dense layers in device memory can be published.");
+        }
+        for (size_t s = 0; s < from.shards.size(); ++s) {
+            copy(from.shards[s].weights, to.shards[s].weights,
+                 static_cast<size_t>(from.neuronCount) * from.shards[s].columns * sizeof(float));
+        }
+        copy(from.biasesBuffer, to.biasesBuffer, from.neuronCount * sizeof(float));
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+bool OnlineModel::publish() {
+    const auto start = std::chrono::steady_clock::now();
+
+    // Any snapshot but the current one that no reader holds. Readers pin a snapshot before checking it is
+    // still the current one, so none can start using this one until it is published again.
+    const int published = current.load(std::memory_order_relaxed);
+    int index = -1;
+    for (int i = 0; i < snapshotCount(); ++i) {
+        if (i != published && snapshots[i]->readers.load() == 0) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        skippedPublishes.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Snapshot &snapshot = *snapshots[index];
+    // The training steps wrote W and b from shaders
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    copyParameters(snapshot);
+    if (snapshot.fence) glDeleteSync(snapshot.fence);
+    snapshot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Other contexts can only wait for a fence that has been flushed
+    glFlush();
+
+    snapshot.version = ++version;
+    snapshot.trainingSteps = trainingSteps.load(std::memory_order_relaxed);
+    snapshot.publishedAt = std::chrono::steady_clock::now();
+    current.store(index);
+
+    publishes.fetch_add(1, std::memory_order_relaxed);
+    publishHistogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+        snapshot.publishedAt - start).count());
+    return true;
+}
+
+OnlineModel::Lease OnlineModel::acquire(uint64_t &seenVersion) {
+    int index;
+    for (;;) {
+        index = current.load();
+        Snapshot &snapshot = *snapshots[index];
+        snapshot.readers.fetch_add(1);
+        // Published again meanwhile: the trainer may already be rewriting it
+        if (current.load() == index) break;
+        snapshot.readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    Snapshot &snapshot = *snapshots[index];
+    if (snapshot.version != seenVersion) {
+        // Orders this context's commands after the copy, without blocking the CPU
+        glWaitSync(snapshot.fence, 0, GL_TIMEOUT_IGNORED);
+        seenVersion = snapshot.version;
+        swapHistogram.record(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - snapshot.publishedAt).count());
+    }
+
+    const uint64_t stale = trainingSteps.load(std::memory_order_relaxed) - snapshot.trainingSteps;
+    servedBatches.fetch_add(1, std::memory_order_relaxed);
+    stalenessSum.fetch_add(stale, std::memory_order_relaxed);
+    uint64_t max = stalenessMax.load(std::memory_order_relaxed);
+    while (stale > max && !stalenessMax.compare_exchange_weak(max, stale, std::memory_order_relaxed)) {
+    }
+    return {&snapshot, index};
+}
+
+OnlineModel::Lease::Lease(Lease &&other) noexcept : snapshot(other.snapshot), snapshotIndex(other.snapshotIndex) {
+    other.snapshot = nullptr;
+}
+
+OnlineModel::Lease::~Lease() {
+    if (snapshot) snapshot->readers.fetch_sub(1, std::memory_order_release);
+}
+
+OnlineModel::Stats OnlineModel::stats() const {
+    const uint64_t served = servedBatches.load(std::memory_order_relaxed);
+    return {
+        snapshots[current.load()]->version, trainingSteps.load(std::memory_order_relaxed),
+        publishes.load(std::memory_order_relaxed), skippedPublishes.load(std::memory_order_relaxed), served,
+        served ? static_cast<double>(stalenessSum.load(std::memory_order_relaxed)) / static_cast<double>(served) : 0.0,
+        stalenessMax.load(std::memory_order_relaxed)
+    };
+}
+
+void OnlineModel::resetStats() {
+    publishHistogram.reset();
+    swapHistogram.reset();
+    publishes.store(0, std::memory_order_relaxed);
+    skippedPublishes.store(0, std::memory_order_relaxed);
+    servedBatches.store(0, std::memory_order_relaxed);
+    stalenessSum.store(0, std::memory_order_relaxed);
+    stalenessMax.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,175 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef ONLINEMODEL_H
+#define ONLINEMODEL_H
+
+#include <GL/glew.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "LatencyHistogram.h"
+#include "../nn/NeuralNetwork.h"
+
+struct GLFWwindow;
+class DeviceDataset;
+
+struct OnlineModelConfig {
+    // Snapshots of the parameters that can exist at once: the published one, the one being written, and
+    // older ones slow readers still hold. publish() is skipped while none is free, so at least 2.
+    int snapshots = 3;
+};
+
+/**
+ * @brief A model that keeps training while GlInferenceEngines serve it.
+ *
+ * The trainer updates its own network and, whenever it wants the engines to see the result, calls
+ * publish(): the parameters are copied into a free snapshot on the device, a fence is placed behind the
+ * copy, and the snapshot becomes the current one with a single atomic store. Readers never lock: acquire()
+ * pins the current snapshot with a reader count, waits for its fence on the GPU (not the CPU) the first
+ * time it sees it, and serves from it until the lease ends, however many versions are published meanwhile.
+ * A snapshot is only rewritten once no reader holds it (RCU-style reclamation).
+ *
+ * Like SharedGlModel, the model lives in its own hidden GL context that engine contexts share objects with.
+ * Construct and destroy it on the main thread; the trainer borrows the context with attachTrainer(). Only
+ * one thread may train and publish.
+ */
+class OnlineModel {
+public:
+    struct Stats {
+        uint64_t version; // of the current snapshot, 1 after construction
+        uint64_t trainingSteps;
+        uint64_t publishes;
+        uint64_t skippedPublishes; // no free snapshot
+        uint64_t servedBatches;
+        double meanStalenessSteps; // training steps the served snapshot was behind the trainer
+        uint64_t maxStalenessSteps;
+    };
+
+    class Lease;
+
+    explicit OnlineModel(const std::string &modelPath, OnlineModelConfig config = {});
+
+    ~OnlineModel();
+
+    OnlineModel(const OnlineModel &) = delete;
+
+    OnlineModel &operator=(const OnlineModel &) = delete;
+
+    /**
+     * @brief Makes the model's context current on the calling (trainer) thread.
+     */
+    void attachTrainer();
+
+    void detachTrainer();
+
+    // --- Trainer thread ---
+
+    void train(const std::vector<float> &inputData, const std::vector<float> &targetData);
+
+    void train(DeviceDataset &dataset, size_t position);
+
+    /**
+     * @brief The network being trained, e.g. to evaluate it or change its learning rate. Parameters it
+     * reaches only become visible to the engines with publish().
+     */
+    [[nodiscard]] NeuralNetwork &getNetwork() { return *network; }
+
+    /**
+     * @brief Publishes the current parameters as a new version. Never waits for the GPU or for readers.
+     * @return false if every other snapshot is still held by readers; nothing is published then.
+     */
+    bool publish();
+
+    // --- Reader threads ---
+
+    /**
+     * @brief Pins the current snapshot. Call with a context sharing the model's current.
+     * @param seenVersion The last version this reader served. When the snapshot is newer, the reader's
+     * context waits for its fence and the swap latency is recorded; then it is updated.
+     */
+    Lease acquire(uint64_t &seenVersion);
+
+    [[nodiscard]] int snapshotCount() const { return static_cast<int>(snapshots.size()); }
+
+    /**
+     * @brief The network holding snapshot `index`, for readers to create their replicas of.
+     */
+    [[nodiscard]] const NeuralNetwork &getSnapshot(int index) const { return *snapshots.at(index)->network; }
+
+    [[nodiscard]] GLFWwindow *getContext() const { return context; }
+
+    [[nodiscard]] int getInputSize() const { return inputSize; }
+
+    [[nodiscard]] Stats stats() const;
+
+    void resetStats();
+
+    // How long publish() takes on the trainer thread: the copy and the fence, not the GPU work
+    [[nodiscard]] const LatencyHistogram &publishLatency() const { return publishHistogram; }
+
+    // From publish() until a reader first serves the version, once per reader and version
+    [[nodiscard]] const LatencyHistogram &swapLatency() const { return swapHistogram; }
+
+private:
+    struct Snapshot {
+        std::unique_ptr<NeuralNetwork> network;
+        GLsync fence = nullptr; // behind the copy that filled it
+        uint64_t version = 0;
+        uint64_t trainingSteps = 0; // of the trainer when published
+        std::chrono::steady_clock::time_point publishedAt;
+        std::atomic<int> readers{0};
+    };
+
+    GLFWwindow *context = nullptr;
+    std::unique_ptr<NeuralNetwork> network;
+    int inputSize = 0;
+    std::vector<std::unique_ptr<Snapshot> > snapshots;
+    std::atomic<int> current{0};
+
+    uint64_t version = 0;
+    std::atomic<uint64_t> trainingSteps{0};
+    std::atomic<uint64_t> publishes{0};
+    std::atomic<uint64_t> skippedPublishes{0};
+    std::atomic<uint64_t> servedBatches{0};
+    std::atomic<uint64_t> stalenessSum{0};
+    std::atomic<uint64_t> stalenessMax{0};
+    LatencyHistogram publishHistogram;
+    LatencyHistogram swapHistogram;
+
+    // Copies the trainer's W and b into the snapshot's
+    void copyParameters(Snapshot &snapshot) const;
+};
+
+/**
+ * @brief A snapshot pinned by a reader. Its parameters stay unchanged until the lease is destroyed, which
+ * must only happen once the GPU work reading them has completed (NeuralNetwork::predict() reads its output
+ * back, so it has).
+ */
+class OnlineModel::Lease {
+public:
+    Lease(Lease &&other) noexcept;
+
+    Lease &operator=(Lease &&) = delete;
+
+    ~Lease();
+
+    [[nodiscard]] int index() const { return snapshotIndex; }
+
+    [[nodiscard]] uint64_t version() const { return snapshot->version; }
+
+private:
+    friend class OnlineModel;
+
+    Lease(Snapshot *snapshot, int index) : snapshot(snapshot), snapshotIndex(index) {
+    }
+
+    Snapshot *snapshot;
+    int snapshotIndex;
+};
+
+#endif //ONLINEMODEL_H
@@ -3,83 +3,243 @@
 //
 
 #include "DatasetLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
 #include <iostream>
-#include <fstream>
 #include <chrono>
+#include <cstring>
 #include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DATASET_LOADER_SSE2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+// The AVX2 path is compiled for AVX2 on its own and only taken if the CPU has it, see hasAvx2()
+#if defined(__GNUC__)
+#define DATASET_LOADER_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define DATASET_LOADER_AVX2_TARGET
+#endif
+#endif
 
 namespace {
-    std::vector<float> parseImageLine(const std::string &line, size_t inputSize) {
-        const size_t space_pos = line.find(' ');
-        if (space_pos == std::string::npos) {
-            std::cerr << "Warning: Malformed line detected, skipping." << std::endl;
-            return {};
+    // Below this a file is parsed in one piece, threads would cost more than they save
+    constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+    struct TextChunk {
+        const char *begin;
+        const char *end;
+        float label;
+        size_t rows = 0; // valid lines, filled by the counting pass
+        size_t malformed = 0;
+        size_t firstRow = 0;
+    };
+
+    /**
+     * @brief Calls f(lineBegin, lineEnd) for every line in [begin, end), without the line break.
+     */
+    template<typename F>
+    void forEachLine(const char *begin, const char *end, F &&f) {
+        while (begin < end) {
+            const auto *newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+            const char *lineEnd = newline ? newline : end;
+            const char *stop = lineEnd > begin && lineEnd[-1] == '\r' ? lineEnd - 1 : lineEnd;
+            f(begin, stop);
+            begin = newline ? newline + 1 : end;
         }
+    }
 
-        std::string pixel_str = line.substr(space_pos + 1);
-
-        std::vector<float> pixels;
-        pixels.reserve(pixel_str.length());
+    /**
+     * @brief Returns the pixel digits of a "name 0101..." line, or nullptr if it has no space.
+     */
+    const char *pixelsOf(const char *begin, const char *end) {
+        const auto *space = static_cast<const char *>(std::memchr(begin, ' ', end - begin));
+        return space ? space + 1 : nullptr;
+    }
 
-        for (char c: pixel_str) {
-            pixels.push_back(static_cast<float>(c - '0'));
+    /**
+     * @brief Appends [data, data + size) to `chunks` cut into up to one piece per hardware thread, each
+     * ending after a line break.
+     */
+    void splitLines(const char *data, const size_t size, const float label, std::vector<TextChunk> &chunks) {
+        const size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        const size_t parts = std::clamp<size_t>(size / MIN_CHUNK_BYTES, 1, threads);
+        const char *end = data + size;
+        const char *begin = data;
+        for (size_t p = 1; p <= parts && begin < end; ++p) {
+            const char *cut = p == parts ? end : std::max(begin, data + size / parts * p);
+            if (cut < end) {
+                const auto *newline = static_cast<const char *>(std::memchr(cut, '\n', end - cut));
+                cut = newline ? newline + 1 : end;
+            }
+            chunks.push_back({begin, cut, label});
+            begin = cut;
         }
+    }
+
+#if defined(DATASET_LOADER_SSE2)
+    bool detectAvx2() {
+#if defined(__AVX2__)
+        return true;
+#elif defined(__GNUC__)
+        return __builtin_cpu_supports("avx2");
+#else
+        // CPUID.7:EBX bit 5, and the OS must save the YMM registers (OSXSAVE, then XCR0 bits 1 and 2)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        constexpr int OSXSAVE = 1 << 27, AVX = 1 << 28;
+        if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX) || (_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#endif
+    }
+
+    bool hasAvx2() {
+        static const bool available = detectAvx2();
+        return available;
+    }
 
-        pixels.resize(inputSize, 0.0f);
+    /**
+     * @brief convertDigits() for the first count - count % 32 digits: 32 take one load and one subtract.
+     * @return How many digits were converted.
+     */
+    DATASET_LOADER_AVX2_TARGET size_t convertDigitsAvx2(const char *src, const size_t count, float *dst) {
+        size_t i = 0;
+        const __m256i zero = _mm256_set1_epi8('0');
+        for (; i + 32 <= count; i += 32) {
+            const __m256i digits = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)),
+                                                   zero);
+            const __m128i lo = _mm256_castsi256_si128(digits);
+            const __m128i hi = _mm256_extracti128_si256(digits, 1);
+            _mm256_storeu_ps(dst + i, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(lo)));
+            _mm256_storeu_ps(dst + i + 8, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(lo, 8))));
+            _mm256_storeu_ps(dst + i + 16, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(hi)));
+            _mm256_storeu_ps(dst + i + 24, _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(hi, 8))));
+        }
+        return i;
+    }
+#endif
+
+    /**
+     * @brief Writes src[i] - '0' as floats, with AVX2 if the CPU has it, else 16 digits at a time with SSE2.
+     */
+    void convertDigits(const char *src, const size_t count, float *dst) {
+        size_t i = 0;
+#if defined(DATASET_LOADER_SSE2)
+        if (hasAvx2()) i = convertDigitsAvx2(src, count, dst);
+        const __m128i zero = _mm_set1_epi8('0');
+        for (; i + 16 <= count; i += 16) {
+            const __m128i digits = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), zero);
+            // Sign-extend 8 -> 16 -> 32 bits by interleaving with the sign mask
+            const __m128i sign = _mm_cmplt_epi8(digits, _mm_setzero_si128());
+            const __m128i lo = _mm_unpacklo_epi8(digits, sign);
+            const __m128i hi = _mm_unpackhi_epi8(digits, sign);
+            const __m128i loSign = _mm_srai_epi16(lo, 15);
+            const __m128i hiSign = _mm_srai_epi16(hi, 15);
+            _mm_storeu_ps(dst + i, _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, loSign)));
+            _mm_storeu_ps(dst + i + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, loSign)));
+            _mm_storeu_ps(dst + i + 8, _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, hiSign)));
+            _mm_storeu_ps(dst + i + 12, _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, hiSign)));
+        }
+#endif
+        for (; i < count; ++i) {
+            dst[i] = static_cast<float>(static_cast<signed char>(src[i] - '0'));
+        }
+    }
 
-        return pixels;
+    template<typename F>
+    void forEachChunk(std::vector<TextChunk> &chunks, F &&f) {
+        std::vector<std::thread> threads;
+        threads.reserve(chunks.size());
+        for (auto &chunk: chunks) {
+            threads.emplace_back([&f, &chunk] { f(chunk); });
+        }
+        for (auto &thread: threads) thread.join();
     }
 }
 
 
+TrainingData SampleMatrix::toTrainingData() const {
+    TrainingData data;
+    data.inputs.reserve(rows);
+    data.targets.reserve(rows);
+    for (size_t r = 0; r < rows; ++r) {
+        data.inputs.emplace_back(input(r), input(r) + inputSize);
+        data.targets.emplace_back(target(r), target(r) + targetSize);
+    }
+    return data;
+}
+
 namespace DatasetLoader {
-    TrainingData load(const std::string &playerPath,
-                      const std::string &notPlayerPath,
-                      size_t inputSize) {
+    SampleMatrix loadMatrix(const std::string &playerPath,
+                            const std::string &notPlayerPath,
+                            size_t inputSize) {
         std::cout << "Loading dataset..." << std::endl;
         auto start = std::chrono::high_resolution_clock::now();
 
-        TrainingData data;
-        std::string line;
-
-        // --- Load Player Images (Target = 1.0) ---
-        std::ifstream playerFile(playerPath);
-        if (!playerFile.is_open()) {
-            throw std::runtime_error("Error: Could not open player dataset file: " + playerPath);
+        const MappedFile playerFile = MappedFile::open(playerPath, false);
+        const MappedFile notPlayerFile = MappedFile::open(notPlayerPath, false);
+
+        // Target for "player" is 1.0
+        std::vector<TextChunk> chunks;
+        splitLines(static_cast<const char *>(playerFile.data()), playerFile.size(), 1.0f, chunks);
+        const size_t playerChunks = chunks.size();
+        splitLines(static_cast<const char *>(notPlayerFile.data()), notPlayerFile.size(), 0.0f, chunks);
+
+        // First pass: count the samples of every chunk, so each one knows where its rows go
+        forEachChunk(chunks, [](TextChunk &chunk) {
+            forEachLine(chunk.begin, chunk.end, [&](const char *begin, const char *end) {
+                ++(pixelsOf(begin, end) ? chunk.rows : chunk.malformed);
+            });
+        });
+
+        SampleMatrix matrix;
+        matrix.inputSize = inputSize;
+        matrix.targetSize = 1;
+        size_t playerRows = 0;
+        size_t malformed = 0;
+        for (size_t c = 0; c < chunks.size(); ++c) {
+            chunks[c].firstRow = matrix.rows;
+            matrix.rows += chunks[c].rows;
+            malformed += chunks[c].malformed;
+            if (c + 1 == playerChunks) playerRows = matrix.rows;
         }
-
-        while (std::getline(playerFile, line)) {
-            std::vector<float> pixels = parseImageLine(line, inputSize);
-            if (!pixels.empty()) {
-                data.inputs.push_back(pixels);
-                data.targets.push_back({1.0f}); // Target for "player" is 1.0
-            }
-        }
-        playerFile.close();
-        std::cout << "Loaded " << data.inputs.size() << " 'player' samples." << std::endl;
-
-        size_t initial_count = data.inputs.size();
-
-        std::ifstream notPlayerFile(notPlayerPath);
-        if (!notPlayerFile.is_open()) {
-            throw std::runtime_error("Error: Could not open not-player dataset file: " + notPlayerPath);
+        matrix.values.resize(matrix.rows * matrix.rowSize());
+
+        // Second pass: convert straight into the rows, the padding is already 0
+        forEachChunk(chunks, [&matrix](TextChunk &chunk) {
+            float *row = matrix.values.data() + chunk.firstRow * matrix.rowSize();
+            forEachLine(chunk.begin, chunk.end, [&](const char *begin, const char *end) {
+                const char *pixels = pixelsOf(begin, end);
+                if (!pixels) return;
+                convertDigits(pixels, std::min<size_t>(end - pixels, matrix.inputSize), row);
+                row[matrix.inputSize] = chunk.label;
+                row += matrix.rowSize();
+            });
+        });
+
+        if (malformed > 0) {
+            std::cerr << "Warning: Skipped " << malformed << " malformed line(s)." << std::endl;
         }
-
-        while (std::getline(notPlayerFile, line)) {
-            std::vector<float> pixels = parseImageLine(line, inputSize);
-            if (!pixels.empty()) {
-                data.inputs.push_back(pixels);
-                data.targets.push_back({0.0f});
-            }
-        }
-        notPlayerFile.close();
-        std::cout << "Loaded " << (data.inputs.size() - initial_count) << " 'not-player' samples." << std::endl;
+        std::cout << "Loaded " << playerRows << " 'player' samples." << std::endl;
+        std::cout << "Loaded " << (matrix.rows - playerRows) << " 'not-player' samples." << std::endl;
 
         auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start);
-        std::cout << "Finished loading " << data.inputs.size() << " total samples in "
-                << duration.count() << "s." << std::endl;
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        std::cout << "Finished loading " << matrix.rows << " total samples in "
+                << duration.count() << "ms." << std::endl;
+
+        return matrix;
+    }
 
-        return data;
+    TrainingData load(const std::string &playerPath,
+                      const std::string &notPlayerPath,
+                      size_t inputSize) {
+        return loadMatrix(playerPath, notPlayerPath, inputSize).toTrainingData();
     }
 }
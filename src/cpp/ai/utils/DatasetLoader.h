@@ -13,7 +13,41 @@ struct TrainingData {
     std::vector<std::vector<float> > targets;
 };
 
+/**
+ * @brief All samples of a dataset in one contiguous block. Each row is the input followed by the target,
+ * which is also the row layout of DeviceDataset's pages.
+ */
+struct SampleMatrix {
+    size_t rows = 0;
+    size_t inputSize = 0;
+    size_t targetSize = 0;
+    std::vector<float> values; // rows x rowSize()
+
+    [[nodiscard]] size_t rowSize() const { return inputSize + targetSize; }
+
+    [[nodiscard]] const float *input(const size_t row) const { return values.data() + row * rowSize(); }
+
+    [[nodiscard]] const float *target(const size_t row) const { return input(row) + inputSize; }
+
+    /**
+     * @brief Copies every row into its own input and target vector, for the per-sample host API.
+     */
+    [[nodiscard]] TrainingData toTrainingData() const;
+};
+
 namespace DatasetLoader {
+    /**
+     * @brief Parses the "name 0101..." text files of the labeling tool into one matrix. Player samples come
+     * first with target 1, then not-player samples with target 0. Pixels beyond inputSize are dropped and
+     * missing ones are 0.
+     *
+     * Both files are memory-mapped and split into line-aligned chunks that are parsed on all hardware
+     * threads, straight into their rows of the preallocated matrix.
+     */
+    SampleMatrix loadMatrix(const std::string &playerPath,
+                            const std::string &notPlayerPath,
+                            size_t inputSize);
+
     TrainingData load(const std::string &playerPath,
                       const std::string &notPlayerPath,
                       size_t inputSize);
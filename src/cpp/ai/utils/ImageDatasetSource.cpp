@@ -0,0 +1,251 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "ImageDatasetSource.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "MappedFile.h"
+
+namespace {
+    constexpr char CACHE_MAGIC[4] = {'G', 'L', 'N', 'I'};
+
+    bool isImageFile(const std::filesystem::path &path) {
+        std::string extension = path.extension().string();
+        std::ranges::transform(extension, extension.begin(), [](const unsigned char c) { return std::tolower(c); });
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp";
+    }
+
+    // FNV-1a
+    void hashBytes(uint64_t &hash, const void *data, const size_t bytes) {
+        const auto *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ p[i]) * 0x100000001B3ull;
+        }
+    }
+}
+
+ImageDatasetSource::ImageDatasetSource(const std::string &playerDirectory, const std::string &notPlayerDirectory,
+                                       const ImageDatasetConfig config)
+    : config(config) {
+    if (config.width <= 0 || config.height <= 0) {
+        throw std::invalid_argument("Image width and height must be positive.");
+    }
+
+    listImages(playerDirectory, 1.0f);
+    const size_t playerImages = files.size();
+    listImages(notPlayerDirectory, 0.0f);
+    if (files.empty()) {
+        throw std::runtime_error("No images found in " + playerDirectory + " or " + notPlayerDirectory);
+    }
+    std::cout << "Found " << playerImages << " 'player' and " << (files.size() - playerImages)
+            << " 'not-player' images." << std::endl;
+
+    openCache();
+
+    slots.resize(std::max<size_t>(config.prefetchSamples, 1));
+    const unsigned threads = config.decodeThreads > 0
+                                 ? static_cast<unsigned>(config.decodeThreads)
+                                 : std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(&ImageDatasetSource::workerLoop, this);
+    }
+}
+
+ImageDatasetSource::~ImageDatasetSource() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    claimable.notify_all();
+    for (auto &worker: workers) worker.join();
+}
+
+void ImageDatasetSource::listImages(const std::string &directory, const float label) {
+    if (!std::filesystem::is_directory(directory)) {
+        throw std::runtime_error("Image directory not found: " + directory);
+    }
+    std::vector<std::string> found;
+    for (const auto &entry: std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && isImageFile(entry.path())) {
+            found.push_back(entry.path().string());
+        }
+    }
+    // Directory iteration order is unspecified, sorting keeps positions (and the cache) stable
+    std::ranges::sort(found);
+    files.insert(files.end(), found.begin(), found.end());
+    labels.resize(files.size(), label);
+}
+
+void ImageDatasetSource::openCache() {
+    if (config.cachePath.empty()) return;
+
+    CacheHeader expected{};
+    std::memcpy(expected.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    expected.version = CACHE_VERSION;
+    expected.width = static_cast<uint32_t>(config.width);
+    expected.height = static_cast<uint32_t>(config.height);
+    expected.imageCount = files.size();
+    expected.fingerprint = 0xCBF29CE484222325ull;
+    for (const auto &file: files) {
+        const uint64_t bytes = std::filesystem::file_size(file);
+        const int64_t modified = std::filesystem::last_write_time(file).time_since_epoch().count();
+        hashBytes(expected.fingerprint, file.data(), file.size());
+        hashBytes(expected.fingerprint, &bytes, sizeof(bytes));
+        hashBytes(expected.fingerprint, &modified, sizeof(modified));
+    }
+    expected.binarize = config.binarize ? 1 : 0;
+    expected.threshold = config.binarize ? config.threshold : 0;
+
+    const size_t bytes = sizeof(CacheHeader) + files.size() * (1 + static_cast<size_t>(getInputSize()));
+    if (std::filesystem::exists(config.cachePath) && std::filesystem::file_size(config.cachePath) == bytes) {
+        auto file = std::make_unique<MappedFile>(MappedFile::open(config.cachePath, true));
+        if (std::memcmp(file->data(), &expected, sizeof(CacheHeader)) == 0) {
+            cache = std::move(file);
+        }
+    }
+    if (!cache) {
+        std::cout << "Creating image cache " << config.cachePath << "..." << std::endl;
+        cache = std::make_unique<MappedFile>(MappedFile::create(config.cachePath, bytes));
+        std::memcpy(cache->data(), &expected, sizeof(CacheHeader));
+    }
+
+    cacheFlags = static_cast<uint8_t *>(cache->data()) + sizeof(CacheHeader);
+    cachePixels = cacheFlags + files.size();
+    std::cout << "Image cache holds " << std::count(cacheFlags, cachePixels, uint8_t{1}) << " of " << files.size()
+            << " images." << std::endl;
+}
+
+void ImageDatasetSource::decode(const size_t image, std::vector<float> &input) const {
+    const size_t pixels = getInputSize();
+    const float scale = config.binarize ? 1.0f : 1.0f / 255.0f;
+    input.resize(pixels);
+
+    uint8_t *cached = cachePixels ? cachePixels + image * pixels : nullptr;
+    if (!cached || !cacheFlags[image]) {
+        const cv::Mat decoded = cv::imread(files[image], cv::IMREAD_GRAYSCALE);
+        if (decoded.empty()) {
+            throw std::runtime_error("Could not decode image: " + files[image]);
+        }
+        cv::Mat resized;
+        cv::resize(decoded, resized, cv::Size(config.width, config.height), 0, 0, cv::INTER_AREA);
+        if (config.binarize) {
+            cv::threshold(resized, resized, config.threshold - 1, 1, cv::THRESH_BINARY);
+        }
+
+        if (!cached) {
+            for (size_t i = 0; i < pixels; ++i) input[i] = static_cast<float>(resized.data[i]) * scale;
+            return;
+        }
+        // Each image has one writer per pass, the flag goes last so a torn write is decoded again
+        std::memcpy(cached, resized.data, pixels);
+        cacheFlags[image] = 1;
+    }
+    for (size_t i = 0; i < pixels; ++i) input[i] = static_cast<float>(cached[i]) * scale;
+}
+
+void ImageDatasetSource::workerLoop() {
+    std::unique_lock lock(mutex);
+    while (true) {
+        // Stay at most slots.size() positions ahead of the training loop
+        claimable.wait(lock, [&] {
+            return stopping || (nextClaim < passEnd && nextClaim < nextConsume + slots.size());
+        });
+        if (stopping) return;
+
+        const size_t position = nextClaim++;
+        const size_t image = order[position];
+        Slot &slot = slots[position % slots.size()];
+        ++inFlight;
+        lock.unlock();
+
+        std::string error;
+        try {
+            decode(image, slot.input);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+
+        lock.lock();
+        slot.position = position;
+        slot.error = std::move(error);
+        slot.ready = true;
+        --inFlight;
+        ready.notify_all();
+    }
+}
+
+void ImageDatasetSource::start(const uint64_t seed, const size_t first, const bool shuffled) {
+    std::unique_lock lock(mutex);
+    // No new claims, and let the decodes of the previous pass land before their slots are reset
+    passEnd = 0;
+    ready.wait(lock, [&] { return inFlight == 0; });
+
+    order.resize(files.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (shuffled) {
+        std::mt19937_64 gen(seed);
+        std::ranges::shuffle(order, gen);
+    }
+    for (auto &slot: slots) slot.ready = false;
+    nextClaim = nextConsume = std::min(first, files.size());
+    passEnd = files.size();
+    claimable.notify_all();
+}
+
+bool ImageDatasetSource::next(std::vector<float> &input, std::vector<float> &target) {
+    std::unique_lock lock(mutex);
+    if (nextConsume >= passEnd) return false;
+
+    const size_t position = nextConsume;
+    Slot &slot = slots[position % slots.size()];
+    ready.wait(lock, [&] { return slot.ready && slot.position == position; });
+    slot.ready = false;
+    ++nextConsume;
+    claimable.notify_all();
+
+    if (!slot.error.empty()) {
+        throw std::runtime_error(slot.error);
+    }
+    // Swapped while the slot is still locked, its next claim can only come after we return
+    std::swap(input, slot.input);
+    target.assign(1, labels[order[position]]);
+    return true;
+}
+
+SampleMatrix ImageDatasetSource::loadAll() {
+    std::cout << "Decoding " << files.size() << " images..." << std::endl;
+    const auto start = std::chrono::steady_clock::now();
+
+    SampleMatrix matrix;
+    matrix.rows = files.size();
+    matrix.inputSize = getInputSize();
+    matrix.targetSize = 1;
+    matrix.values.resize(matrix.rows * matrix.rowSize());
+
+    this->start(0, 0, false);
+    std::vector<float> input, target;
+    for (size_t r = 0; next(input, target); ++r) {
+        float *row = matrix.values.data() + r * matrix.rowSize();
+        std::ranges::copy(input, row);
+        row[matrix.inputSize] = target[0];
+    }
+
+    const auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                                                 start);
+    std::cout << "Decoded " << matrix.rows << " images in " << duration.count() << "ms." << std::endl;
+    return matrix;
+}
@@ -0,0 +1,135 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef IMAGEDATASETSOURCE_H
+#define IMAGEDATASETSOURCE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DatasetLoader.h"
+
+class MappedFile;
+
+struct ImageDatasetConfig {
+    // Every image is decoded as grayscale and resized to width x height.
+    int width = 450;
+    int height = 450;
+    // Pixels >= threshold become 1 and the rest 0, like the exported text files. Without binarize, pixels
+    // are scaled to [0, 1].
+    bool binarize = true;
+    int threshold = 128;
+    // Decode threads, 0 for one per hardware thread.
+    int decodeThreads = 0;
+    // Decoded samples that may wait for the training loop. Bounds the memory of the pipeline.
+    size_t prefetchSamples = 64;
+    // Optional file that keeps decoded images across epochs and runs. Rebuilt when the images or the
+    // settings change.
+    std::string cachePath;
+};
+
+/**
+ * @brief Reads a dataset straight from two image directories (players with target 1, not-players with
+ * target 0), replacing the export to DatasetLoader's text format.
+ *
+ * A pool of threads decodes, resizes and binarizes images with OpenCV into a bounded ring of slots
+ * while the training loop consumes them. Samples come out in the order given to start(), whichever
+ * thread decoded them, so shuffled runs stay reproducible.
+ *
+ * Cache layout: CacheHeader, one "decoded" byte per image, then width * height bytes per image.
+ */
+class ImageDatasetSource {
+public:
+    static constexpr uint32_t CACHE_VERSION = 1;
+
+    struct CacheHeader {
+        char magic[4]; // "GLNI"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint64_t imageCount;
+        uint64_t fingerprint; // paths, sizes and modification times of all images
+        int32_t binarize;
+        int32_t threshold;
+    };
+
+    ImageDatasetSource(const std::string &playerDirectory, const std::string &notPlayerDirectory,
+                       ImageDatasetConfig config = {});
+
+    /**
+     * @brief Stops and joins the decode threads.
+     */
+    ~ImageDatasetSource();
+
+    ImageDatasetSource(const ImageDatasetSource &) = delete;
+
+    ImageDatasetSource &operator=(const ImageDatasetSource &) = delete;
+
+    /**
+     * @brief Starts a pass over the dataset. Samples still in flight from the previous pass are dropped.
+     * @param seed Seeds the shuffle, the same seed always gives the same order.
+     * @param first Position to start at, to resume a pass.
+     * @param shuffled Whether to go through the images in a random order or in directory order.
+     */
+    void start(uint64_t seed, size_t first = 0, bool shuffled = true);
+
+    /**
+     * @brief Waits for the next sample of the pass and swaps it into input and target.
+     * @return false once the pass is complete.
+     * @throws std::runtime_error if the image could not be decoded.
+     */
+    bool next(std::vector<float> &input, std::vector<float> &target);
+
+    /**
+     * @brief Decodes every image in directory order into one matrix, e.g. for DeviceDataset.
+     */
+    SampleMatrix loadAll();
+
+    [[nodiscard]] size_t size() const { return files.size(); }
+
+    [[nodiscard]] int getInputSize() const { return config.width * config.height; }
+
+private:
+    struct Slot {
+        size_t position = 0;
+        bool ready = false;
+        std::vector<float> input;
+        std::string error;
+    };
+
+    ImageDatasetConfig config;
+    std::vector<std::string> files;
+    std::vector<float> labels;
+
+    std::unique_ptr<MappedFile> cache;
+    uint8_t *cacheFlags = nullptr;
+    uint8_t *cachePixels = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable claimable; // workers wait for a free slot or a new pass
+    std::condition_variable ready; // next() waits for its slot
+    std::vector<Slot> slots; // position p lives in slots[p % slots.size()]
+    std::vector<size_t> order; // position -> image
+    size_t nextClaim = 0;
+    size_t nextConsume = 0;
+    size_t passEnd = 0;
+    size_t inFlight = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    void listImages(const std::string &directory, float label);
+
+    void openCache();
+
+    void decode(size_t image, std::vector<float> &input) const;
+
+    void workerLoop();
+};
+
+#endif //IMAGEDATASETSOURCE_H
@@ -0,0 +1,121 @@
+//
+// Created by CorruptionHades on 17/10/2025.
+//
+
+#include "MappedFile.h"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile MappedFile::create(const std::string &path, const size_t size) {
+    return map(path, size, true, true);
+}
+
+MappedFile MappedFile::open(const std::string &path, const bool writable) {
+    return map(path, 0, writable, false);
+}
+
+MappedFile MappedFile::map(const std::string &path, size_t size, const bool writable, const bool create) {
+    MappedFile file;
+    file.filePath = path;
+
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | (writable ? GENERIC_WRITE : 0), FILE_SHARE_READ,
+                                nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) throw std::runtime_error("Could not open file for mapping: " + path);
+    file.fileHandle = reinterpret_cast<intptr_t>(handle);
+    if (!create) {
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(handle, &fileSize);
+        size = static_cast<size_t>(fileSize.QuadPart);
+    }
+    file.length = size;
+    if (size == 0) return file;
+
+    // Creating a writable mapping of `size` bytes also grows the file to that size
+    HANDLE mapping = CreateFileMappingA(handle, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size), nullptr);
+    if (!mapping) throw std::runtime_error("CreateFileMapping failed for " + path);
+    file.mappingHandle = reinterpret_cast<intptr_t>(mapping);
+    file.base = MapViewOfFile(mapping, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+#else
+    const int fd = ::open(path.c_str(), (writable ? O_RDWR : O_RDONLY) | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0) throw std::runtime_error("Could not open file for mapping: " + path);
+    struct stat st{};
+    if (create ? ftruncate(fd, static_cast<off_t>(size)) != 0 : fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Could not size file for mapping: " + path);
+    }
+    if (!create) size = static_cast<size_t>(st.st_size);
+    file.length = size;
+    if (size == 0) {
+        ::close(fd);
+        return file;
+    }
+
+    void *base = mmap(nullptr, size, PROT_READ | (writable ? PROT_WRITE : 0), MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    file.base = base == MAP_FAILED ? nullptr : base;
+#endif
+    if (!file.base) throw std::runtime_error("Could not map file: " + path);
+    return file;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : base(std::exchange(other.base, nullptr)),
+      length(std::exchange(other.length, 0)),
+      filePath(std::move(other.filePath)),
+      fileHandle(std::exchange(other.fileHandle, -1)),
+      mappingHandle(std::exchange(other.mappingHandle, -1)) {
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        base = std::exchange(other.base, nullptr);
+        length = std::exchange(other.length, 0);
+        filePath = std::move(other.filePath);
+        fileHandle = std::exchange(other.fileHandle, -1);
+        mappingHandle = std::exchange(other.mappingHandle, -1);
+    }
+    return *this;
+}
+
+void MappedFile::flush() const {
+    if (!base) return;
+#ifdef _WIN32
+    FlushViewOfFile(base, 0);
+    FlushFileBuffers(reinterpret_cast<HANDLE>(fileHandle));
+#else
+    msync(base, length, MS_SYNC);
+#endif
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle != -1) CloseHandle(reinterpret_cast<HANDLE>(mappingHandle));
+    if (fileHandle != -1) CloseHandle(reinterpret_cast<HANDLE>(fileHandle));
+#else
+    if (base) munmap(base, length);
+#endif
+    base = nullptr;
+    length = 0;
+    fileHandle = -1;
+    mappingHandle = -1;
+}
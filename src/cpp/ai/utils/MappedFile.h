@@ -0,0 +1,63 @@
+//
+// Created by CorruptionHades on 17/10/2025.
+//
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A file mapped into the address space. Pages are loaded on first touch and written back by the
+ * OS, so data much larger than RAM (let alone device memory) can be addressed like an array.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Creates (or truncates) `path` with `size` zero bytes and maps it read-write.
+     */
+    static MappedFile create(const std::string &path, size_t size);
+
+    /**
+     * @brief Maps an existing file in full.
+     */
+    static MappedFile open(const std::string &path, bool writable);
+
+    MappedFile() = default;
+
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    [[nodiscard]] void *data() const { return base; }
+
+    [[nodiscard]] size_t size() const { return length; }
+
+    [[nodiscard]] const std::string &path() const { return filePath; }
+
+    /**
+     * @brief Writes dirty pages back to the file and waits for it.
+     */
+    void flush() const;
+
+private:
+    void *base = nullptr;
+    size_t length = 0;
+    std::string filePath;
+    intptr_t fileHandle = -1; // Windows only: file and mapping handles
+    intptr_t mappingHandle = -1;
+
+    static MappedFile map(const std::string &path, size_t size, bool writable, bool create);
+
+    void close();
+};
+
+#endif //MAPPEDFILE_H
@@ -0,0 +1,62 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+Profiler &Profiler::global() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::record(const std::string &section, const double micros) {
+    std::lock_guard lock(mutex);
+    Section &s = sections[section];
+    ++s.count;
+    s.totalMicros += micros;
+    s.maxMicros = std::max(s.maxMicros, micros);
+}
+
+void Profiler::note(const std::string &topic, const std::string &text) {
+    std::lock_guard lock(mutex);
+    notes[topic] = text;
+}
+
+void Profiler::report(std::ostream &out) const {
+    std::lock_guard lock(mutex);
+    out << "--- Profile ---" << std::endl;
+    for (const auto &[topic, text]: notes) {
+        out << topic << ":" << std::endl << text;
+        if (!text.empty() && text.back() != '\n') out << std::endl;
+    }
+    if (!sections.empty()) {
+        out << std::left << std::setw(32) << "section" << std::right << std::setw(10) << "calls"
+                << std::setw(14) << "avg us" << std::setw(14) << "max us" << std::setw(14) << "total ms" << std::endl;
+        for (const auto &[name, s]: sections) {
+            out << std::left << std::setw(32) << name << std::right << std::setw(10) << s.count << std::fixed
+                    << std::setprecision(2) << std::setw(14) << s.totalMicros / static_cast<double>(s.count)
+                    << std::setw(14) << s.maxMicros << std::setw(14) << s.totalMicros / 1000.0 << std::endl;
+        }
+        out.unsetf(std::ios::fixed);
+    }
+}
+
+void Profiler::reset() {
+    std::lock_guard lock(mutex);
+    sections.clear();
+    notes.clear();
+}
+
+Profiler::Scope::Scope(const char *section) : section(section), active(global().isEnabled()) {
+    if (active) start = std::chrono::steady_clock::now();
+}
+
+Profiler::Scope::~Scope() {
+    if (active) {
+        global().record(section, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).
+                        count());
+    }
+}
@@ -0,0 +1,71 @@
+//
+// Created by CorruptionHades on 16/10/2025.
+//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief Process-wide collection of section timings and notes (decisions such as the layer placement),
+ * printed together by report(). Timings are only recorded while enabled; notes always are.
+ */
+class Profiler {
+public:
+    static Profiler &global();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+
+    [[nodiscard]] bool isEnabled() const { return enabled; }
+
+    void record(const std::string &section, double micros);
+
+    /**
+     * @brief Stores a (multi-line) note under a topic, replacing the previous note of that topic.
+     */
+    void note(const std::string &topic, const std::string &text);
+
+    void report(std::ostream &out) const;
+
+    void reset();
+
+    /**
+     * @brief Times its own lifetime into a section, if the profiler was enabled when it was created.
+     */
+    class Scope {
+    public:
+        explicit Scope(const char *section);
+
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        const char *section;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    struct Section {
+        uint64_t count = 0;
+        double totalMicros = 0.0;
+        double maxMicros = 0.0;
+    };
+
+    std::atomic<bool> enabled = false;
+    mutable std::mutex mutex;
+    std::map<std::string, Section> sections;
+    std::map<std::string, std::string> notes;
+};
+
+#endif //PROFILER_H
@@ -6,12 +6,13 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <stdexcept>
 
 
 GLFWwindow *window;
 
 void error_callback(int error, const char *description) {
-    std::cerr << "Error: " << description << std::endl;
+    std::cerr << "Error " << error << ": " << description << std::endl;
 }
 
 int setupOpenGLWindow() {
@@ -50,3 +51,16 @@ void cleanupOpenGLWindow() {
     glfwDestroyWindow(window);
     glfwTerminate();
 }
+
+GLFWwindow *createOffscreenContext(GLFWwindow *share) {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *context = glfwCreateWindow(1, 1, "Compute", nullptr, share);
+    if (!context) {
+        throw std::runtime_error("Failed to create offscreen GL context");
+    }
+    return context;
+}
+
+void destroyOffscreenContext(GLFWwindow *context) {
+    if (context) glfwDestroyWindow(context);
+}
@@ -7,11 +7,20 @@
 
 #include <iostream>
 
+struct GLFWwindow;
 
 void error_callback(int error, const char* description);
 int setupOpenGLWindow();
 void cleanupOpenGLWindow();
 
+/**
+ * Creates another hidden window whose context can be made current on a worker thread.
+ * setupOpenGLWindow() must have been called first. Must be called from the main thread.
+ * @param share Context to share objects (buffers, programs) with, or nullptr.
+ */
+GLFWwindow *createOffscreenContext(GLFWwindow *share = nullptr);
+void destroyOffscreenContext(GLFWwindow *context);
+
 
 
 #endif //SETUPUTIL_H
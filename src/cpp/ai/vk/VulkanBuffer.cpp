@@ -0,0 +1,99 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "VulkanBuffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "VulkanContext.h"
+
+VulkanBuffer::VulkanBuffer(const VulkanContext &context, const size_t floats, const bool hostVisible)
+    : context(context), floats(std::max<size_t>(floats, 1)) {
+    VkDevice device = context.getDevice();
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = bytes();
+    bufferInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                       VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    checkVulkan(vkCreateBuffer(device, &bufferInfo, nullptr, &buffer), "vkCreateBuffer");
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(device, buffer, &requirements);
+    int type;
+    if (hostVisible) {
+        // Device-local and mappable if there is such memory (integrated GPUs, lavapipe)
+        constexpr VkMemoryPropertyFlags mappable = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                   VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        type = context.findMemoryType(requirements.memoryTypeBits, mappable | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (type < 0) type = context.findMemoryType(requirements.memoryTypeBits, mappable);
+    } else {
+        type = context.findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
+    if (type < 0) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        throw std::runtime_error("No suitable Vulkan memory type for a buffer.");
+    }
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = static_cast<uint32_t>(type);
+    checkVulkan(vkAllocateMemory(device, &allocateInfo, nullptr, &memory), "vkAllocateMemory");
+    checkVulkan(vkBindBufferMemory(device, buffer, memory, 0), "vkBindBufferMemory");
+
+    if (hostVisible) {
+        void *pointer;
+        checkVulkan(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &pointer), "vkMapMemory");
+        mapped = static_cast<float *>(pointer);
+    }
+}
+
+VulkanBuffer::~VulkanBuffer() {
+    VkDevice device = context.getDevice();
+    if (mapped) vkUnmapMemory(device, memory);
+    vkDestroyBuffer(device, buffer, nullptr);
+    vkFreeMemory(device, memory, nullptr);
+}
+
+void VulkanBuffer::upload(const float *values, const size_t count) const {
+    if (count > floats) {
+        throw std::invalid_argument("Data does not fit the Vulkan buffer.");
+    }
+    if (mapped) {
+        std::copy_n(values, count, mapped);
+        return;
+    }
+    const VulkanBuffer staging(context, count, true);
+    std::copy_n(values, count, staging.mapped);
+    context.runOnce([&](VkCommandBuffer commandBuffer) {
+        const VkBufferCopy region{0, 0, count * sizeof(float)};
+        vkCmdCopyBuffer(commandBuffer, staging.buffer, buffer, 1, &region);
+    });
+}
+
+void VulkanBuffer::download(float *values, const size_t count) const {
+    if (count > floats) {
+        throw std::invalid_argument("Requested more data than the Vulkan buffer holds.");
+    }
+    if (mapped) {
+        std::copy_n(mapped, count, values);
+        return;
+    }
+    const VulkanBuffer staging(context, count, true);
+    context.runOnce([&](VkCommandBuffer commandBuffer) {
+        const VkBufferCopy region{0, 0, count * sizeof(float)};
+        vkCmdCopyBuffer(commandBuffer, buffer, staging.buffer, 1, &region);
+        // The copy must land before the host reads the mapping
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier,
+                             0, nullptr, 0, nullptr);
+    });
+    std::copy_n(staging.mapped, count, values);
+}
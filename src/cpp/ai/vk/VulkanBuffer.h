@@ -0,0 +1,50 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef VULKANBUFFER_H
+#define VULKANBUFFER_H
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+
+class VulkanContext;
+
+/**
+ * @brief A storage buffer of floats with its own memory allocation.
+ *
+ * Device-local buffers are filled and read through a temporary staging buffer. Host-visible ones (inputs,
+ * targets and outputs that change every step) stay mapped and are written and read in place.
+ */
+class VulkanBuffer {
+public:
+    VulkanBuffer(const VulkanContext &context, size_t floats, bool hostVisible = false);
+
+    ~VulkanBuffer();
+
+    VulkanBuffer(const VulkanBuffer &) = delete;
+
+    VulkanBuffer &operator=(const VulkanBuffer &) = delete;
+
+    [[nodiscard]] VkBuffer get() const { return buffer; }
+
+    [[nodiscard]] size_t size() const { return floats; }
+
+    [[nodiscard]] VkDeviceSize bytes() const { return floats * sizeof(float); }
+
+    // The mapping of a host-visible buffer, nullptr otherwise
+    [[nodiscard]] float *data() const { return mapped; }
+
+    void upload(const float *values, size_t count) const;
+
+    void download(float *values, size_t count) const;
+
+private:
+    const VulkanContext &context;
+    size_t floats;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    float *mapped = nullptr;
+};
+
+#endif //VULKANBUFFER_H
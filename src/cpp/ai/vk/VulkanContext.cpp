@@ -0,0 +1,154 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "VulkanContext.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+void checkVulkan(const VkResult result, const char *what) {
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(std::string(what) + " failed (VkResult " + std::to_string(result) + ").");
+    }
+}
+
+namespace {
+    // Lower is better
+    int deviceRank(const VkPhysicalDeviceType type) {
+        switch (type) {
+            case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return 0;
+            case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 1;
+            case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return 2;
+            default: return 3;
+        }
+    }
+}
+
+VulkanContext::VulkanContext() {
+    VkApplicationInfo application{};
+    application.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    application.pApplicationName = "GlNeuralNet";
+    application.apiVersion = VK_API_VERSION_1_1;
+
+    VkInstanceCreateInfo instanceInfo{};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &application;
+    checkVulkan(vkCreateInstance(&instanceInfo, nullptr, &instance), "vkCreateInstance");
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+    const char *wanted = std::getenv("GLNN_VULKAN_DEVICE");
+    int bestRank = 4;
+    for (VkPhysicalDevice candidate: devices) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(candidate, &properties);
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+        int family = -1;
+        for (uint32_t f = 0; f < familyCount && family < 0; ++f) {
+            if (families[f].queueFlags & VK_QUEUE_COMPUTE_BIT) family = static_cast<int>(f);
+        }
+        if (family < 0) continue;
+
+        const std::string name = properties.deviceName;
+        const int rank = wanted ? (name.find(wanted) != std::string::npos ? 0 : 4) : deviceRank(properties.deviceType);
+        if (rank < bestRank) {
+            bestRank = rank;
+            physicalDevice = candidate;
+            queueFamily = static_cast<uint32_t>(family);
+            deviceName = name;
+        }
+    }
+    if (physicalDevice == VK_NULL_HANDLE) {
+        vkDestroyInstance(instance, nullptr);
+        throw std::runtime_error(wanted
+                                     ? "No Vulkan device matches GLNN_VULKAN_DEVICE=" + std::string(wanted) + "."
+                                     : "No Vulkan device with a compute queue.");
+    }
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    constexpr float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo{};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    VkDeviceCreateInfo deviceInfo{};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    checkVulkan(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device), "vkCreateDevice");
+    vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+    checkVulkan(vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool), "vkCreateCommandPool");
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    checkVulkan(vkCreateFence(device, &fenceInfo, nullptr, &fence), "vkCreateFence");
+
+    std::cout << "Vulkan device: " << deviceName << std::endl;
+}
+
+VulkanContext::~VulkanContext() {
+    vkDeviceWaitIdle(device);
+    vkDestroyFence(device, fence, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    vkDestroyDevice(device, nullptr);
+    vkDestroyInstance(instance, nullptr);
+}
+
+int VulkanContext::findMemoryType(const uint32_t typeBits, const VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+VkCommandBuffer VulkanContext::allocateCommandBuffer() const {
+    VkCommandBufferAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocateInfo.commandPool = commandPool;
+    allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocateInfo.commandBufferCount = 1;
+    VkCommandBuffer commandBuffer;
+    checkVulkan(vkAllocateCommandBuffers(device, &allocateInfo, &commandBuffer), "vkAllocateCommandBuffers");
+    return commandBuffer;
+}
+
+void VulkanContext::submit(VkCommandBuffer commandBuffer) const {
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    checkVulkan(vkQueueSubmit(queue, 1, &submitInfo, fence), "vkQueueSubmit");
+    checkVulkan(vkWaitForFences(device, 1, &fence, VK_TRUE, UINT64_MAX), "vkWaitForFences");
+    vkResetFences(device, 1, &fence);
+}
+
+void VulkanContext::runOnce(const std::function<void(VkCommandBuffer)> &record) const {
+    VkCommandBuffer commandBuffer = allocateCommandBuffer();
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+    record(commandBuffer);
+    vkEndCommandBuffer(commandBuffer);
+    submit(commandBuffer);
+    vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+}
@@ -0,0 +1,69 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef VULKANCONTEXT_H
+#define VULKANCONTEXT_H
+
+#include <vulkan/vulkan.h>
+#include <functional>
+#include <string>
+
+/**
+ * @brief Throws std::runtime_error naming `what` if a Vulkan call failed.
+ */
+void checkVulkan(VkResult result, const char *what);
+
+/**
+ * @brief A Vulkan instance and logical device with one compute queue, for the Vulkan backend.
+ *
+ * Picks the first device with a compute queue, preferring a discrete or integrated GPU over a CPU
+ * implementation. Set GLNN_VULKAN_DEVICE to a substring of a device name to choose one, e.g. "llvmpipe" for
+ * Mesa's lavapipe, which runs the backend without a GPU.
+ */
+class VulkanContext {
+public:
+    VulkanContext();
+
+    ~VulkanContext();
+
+    VulkanContext(const VulkanContext &) = delete;
+
+    VulkanContext &operator=(const VulkanContext &) = delete;
+
+    [[nodiscard]] VkDevice getDevice() const { return device; }
+
+    [[nodiscard]] VkCommandPool getCommandPool() const { return commandPool; }
+
+    [[nodiscard]] const std::string &getDeviceName() const { return deviceName; }
+
+    /**
+     * @brief A memory type allowed by `typeBits` with all the `properties`, or -1.
+     */
+    [[nodiscard]] int findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+    [[nodiscard]] VkCommandBuffer allocateCommandBuffer() const;
+
+    /**
+     * @brief Submits a recorded command buffer and blocks until it has completed.
+     */
+    void submit(VkCommandBuffer commandBuffer) const;
+
+    /**
+     * @brief Records commands into a temporary command buffer, submits it and waits, e.g. for a transfer.
+     */
+    void runOnce(const std::function<void(VkCommandBuffer)> &record) const;
+
+private:
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE; // signalled by every submit()
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    std::string deviceName;
+};
+
+#endif //VULKANCONTEXT_H
@@ -0,0 +1,77 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "VulkanKernel.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "VulkanContext.h"
+
+VulkanKernel::VulkanKernel(const VulkanContext &context, const std::string &spirvPath, const uint32_t bufferCount,
+                           const uint32_t pushConstantBytes)
+    : context(context), bufferCount(bufferCount), pushConstantBytes(pushConstantBytes) {
+    std::ifstream file(spirvPath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open SPIR-V file: " + spirvPath);
+    }
+    const auto size = static_cast<size_t>(file.tellg());
+    if (size == 0 || size % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("Invalid SPIR-V file: " + spirvPath);
+    }
+    std::vector<uint32_t> code(size / sizeof(uint32_t));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(code.data()), static_cast<std::streamsize>(size));
+
+    VkDevice device = context.getDevice();
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = size;
+    moduleInfo.pCode = code.data();
+    VkShaderModule module;
+    checkVulkan(vkCreateShaderModule(device, &moduleInfo, nullptr, &module), "vkCreateShaderModule");
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings(bufferCount);
+    for (uint32_t i = 0; i < bufferCount; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+    setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutInfo.bindingCount = bufferCount;
+    setLayoutInfo.pBindings = bindings.data();
+    checkVulkan(vkCreateDescriptorSetLayout(device, &setLayoutInfo, nullptr, &setLayout),
+                "vkCreateDescriptorSetLayout");
+
+    const VkPushConstantRange pushConstants{VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantBytes};
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+    checkVulkan(vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout), "vkCreatePipelineLayout");
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = pipelineLayout;
+    const VkResult result = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline);
+    // The pipeline keeps what it needs
+    vkDestroyShaderModule(device, module, nullptr);
+    checkVulkan(result, "vkCreateComputePipelines");
+}
+
+VulkanKernel::~VulkanKernel() {
+    VkDevice device = context.getDevice();
+    vkDestroyPipeline(device, pipeline, nullptr);
+    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+}
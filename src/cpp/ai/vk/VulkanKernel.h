@@ -0,0 +1,47 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef VULKANKERNEL_H
+#define VULKANKERNEL_H
+
+#include <vulkan/vulkan.h>
+#include <string>
+
+class VulkanContext;
+
+/**
+ * @brief A compute pipeline built from a SPIR-V file (see src/shaders/vk), whose storage buffers are
+ * bindings 0..bufferCount-1 of set 0 and whose parameters are push constants.
+ */
+class VulkanKernel {
+public:
+    VulkanKernel(const VulkanContext &context, const std::string &spirvPath, uint32_t bufferCount,
+                 uint32_t pushConstantBytes);
+
+    ~VulkanKernel();
+
+    VulkanKernel(const VulkanKernel &) = delete;
+
+    VulkanKernel &operator=(const VulkanKernel &) = delete;
+
+    [[nodiscard]] VkPipeline getPipeline() const { return pipeline; }
+
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+
+    [[nodiscard]] VkDescriptorSetLayout getSetLayout() const { return setLayout; }
+
+    [[nodiscard]] uint32_t getBufferCount() const { return bufferCount; }
+
+    [[nodiscard]] uint32_t getPushConstantBytes() const { return pushConstantBytes; }
+
+private:
+    const VulkanContext &context;
+    uint32_t bufferCount;
+    uint32_t pushConstantBytes;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+};
+
+#endif //VULKANKERNEL_H
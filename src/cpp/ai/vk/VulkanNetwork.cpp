@@ -0,0 +1,328 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#include "VulkanNetwork.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+#include "VulkanContext.h"
+
+namespace {
+    uint32_t groupsFor(const int count, const int localSize) {
+        return static_cast<uint32_t>((count + localSize - 1) / localSize);
+    }
+
+    constexpr int32_t ADD = 0;
+    constexpr int32_t SUBTRACT = 1;
+    constexpr int32_t MULTIPLY = 2;
+    constexpr int32_t SIGMOID = 0;
+    constexpr int32_t SIGMOID_DERIVATIVE = 1;
+}
+
+VulkanNetwork::VulkanNetwork(const VulkanContext &context, const std::vector<int> &layerSizes)
+    : context(context), layerSizes(layerSizes) {
+    if (layerSizes.size() < 2) {
+        throw std::invalid_argument("A network needs an input size and at least one layer.");
+    }
+
+    // The SPIR-V is compiled from src/shaders/vk at build time
+    kernels.matmul = std::make_unique<VulkanKernel>(context, "shaders/vk/matmul.spv", 3, 5 * sizeof(int32_t));
+    kernels.matmulTransposed = std::make_unique<VulkanKernel>(context, "shaders/vk/matmul_transpose_A.spv", 3,
+                                                              4 * sizeof(int32_t));
+    kernels.elementwise = std::make_unique<VulkanKernel>(context, "shaders/vk/elementwise.spv", 3,
+                                                         2 * sizeof(int32_t));
+    kernels.activation = std::make_unique<VulkanKernel>(context, "shaders/vk/activation.spv", 2, 2 * sizeof(int32_t));
+    kernels.outerProduct = std::make_unique<VulkanKernel>(context, "shaders/vk/outer_product.spv", 3,
+                                                          4 * sizeof(int32_t));
+    kernels.sgdUpdate = std::make_unique<VulkanKernel>(context, "shaders/vk/sgd_update.spv", 2, 2 * sizeof(int32_t));
+
+    activations.push_back(std::make_unique<VulkanBuffer>(context, layerSizes.front(), true));
+    for (size_t l = 0; l + 1 < layerSizes.size(); ++l) {
+        const int inputSize = layerSizes[l];
+        const int neuronCount = layerSizes[l + 1];
+        const size_t weightCount = static_cast<size_t>(neuronCount) * inputSize;
+        LayerBuffers layer{inputSize, neuronCount};
+        layer.weights = std::make_unique<VulkanBuffer>(context, weightCount);
+        layer.biases = std::make_unique<VulkanBuffer>(context, neuronCount);
+        layer.gradWeights = std::make_unique<VulkanBuffer>(context, weightCount);
+        layer.gradBiases = std::make_unique<VulkanBuffer>(context, neuronCount);
+        layer.weightedSum = std::make_unique<VulkanBuffer>(context, neuronCount);
+        layer.delta = std::make_unique<VulkanBuffer>(context, neuronCount);
+        layer.error = std::make_unique<VulkanBuffer>(context, inputSize);
+        layers.push_back(std::move(layer));
+
+        // Only the output is read back
+        const bool output = l + 2 == layerSizes.size();
+        activations.push_back(std::make_unique<VulkanBuffer>(context, neuronCount, output));
+    }
+    target = std::make_unique<VulkanBuffer>(context, layerSizes.back(), true);
+
+    // Biases start at zero, like Layer's; W is expected from uploadParameters()
+    for (const auto &layer: layers) {
+        layer.biases->upload(std::vector<float>(layer.neuronCount, 0.0f).data(), layer.neuronCount);
+    }
+
+    std::vector<Command> commands;
+    forwardCommands(commands);
+    record(inference, commands);
+}
+
+VulkanNetwork::~VulkanNetwork() {
+    vkDeviceWaitIdle(context.getDevice());
+    release(inference);
+    release(training);
+}
+
+void VulkanNetwork::uploadParameters(const size_t layer, const std::vector<float> &weights,
+                                     const std::vector<float> &biases) {
+    const LayerBuffers &buffers = layers.at(layer);
+    if (weights.size() != buffers.weights->size() || biases.size() != buffers.biases->size()) {
+        throw std::invalid_argument("Mismatched data size when uploading layer parameters.");
+    }
+    buffers.weights->upload(weights.data(), weights.size());
+    buffers.biases->upload(biases.data(), biases.size());
+}
+
+void VulkanNetwork::downloadParameters(const size_t layer, std::vector<float> &weights,
+                                       std::vector<float> &biases) const {
+    const LayerBuffers &buffers = layers.at(layer);
+    weights.resize(buffers.weights->size());
+    biases.resize(buffers.biases->size());
+    buffers.weights->download(weights.data(), weights.size());
+    buffers.biases->download(biases.data(), biases.size());
+}
+
+void VulkanNetwork::forwardCommands(std::vector<Command> &commands) const {
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const LayerBuffers &layer = layers[l];
+        const VkBuffer z = layer.weightedSum->get();
+        const VkBuffer output = activations[l + 1]->get();
+
+        // z = W * x, z = z + b, a = sigmoid(z)
+        commands.push_back({
+            kernels.matmul.get(), {layer.weights->get(), activations[l]->get(), z},
+            {layer.neuronCount, layer.inputSize, 1, 0, 0}, {1, groupsFor(layer.neuronCount, 16), 1}, {z}
+        });
+        commands.push_back({
+            kernels.elementwise.get(), {z, layer.biases->get(), z}, {ADD, layer.neuronCount},
+            {groupsFor(layer.neuronCount, 256), 1, 1}, {z}
+        });
+        commands.push_back({
+            kernels.activation.get(), {z, output}, {SIGMOID, layer.neuronCount},
+            {groupsFor(layer.neuronCount, 256), 1, 1}, {output}
+        });
+    }
+}
+
+void VulkanNetwork::trainingCommands(std::vector<Command> &commands) const {
+    forwardCommands(commands);
+
+    // δ_L = prediction - target
+    const LayerBuffers &last = layers.back();
+    commands.push_back({
+        kernels.elementwise.get(), {activations.back()->get(), target->get(), last.delta->get()},
+        {SUBTRACT, last.neuronCount}, {groupsFor(last.neuronCount, 256), 1, 1}, {last.delta->get()}
+    });
+
+    for (size_t l = layers.size(); l-- > 0;) {
+        const LayerBuffers &layer = layers[l];
+        const VkBuffer delta = layer.delta->get();
+
+        // ∇b = δ, ∇W = δ * transpose(x)
+        Command copy;
+        copy.buffers = {delta, layer.gradBiases->get()};
+        copy.writes = {layer.gradBiases->get()};
+        copy.copyBytes = layer.delta->bytes();
+        commands.push_back(std::move(copy));
+        commands.push_back({
+            kernels.outerProduct.get(), {delta, activations[l]->get(), layer.gradWeights->get()},
+            {layer.neuronCount, layer.inputSize, 0, 0},
+            {groupsFor(layer.inputSize, 16), groupsFor(layer.neuronCount, 16), 1}, {layer.gradWeights->get()}
+        });
+        if (l == 0) break;
+
+        // δ_{l-1} = (transpose(W_l) * δ_l) .* g'(z_{l-1})
+        const LayerBuffers &previous = layers[l - 1];
+        const VkBuffer error = layer.error->get();
+        const VkBuffer previousDelta = previous.delta->get();
+        commands.push_back({
+            kernels.matmulTransposed.get(), {layer.weights->get(), delta, error},
+            {layer.neuronCount, layer.inputSize, 1, 0}, {1, groupsFor(layer.inputSize, 16), 1}, {error}
+        });
+        commands.push_back({
+            kernels.activation.get(), {previous.weightedSum->get(), previousDelta},
+            {SIGMOID_DERIVATIVE, previous.neuronCount}, {groupsFor(previous.neuronCount, 256), 1, 1}, {previousDelta}
+        });
+        commands.push_back({
+            kernels.elementwise.get(), {error, previousDelta, previousDelta}, {MULTIPLY, previous.neuronCount},
+            {groupsFor(previous.neuronCount, 256), 1, 1}, {previousDelta}
+        });
+    }
+
+    // W -= lr * ∇W, b -= lr * ∇b
+    const int32_t rate = std::bit_cast<int32_t>(learningRate);
+    for (const auto &layer: layers) {
+        for (const auto &[parameters, gradients]: {
+                 std::pair{layer.weights.get(), layer.gradWeights.get()},
+                 std::pair{layer.biases.get(), layer.gradBiases.get()}
+             }) {
+            const auto count = static_cast<int32_t>(parameters->size());
+            commands.push_back({
+                kernels.sgdUpdate.get(), {parameters->get(), gradients->get()}, {rate, count},
+                {groupsFor(count, 256), 1, 1}, {parameters->get()}
+            });
+        }
+    }
+}
+
+void VulkanNetwork::record(Recording &recording, const std::vector<Command> &commands) const {
+    VkDevice device = context.getDevice();
+    release(recording);
+
+    // One descriptor set per dispatch, all written now
+    size_t dispatchCount = 0;
+    size_t descriptorCount = 0;
+    for (const auto &command: commands) {
+        if (!command.kernel) continue;
+        ++dispatchCount;
+        descriptorCount += command.buffers.size();
+    }
+    const VkDescriptorPoolSize poolSize{
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(std::max<size_t>(descriptorCount, 1))
+    };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = static_cast<uint32_t>(std::max<size_t>(dispatchCount, 1));
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    checkVulkan(vkCreateDescriptorPool(device, &poolInfo, nullptr, &recording.descriptorPool),
+                "vkCreateDescriptorPool");
+
+    recording.commandBuffer = context.allocateCommandBuffer();
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    checkVulkan(vkBeginCommandBuffer(recording.commandBuffer, &beginInfo), "vkBeginCommandBuffer");
+
+    // Buffers touched since the last barrier. A command waits if it reads or writes a buffer written since,
+    // or writes one read since; the others overlap with their predecessors.
+    std::vector<VkBuffer> written;
+    std::vector<VkBuffer> read;
+    auto contains = [](const std::vector<VkBuffer> &list, VkBuffer buffer) {
+        return std::ranges::find(list, buffer) != list.end();
+    };
+    auto barrier = [&recording](const VkAccessFlags dstAccess, const VkPipelineStageFlags dstStage) {
+        VkMemoryBarrier memoryBarrier{};
+        memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(recording.commandBuffer,
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0,
+                             1, &memoryBarrier, 0, nullptr, 0, nullptr);
+        ++recording.barriers;
+    };
+
+    for (const auto &command: commands) {
+        bool hazard = false;
+        for (VkBuffer buffer: command.buffers) {
+            const bool writes = contains(command.writes, buffer);
+            hazard |= contains(written, buffer) || (writes && contains(read, buffer));
+        }
+        if (hazard) {
+            barrier(VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT |
+                    VK_ACCESS_TRANSFER_WRITE_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT);
+            written.clear();
+            read.clear();
+        }
+        for (VkBuffer buffer: command.buffers) {
+            (contains(command.writes, buffer) ? written : read).push_back(buffer);
+        }
+
+        if (!command.kernel) {
+            const VkBufferCopy region{0, 0, command.copyBytes};
+            vkCmdCopyBuffer(recording.commandBuffer, command.buffers[0], command.buffers[1], 1, &region);
+            continue;
+        }
+
+        const VulkanKernel &kernel = *command.kernel;
+        VkDescriptorSetLayout setLayout = kernel.getSetLayout();
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = recording.descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &setLayout;
+        VkDescriptorSet set;
+        checkVulkan(vkAllocateDescriptorSets(device, &allocateInfo, &set), "vkAllocateDescriptorSets");
+
+        std::vector<VkDescriptorBufferInfo> bufferInfos(command.buffers.size());
+        std::vector<VkWriteDescriptorSet> writes(command.buffers.size());
+        for (size_t b = 0; b < command.buffers.size(); ++b) {
+            bufferInfos[b] = {command.buffers[b], 0, VK_WHOLE_SIZE};
+            writes[b] = {};
+            writes[b].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[b].dstSet = set;
+            writes[b].dstBinding = static_cast<uint32_t>(b);
+            writes[b].descriptorCount = 1;
+            writes[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[b].pBufferInfo = &bufferInfos[b];
+        }
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        vkCmdBindPipeline(recording.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.getPipeline());
+        vkCmdBindDescriptorSets(recording.commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, kernel.getPipelineLayout(), 0,
+                                1, &set, 0, nullptr);
+        vkCmdPushConstants(recording.commandBuffer, kernel.getPipelineLayout(), VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                           kernel.getPushConstantBytes(), command.pushConstants.data());
+        vkCmdDispatch(recording.commandBuffer, command.groups[0], command.groups[1], command.groups[2]);
+        ++recording.dispatches;
+    }
+
+    // The host reads the output once the submission has completed
+    barrier(VK_ACCESS_HOST_READ_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+    checkVulkan(vkEndCommandBuffer(recording.commandBuffer), "vkEndCommandBuffer");
+}
+
+void VulkanNetwork::release(Recording &recording) const {
+    VkDevice device = context.getDevice();
+    if (recording.commandBuffer) {
+        vkFreeCommandBuffers(device, context.getCommandPool(), 1, &recording.commandBuffer);
+    }
+    if (recording.descriptorPool) {
+        vkDestroyDescriptorPool(device, recording.descriptorPool, nullptr);
+    }
+    recording = {};
+}
+
+void VulkanNetwork::uploadInput(const std::vector<float> &inputData) const {
+    if (inputData.size() != static_cast<size_t>(layerSizes.front())) {
+        throw std::invalid_argument("Input data size does not match network input size.");
+    }
+    std::ranges::copy(inputData, activations.front()->data());
+}
+
+std::vector<float> VulkanNetwork::predict(const std::vector<float> &inputData) {
+    uploadInput(inputData);
+    context.submit(inference.commandBuffer);
+
+    const float *output = activations.back()->data();
+    return {output, output + layerSizes.back()};
+}
+
+void VulkanNetwork::train(const std::vector<float> &inputData, const std::vector<float> &targetData) {
+    if (targetData.size() != static_cast<size_t>(layerSizes.back())) {
+        throw std::invalid_argument("Target data size does not match network output size.");
+    }
+    if (!training.commandBuffer || learningRate != recordedLearningRate) {
+        std::vector<Command> commands;
+        trainingCommands(commands);
+        record(training, commands);
+        recordedLearningRate = learningRate;
+    }
+
+    uploadInput(inputData);
+    std::ranges::copy(targetData, target->data());
+    context.submit(training.commandBuffer);
+}
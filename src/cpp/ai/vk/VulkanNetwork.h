@@ -0,0 +1,123 @@
+//
+// Created by CorruptionHades on 19/10/2025.
+//
+
+#ifndef VULKANNETWORK_H
+#define VULKANNETWORK_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "VulkanBuffer.h"
+#include "VulkanKernel.h"
+
+class VulkanContext;
+
+/**
+ * @brief The dense sigmoid network of NeuralNetwork on the Vulkan backend, with the same kernels, math and
+ * parameter layout, so parameters move between the two unchanged.
+ *
+ * A training step (forward, backward and SGD update) and a forward pass are each recorded once into a
+ * command buffer and resubmitted as-is: every dispatch's descriptor set and push constants are baked in,
+ * and pipeline barriers only separate commands that touch a buffer written since the previous barrier.
+ * Per step, the host only writes the input and target into mapped buffers, submits and waits. Changing
+ * learningRate re-records the training step.
+ */
+class VulkanNetwork {
+public:
+    float learningRate = 0.1f;
+
+    VulkanNetwork(const VulkanContext &context, const std::vector<int> &layerSizes);
+
+    ~VulkanNetwork();
+
+    VulkanNetwork(const VulkanNetwork &) = delete;
+
+    VulkanNetwork &operator=(const VulkanNetwork &) = delete;
+
+    /**
+     * @brief Sets W (neuronCount x inputSize, row-major) and b of one layer, e.g. from Layer::downloadParameters.
+     */
+    void uploadParameters(size_t layer, const std::vector<float> &weights, const std::vector<float> &biases);
+
+    void downloadParameters(size_t layer, std::vector<float> &weights, std::vector<float> &biases) const;
+
+    std::vector<float> predict(const std::vector<float> &inputData);
+
+    /**
+     * @brief One SGD step on a single sample, like NeuralNetwork::train.
+     */
+    void train(const std::vector<float> &inputData, const std::vector<float> &targetData);
+
+    [[nodiscard]] const std::vector<int> &getLayerSizes() const { return layerSizes; }
+
+    // Commands in the recorded training step, and how many of them are dispatches and barriers
+    [[nodiscard]] size_t getTrainDispatches() const { return training.dispatches; }
+
+    [[nodiscard]] size_t getTrainBarriers() const { return training.barriers; }
+
+private:
+    struct Kernels {
+        std::unique_ptr<VulkanKernel> matmul;
+        std::unique_ptr<VulkanKernel> matmulTransposed;
+        std::unique_ptr<VulkanKernel> elementwise;
+        std::unique_ptr<VulkanKernel> activation;
+        std::unique_ptr<VulkanKernel> outerProduct;
+        std::unique_ptr<VulkanKernel> sgdUpdate;
+    };
+
+    struct LayerBuffers {
+        int inputSize;
+        int neuronCount;
+        std::unique_ptr<VulkanBuffer> weights{};
+        std::unique_ptr<VulkanBuffer> biases{};
+        std::unique_ptr<VulkanBuffer> gradWeights{};
+        std::unique_ptr<VulkanBuffer> gradBiases{};
+        std::unique_ptr<VulkanBuffer> weightedSum{}; // z
+        std::unique_ptr<VulkanBuffer> delta{};
+        std::unique_ptr<VulkanBuffer> error{}; // transpose(W) * δ, for the layer in front (unused by layer 0)
+    };
+
+    // A dispatch, or a buffer copy if kernel is null
+    struct Command {
+        const VulkanKernel *kernel = nullptr;
+        std::vector<VkBuffer> buffers; // bindings 0..n-1, or source and destination of a copy
+        std::vector<int32_t> pushConstants;
+        uint32_t groups[3] = {1, 1, 1};
+        std::vector<VkBuffer> writes; // the rest are only read
+        VkDeviceSize copyBytes = 0;
+    };
+
+    // A list of commands recorded into a command buffer, with the descriptor sets it binds
+    struct Recording {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        size_t dispatches = 0;
+        size_t barriers = 0;
+    };
+
+    const VulkanContext &context;
+    std::vector<int> layerSizes;
+    Kernels kernels;
+    std::vector<LayerBuffers> layers;
+    std::vector<std::unique_ptr<VulkanBuffer> > activations; // [0] is the input, mapped like the output
+    std::unique_ptr<VulkanBuffer> target;
+
+    Recording inference;
+    Recording training;
+    float recordedLearningRate = 0.0f;
+
+    void forwardCommands(std::vector<Command> &commands) const;
+
+    void trainingCommands(std::vector<Command> &commands) const;
+
+    void record(Recording &recording, const std::vector<Command> &commands) const;
+
+    void release(Recording &recording) const;
+
+    void uploadInput(const std::vector<float> &inputData) const;
+};
+
+#endif //VULKANNETWORK_H
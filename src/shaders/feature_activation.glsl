@@ -0,0 +1,17 @@
+// Activations of the feature (conv) layers, shared by forward and backward kernels.
+// 0: none, 1: sigmoid, 2: relu
+
+float activate(float z, int type) {
+    if (type == 1) return 1.0 / (1.0 + exp(-z));
+    if (type == 2) return max(z, 0.0);
+    return z;
+}
+
+float activateDerivative(float z, int type) {
+    if (type == 1) {
+        float s = 1.0 / (1.0 + exp(-z));
+        return s * (1.0 - s);
+    }
+    if (type == 2) return z > 0.0 ? 1.0 : 0.0;
+    return 1.0;
+}
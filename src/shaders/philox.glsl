@@ -0,0 +1,25 @@
+// Counter-based RNG shared by the compute shaders (included, not compiled on its own).
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"):
+// the same (counter, key) always gives the same 4 random words, so every invocation can
+// draw its own numbers without any state, and results are reproducible for a given seed.
+
+const uint PHILOX_M0 = 0xD2511F53u;
+const uint PHILOX_M1 = 0xCD9E8D57u;
+const uint PHILOX_W0 = 0x9E3779B9u;
+const uint PHILOX_W1 = 0xBB67AE85u;
+
+uvec4 philox4x32(uvec4 ctr, uvec2 key) {
+    for (int i = 0; i < 10; ++i) {
+        uint hi0, lo0, hi1, lo1;
+        umulExtended(PHILOX_M0, ctr.x, hi0, lo0);
+        umulExtended(PHILOX_M1, ctr.z, hi1, lo1);
+        ctr = uvec4(hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0);
+        key += uvec2(PHILOX_W0, PHILOX_W1);
+    }
+    return ctr;
+}
+
+// Uniform float in [0, 1) from a random word (24 bits of precision)
+float philoxToFloat(uint x) {
+    return float(x >> 8) * (1.0 / 16777216.0);
+}